@@ -0,0 +1,71 @@
+#include <onut/Archive.h>
+#include <onut/onut.h>
+
+#include <cstdlib>
+#include <iostream>
+
+// Packs a folder into an archive ContentManager can use as a search path:
+//   AssetPacker assets game.opak [-store] [-level 0-9] [-align bytes]
+// It runs before onut creates the window, then exits.
+void initSettings()
+{
+    std::vector<std::string> args;
+    for (size_t i = 1; i < OArguments.size(); ++i)
+    {
+        args.push_back(OArguments[i]);
+    }
+
+    onut::Archive::PackOptions options;
+    std::vector<std::string> paths;
+    for (size_t i = 0; i < args.size(); ++i)
+    {
+        if (args[i] == "-store")
+        {
+            options.compress = false;
+        }
+        else if (args[i] == "-level" && i + 1 < args.size())
+        {
+            options.compressionLevel = std::atoi(args[++i].c_str());
+        }
+        else if (args[i] == "-align" && i + 1 < args.size())
+        {
+            options.alignment = static_cast<uint32_t>(std::atoi(args[++i].c_str()));
+        }
+        else
+        {
+            paths.push_back(args[i]);
+        }
+    }
+
+    if (paths.size() != 2)
+    {
+        std::cout << "Usage: AssetPacker folder archive.opak [-store] [-level 0-9] [-align bytes]" << std::endl;
+        exit(1);
+    }
+
+    auto folder = paths[0];
+    while (folder.size() > 1 && (folder.back() == '/' || folder.back() == '\\')) folder.pop_back();
+    if (!onut::Archive::pack(paths[1], folder, options))
+    {
+        std::cout << "Failed to pack " << folder << std::endl;
+        exit(1);
+    }
+    std::cout << "Packed " << folder << " into " << paths[1] << std::endl;
+    exit(0);
+}
+
+void init()
+{
+}
+
+void update()
+{
+}
+
+void render()
+{
+}
+
+void postRender()
+{
+}
@@ -0,0 +1,128 @@
+#include <onut/Random.h>
+#include <onut/RenderCommandList.h>
+#include <onut/RendererNull.h>
+#include <onut/SpriteBatch.h>
+#include <onut/Texture.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+
+// CPU cost and GPU work of drawing sprites, on the null renderer:
+//   RenderBenchmark [frames]
+// No window and no GPU, so it runs anywhere. Draw calls and uploads are what
+// the real renderers would have sent.
+static const int SPRITE_COUNT = 10000;
+static const int TEXTURE_COUNT = 8;
+
+struct Sprite
+{
+    Vector2 position;
+    float angle;
+    int texture;
+};
+
+static std::vector<Sprite> sprites;
+static std::vector<OTextureRef> textures;
+
+static double getMilliseconds(std::chrono::steady_clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+static void drawSprites(bool sortByTexture, bool switchBlendMode)
+{
+    for (int i = 0; i < SPRITE_COUNT; ++i)
+    {
+        if (switchBlendMode && i == SPRITE_COUNT / 2) oSpriteBatch->changeBlendMode(OBlendAdd);
+        const auto& sprite = sprites[i];
+        auto texture = sortByTexture ? i * TEXTURE_COUNT / SPRITE_COUNT : sprite.texture;
+        oSpriteBatch->drawSprite(textures[texture], sprite.position, Color::White, sprite.angle, .25f);
+    }
+}
+
+static void run(const std::string& name, int frameCount, const std::function<void()>& renderFrame)
+{
+    auto pRenderer = static_cast<onut::RendererNull*>(oRenderer.get());
+    pRenderer->resetCounters();
+    auto start = std::chrono::steady_clock::now();
+    for (int frame = 0; frame < frameCount; ++frame)
+    {
+        oRenderer->beginFrame();
+        oRenderer->clear(Color::Black);
+        renderFrame();
+        oRenderer->endFrame();
+    }
+    auto elapsed = getMilliseconds(start);
+
+    const auto& counters = pRenderer->getCounters();
+    std::cout << name << ": " << elapsed / frameCount << " ms/frame, per frame: " <<
+        counters.drawCalls / frameCount << " draw calls, " <<
+        counters.stateChanges / frameCount << " state changes, " <<
+        counters.textureChanges / frameCount << " texture changes, " <<
+        counters.uploadedBytes / frameCount << " bytes uploaded" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    int frameCount = (argc > 1) ? std::atoi(argv[1]) : 100;
+    if (frameCount <= 0)
+    {
+        std::cout << "Usage: RenderBenchmark [frames]" << std::endl;
+        return 1;
+    }
+
+    oRenderer = ORenderer::create(nullptr);
+    oRenderer->init(nullptr);
+    oSpriteBatch = OSpriteBatch::create();
+
+    std::vector<uint8_t> pixels(64 * 64 * 4, 255);
+    for (int i = 0; i < TEXTURE_COUNT; ++i)
+    {
+        textures.push_back(OTexture::createFromData(pixels.data(), {64, 64}, false));
+    }
+    onut::randomizeSeed();
+    for (int i = 0; i < SPRITE_COUNT; ++i)
+    {
+        sprites.push_back({onut::rand2f(Vector2(0, 0), Vector2(1280, 720)), onut::randf(0, 360), onut::randi(0, TEXTURE_COUNT - 1)});
+    }
+
+    std::cout << SPRITE_COUNT << " sprites, " << TEXTURE_COUNT << " textures, " << frameCount << " frames" << std::endl;
+    run("Sorted by texture", frameCount, []
+    {
+        oSpriteBatch->begin();
+        drawSprites(true, false);
+        oSpriteBatch->end();
+    });
+    run("Mixed textures", frameCount, []
+    {
+        oSpriteBatch->begin();
+        drawSprites(false, false);
+        oSpriteBatch->end();
+    });
+    run("Sorted, blend switch", frameCount, []
+    {
+        oSpriteBatch->begin();
+        drawSprites(true, true);
+        oSpriteBatch->end();
+    });
+
+    // Recorded then replayed, like a worker would
+    auto pCommandList = ORenderCommandList::create();
+    run("Sorted, recorded", frameCount, [pCommandList]
+    {
+        pCommandList->reset();
+        oSpriteBatch->begin(pCommandList);
+        drawSprites(true, true);
+        oSpriteBatch->end();
+        oRenderer->submit(pCommandList);
+        oRenderer->executeCommandLists();
+    });
+
+    oSpriteBatch = nullptr;
+    oRenderer = nullptr;
+    return 0;
+}
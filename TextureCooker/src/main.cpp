@@ -0,0 +1,114 @@
+#include <onut/CookedTexture.h>
+#include <onut/Files.h>
+#include <onut/Images.h>
+#include <onut/onut.h>
+
+#include <chrono>
+#include <cstdlib>
+#include <iostream>
+
+// Cooks PNGs into .otex textures, next to them or to the given file:
+//   TextureCooker folder|image.png [image.otex] [-rgba] [-nomips] [-bench]
+// -bench compares loading and memory of the PNGs against the cooked textures.
+// It runs before onut creates the window, then exits.
+static double getMilliseconds(std::chrono::steady_clock::time_point from)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - from).count();
+}
+
+static std::string getCookedFilename(const std::string& filename)
+{
+    return filename.substr(0, filename.find_last_of('.')) + "." + onut::CookedTexture::EXTENSION;
+}
+
+void initSettings()
+{
+    onut::CookedTexture::CookOptions options;
+    bool bench = false;
+    std::vector<std::string> paths;
+    for (size_t i = 1; i < OArguments.size(); ++i)
+    {
+        const auto& arg = OArguments[i];
+        if (arg == "-rgba") options.compress = false;
+        else if (arg == "-nomips") options.generateMipmaps = false;
+        else if (arg == "-bench") bench = true;
+        else paths.push_back(arg);
+    }
+
+    if (paths.empty() || paths.size() > 2)
+    {
+        std::cout << "Usage: TextureCooker folder|image.png [image.otex] [-rgba] [-nomips] [-bench]" << std::endl;
+        exit(1);
+    }
+
+    std::vector<std::pair<std::string, std::string>> jobs;
+    if (onut::getExtension(paths[0]) == "PNG")
+    {
+        auto cookedFilename = (paths.size() == 2) ? paths[1] : getCookedFilename(paths[0]);
+        jobs.push_back({paths[0], cookedFilename});
+    }
+    else
+    {
+        for (auto& filename : onut::findAllFiles(paths[0], "png"))
+        {
+            jobs.push_back({filename, getCookedFilename(filename)});
+        }
+    }
+
+    double pngTime = 0, cookedTime = 0, decompressTime = 0;
+    size_t pngMemory = 0, cookedMemory = 0;
+    for (auto& job : jobs)
+    {
+        if (!onut::CookedTexture::cookFile(job.first, job.second, options))
+        {
+            std::cout << "Failed to cook " << job.first << std::endl;
+            exit(1);
+        }
+        std::cout << job.first << " -> " << job.second << std::endl;
+        if (!bench) continue;
+
+        // What Texture::createFromFileData does before the upload
+        auto pngData = onut::getFileData(job.first);
+        auto start = std::chrono::steady_clock::now();
+        Point size;
+        auto image = onut::decodeImage(pngData.data(), pngData.size(), size, true);
+        pngTime += getMilliseconds(start);
+        pngMemory += image.size();
+
+        auto cookedData = onut::getFileData(job.second);
+        start = std::chrono::steady_clock::now();
+        onut::CookedTexture cooked;
+        cooked.read(cookedData.data(), cookedData.size());
+        cookedTime += getMilliseconds(start);
+        cookedMemory += cooked.getMemorySize();
+
+        // Fallback when the GPU doesn't support the format
+        start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < cooked.getLevels().size(); ++i) cooked.decompress(i);
+        decompressTime += getMilliseconds(start);
+    }
+
+    if (bench && !jobs.empty())
+    {
+        std::cout << "PNG:    " << pngTime << " ms, " << pngMemory / 1024 << " KB (RGBA8, no mipmaps)" << std::endl;
+        std::cout << "Cooked: " << cookedTime << " ms, " << cookedMemory / 1024 << " KB (with mipmaps)" << std::endl;
+        std::cout << "Cooked, decompressed on the CPU: " << cookedTime + decompressTime << " ms" << std::endl;
+    }
+    exit(0);
+}
+
+void init()
+{
+}
+
+void update()
+{
+}
+
+void render()
+{
+}
+
+void postRender()
+{
+}
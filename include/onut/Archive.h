@@ -0,0 +1,84 @@
+#ifndef ARCHIVE_H_INCLUDED
+#define ARCHIVE_H_INCLUDED
+
+// Onut
+#include <onut/Files.h>
+
+// STL
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(Archive);
+
+namespace onut
+{
+    /*!
+        Packed assets. The whole archive is memory mapped once, and files
+        stored uncompressed are read straight from the mapping, no copy.
+        Files are looked up by relative path in a hashed table of contents.
+        Add an archive with ContentManager::addSearchPath like a folder.
+    */
+    class Archive final
+    {
+    public:
+        struct PackOptions
+        {
+            bool compress = true; // zlib, kept only when it saves at least 1/8th
+            int compressionLevel = 6;
+            uint32_t alignment = 16; // Of each file's data in the archive
+            std::vector<std::string> storeExtensions = {"PNG", "JPG", "OGG", "MP3", "MP4", "OPAK"}; // Already compressed
+        };
+
+        // Packs every file under folder. Paths are stored relative to it, with '/'
+        static bool pack(const std::string& archiveFilename, const std::string& folder);
+        static bool pack(const std::string& archiveFilename, const std::string& folder, const PackOptions& options);
+
+        // nullptr if it's not an archive
+        static OArchiveRef open(const std::string& filename);
+
+        ~Archive();
+
+        const std::string& getFilename() const { return m_filename; }
+        bool contains(const std::string& path) const;
+        FileData read(const std::string& path) const; // Empty if not found
+        std::vector<std::string> getPaths() const;
+
+    private:
+        struct Header
+        {
+            char signature[4];
+            uint32_t version;
+            uint32_t entryCount;
+            uint32_t bucketCount; // Power of 2
+            uint64_t tocOffset;
+            uint64_t namesOffset;
+        };
+
+        struct Entry
+        {
+            uint64_t hash; // 0 for an empty bucket
+            uint64_t offset;
+            uint64_t storedSize;
+            uint64_t size;
+            uint32_t nameOffset;
+            uint16_t nameLength;
+            uint16_t flags;
+        };
+
+        Archive() = default;
+
+        static uint64_t hash(const std::string& path);
+        const Entry* find(const std::string& path) const;
+
+        std::string m_filename;
+        FileData m_mapping;
+        const Header* m_pHeader = nullptr;
+        const Entry* m_pEntries = nullptr;
+        const char* m_pNames = nullptr;
+    };
+}
+
+#endif
@@ -2,6 +2,8 @@
 #define CSV_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
+#include <onut/Files.h>
 #include <onut/Resource.h>
 
 // STL
@@ -15,9 +17,27 @@ OForwardDeclare(CSV)
 
 namespace onut
 {
+    /*!
+        Table stored by column. Each column gets a type at load time: Int if
+        all its cells are integers, Float if they are all numbers, String
+        otherwise. Numbers are parsed once, when loading, and strings are
+        interned. Look a column up once with getColumn, then read its rows
+        with the handle.
+    */
     class CSV final : public Resource
     {
     public:
+        enum class ColumnType
+        {
+            Int,
+            Float,
+            String
+        };
+
+        // Index of the column, -1 if there is none by that name.
+        // Stays the same after a reload if the header didn't change
+        using ColumnHandle = int;
+
         static OCSVRef createFromFile(const std::string& filename, const OContentManagerRef& pContentManager);
 
         int getRowCount() const;
@@ -26,15 +46,46 @@ namespace onut
         float getFloat(const std::string& column, int row) const;
         double getDouble(const std::string& column, int row) const;
 
+        ColumnHandle getColumn(const std::string& name) const;
+        ColumnType getColumnType(ColumnHandle column) const;
+        const std::string& getValue(ColumnHandle column, int row) const;
+        int getInt(ColumnHandle column, int row) const;
+        float getFloat(ColumnHandle column, int row) const;
+        double getDouble(ColumnHandle column, int row) const;
+
+        size_t getMemorySize() const override;
+        bool reload(const OContentManagerRef& pContentManager) override;
+
     private:
-        CSV(const std::string& filename);
+        CSV(const FileData& data);
 
-        using Column = std::vector<std::string>;
-        using ColumnMap = std::unordered_map<std::string, Column>;
+        struct Column
+        {
+            ColumnType type = ColumnType::Int;
+            std::vector<uint32_t> stringIds; // Into m_strings, for getValue
+            std::vector<int> ints; // Int and Float columns
+            std::vector<double> numbers; // Float columns
+        };
+
+        // What std::stoi/std::stod give for a string, 0 when they throw
+        struct ParsedString
+        {
+            int intValue;
+            double number;
+        };
+
+        using ColumnMap = std::unordered_map<std::string, ColumnHandle>;
+
+        const Column* getColumnData(ColumnHandle column, int row) const;
 
         ColumnMap m_columnMap;
+        std::vector<Column> m_columns;
+        std::vector<std::string> m_strings;
+        std::vector<ParsedString> m_parsedStrings;
         int m_rowCount = 0;
     };
+
+    template<> struct AsyncLoader<CSV> : public AsyncLoaderCPU<CSV> {};
 }
 
 OCSVRef OGetCSV(const std::string& name);
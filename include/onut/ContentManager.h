@@ -1,26 +1,99 @@
 #ifndef CONTENTMANAGER_H_INCLUDED
 #define CONTENTMANAGER_H_INCLUDED
 
+// Onut
+#include <onut/Files.h>
+#include <onut/Resource.h>
+
 // STL
+#include <atomic>
+#include <condition_variable>
+#include <functional>
 #include <mutex>
 #include <string>
+#include <thread>
 #include <unordered_map>
 #include <vector>
 
 // Forward
 #include <onut/ForwardDeclaration.h>
+OForwardDeclare(Archive);
 OForwardDeclare(ContentManager);
+OForwardDeclare(FileWatcher);
 OForwardDeclare(Resource);
 
 namespace onut
 {
     /*!
         Thread safe resource management class.
+        A search path can also be an archive (.opak, see Archive). Its files
+        are then found as "archive.opak/relative/path" and read with readFile.
+
+        loadAsync loads on loader threads, highest priority first. What has
+        to happen on the main thread (GPU uploads) is done in update(),
+        within a time budget per frame. See AsyncLoader.
+
+        Memory budgets can be set per Resource::MemoryCategory. When one is
+        exceeded, update() unloads the least recently used resources of
+        that category that nothing else references anymore.
+
+        In editor mode, files changed under the search paths are reloaded
+        by update(), in place (Resource::reload), so existing references
+        see the new content.
     */
     class ContentManager : public std::enable_shared_from_this<ContentManager>
     {
     public:
         using SearchPaths = std::vector<std::string>;
+        using AsyncCallback = std::function<void(const OResourceRef&)>;
+
+        class AsyncLoad final
+        {
+        public:
+            enum class State
+            {
+                Queued,
+                Loading,
+                Waiting, // For its dependencies, or the main thread
+                Loaded,
+                Failed,
+                Canceled
+            };
+
+            State getState() const { return m_state; }
+            bool isDone() const;
+            const std::string& getName() const { return m_name; }
+
+            // nullptr until Loaded
+            OResourceRef getResource() const;
+            template<typename Tresource> std::shared_ptr<Tresource> getResourceAs() const { return std::dynamic_pointer_cast<Tresource>(getResource()); }
+
+            float getPriority() const { return m_priority; }
+            void setPriority(float priority) { m_priority = priority; }
+
+            // Callbacks won't be called. Doesn't stop a load already running on a loader thread
+            void cancel();
+
+        private:
+            friend class ContentManager;
+
+            std::string m_name;
+            std::atomic<State> m_state{State::Queued};
+            std::atomic<float> m_priority{0.0f};
+            uint64_t m_order = 0;
+            OResourceRef m_pResource;
+            std::vector<AsyncCallback> m_callbacks;
+        };
+        using AsyncLoadRef = std::shared_ptr<AsyncLoad>;
+
+        // What's left to do after the loader thread is done
+        struct AsyncSteps
+        {
+            OResourceRef pResource; // Set if it's done
+            std::vector<AsyncLoadRef> dependencies; // Waited on before finish
+            std::function<OResourceRef(const OContentManagerRef& pContentManager)> finish; // Main thread
+        };
+        using AsyncPrepare = std::function<AsyncSteps(const std::string& filename, const OContentManagerRef& pContentManager, float priority)>;
 
         static OContentManagerRef create();
         virtual ~ContentManager();
@@ -34,6 +107,29 @@ namespace onut
         OResourceRef getResource(const std::string& name);
         template<typename Tresource> std::shared_ptr<Tresource> getResourceAs(const std::string& name);
 
+        // Async. Loading the same name again returns the same load.
+        // onLoaded is called on the main thread, with nullptr if it failed
+        template<typename Tresource> AsyncLoadRef loadAsync(const std::string& name, float priority = 0.0f, const std::function<void(const std::shared_ptr<Tresource>&)>& onLoaded = nullptr);
+        AsyncLoadRef loadAsync(const std::string& name, float priority, const AsyncPrepare& prepare, const AsyncCallback& onLoaded);
+        size_t getAsyncLoadCount();
+
+        // Finishes async loads on the main thread, for up to budget seconds per call. Called every frame by onut
+        void update();
+        void setAsyncBudget(float seconds) { m_asyncBudget = seconds; }
+        float getAsyncBudget() const { return m_asyncBudget; }
+
+        // Memory
+        struct MemoryStats
+        {
+            size_t count = 0;
+            size_t size = 0; // Bytes
+            size_t budget = 0; // 0 is unlimited
+            size_t evictedCount = 0; // Since creation
+        };
+        void setMemoryBudget(Resource::MemoryCategory category, size_t budget);
+        MemoryStats getMemoryStats(Resource::MemoryCategory category);
+        void evict(); // Done by update()
+
         // Search Paths
         void addDefaultSearchPaths();
         void addSearchPath(const std::string& path);
@@ -41,14 +137,93 @@ namespace onut
         std::string findResourceFile(const std::string& name);
         const SearchPaths& getSearchPaths() const;
 
+        // Forces the file index to be rebuilt on next lookup
+        void refreshSearchPaths();
+
+        // Reads a file found by findResourceFile, from its archive if it's in one
+        FileData readFile(const std::string& filename);
+
+        // Reloads the resources loaded from that file, now
+        void reload(const std::string& filename);
+
     private:
         ContentManager();
 
-        using ResourceMap = std::unordered_map<std::string, OResourceRef>;
+        struct ResourceEntry
+        {
+            OResourceRef pResource;
+            Resource::MemoryCategory category;
+            size_t size; // As of when it was added
+            uint64_t lastUsed;
+        };
+        using ResourceMap = std::unordered_map<std::string, ResourceEntry>;
+
+        // Every file under a search path by name. First found wins, same as findFile
+        struct FileIndex
+        {
+            std::string path;
+            OArchiveRef pArchive;
+            std::unordered_map<std::string, std::string> files;
+        };
+        using FileIndexRef = std::shared_ptr<const FileIndex>;
+        using SearchIndex = std::vector<FileIndexRef>;
+        using SearchIndexRef = std::shared_ptr<const SearchIndex>;
+
+        struct AsyncRequest
+        {
+            AsyncLoadRef pLoad;
+            AsyncPrepare prepare;
+        };
+
+        // Shared with the loader threads, which can outlive us
+        struct AsyncQueue
+        {
+            std::mutex mutex;
+            std::condition_variable wakeUp;
+            bool isRunning = true;
+            std::vector<AsyncRequest> queue;
+            std::vector<std::thread> threads;
+        };
+        using AsyncQueueRef = std::shared_ptr<AsyncQueue>;
+
+        struct AsyncJob
+        {
+            AsyncLoadRef pLoad;
+            std::string filename;
+            AsyncSteps steps;
+        };
+
+        static void loaderThread(AsyncQueueRef pAsyncQueue, OContentManagerWeak pWeakThis);
+        void runAsync(const AsyncRequest& request);
+        void completeAsync(const AsyncLoadRef& pLoad, const std::string& filename, const OResourceRef& pResource);
+
+        SearchIndexRef getSearchIndex();
+        void onFileChanged(const std::string& searchPath, bool isRemoved, const std::string& filename);
+        void queueReload(const std::string& filename);
+
+        void removeEntry(ResourceMap::iterator it);
 
         ResourceMap m_resources;
         SearchPaths m_searchPaths;
         std::mutex m_mutex;
+        uint64_t m_useCounter = 0;
+        MemoryStats m_memoryStats[Resource::MEMORY_CATEGORY_COUNT];
+
+        // Immutable once published, swapped atomically. Lookups don't lock
+        SearchIndexRef m_pSearchIndex;
+        std::mutex m_searchIndexMutex;
+        std::mutex m_reloadMutex;
+        std::vector<std::string> m_reloadQueue; // From the file watcher thread
+        OFileWatcherRef m_pFileWatcher; // Editor mode only. Last, its callbacks use the above
+
+        // Async loads
+        AsyncQueueRef m_pAsyncQueue;
+        std::mutex m_asyncMutex;
+        std::unordered_map<std::string, AsyncLoadRef> m_asyncLoads; // By name, until done
+        std::vector<AsyncJob> m_asyncJobs; // Waiting for the main thread
+        std::vector<AsyncLoadRef> m_asyncCompleted; // Callbacks to call on the main thread
+        uint64_t m_asyncOrder = 0;
+        float m_asyncBudget = 0.004f;
     };
 
     template<typename Tresource>
@@ -77,8 +252,60 @@ namespace onut
         }
         return pRet;
     }
+
+    /*!
+        How loadAsync loads a type of resource. prepare runs on a loader
+        thread. By default it leaves everything to the main thread.
+        Specialize it next to a resource to decode there, and to load the
+        resources it uses first (dependencies).
+    */
+    template<typename Tresource>
+    struct AsyncLoader
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+        {
+            ContentManager::AsyncSteps steps;
+            steps.finish = [filename](const OContentManagerRef& pContentManager) -> OResourceRef
+            {
+                return Tresource::createFromFile(filename, pContentManager);
+            };
+            return steps;
+        }
+    };
+
+    // For resources that don't touch the GPU, created entirely on the loader thread
+    template<typename Tresource>
+    struct AsyncLoaderCPU
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+        {
+            ContentManager::AsyncSteps steps;
+            steps.pResource = Tresource::createFromFile(filename, pContentManager);
+            return steps;
+        }
+    };
+
+    template<typename Tresource>
+    inline ContentManager::AsyncLoadRef ContentManager::loadAsync(const std::string& name, float priority, const std::function<void(const std::shared_ptr<Tresource>&)>& onLoaded)
+    {
+        AsyncCallback callback;
+        if (onLoaded)
+        {
+            callback = [onLoaded](const OResourceRef& pResource)
+            {
+                onLoaded(std::dynamic_pointer_cast<Tresource>(pResource));
+            };
+        }
+        return loadAsync(name, priority, &AsyncLoader<Tresource>::prepare, callback);
+    }
 }
 
 extern OContentManagerRef oContentManager;
 
+namespace onut
+{
+    // Reads through pContentManager, or oContentManager if null
+    FileData readResourceFile(const std::string& filename, OContentManagerRef pContentManager);
+}
+
 #endif
@@ -0,0 +1,85 @@
+#ifndef COOKEDTEXTURE_H_INCLUDED
+#define COOKEDTEXTURE_H_INCLUDED
+
+// Onut
+#include <onut/Point.h>
+
+// STL
+#include <cinttypes>
+#include <string>
+#include <vector>
+
+namespace onut
+{
+    /*!
+        Texture cooked offline (.otex), ready to upload: premultiplied alpha,
+        mip chain already generated, pixels as RGBA8 or BC1/BC3 blocks.
+        Renderers upload the blocks as is when the GPU supports the format,
+        and decompress them to RGBA8 when it doesn't.
+        Texture::createFromFile picks "name.otex" over "name.png" when both
+        are in the content search paths.
+    */
+    class CookedTexture final
+    {
+    public:
+        enum class Format : uint32_t
+        {
+            RGBA8 = 0,
+            BC1 = 1, // DXT1, RGB. 8:1
+            BC3 = 2 // DXT5, RGBA. 4:1
+        };
+
+        struct CookOptions
+        {
+            bool compress = true; // BC1 if opaque, BC3 if not. RGBA8 if the size isn't a multiple of 4
+            bool generateMipmaps = true;
+        };
+
+        struct Level
+        {
+            Point size;
+            const uint8_t* pData;
+            size_t dataSize;
+        };
+
+        static const char* EXTENSION; // "otex"
+
+        // From RGBA8 with straight alpha, like PNGs decode to
+        static std::vector<uint8_t> cook(const uint8_t* pImage, const Point& size);
+        static std::vector<uint8_t> cook(const uint8_t* pImage, const Point& size, const CookOptions& options);
+        static bool cookFile(const std::string& imageFilename, const std::string& cookedFilename, const CookOptions& options);
+
+        static bool isCooked(const uint8_t* pData, size_t dataSize);
+
+        // Levels point into pData, which must outlive this
+        bool read(const uint8_t* pData, size_t dataSize);
+
+        Format getFormat() const { return m_format; }
+        const Point& getSize() const { return m_size; }
+        const std::vector<Level>& getLevels() const { return m_levels; }
+        size_t getMemorySize() const; // All levels, as uploaded when the format is supported
+
+        // RGBA8 of one level, for GPUs without the format
+        std::vector<uint8_t> decompress(size_t level) const;
+
+        static size_t getLevelDataSize(Format format, const Point& size);
+
+    private:
+        struct Header
+        {
+            char signature[4];
+            uint32_t version;
+            Format format;
+            uint32_t width;
+            uint32_t height;
+            uint32_t levelCount;
+            uint32_t reserved[2];
+        };
+
+        Format m_format = Format::RGBA8;
+        Point m_size;
+        std::vector<Level> m_levels;
+    };
+}
+
+#endif
@@ -13,6 +13,7 @@ namespace onut
         uint32_t hash(const std::string& s, unsigned int seed = 0);
 
         std::string sha1(const std::string& str);
+        std::string sha1(const uint8_t* pData, size_t size);
 
         bool validateEmail(const std::string& email);
 
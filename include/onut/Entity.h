@@ -105,10 +105,20 @@ namespace onut
 
     private:
         friend class Component;
+        friend class ReplicationServer;
         friend class SceneManager;
 
         using Components = std::vector<OComponentRef>;
 
+        // Fields changed since the last replication capture
+        enum ReplicatedField : uint8_t
+        {
+            REPLICATED_TRANSFORM = 1,
+            REPLICATED_ENABLED = 2,
+            REPLICATED_VISIBLE = 4,
+            REPLICATED_ALL = 7
+        };
+
         Entity();
 
         void dirtyWorld();
@@ -128,6 +138,7 @@ namespace onut
         bool m_isStatic = false;
         int m_drawIndex = 0;
         std::string m_name;
+        uint8_t m_dirtyReplicatedFields = REPLICATED_ALL;
     };
 };
 
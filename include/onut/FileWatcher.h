@@ -0,0 +1,45 @@
+#ifndef FILEWATCHER_H_INCLUDED
+#define FILEWATCHER_H_INCLUDED
+
+// STL
+#include <functional>
+#include <memory>
+#include <string>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(FileWatcher);
+
+namespace onut
+{
+    /*!
+        Reports changes to files under watched folders, recursively.
+        Callbacks are called from the watcher thread. Use OSync to get
+        back on the main thread.
+    */
+    class FileWatcher
+    {
+    public:
+        enum class Event
+        {
+            Created,
+            Modified, // Written and closed, or moved in. Safe to read
+            Removed
+        };
+
+        using Callback = std::function<void(Event event, const std::string& filename)>;
+
+        // Returns nullptr if not supported on this platform
+        static OFileWatcherRef create();
+
+        virtual ~FileWatcher();
+
+        virtual bool watch(const std::string& path, const Callback& callback) = 0;
+        virtual void unwatch(const std::string& path) = 0;
+
+    protected:
+        FileWatcher();
+    };
+}
+
+#endif
@@ -3,11 +3,37 @@
 
 // STL
 #include <cinttypes>
+#include <memory>
 #include <string>
 #include <vector>
 
 namespace onut
 {
+    /*!
+        Content of a file. Either owns its bytes, or is a view into a memory
+        mapping that it keeps alive.
+    */
+    class FileData final
+    {
+    public:
+        FileData() = default;
+        FileData(std::vector<uint8_t>&& data);
+        FileData(const uint8_t* pData, size_t size, const std::shared_ptr<void>& pOwner);
+
+        const uint8_t* getData() const { return m_pOwner ? m_pData : m_data.data(); }
+        size_t getSize() const { return m_pOwner ? m_size : m_data.size(); }
+        bool isEmpty() const { return getSize() == 0; }
+
+        // View of part of a mapping, sharing it
+        FileData subData(const uint8_t* pData, size_t size) const { return FileData(pData, size, m_pOwner); }
+
+    private:
+        std::vector<uint8_t> m_data;
+        const uint8_t* m_pData = nullptr;
+        size_t m_size = 0;
+        std::shared_ptr<void> m_pOwner;
+    };
+
     struct FileType
     {
         std::string typeName;
@@ -24,6 +50,8 @@ namespace onut
     std::string getExtension(const std::string& filename);
     std::string makeRelativePath(const std::string& path, const std::string& relativeTo);
     std::vector<uint8_t> getFileData(const std::string& filename);
+    FileData mapFileData(const std::string& filename); // Read only. Empty if it can't be mapped
+    uint64_t getFileTime(const std::string& filename); // Last modification, 0 if it isn't a file on disk
     bool fileExists(const std::string& filename);
     std::string showOpenDialog(const std::string& caption, const FileTypes& extensions, const std::string& defaultFilename = "");
     std::string showSaveAsDialog(const std::string& caption, const FileTypes& extensions, const std::string& defaultFilename = "");
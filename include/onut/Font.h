@@ -2,10 +2,13 @@
 #define FONT_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
 #include <onut/Maths.h>
 #include <onut/Resource.h>
+#include <onut/SpriteBatch.h>
 
 // STL
+#include <cinttypes>
 #include <unordered_map>
 #include <vector>
 
@@ -19,6 +22,7 @@ OForwardDeclare(Texture)
 namespace onut
 {
     class SpriteBatch;
+    class TextLayout;
 
     class Font final : public Resource, public std::enable_shared_from_this<Font>
     {
@@ -27,6 +31,8 @@ namespace onut
 
         ~Font();
 
+        bool reload(const OContentManagerRef& pContentManager) override;
+
         Vector2 measure(const std::string& text);
         size_t caretPos(const std::string& text, float at);
 
@@ -47,6 +53,11 @@ namespace onut
                           const OSpriteBatchRef& pSpriteBatch = nullptr);
 
     private:
+        friend struct AsyncLoader<Font>;
+        friend class TextLayout;
+
+        static const int DENSE_CHAR_COUNT = 256; // Every byte a std::string can hold
+
         struct fntCommon
         {
             int lineHeight = 0;
@@ -78,16 +89,84 @@ namespace onut
             int xadvance = 0;
             int page = 0;
             int chnl = 0;
-            int displayList = 0;
+            Vector4 uvs;
+            bool hasKernings = false; // As the first of a pair
         };
 
         static int parseInt(const std::string& arg, const std::vector<std::string>& lineSplit);
         static std::string parseString(const std::string& arg, const std::vector<std::string>& lineSplit);
 
+        const fntChar* getChar(int id) const
+        {
+            if (id >= 0 && id < DENSE_CHAR_COUNT) return m_denseChars[id];
+            auto it = m_sparseChars.find(id);
+            return (it == m_sparseChars.end()) ? nullptr : it->second;
+        }
+
+        float getKerning(const fntChar* pFirst, int second) const
+        {
+            if (!pFirst->hasKernings) return 0.f;
+            auto it = m_kernings.find(getKerningKey(pFirst->id, second));
+            return (it == m_kernings.end()) ? 0.f : static_cast<float>(it->second);
+        }
+
+        static uint64_t getKerningKey(int first, int second)
+        {
+            return (static_cast<uint64_t>(static_cast<uint32_t>(first)) << 32) | static_cast<uint32_t>(second);
+        }
+
+        // Calls back with each glyph of the text, at its position from the
+        // top left of the first line, in the color it's drawn with
+        template<typename Tcallback>
+        void forEachGlyph(const std::string& text, const Color& color, Tcallback callback) const;
+
         fntCommon m_common;
         fntPage** m_pages = nullptr;
         int m_charsCount = 0;
-        std::unordered_map<int, fntChar*> m_chars;
+        std::vector<fntChar> m_chars;
+        const fntChar* m_denseChars[DENSE_CHAR_COUNT] = {};
+        std::unordered_map<int, const fntChar*> m_sparseChars;
+        std::unordered_map<uint64_t, int> m_kernings;
+    };
+
+    /*!
+        Text laid out once and drawn many times. Keeps the quads Font::draw
+        would produce and copies them straight into the sprite batch, for
+        labels whose text doesn't change every frame. Lay it out again if
+        the font reloads.
+    */
+    class TextLayout final
+    {
+    public:
+        void set(const OFontRef& pFont,
+                 const std::string& text,
+                 const Vector2& align = Vector2(0.f, 0.f),
+                 const Color& color = Color::White);
+        void clear();
+
+        Rect draw(const Vector2& pos, bool snapPixels = true, const OSpriteBatchRef& pSpriteBatch = nullptr) const;
+
+        const Vector2& getSize() const { return m_size; }
+
+    private:
+        struct Run
+        {
+            OTextureRef pTexture;
+            size_t firstQuad;
+            size_t quadCount;
+        };
+
+        std::vector<SpriteBatch::SVertexP2T2C4> m_vertices;
+        std::vector<Run> m_runs;
+        Vector2 m_size;
+        Vector2 m_alignOffset;
+    };
+
+    // Its pages are loaded first
+    template<>
+    struct AsyncLoader<Font>
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority);
     };
 }
 
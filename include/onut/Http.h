@@ -2,8 +2,12 @@
 #define HTTP_H_INCLUDED
 
 // STL
+#include <atomic>
+#include <cinttypes>
 #include <functional>
+#include <mutex>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 // Forward
@@ -30,30 +34,101 @@ namespace onut
         using GetCallback = std::function<void(Body)>;
         using GetStringCallback = PostCallback;
         using TextureCallback = std::function<void(OTextureRef)>;
+        using RequestId = uint64_t; // 0 is never a valid request
+
+        enum class Priority
+        {
+            Low,
+            Normal,
+            High
+        };
+
+        struct Response
+        {
+            long status = 0;
+            Body body;
+            std::string etag;
+            std::string lastModified;
+        };
+        using ResponseCallback = std::function<void(Response&)>;
 
         virtual std::string post(const std::string& url, const Body& body, const ErrorCallback& onError = nullptr) = 0;
         virtual Body get(const std::string& url, const Arguments& arguments, const ErrorCallback& onError = nullptr) = 0;
 
+        /*!
+            Conditional get, for caches. Sends If-None-Match/If-Modified-Since
+            when etag/lastModified are not empty. A 304 comes back with an empty body.
+        */
+        virtual Response getConditional(const std::string& url, const std::string& etag, const std::string& lastModified, const ErrorCallback& onError = nullptr);
+
         std::string post(const std::string& url, const ErrorCallback& onError = nullptr);
         std::string post(const std::string& url, const Arguments& arguments, const ErrorCallback& onError = nullptr);
 
-        void postAsync(const std::string& url, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
-        void postAsync(const std::string& url, const Body& body, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
-        void postAsync(const std::string& url, const Arguments& arguments, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId postAsync(const std::string& url, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId postAsync(const std::string& url, const Body& body, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId postAsync(const std::string& url, const Arguments& arguments, const PostCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
 
         Body get(const std::string& url, const ErrorCallback& onError = nullptr);
         std::string getString(const std::string& url, const ErrorCallback& onError = nullptr);
         std::string getString(const std::string& url, const Arguments& arguments, const ErrorCallback& onError = nullptr);
 
-        void getAsync(const std::string& url, const GetCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
-        void getAsync(const std::string& url, const Arguments& arguments, const GetCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
-        void getStringAsync(const std::string& url, const GetStringCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
-        void getStringAsync(const std::string& url, const Arguments& arguments, const GetStringCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getAsync(const std::string& url, const GetCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getAsync(const std::string& url, const Arguments& arguments, const GetCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getAsync(const std::string& url, const Arguments& arguments, Priority priority, const GetCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getStringAsync(const std::string& url, const GetStringCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getStringAsync(const std::string& url, const Arguments& arguments, const GetStringCallback& onSuccess = nullptr, const ErrorCallback& onError = nullptr);
+        RequestId getConditionalAsync(const std::string& url, const std::string& etag, const std::string& lastModified, Priority priority, const ResponseCallback& onResponse, const ErrorCallback& onError = nullptr);
+
+        /*!
+            Callbacks of a cancelled request are never called.
+            Call from the main thread.
+        */
+        void cancel(RequestId requestId);
+
+        // How many async requests can be in flight at once. The rest wait in priority order.
+        virtual void setMaxConcurrentRequests(int maxConcurrentRequests);
+
+        static std::string packArguments(const Http::Arguments& arguments);
+        static std::string makeUrl(const std::string& url, const Arguments& arguments);
 
     protected:
+        enum class Method
+        {
+            Get,
+            Post
+        };
+
+        struct AsyncRequest
+        {
+            RequestId id;
+            Method method;
+            std::string url; // Arguments already packed for Get
+            Body body;
+            std::string etag; // Validators for conditional Get
+            std::string lastModified;
+            Priority priority;
+            ResponseCallback onSuccess; // Raw response on the main thread, converted to what the user wants
+            ErrorCallback onError;
+            std::atomic<bool> isCancelled;
+        };
+        using AsyncRequestRef = std::shared_ptr<AsyncRequest>;
+
         Http();
 
-        static std::string packArguments(const Http::Arguments& arguments);
+        RequestId startAsync(Method method, const std::string& url, const Body& body, Priority priority, const ResponseCallback& onSuccess, const ErrorCallback& onError, const std::string& etag = "", const std::string& lastModified = "");
+
+        // Implementations call one of those from any thread when a request is done
+        void completeAsync(const AsyncRequestRef& pRequest, Response& response);
+        void failAsync(const AsyncRequestRef& pRequest, long errCode, const std::string& message);
+
+        // Default runs a blocking get/post on its own thread
+        virtual void performAsync(const AsyncRequestRef& pRequest);
+        virtual void cancelAsync(const AsyncRequestRef& pRequest);
+
+    private:
+        std::mutex m_asyncMutex;
+        std::unordered_map<RequestId, AsyncRequestRef> m_asyncRequests;
+        RequestId m_nextRequestId = 1;
     };
 };
 
@@ -66,8 +141,10 @@ extern OHttpRef oHttp;
 #define OHttpGetString oHttp->getString
 #define OHttpGetStringAsync oHttp->getStringAsync
 
+// Textures go through oHttpCache: decoded ones are shared while in use, downloaded
+// files are kept on disk. Cached files are revalidated, and used as is when offline.
 OTextureRef OHTTPGetTexture(const std::string& url, const onut::Http::Arguments& arguments = {}, const onut::Http::ErrorCallback& onError = nullptr);
-void OHTTPGetTextureAsync(const std::string& url, const onut::Http::Arguments& arguments, const onut::Http::TextureCallback& onSuccess = nullptr, const onut::Http::ErrorCallback& onError = nullptr);
-void OHTTPGetTextureAsync(const std::string& url, const onut::Http::TextureCallback& onSuccess = nullptr, const onut::Http::ErrorCallback& onError = nullptr);
+onut::Http::RequestId OHTTPGetTextureAsync(const std::string& url, const onut::Http::Arguments& arguments, const onut::Http::TextureCallback& onSuccess = nullptr, const onut::Http::ErrorCallback& onError = nullptr);
+onut::Http::RequestId OHTTPGetTextureAsync(const std::string& url, const onut::Http::TextureCallback& onSuccess = nullptr, const onut::Http::ErrorCallback& onError = nullptr);
 
 #endif
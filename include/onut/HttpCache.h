@@ -0,0 +1,135 @@
+#ifndef HTTPCACHE_H_INCLUDED
+#define HTTPCACHE_H_INCLUDED
+
+// Onut
+#include <onut/Http.h>
+
+// STL
+#include <cinttypes>
+#include <list>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(HttpCache);
+OForwardDeclare(Texture);
+
+namespace onut
+{
+    /*!
+        On-disk cache of http responses, in front of Http::get.
+        Files are named after the sha1 of their content, so urls serving the
+        same bytes share one file, and a changed response never overwrites a
+        file someone has mapped. Entries are found by the sha1 of their url
+        and keep its ETag/Last-Modified, so OHTTPGetTexture can ask the
+        server whether they are still good. A 304 keeps the file, a 200
+        replaces the entry. The least recently used entries are dropped once
+        the files grow over maxSize.
+        Also remembers the textures decoded from those urls, for as long as
+        they are in use.
+        Thread safe.
+    */
+    class HttpCache final
+    {
+    public:
+        // Read only memory mapping of a cached file. Stays valid even if the entry gets evicted.
+        class View final
+        {
+        public:
+            ~View();
+
+            const uint8_t* getData() const { return m_pData; }
+            size_t getSize() const { return m_size; }
+
+        private:
+            friend class HttpCache;
+
+            View() = default;
+
+            const uint8_t* m_pData = nullptr;
+            size_t m_size = 0;
+#if defined(WIN32)
+            void* m_hFile = nullptr;
+            void* m_hMapping = nullptr;
+#else
+            int m_fd = -1;
+#endif
+        };
+        using ViewRef = std::shared_ptr<View>;
+
+        static OHttpCacheRef create(const std::string& path, size_t maxSize);
+
+        // Per user cache folder for this app, like ~/.cache/appName/httpcache.
+        // Next to the executable if there is no user folder
+        static std::string getUserPath(const std::string& appName);
+
+        ~HttpCache();
+
+        // Validators to send with the next request. Returns false if not cached
+        bool getValidators(const std::string& url, std::string& etag, std::string& lastModified);
+
+        // nullptr if not cached
+        ViewRef open(const std::string& url);
+
+        // Stores a 200, returns the new view of it
+        ViewRef store(const std::string& url, const Http::Response& response);
+
+        void remove(const std::string& url);
+        void clear();
+
+        size_t getSize();
+        size_t getMaxSize() const { return m_maxSize; }
+        void setMaxSize(size_t maxSize);
+
+        // Decoded textures, by url. Not kept alive
+        OTextureRef getTexture(const std::string& url);
+        void setTexture(const std::string& url, const OTextureRef& pTexture);
+        void clearTextures();
+
+    private:
+        struct Entry
+        {
+            std::string key; // sha1 of the url
+            std::string contentKey; // sha1 of the body, also the filename
+            size_t size;
+            std::string etag;
+            std::string lastModified;
+        };
+        using Entries = std::list<Entry>; // Most recently used at the back
+
+        HttpCache(const std::string& path, size_t maxSize);
+
+        static ViewRef mapFile(const std::string& filename);
+
+        std::string getFilename(const std::string& key) const;
+        Entries::iterator find(const std::string& key);
+        void touch(Entries::iterator it);
+        void addContent(const Entry& entry);
+        void releaseContent(const Entry& entry);
+        void evict();
+        void erase(Entries::iterator it);
+        void loadIndex();
+        void saveIndex();
+
+        std::string m_path;
+        size_t m_maxSize;
+        size_t m_size = 0;
+        bool m_isIndexDirty = false;
+
+        std::mutex m_mutex;
+        Entries m_entries;
+        std::unordered_map<std::string, Entries::iterator> m_entriesByKey;
+        std::unordered_map<std::string, int> m_contentRefCounts; // Entries per file
+
+        std::mutex m_texturesMutex;
+        std::unordered_map<std::string, OTextureWeak> m_textures;
+        size_t m_texturesSweepSize = 64; // Released ones are forgotten when it grows past this
+    };
+}
+
+// Created on first use by OHTTPGetTexture
+extern OHttpCacheRef oHttpCache;
+
+#endif
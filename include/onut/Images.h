@@ -6,6 +6,7 @@
 
 // STL
 #include <cinttypes>
+#include <functional>
 #include <string>
 #include <vector>
 
@@ -16,11 +17,29 @@
 
 namespace onut
 {
+    /*!
+        Decodes an image format to RGBA8. getSize returns false when the data
+        isn't something this decoder handles. decode writes size.x * size.y * 4
+        bytes to pOut, the caller's buffer.
+    */
+    struct ImageDecoder
+    {
+        std::function<bool(const uint8_t* pData, size_t dataSize, Point& size)> getSize;
+        std::function<bool(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply)> decode;
+    };
+
+    // Decoders added last are tried first. The built-in ones decode PNG
+    void addImageDecoder(const ImageDecoder& decoder);
+    bool getImageSize(const uint8_t* pData, size_t dataSize, Point& size);
+    bool decodeImage(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply = false);
+    std::vector<uint8_t> decodeImage(const uint8_t* pData, size_t dataSize, Point& size, bool premultiply = false); // Empty on failure
+
     bool savePNG(const std::string& filename, const std::vector<uint8_t>& data, const Point& size);
     std::vector<uint8_t> convertToPNG(const std::vector<uint8_t>& data, const Point& size);
     std::vector<uint8_t> convertToPNG(const uint8_t* pData, const Point& size);
     std::vector<uint8_t> loadPNG(const std::string& filename, Point& size);
     std::vector<uint8_t> loadPNG(const std::vector<uint8_t>& data, Point& size);
+    std::vector<uint8_t> loadPNG(const uint8_t* pData, size_t dataSize, Point& size);
 #if defined(WIN32)
     HCURSOR pngToCursor(const std::string& filename, const Point& center);
 #endif
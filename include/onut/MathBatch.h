@@ -0,0 +1,32 @@
+#ifndef MATHBATCH_H_INCLUDED
+#define MATHBATCH_H_INCLUDED
+
+// Onut
+#include <onut/Matrix.h>
+#include <onut/Tween.h>
+#include <onut/Vector4.h>
+
+// STL
+#include <cinttypes>
+#include <cstddef>
+
+namespace onut
+{
+    // Math on many values at once. Arrays are split per component (all the x,
+    // then all the y), 4 values per SSE2 or NEON instruction, scalar elsewhere.
+    // Outputs can be the inputs. Results match the per value operators.
+
+    // 2D part of the transform, like Vector2::Transform with an affine matrix
+    void transformPoints(const float* pX, const float* pY, float* pOutX, float* pOutY, size_t count, const Matrix& transform);
+
+    // 1 in pVisible for boxes touching the view {x, y, w, h}, 0 for the others.
+    // Returns how many are visible
+    size_t cullBoxes(const float* pMinX, const float* pMinY, const float* pMaxX, const float* pMaxY, size_t count, const Rect& view, uint8_t* pVisible);
+
+    // pOut = pFrom + (pTo - pFrom) * t
+    void lerpValues(const float* pFrom, const float* pTo, float t, float* pOut, size_t count);
+    void lerpValues(const float* pFrom, const float* pTo, const float* pT, float* pOut, size_t count);
+    void tweenValues(const float* pFrom, const float* pTo, float t, Tween tween, float* pOut, size_t count);
+}
+
+#endif
@@ -2,6 +2,7 @@
 #define MUSIC_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
 #include <onut/Resource.h>
 
 // Forward
@@ -31,6 +32,8 @@ namespace onut
     protected:
         Music();
     };
+
+    template<> struct AsyncLoader<Music> : public AsyncLoaderCPU<Music> {};
 }
 
 OMusicRef OGetMusic(const std::string& name);
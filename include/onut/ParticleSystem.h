@@ -254,6 +254,9 @@ namespace onut
 
         const Emitters& getEmitters() const;
 
+        // Emitters already playing keep the old descriptions
+        bool reload(const OContentManagerRef& pContentManager) override;
+
     private:
         Emitters m_emitters;
     };
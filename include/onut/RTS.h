@@ -1,22 +1,41 @@
 #ifndef RTS_H_INCLUDED
 #define RTS_H_INCLUDED
 
-// Onut
+// System
+#if defined(WIN32)
+#include <winsock2.h>
 #include <Windows.h>
-#include <string>
+#else
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#endif
+
+// STL
+#include <atomic>
+#include <chrono>
 #include <cinttypes>
-#include <vector>
+#include <cstring>
+#include <functional>
+#include <string>
 #include <thread>
-#include <atomic>
 #include <unordered_map>
-
-// Forward
-#include <onut/ForwardDeclaration.h>
-OForwardDeclare(Dispatcher);
+#include <vector>
 
 namespace onut
 {
+#if defined(WIN32)
+    using RTSSocketHandle = SOCKET;
+    static const RTSSocketHandle InvalidRTSSocket = INVALID_SOCKET;
+#else
+    using RTSSocketHandle = int;
+    static const RTSSocketHandle InvalidRTSSocket = -1;
+#endif
+
     static const int packetSize = 1400;
+    static const int turnCount = 64; // turnId is 6 bits
+    static const int recvRingSize = 256; // Must be a power of 2
+    static const int recvBatchSize = 32;
 
     class Object
     {
@@ -41,19 +60,23 @@ namespace onut
         uint8_t connection : 1;
         uint64_t playerId;
     };
+
+    /*!
+        Turn acks carry the full set of turns received by the peer, so a
+        single lost ack is recovered by the next one and the sender only
+        resends what is really missing.
+    */
+    struct sAckPacket
+    {
+        sPacketHeader header;
+        uint64_t ackBits; // Bit N set = turnId N received
+    };
 #pragma pack (pop)
 
     struct sPacket
     {
         sPacket() {}
 
-        sPacket(char *in, int in_size, const sockaddr_in& in_from)
-        {
-            size = std::min<>(in_size, packetSize);
-            from = in_from;
-            memcpy(pBuf, in, packetSize);
-        }
-
         sPacket(const sPacket &other)
         {
             size = other.size;
@@ -66,26 +89,50 @@ namespace onut
             sPacketHeader header;
             uint8_t pBuf[packetSize];
         };
-        int size;
+        int size = 0;
         sockaddr_in from;
     };
 
+    /*!
+        Preallocated single producer / single consumer packet ring. The
+        receive thread reads datagrams straight into the free slots, and the
+        main thread consumes them in place.
+    */
+    class RTSPacketRing
+    {
+    public:
+        // Producer side. Returns contiguous free slots, up to maxCount
+        int acquire(sPacket **ppOut, int maxCount);
+        void commit(int count);
+
+        // Consumer side
+        sPacket *front();
+        void pop();
+
+    private:
+        sPacket m_packets[recvRingSize];
+        std::atomic<uint32_t> m_head{0}; // Written by the consumer
+        std::atomic<uint32_t> m_tail{0}; // Written by the producer
+    };
+
     class RTSSocket : public Object
     {
     public:
         RTSSocket();
-        RTSSocket(SOCKET parentSocket);
+        RTSSocket(RTSSocketHandle parentSocket);
         virtual ~RTSSocket();
 
-        bool                isValid() const { return m_sock != INVALID_SOCKET; }
-        SOCKET              getSock() const { return m_sock; }
+        bool                isValid() const { return m_sock != InvalidRTSSocket; }
+        RTSSocketHandle     getSock() const { return m_sock; }
         const std::string&  getIPPort() const { return m_ipport; };
         void                setIPPort(const std::string& ipPort);
         const sockaddr_in  &getAddr() const { return m_addr; }
         void                setAddr(const sockaddr_in& addr);
 
     private:
-        SOCKET m_sock = INVALID_SOCKET;
+        void closeSock();
+
+        RTSSocketHandle m_sock = InvalidRTSSocket;
         std::string m_ipport;
         sockaddr_in m_addr;
         bool m_ownSocket = false;
@@ -114,12 +161,10 @@ namespace onut
     private:
         friend class RTS;
 
-        void queueTurn(const sPacket& packet);
-        bool isReadyForTurn(uint8_t turn);
-        void extractTurn(uint8_t turn, sPacket *pOut);
-        void sendPacket(const sPacket& packet);
-        void resendPackets();
-        void ackReceived(uint8_t turn);
+        bool queueTurn(const sPacket& packet);
+        bool isReadyForTurn(uint8_t turn) const;
+        const sPacket *extractTurn(uint8_t turn);
+        void ackReceived(uint64_t ackBits);
         void connectionAckReceived(const sPacket& packet);
         void updateConnection(uint64_t parentPlayerId);
         void keepAlive();
@@ -128,15 +173,17 @@ namespace onut
         RTSSocket *m_pSocket;
         std::string m_ipPort;
         uint64_t m_playerId;
-        uint8_t m_currentTurn = 0; // 0 - 127
+        uint8_t m_currentTurn = 0; // 0 - 63
         bool m_isConnected = false;
         std::vector<std::string> m_ips;
         std::string m_port;
         int m_connectionTries = 0;
         int m_connectionAttemptId = 0;
 
-        std::vector<sPacket> queuedTurns;
-        std::vector<sPacket> sending;
+        sPacket m_turns[turnCount]; // Indexed by turnId
+        uint64_t m_queuedBits = 0; // Received, not yet processed
+        uint64_t m_receivedBits = 0; // Received within the ack window. What we ack back
+        uint64_t m_unackedBits = 0; // Our turns this peer didn't ack yet
     };
 
     class RTS : public Object
@@ -166,24 +213,28 @@ namespace onut
 
         void stopRecvThread();
         void startRecvThread();
+        void processPackets();
         void onPacket(const sPacket& packet);
         RTSPeer *getPeerFromPacket(const sPacket& packet);
         bool processTurn();
         bool arePlayersReadyForTurn(uint8_t turn);
-        void processCommands(uint8_t *pCommands, int size, RTSPeer *pPeer);
+        void processCommands(const uint8_t *pCommands, int size, RTSPeer *pPeer);
         sCmd *getCommand(uint8_t cmdId);
+        void sendTurn(uint8_t turnId);
         void resendPackets();
         void updateConnections();
         void keepAlive();
         bool arePeersConnected() const;
-        void extractTurn(uint8_t turn, sPacket *pOut);
+        sPacket *prepareTurn(uint8_t turnId);
 
+#if defined(WIN32)
         WSADATA m_wsa;
+#endif
         RTSSocket *m_pMySocket = nullptr;
         std::vector<RTSPeer *> m_peers;
         std::thread *m_pRecvThread = nullptr;
-        std::atomic<bool> m_isRecvThreadValid = false;
-        ODispatcherRef m_pDispatcher;
+        std::atomic<bool> m_isRecvThreadValid{false};
+        RTSPacketRing m_recvRing;
         uint8_t m_currentTurn = 0;
         uint32_t m_realTurn = 0;
         bool m_isStarted = false;
@@ -192,9 +243,10 @@ namespace onut
         std::chrono::steady_clock::time_point lastConnectionAttempt;
         std::chrono::steady_clock::time_point lastKeepAlive;
         std::unordered_map<uint8_t, sCmd> commands;
-        sPacket m_commandBuffer;
         uint64_t m_myPlayerId;
-        std::vector<sPacket> queuedTurns; // Those are mine
+        sPacket m_myTurns[turnCount]; // Those are mine. Sent to peers from here, never copied
+        uint64_t m_myQueuedBits = 0;
+        sPacket *m_pCommandBuffer = nullptr; // Turn being filled by sendCommand
         int m_frame = 0; // Turn frame. 15 Frame per turn (FPT)
     };
 };
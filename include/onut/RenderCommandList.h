@@ -0,0 +1,149 @@
+#ifndef RENDERCOMMANDLIST_H_INCLUDED
+#define RENDERCOMMANDLIST_H_INCLUDED
+
+// Onut
+#include <onut/BlendMode.h>
+#include <onut/Maths.h>
+#include <onut/PrimitiveMode.h>
+#include <onut/SampleMode.h>
+
+// STL
+#include <cinttypes>
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(IndexBuffer);
+OForwardDeclare(RenderCommandList);
+OForwardDeclare(Renderer);
+OForwardDeclare(Shader);
+OForwardDeclare(Texture);
+OForwardDeclare(VertexBuffer);
+
+namespace onut
+{
+    /*!
+        Render states, uploads and draws recorded for later. Any thread can
+        record into its own list, without touching the renderer. Submit it
+        to the renderer and the render thread replays every submitted list
+        in sort key order. Don't record into a list again until it was
+        replayed, use one per thread per frame in flight.
+    */
+    class RenderCommandList final
+    {
+    public:
+        static ORenderCommandListRef create(int sortKey = 0);
+
+        RenderCommandList(int sortKey = 0);
+
+        // Lower keys replay first. Same keys replay in submit order
+        void setSortKey(int sortKey) { m_sortKey = sortKey; }
+        int getSortKey() const { return m_sortKey; }
+
+        // Empties the list and keeps its memory
+        void reset();
+        bool isEmpty() const { return m_commands.empty(); }
+
+        void clear(const Color& color = {.25f, .5f, 1, 1});
+        void clearDepth();
+
+        void setTexture(const OTextureRef& pTexture, int slot = 0);
+        void setBlendMode(BlendMode blendMode);
+        void setSampleFiltering(sample::Filtering filtering);
+        void setSampleAddressMode(sample::AddressMode addressMode);
+        void setViewport(const iRect& viewport);
+        void setScissor(const iRect& scissor);
+        void setScissorEnabled(bool enabled);
+        void setProjection(const Matrix& projection);
+        void setView(const Matrix& view);
+        void setWorld(const Matrix& world);
+        void setDepthEnabled(bool enabled);
+        void setDepthWrite(bool enabled);
+        void setBackFaceCull(bool enabled);
+        void setPrimitiveMode(PrimitiveMode primitiveMode);
+        void setVertexShader(const OShaderRef& pShader);
+        void setPixelShader(const OShaderRef& pShader);
+        void setVertexBuffer(const OVertexBufferRef& pVertexBuffer);
+        void setIndexBuffer(const OIndexBufferRef& pIndexBuffer);
+        void setRenderTarget(const OTextureRef& pRenderTarget);
+
+        // Renderer::setupFor2D, with the viewport at replay
+        void setupFor2D(const Matrix& transform = Matrix::Identity);
+
+        // The data is copied now, and written to the dynamic buffer at replay
+        void uploadVertices(const OVertexBufferRef& pVertexBuffer, const void* pVertexData, uint32_t size);
+        void uploadIndices(const OIndexBufferRef& pIndexBuffer, const void* pIndexData, uint32_t size);
+
+        void draw(uint32_t vertexCount);
+        void drawIndexed(uint32_t indexCount);
+
+        // Render thread only
+        void execute(Renderer& renderer) const;
+
+    private:
+        enum class CommandType : uint8_t
+        {
+            Clear,
+            ClearDepth,
+            Texture,
+            BlendMode,
+            SampleFiltering,
+            SampleAddressMode,
+            Viewport,
+            Scissor,
+            ScissorEnabled,
+            Projection,
+            View,
+            World,
+            DepthEnabled,
+            DepthWrite,
+            BackFaceCull,
+            PrimitiveMode,
+            VertexShader,
+            PixelShader,
+            VertexBuffer,
+            IndexBuffer,
+            RenderTarget,
+            SetupFor2D,
+            UploadVertices,
+            UploadIndices,
+            Draw,
+            DrawIndexed
+        };
+
+        struct Command
+        {
+            CommandType type;
+            uint8_t slot; // Texture slot
+            uint32_t value; // Count, enum, bool, or index into the resources
+            uint32_t dataOffset;
+            uint32_t dataSize;
+        };
+
+        void add(CommandType type, uint32_t value, uint8_t slot = 0);
+        void addData(CommandType type, uint32_t value, const void* pData, uint32_t size);
+
+        template<typename Ttype>
+        void addValue(CommandType type, const Ttype& value)
+        {
+            addData(type, 0, &value, sizeof(Ttype));
+        }
+
+        template<typename Ttype>
+        static uint32_t addResource(std::vector<Ttype>& resources, const Ttype& pResource)
+        {
+            resources.push_back(pResource);
+            return static_cast<uint32_t>(resources.size() - 1);
+        }
+
+        int m_sortKey = 0;
+        std::vector<Command> m_commands;
+        std::vector<uint8_t> m_data; // Matrices, rects, colors and uploads
+        std::vector<OTextureRef> m_textures; // Kept alive until the list is reset
+        std::vector<OShaderRef> m_shaders;
+        std::vector<OVertexBufferRef> m_vertexBuffers;
+        std::vector<OIndexBufferRef> m_indexBuffers;
+    };
+}
+
+#endif
@@ -9,11 +9,13 @@
 #include <onut/SampleMode.h>
 
 // STL
+#include <mutex>
 #include <vector>
 
 // Forward
 #include <onut/ForwardDeclaration.h>
 OForwardDeclare(IndexBuffer)
+OForwardDeclare(RenderCommandList)
 OForwardDeclare(Renderer)
 OForwardDeclare(Shader)
 OForwardDeclare(Texture)
@@ -132,6 +134,7 @@ namespace onut
         RenderState<OShaderRef> vertexShader;
         RenderState<OShaderRef> pixelShader;
         RenderState<OVertexBufferRef> vertexBuffer;
+        RenderState<OVertexBufferRef> instanceBuffer; // For vertex shaders with per instance elements
         RenderState<OIndexBufferRef> indexBuffer;
         RenderState<OTextureRef> renderTarget;
         RenderState<Color> clearColor;
@@ -165,6 +168,13 @@ namespace onut
         virtual void draw(uint32_t vertexCount) = 0;
         virtual void drawIndexed(uint32_t indexCount) = 0;
 
+        // Draws the indexed vertices once per instance of the instance buffer.
+        // Only if get2DInstancedVertexShader isn't null
+        virtual void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount);
+
+        // 2D vertex shader taking SpriteBatch::SInstance, null if the renderer can't instance
+        const OShaderRef& get2DInstancedVertexShader() const { return m_p2DInstancedVertexShader; }
+
         Point getResolution() const;
         virtual Point getTrueResolution() const = 0;
         virtual void onResize(const Point& newSize) = 0;
@@ -184,6 +194,22 @@ namespace onut
         void drawCartoon();
         void drawVignette();
 
+        // Graphics API calls of the last frame, counted by the OpenGL renderer
+        struct CallStats
+        {
+            uint32_t drawCalls = 0;
+            uint32_t stateCalls = 0; // Blend, raster, depth, viewport, scissor and render target
+            uint32_t textureBinds = 0;
+            uint32_t samplerBinds = 0; // Texture parameters when there are no sampler objects
+            uint32_t skippedCalls = 0; // Dirty states that were already set on the device
+        };
+        const CallStats& getCallStats() const { return m_lastFrameCallStats; }
+
+        // Command lists. Submit from any thread, replayed in sort key order by
+        // executeCommandLists on the render thread. Render states are restored after
+        void submit(const ORenderCommandListRef& pCommandList);
+        void executeCommandLists();
+
         virtual void applyRenderStates() = 0;
         virtual void init(const OWindowRef& pWindow);
 
@@ -199,6 +225,7 @@ namespace onut
 
         OShaderRef m_p2DVertexShader;
         OShaderRef m_p2DPixelShader;
+        OShaderRef m_p2DInstancedVertexShader;
         OShaderRef m_pEffectsVertexShader;
         OShaderRef m_pBlurHPixelShader;
         OShaderRef m_pBlurVPixelShader;
@@ -206,6 +233,13 @@ namespace onut
         OShaderRef m_pCRTPixelShader;
         OShaderRef m_pCartoonPixelShader;
         OShaderRef m_pVignettePixelShader;
+
+        CallStats m_callStats;
+        CallStats m_lastFrameCallStats;
+
+        std::mutex m_commandListsMutex;
+        std::vector<ORenderCommandListRef> m_submittedCommandLists;
+        std::vector<ORenderCommandListRef> m_executingCommandLists;
     };
 }
 
@@ -0,0 +1,74 @@
+#ifndef RENDERERNULL_H_INCLUDED
+#define RENDERERNULL_H_INCLUDED
+
+// Onut
+#include <onut/Point.h>
+#include <onut/Renderer.h>
+
+// STL
+#include <cinttypes>
+#include <cstddef>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(RendererNull);
+
+namespace onut
+{
+    /*!
+        Renderer that draws nothing, for benchmarks and tests on machines
+        without a GPU. Built instead of the platform's renderer with
+        ONUT_USE_NULL_RENDERER. Render states are applied the way the real
+        renderers apply them, and what would reach the GPU is counted.
+        It doesn't need a window: Renderer::create(nullptr) then init(nullptr).
+    */
+    class RendererNull final : public Renderer
+    {
+    public:
+        struct Counters
+        {
+            uint32_t frames = 0;
+            uint32_t clears = 0;
+            uint32_t drawCalls = 0;
+            uint32_t vertexCount = 0; // Indices for indexed draws
+            uint32_t stateChanges = 0; // Dirty states applied. Each texture slot is one
+            uint32_t textureChanges = 0;
+            uint32_t shaderChanges = 0;
+            uint32_t renderTargetChanges = 0;
+            uint64_t uploadedBytes = 0; // Textures, buffers and shader uniforms
+        };
+
+        RendererNull(const OWindowRef& pWindow);
+
+        void clear(const Color& color = {.25f, .5f, 1, 1}) override;
+        void clearDepth() override;
+
+        void beginFrame() override;
+        void endFrame() override;
+
+        void draw(uint32_t vertexCount) override;
+        void drawIndexed(uint32_t indexCount) override;
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount) override;
+
+        Point getTrueResolution() const override;
+        void onResize(const Point& newSize) override;
+
+        void applyRenderStates() override;
+        void init(const OWindowRef& pWindow) override;
+
+        const Counters& getCounters() const { return m_counters; }
+        void resetCounters() { m_counters = Counters(); }
+
+        // Called by the null textures, buffers and shaders
+        static void countUpload(size_t size);
+
+    private:
+        template<typename Ttype>
+        bool applyState(RenderState<Ttype>& state);
+
+        Point m_resolution;
+        Counters m_counters;
+    };
+}
+
+#endif
@@ -0,0 +1,173 @@
+#ifndef REPLICATION_H_INCLUDED
+#define REPLICATION_H_INCLUDED
+
+// STL
+#include <cinttypes>
+#include <functional>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(Entity);
+OForwardDeclare(ReplicationClient);
+OForwardDeclare(ReplicationServer);
+
+namespace onut
+{
+    /*!
+        Snapshot replication of entity states, for action games where lockstep
+        (RTS) doesn't fit. Transport agnostic: the server writes one snapshot
+        per client per network tick, sends it however it wants (Unreliable is
+        fine), and the client acks back the tick returned by readSnapshot.
+
+        The local transform (2D position, rotation and uniform scale), enabled
+        and visible flags are replicated. States are quantized, and each entity
+        is delta encoded against the last state its client acked. Entities
+        that don't fit in the snapshot's byte budget accumulate priority, so
+        everything gets through eventually.
+    */
+    namespace replication
+    {
+        using NetworkId = uint32_t;
+        using Tick = uint32_t;
+
+        // Position in 1/16 units, angle in 1/65536 turns, scale in 1/256
+        static const float POSITION_PRECISION = 16.0f;
+        static const float SCALE_PRECISION = 256.0f;
+
+        // How far back, in ticks, a state can be used as delta baseline
+        static const Tick HISTORY_SIZE = 64;
+
+        struct State
+        {
+            int32_t x;
+            int32_t y;
+            uint16_t angle;
+            uint16_t scale;
+            uint8_t flags;
+
+            bool operator==(const State& other) const;
+            bool operator!=(const State& other) const { return !(*this == other); }
+        };
+    }
+
+    class ReplicationServer final
+    {
+    public:
+        using ClientId = uint32_t;
+
+        static OReplicationServerRef create();
+
+        ~ReplicationServer();
+
+        // Higher priority entities are sent more often when the budget is tight
+        replication::NetworkId add(const OEntityRef& pEntity, float priority = 1.0f);
+        void remove(const OEntityRef& pEntity);
+        void setPriority(const OEntityRef& pEntity, float priority);
+
+        ClientId addClient();
+        void removeClient(ClientId clientId);
+
+        // Captures changed entities. Call once per network tick, before writing snapshots
+        void update();
+        replication::Tick getTick() const { return m_tick; }
+
+        // Returns the snapshot size, never more than maxSize
+        size_t writeSnapshot(ClientId clientId, uint8_t* pOut, size_t maxSize);
+        void onAck(ClientId clientId, replication::Tick tick);
+
+    private:
+        struct Slot
+        {
+            OEntityRef pEntity;
+            replication::NetworkId id = 0;
+            float priority = 1.0f;
+            replication::State state;
+        };
+
+        struct ClientSlot
+        {
+            replication::NetworkId id = 0; // Id this was tracked for. Slots get reused
+            replication::Tick ackedTick = 0; // 0 means the client doesn't have it
+            replication::State acked;
+            float priority = 0.0f;
+        };
+
+        struct Sent
+        {
+            uint32_t slot;
+            replication::NetworkId id;
+            replication::State state;
+        };
+
+        struct SentSnapshot
+        {
+            replication::Tick tick = 0;
+            std::vector<Sent> entities;
+        };
+
+        struct Removal
+        {
+            replication::NetworkId id;
+            replication::Tick firstSentTick;
+        };
+
+        struct Client
+        {
+            std::vector<ClientSlot> slots;
+            std::vector<Removal> removals;
+            SentSnapshot history[replication::HISTORY_SIZE];
+            std::vector<uint32_t> candidates;
+        };
+        using ClientRef = std::shared_ptr<Client>;
+
+        ReplicationServer();
+
+        std::vector<Slot> m_slots;
+        std::vector<uint32_t> m_freeSlots;
+        std::unordered_map<OEntity*, uint32_t> m_slotsByEntity;
+        std::unordered_map<ClientId, ClientRef> m_clients;
+        replication::NetworkId m_nextId = 1;
+        ClientId m_nextClientId = 1;
+        replication::Tick m_tick = 0;
+    };
+
+    class ReplicationClient final
+    {
+    public:
+        using CreateCallback = std::function<OEntityRef(replication::NetworkId id)>;
+        using DestroyCallback = std::function<void(replication::NetworkId id, const OEntityRef& pEntity)>;
+
+        // onCreate makes the local entity for a new id. By default removed entities are destroyed
+        static OReplicationClientRef create(const CreateCallback& onCreate, const DestroyCallback& onDestroy = nullptr);
+
+        ~ReplicationClient();
+
+        // Returns the tick to ack back to the server, 0 if the snapshot was dropped
+        replication::Tick readSnapshot(const uint8_t* pData, size_t size);
+
+        OEntityRef getEntity(replication::NetworkId id) const;
+        size_t getEntityCount() const { return m_entities.size(); }
+
+    private:
+        struct Replica
+        {
+            OEntityRef pEntity;
+            replication::Tick lastTick = 0;
+            replication::Tick historyTicks[replication::HISTORY_SIZE];
+            replication::State history[replication::HISTORY_SIZE];
+        };
+        using ReplicaRef = std::shared_ptr<Replica>;
+
+        ReplicationClient();
+
+        CreateCallback m_onCreate;
+        DestroyCallback m_onDestroy;
+        std::unordered_map<replication::NetworkId, ReplicaRef> m_entities;
+        replication::Tick m_lastTick = 0;
+    };
+}
+
+#endif
@@ -2,10 +2,12 @@
 #define RESOURCE_H_INCLUDED
 
 // STL
+#include <cinttypes>
 #include <string>
 
 // Forward
 #include <onut/ForwardDeclaration.h>
+OForwardDeclare(ContentManager);
 OForwardDeclare(Resource);
 
 namespace onut
@@ -13,8 +15,24 @@ namespace onut
     class Resource
     {
     public:
+        enum class MemoryCategory
+        {
+            Texture, // GPU
+            Sound, // PCM samples
+            Other
+        };
+        static const int MEMORY_CATEGORY_COUNT = 3;
+
         virtual ~Resource();
 
+        // Approximate memory held, for ContentManager's budgets
+        virtual MemoryCategory getMemoryCategory() const { return MemoryCategory::Other; }
+        virtual size_t getMemorySize() const { return 0; }
+
+        // Loads its file again into this same object, so whoever holds it sees the change.
+        // False if it couldn't, or if this type of resource doesn't support it
+        virtual bool reload(const OContentManagerRef& /*pContentManager*/) { return false; }
+
         void setName(const std::string& name);
         const std::string& getName() const;
 
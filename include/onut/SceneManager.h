@@ -2,11 +2,15 @@
 #define SCENEMANAGER_H_INCLUDED
 
 
+// Onut includes
+#include <onut/Maths.h>
+
 // Third parties
 #include <list/List.h>
 
 // STL
 #include <set>
+#include <unordered_map>
 #include <vector>
 
 // Forward declarations
@@ -15,8 +19,12 @@ OForwardDeclare(Collider2DComponent);
 OForwardDeclare(Camera2DComponent);
 OForwardDeclare(Component);
 OForwardDeclare(Entity);
+OForwardDeclare(IndexBuffer);
 OForwardDeclare(SceneManager);
+OForwardDeclare(SpriteComponent);
+OForwardDeclare(Texture);
 OForwardDeclare(Updater);
+OForwardDeclare(VertexBuffer);
 class b2Contact;
 class b2World;
 
@@ -54,6 +62,9 @@ namespace onut
         friend class Entity;
         friend class Component;
         friend class Physic2DContactListener;
+        friend class SpriteComponent;
+
+        static const int STATIC_CHUNK_SIZE = 256;
 
         using Components = std::vector<OComponentRef>;
         using EntitySet = std::set<OEntityRef>;
@@ -88,8 +99,29 @@ namespace onut
             OCollider2DComponentRef pColliderB;
         };
 
+        // Consecutive static sprites of the render 2D list with the same texture,
+        // baked in draw order. Only rebuilt when one of its sprites changes
+        struct StaticChunk
+        {
+            std::vector<SpriteComponent*> sprites;
+            OTextureRef pTexture;
+            OVertexBufferRef pVertexBuffer;
+            Vector2 boundsMin;
+            Vector2 boundsMax;
+            bool isDirty = true;
+        };
+
+        // Render 2D list with the static sprites replaced by their chunk
+        struct Render2DItem
+        {
+            Component* pComponent; // Null for a static chunk
+            size_t staticChunk;
+        };
+
         using ComponentActions = std::vector<ComponentAction>;
         using Contact2Ds = std::vector<Contact2D>;
+        using StaticChunks = std::vector<StaticChunk>;
+        using Render2DItems = std::vector<Render2DItem>;
 
         void addEntity(const OEntityRef& pEntity);
         void removeEntity(const OEntityRef& pEntity);
@@ -102,6 +134,11 @@ namespace onut
         void end2DContact(b2Contact* pContact);
         void performContacts();
 
+        void updateRender2DItems();
+        void addStaticChunk(StaticChunk& chunk, std::unordered_map<SpriteComponent*, StaticChunk>& previousChunks);
+        void bakeStaticChunk(StaticChunk& chunk);
+        void dirtyStatic2D(Entity* pEntity);
+
         SceneManager();
 
         EntitySet m_entities;
@@ -115,6 +152,12 @@ namespace onut
         Entities m_entitiesToRemove;
         bool m_pause = false;
 
+        Render2DItems m_render2DItems;
+        StaticChunks m_staticChunks;
+        std::unordered_map<Component*, size_t> m_staticChunkByComponent;
+        OIndexBufferRef m_pStaticIndexBuffer;
+        bool m_isRender2DDirty = true;
+
         b2World* m_pPhysic2DWorld;
         Physic2DContactListener* m_pPhysic2DContactListener;
         OUpdaterRef m_pUpdater;
@@ -71,6 +71,14 @@ namespace onut
         int getMatchMakingPort() const { return m_matchMakingPort; }
         void setMatchMakingPort(int matchMakingPort);
 
+        // Where OHTTPGetTexture keeps downloaded files, created on its first call.
+        // Empty for the per user cache folder of the game \see HttpCache::getUserPath
+        std::string getHttpCachePath() const { return m_httpCachePath; }
+        void setHttpCachePath(const std::string& httpCachePath);
+
+        size_t getHttpCacheMaxSize() const { return m_httpCacheMaxSize; }
+        void setHttpCacheMaxSize(size_t httpCacheMaxSize);
+
     private:
         using UserSettings = std::unordered_map<SettingKey, SettingValue>;
 
@@ -88,6 +96,8 @@ namespace onut
         bool m_showOnScreenLog = false;
         std::string m_matchMakingAddress = "192.168.1.112";
         int m_matchMakingPort = 4444;
+        std::string m_httpCachePath;
+        size_t m_httpCacheMaxSize = 64 * 1024 * 1024;
 
         std::atomic<bool> m_isDirty;
         std::atomic<bool> m_isRunning;
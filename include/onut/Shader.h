@@ -26,10 +26,20 @@ namespace onut
 
         struct VertexElement
         {
+            enum class Format
+            {
+                Float, // size floats
+                UNorm8 // size bytes, 0 to 1 in the shader
+            };
+
             uint32_t size;
             std::string semanticName;
+            bool isPerInstance = false; // From the instance buffer, once per instance
+            Format format = Format::Float;
+
+            VertexElement(uint32_t in_size, const std::string& in_semanticName = "ELEMENT", bool in_isPerInstance = false, Format in_format = Format::Float);
 
-            VertexElement(uint32_t in_size, const std::string& in_semanticName = "ELEMENT");
+            uint32_t getByteSize() const;
         };
         using VertexElements = std::vector<VertexElement>;
 
@@ -44,6 +54,7 @@ namespace onut
 
         Type getType() const;
         uint32_t getVertexSize() const;
+        uint32_t getInstanceSize() const; // 0 if it doesn't take instances
 
         virtual int getUniformId(const std::string& varName) const = 0;
         virtual void setFloat(int varId, float value) = 0;
@@ -121,6 +132,7 @@ namespace onut
 
         Type m_type;
         uint32_t m_vertexSize = 0;
+        uint32_t m_instanceSize = 0;
 
     private:
     };
@@ -4,6 +4,7 @@
 // STL
 #include <cinttypes>
 #include <memory>
+#include <string>
 #include <vector>
 
 // Forward
@@ -15,6 +16,12 @@ namespace onut
     class SocketTCP
     {
     public:
+        struct Buffer
+        {
+            const void *pData;
+            int size;
+        };
+
         static OSocketTCPRef listen(int port);
         static OSocketTCPRef connect(const std::string& ip, int port);
 
@@ -25,6 +32,12 @@ namespace onut
         virtual void send(const void *pData, int size) = 0;
         virtual void close() = 0;
 
+        /*!
+            Vectored send. Buffers are sent in order, as one stream.
+            Implementations can gather them in a single system call.
+        */
+        virtual void send(const Buffer *pBuffers, int count);
+
     protected:
         SocketTCP();
     };
@@ -0,0 +1,47 @@
+#ifndef SOCKET_TCP_REACTOR_H_INCLUDED
+#define SOCKET_TCP_REACTOR_H_INCLUDED
+
+// STL
+#include <cinttypes>
+#include <functional>
+#include <memory>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(SocketTCP)
+OForwardDeclare(SocketTCPReactor)
+
+namespace onut
+{
+    /*!
+        Drives many non-blocking SocketTCP from a single I/O thread.
+        The stream is split into messages on frameDelimiter (The match
+        making protocol uses null terminated json).
+        All callbacks are called from the reactor thread. Use OSync to get
+        back on the main thread.
+        Once a socket is added, send() never blocks: what the kernel doesn't
+        take right away is queued and flushed by the reactor.
+    */
+    class SocketTCPReactor
+    {
+    public:
+        using AcceptCallback = std::function<void(const OSocketTCPRef& pSocket)>;
+        using MessageCallback = std::function<void(const OSocketTCPRef& pSocket, const uint8_t* pData, size_t size)>;
+        using CloseCallback = std::function<void(const OSocketTCPRef& pSocket)>;
+
+        // Returns nullptr if not supported on this platform
+        static OSocketTCPReactorRef create(uint8_t frameDelimiter = 0);
+
+        virtual ~SocketTCPReactor();
+
+        virtual bool addListener(const OSocketTCPRef& pListenSocket, const AcceptCallback& onAccept) = 0;
+        virtual bool add(const OSocketTCPRef& pSocket, const MessageCallback& onMessage, const CloseCallback& onClose = nullptr) = 0;
+        virtual void remove(const OSocketTCPRef& pSocket) = 0;
+        virtual size_t getConnectionCount() = 0;
+
+    protected:
+        SocketTCPReactor();
+    };
+}
+
+#endif
@@ -3,6 +3,7 @@
 
 // Onut
 #include <onut/AudioStream.h>
+#include <onut/ContentManager.h>
 #include <onut/Resource.h>
 #include <onut/Timer.h>
 
@@ -67,6 +68,9 @@ namespace onut
 
         ~Sound();
 
+        MemoryCategory getMemoryCategory() const override { return MemoryCategory::Sound; }
+        size_t getMemorySize() const override { return static_cast<size_t>(m_bufferSampleCount) * m_bufferChannelCount * sizeof(float); }
+
         void setMaxInstance(int maxInstance = -1) { m_maxInstance = maxInstance; }
         void play(float volume = 1.f, float balance = 0.f, float pitch = 1.f);
         void stop();
@@ -81,6 +85,7 @@ namespace onut
 
         float* m_pBuffer = nullptr;
         int m_bufferSampleCount = 0;
+        int m_bufferChannelCount = 0;
         Instances m_instances;
         int m_maxInstance = -1;
     };
@@ -116,6 +121,8 @@ namespace onut
 
         Plays m_plays;
     };
+
+    template<> struct AsyncLoader<Sound> : public AsyncLoaderCPU<Sound> {};
 }
 
 OSoundRef OGetSound(const std::string& name);
@@ -2,6 +2,7 @@
 #define SPRITEANIM_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
 #include <onut/Maths.h>
 #include <onut/Resource.h>
 #include <onut/Updater.h>
@@ -55,6 +56,13 @@ namespace onut
         std::string m_filename;
         Point m_size;
     };
+
+    // Its texture is loaded first
+    template<>
+    struct AsyncLoader<SpriteAnim>
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority);
+    };
 }
 
 namespace onut
@@ -7,11 +7,14 @@
 #include <onut/SampleMode.h>
 
 // STL
+#include <cinttypes>
 #include <vector>
 
 // Forward
 #include <onut/ForwardDeclaration.h>
 OForwardDeclare(IndexBuffer);
+OForwardDeclare(RenderCommandList);
+OForwardDeclare(Shader);
 OForwardDeclare(SpriteBatch);
 OForwardDeclare(Texture);
 OForwardDeclare(VertexBuffer);
@@ -28,6 +31,17 @@ namespace onut
             Color   color;
         };
 
+        // One sprite on the instanced path, a parallelogram. Corners are
+        // topLeft, topLeft + down, topLeft + right + down and topLeft + right
+        struct SInstance
+        {
+            Vector2 topLeft;
+            Vector2 right;
+            Vector2 down;
+            Vector4 uvs;
+            uint32_t color; // RGBA8
+        };
+
         static OSpriteBatchRef create();
 
         SpriteBatch();
@@ -35,12 +49,17 @@ namespace onut
 
         void begin(const Matrix& transform = Matrix::Identity, BlendMode blendMode = BlendMode::PreMultiplied);
         void begin(BlendMode blendMode);
+
+        // Records the batch into the list instead of drawing it. Safe off the render
+        // thread if no other thread uses this batch. Create it on the render thread
+        void begin(const ORenderCommandListRef& pCommandList, const Matrix& transform = Matrix::Identity, BlendMode blendMode = BlendMode::PreMultiplied);
         void drawAbsoluteRect(const OTextureRef& pTexture, const Rect& rect, const Color& color = Color::White);
         void drawRect(const OTextureRef& pTexture, const Rect& rect, const Color& color = Color::White);
         void drawInclinedRect(const OTextureRef& pTexture, const Rect& rect, float inclinedRatio = -1.f, const Color& color = Color::White);
         void drawRectWithColors(const OTextureRef& pTexture, const Rect& rect, const std::vector<Color>& colors);
         void drawRectWithUVs(const OTextureRef& pTexture, const Rect& rect, const Vector4& uvs, const Color& color = Color::White);
         void drawRectWithUVsColors(const OTextureRef& pTexture, const Rect& rect, const Vector4& uvs, const std::vector<Color>& colors);
+        void drawQuads(const OTextureRef& pTexture, const SVertexP2T2C4* pVertices, size_t quadCount, const Vector2& offset); // 4 vertices each, ordered like drawRectWithUVs
         void drawRectScaled9(const OTextureRef& pTexture, const Rect& rect, const Vector4& padding, const Color& color = Color::White);
         void drawRectScaled9RepeatCenters(const OTextureRef& pTexture, const Rect& rect, const Vector4& padding, const Color& color = Color::White);
         void draw4Corner(const OTextureRef& pTexture, const Rect& rect, const Color& color = Color::White);
@@ -60,6 +79,8 @@ namespace onut
         void changeFiltering(sample::Filtering filtering);
 
         const Matrix& getTransform() const { return m_currentTransform; }
+        BlendMode getBlendMode() const { return m_curBlendMode; }
+        sample::Filtering getFiltering() const { return m_curFiltering; }
 
         bool isInBatch() const { return m_isDrawing; };
 
@@ -71,6 +92,17 @@ namespace onut
         OVertexBufferRef m_pVertexBuffer;
         OIndexBufferRef m_pIndexBuffer;
         SVertexP2T2C4* m_pMappedVertexBuffer = nullptr;
+        ORenderCommandListRef m_pCommandList;
+        std::vector<SVertexP2T2C4> m_recordedVertices;
+
+        // Sprites with one color go through the instanced path when the renderer
+        // has an instanced vertex shader, as 44 bytes instead of 4 vertices
+        OVertexBufferRef m_pInstanceBuffer;
+        OVertexBufferRef m_pQuadVertexBuffer; // Corners of the instanced quad
+        std::vector<SInstance> m_instances; // Copied to the buffer at flush, they can become vertices
+        unsigned int m_instanceCount = 0;
+        bool m_isInstancing = false;
+        OShaderRef m_pBatchVertexShader; // Vertex shader at begin. Instancing stops if it's changed
 
         bool m_isDrawing = false;
         bool m_snapToPixel = false;
@@ -78,6 +110,10 @@ namespace onut
         OTextureRef m_pTexWhite = nullptr;
 
         void changeTexture(const OTextureRef& pTexture);
+        SVertexP2T2C4* nextVertices();
+        bool addInstance(const Vector2& topLeft, const Vector2& right, const Vector2& down, const Vector4& uvs, const Color& color);
+        void flushVertices();
+        void flushInstances();
 
         OTextureRef m_pTexture = nullptr;
         unsigned int m_spriteCount = 0;
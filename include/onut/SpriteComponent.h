@@ -5,6 +5,7 @@
 // Onut includes
 #include <onut/Component.h>
 #include <onut/Maths.h>
+#include <onut/SpriteBatch.h>
 
 // Forward declarations
 #include <onut/ForwardDeclaration.h>
@@ -31,8 +32,14 @@ namespace onut
         const Vector2& getOrigin() const;
 
     private:
+        friend class SceneManager;
+
         void onRender2d() override;
 
+        // The quad onRender2d draws, for when the entity is static
+        void getVertices(OSpriteBatch::SVertexP2T2C4* pVertices);
+        void dirtyStatic();
+
         OTextureRef m_pTexture;
         Vector2 m_scale = Vector2(1);
         Color m_color = Color::White;
@@ -2,6 +2,8 @@
 #define TEXTURE_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
+#include <onut/Files.h>
 #include <onut/Maths.h>
 #include <onut/Point.h>
 #include <onut/Resource.h>
@@ -25,8 +27,14 @@ namespace onut
         static OTextureRef createScreenRenderTarget(bool willBeUsedInEffects = false);
         static OTextureRef createDynamic(const Point& size);
 
+        // The cooked "name.otex" if there is one, else the file itself
+        static FileData readTextureFile(const std::string& filename, const OContentManagerRef& pContentManager);
+
         virtual ~Texture();
 
+        MemoryCategory getMemoryCategory() const override { return MemoryCategory::Texture; }
+        size_t getMemorySize() const override;
+
         const Point& getSize() const;
         Vector2 getSizef() const;
         void bind(int slot = 0);
@@ -50,6 +58,9 @@ namespace onut
     protected:
         Texture() {}
 
+        // See CookedTexture. Each renderer uploads or decompresses it
+        static OTextureRef createFromCookedData(const uint8_t* pData, size_t dataSize);
+
         enum class Type
         {
             Static,
@@ -61,6 +72,14 @@ namespace onut
         Point m_size;
         Type m_type;
         bool m_isScreenRenderTarget = false;
+        size_t m_memorySize = 0; // 0 for RGBA8 without mipmaps
+    };
+
+    // Decoded on the loader thread, only the upload is left to the main thread
+    template<>
+    struct AsyncLoader<Texture>
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority);
     };
 }
 
@@ -2,6 +2,7 @@
 #define TILEDMAP_H_INCLUDED
 
 // Onut
+#include <onut/ContentManager.h>
 #include <onut/Point.h>
 #include <onut/Maths.h>
 #include <onut/Resource.h>
@@ -172,6 +173,13 @@ namespace onut
         int m_pathType = PATH_ALLOW_DIAGONAL | PATH_CROSS_CORNERS;
         MP_VECTOR<void*> m_cachedPath;
     };
+
+    // Its tileset textures are loaded first
+    template<>
+    struct AsyncLoader<TiledMap>
+    {
+        static ContentManager::AsyncSteps prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority);
+    };
 };
 
 OTiledMapRef OGetTiledMap(const std::string& name);
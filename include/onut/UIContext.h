@@ -102,6 +102,7 @@ namespace onut
         DrawTextInsertCallback drawInsert = nullptr;
         std::chrono::steady_clock::duration doubleClickTime = std::chrono::milliseconds(500);
         bool useNavigation = false;
+        bool useHitTestIndex = true; // Resolve the mouse hover from the last render instead of walking all the controls
         OContentManagerWeak pContentManager;
 
         // Styles related function
@@ -182,11 +183,43 @@ namespace onut
         using TextCaretStyleMapByType = std::unordered_map<std::type_index, TextCaretStyleMap>;
         using Clips = std::vector<Rect>;
 
+        // A control as it was last rendered. hitRect is clipped by the
+        // parents with clipChildren
+        struct HitEntry
+        {
+            UIControl* pControl;
+            Rect rect;
+            Rect hitRect;
+            bool isHitTestable;
+
+            bool operator==(const HitEntry& other) const
+            {
+                return pControl == other.pControl &&
+                    isHitTestable == other.isHitTestable &&
+                    rect == other.rect &&
+                    hitRect == other.hitRect;
+            }
+        };
+        using HitEntries = std::vector<HitEntry>;
+        using HitCell = std::vector<uint32_t>;
+        using HitCells = std::vector<HitCell>;
+
+        static const int HIT_CELL_SIZE = 64;
+
         void resolve();
         void dispatchEvents();
         void reset();
         OTextureRef getTextureForState(const OUIControlRef& pControl, const std::string &filename);
 
+        void pushHitClip(const Rect& rect);
+        void popHitClip();
+        Rect getHitRect(const Rect& rect) const;
+        void beginHitEntries(const UIControl* pRoot);
+        void addHitEntry(UIControl* pControl, const Rect& rect);
+        void endHitEntries();
+        void buildHitCells();
+        bool hitTest(const UIControl* pRoot);
+
         RenderStyleMapByType m_callbacks;
         TextCaretStyleMapByType m_textCaretSolvers;
 
@@ -208,6 +241,20 @@ namespace onut
 
         std::chrono::steady_clock::time_point m_clickTimes[3];
         Vector2 m_clicksPos[3];
+
+        Vector2 m_clipOffset; // Top left of the cached control being drawn in its texture
+
+        // Hit test index, recorded while rendering and bucketed in a grid
+        HitEntries m_hitEntries;
+        HitCells m_hitCells;
+        Clips m_hitClips;
+        const UIControl* m_pHitRoot = nullptr;
+        uint32_t m_hitGeneration = 0;
+        size_t m_hitEntryCount = 0;
+        int m_hitCellCountX = 0;
+        int m_hitCellCountY = 0;
+        bool m_isHitEnabled = true;
+        bool m_areHitCellsDirty = true;
     };
 };
 
@@ -13,6 +13,7 @@
 // Forward
 #include <onut/ForwardDeclaration.h>
 OForwardDeclare(ContentManager);
+OForwardDeclare(Texture);
 OForwardDeclare(UIContext);
 OForwardDeclare(UIControl);
 namespace rapidjson
@@ -27,6 +28,9 @@ namespace rapidjson
 
 namespace onut
 {
+    class UIBinaryReader;
+    class UIBinaryWriter;
+
     class UIControl : public std::enable_shared_from_this<UIControl>
     {
     public:
@@ -43,6 +47,10 @@ namespace onut
 
             Property();
             Property(const rapidjson::Value& jsonNode);
+            Property(int value);
+            Property(float value);
+            Property(bool value);
+            Property(const char* szValue);
             Property(const Property& other);
             Property& operator=(const Property& other);
             ~Property();
@@ -119,9 +127,11 @@ namespace onut
         using Controls = std::vector<OUIControlRef>;
 
         static OUIControlRef create();
+        // Loads "name.uib" instead of "name.json" if there is one at least as recent, except in editor mode
         static OUIControlRef createFromFile(const std::string& filename, OContentManagerRef pContentManager = nullptr);
 
         UIControl(const UIControl& other) = delete;
+        virtual ~UIControl();
         virtual void operator=(const UIControl& other);
         OUIControlRef copy() const;
 
@@ -130,7 +140,8 @@ namespace onut
         bool isClickThrough = false; /*! Same as isEnabled, but will traverse children */
         bool isVisible = true; /*! Visible or not. Invisible controls don't receive mouse events */
         bool clipChildren = false; /*! Will trigger a scissor on the children. Usefull for lists */
-        Rect rect; /*! Local rectangle. Greatly influenced by align, anchor, pos and dim types. \see getWorldRect */
+        bool cacheRender = false; /*! Renders itself and children into a texture, redrawn only when invalidated. Children should stay inside its rect \see invalidateRender */
+        Rect rect; /*! Local rectangle. Greatly influenced by align, anchor, pos and dim types. \see getWorldRect \see invalidateLayout */
         onut::Align align = onut::Align::TopLeft; /*! Alignement inside parent control */
         PosType xType = PosType::Relative; /*! x position type */
         PosType yType = PosType::Relative; /*! y position type */
@@ -143,7 +154,7 @@ namespace onut
         void* pUserData = nullptr; /*! Set whatever data you want on this. it will never be accessed or freed by onut::UI */
         std::shared_ptr<void> pSharedUserData = nullptr; /*! Set whatever data you want on this. it will never be accessed or freed by onut::UI */
 
-        void save(const std::string& filename) const;
+        void save(const std::string& filename) const; // Binary layout if it ends with .uib, else JSON
 
         virtual Type getType() const { return Type::Control; }
         virtual bool isNavigatable() const { return false; }
@@ -179,6 +190,13 @@ namespace onut
         Rect getWorldRect(const OUIContextRef& context) const;
         void setWorldRect(const Rect& rect, const OUIContextRef& context);
 
+        // World rects are cached. Changes to rect, align, anchor or the pos,
+        // dim and anchor types are noticed on render and getWorldRect by
+        // comparing them with what the cache was computed from. Calling this
+        // after changing them is cheaper, and also redraws parents that
+        // cacheRender. Adding, removing and setWorldRect already do
+        void invalidateLayout();
+
         Vector2 getAnchorInPixel() const;
         Vector2 getAnchorInPercentage() const;
         void setAnchorPercent(const Vector2& anchor);
@@ -186,6 +204,10 @@ namespace onut
         State getState(const OUIContextRef& context) const;
         bool hasFocus(const OUIContextRef& context) const;
 
+        // Redraw the cached controls containing this one. Hover, down, focus,
+        // resizing and adding or removing controls already do
+        void invalidateRender();
+
         OUIControlRef getParent() const { return m_pParent.lock(); }
 
         const Property& getProperty(const std::string& name) const;
@@ -234,9 +256,12 @@ namespace onut
 
         virtual void load(const rapidjson::Value& jsonNode);
         virtual void save(rapidjson::Value& jsonNode, rapidjson::Allocator& allocator) const;
+        virtual void load(UIBinaryReader& reader);
+        virtual void save(UIBinaryWriter& writer) const;
 
         void updateInternal(const OUIContextRef& context, const Rect& parentRect);
         void renderInternal(const OUIContextRef& context, const Rect& parentRect);
+        void renderControlAndChildren(const OUIContextRef& context, const Rect& worldRect);
         virtual void renderControl(const OUIContextRef& context, const Rect& rect) {}
 
         virtual void onClickInternal(const UIMouseEvent& evt) {}
@@ -252,7 +277,21 @@ namespace onut
     private:
         using PropertyMap = std::unordered_map<std::string, Property>;
 
+        static uint32_t s_hierarchyGeneration; // Changes when any control is added, removed or destroyed
+
         Rect getWorldRect(const Rect& parentRect) const;
+        Rect computeWorldRect(const Rect& parentRect) const;
+        void updateLayout(const Rect& parentRect) const;
+        void dirtyLayout() const;
+        void dirtyParentLayouts() const;
+        uint32_t getLayoutTypes() const;
+        bool isLayoutChanged() const;
+        bool isLayoutClean() const;
+
+        bool renderCached(const OUIContextRef& context, const Rect& worldRect);
+        bool isRenderCacheValid(const OUIContextRef& context) const;
+        bool isInRenderCache(const UIControl* pControl) const;
+        void addHitEntries(const OUIContextRef& context, const Rect& worldRect);
         void getChild(const OUIContextRef& context,
                       const Vector2& mousePos,
                       bool bSearchSubChildren,
@@ -265,6 +304,22 @@ namespace onut
         std::string m_styleName;
         OUIControlWeak m_pParent;
         PropertyMap m_properties;
+
+        // Cached layout. A dirty control has all its children dirty too, and
+        // its parents know they have a dirty child so the layout pass finds it
+        mutable Rect m_parentRect;
+        mutable Rect m_worldRect;
+        mutable Rect m_layoutRect; // The fields it was computed from
+        mutable Vector2 m_layoutAnchor;
+        mutable uint32_t m_layoutTypes = 0;
+        mutable bool m_isLayoutDirty = true;
+        mutable bool m_isChildLayoutDirty = true;
+
+        // Render cache, with the hover, down and focus controls it was drawn with
+        OTextureRef m_pRenderCache;
+        const UIControl* m_renderCacheControls[5] = {};
+        uint32_t m_renderCacheGeneration = 0;
+        bool m_isRenderCacheDirty = true;
     };
 };
 
@@ -28,6 +28,8 @@ namespace onut
 
         void load(const rapidjson::Value& jsonNode) override;
         void save(rapidjson::Value& jsonNode, rapidjson::Allocator& allocator) const override;
+        void load(UIBinaryReader& reader) override;
+        void save(UIBinaryWriter& writer) const override;
         void renderControl(const OUIContextRef& context, const Rect& rect) override;
     };
 };
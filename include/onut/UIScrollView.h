@@ -24,14 +24,57 @@ namespace onut
         bool isScrollV = true;
         Vector4 padding;
 
+        // Virtual items. Only the rows in view exist as controls, made with
+        // createItem and given back to bindItem as they scroll in. Rows are
+        // placed with rect.y and rect.w, keep them top aligned.
+        using CreateItemCallback = std::function<OUIControlRef()>;
+        using BindItemCallback = std::function<void(const OUIControlRef&, size_t index)>;
+        using ItemHeightCallback = std::function<float(size_t index)>;
+        CreateItemCallback createItem;
+        BindItemCallback bindItem;
+        ItemHeightCallback getItemHeight; // Heights are cached, call invalidateItems when they change. Without it, all rows are itemHeight
+        float itemHeight = 20.f;
+
+        void setItemCount(size_t count);
+        size_t getItemCount() const { return m_itemCount; }
+        void invalidateItems(); // Measures and binds again
+        void scrollToItem(size_t index);
+        float getScrollV() const { return m_scrollV; }
+
     protected:
         UIScrollView() {}
 
         void load(const rapidjson::Value& jsonNode) override;
         void save(rapidjson::Value& jsonNode, rapidjson::Allocator& allocator) const override;
+        void load(UIBinaryReader& reader) override;
+        void save(UIBinaryWriter& writer) const override;
+        void renderControl(const OUIContextRef& context, const Rect& rect) override;
+        void onMouseScrollInternal(const UIMouseEvent& evt) override;
 
         float m_scrollH = 0;
         float m_scrollV = 0;
+
+    private:
+        struct RealizedItem
+        {
+            OUIControlRef pControl;
+            size_t index;
+        };
+        using RealizedItems = std::vector<RealizedItem>;
+
+        static const size_t NO_ITEM = static_cast<size_t>(-1);
+
+        const std::vector<float>& getItemOffsets() const;
+        float getItemOffset(size_t index) const;
+        float getContentHeight() const;
+        size_t getItemAtOffset(float offset) const;
+        void realizeItems(const Rect& rect);
+
+        size_t m_itemCount = 0;
+        mutable std::vector<float> m_itemOffsets; // Top of each item, then the content height
+        mutable bool m_areItemOffsetsDirty = true;
+        RealizedItems m_realizedItems;
+        std::vector<bool> m_isIndexRealized;
     };
 };
 
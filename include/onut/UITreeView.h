@@ -55,6 +55,8 @@ namespace onut
     protected:
         void load(const rapidjson::Value& jsonNode) override;
         void save(rapidjson::Value& jsonNode, rapidjson::Allocator& allocator) const override;
+        void load(UIBinaryReader& reader) override;
+        void save(UIBinaryWriter& writer) const override;
         void renderControl(const OUIContextRef& context, const Rect& rect) override;
         void onMouseDownInternal(const UIMouseEvent& evt) override;
         void onMouseMoveInternal(const UIMouseEvent& evt) override;
@@ -62,11 +64,25 @@ namespace onut
         void onMouseScrollInternal(const UIMouseEvent& evt) override;
 
     private:
+        friend UITreeViewItem;
+
+        // Expanded items flattened in display order, so only the rows in view
+        // are rendered and picking is a division
+        struct Row
+        {
+            UITreeViewItem* pItem;
+            int depth;
+        };
+        using Rows = std::vector<Row>;
+        using Expansions = std::vector<std::pair<UITreeViewItem*, bool>>;
+
         UITreeView() {}
 
         OUITreeViewItemRef getItemAtPosition(const Vector2& pos, const Rect& rect, bool* pPickedExpandButton = nullptr, Rect* pItemRect = nullptr) const;
-        OUITreeViewItemRef getItemAtPosition(const OUITreeViewItemRef& pItem, const Vector2& pos, Rect& rect, bool* pPickedExpandButton = nullptr, Rect* pItemRect = nullptr) const;
-        float getTotalHeight(const OUITreeViewItemRef& pItem = nullptr) const;
+        float getTotalHeight() const;
+        const Rows& getRows() const;
+        void addRows(const TreeViewItems& items, int depth) const;
+        void dirtyRows();
 
         TreeViewItems m_items;
         TreeViewItems m_selectedItems;
@@ -78,6 +94,9 @@ namespace onut
         OUITreeViewItemRef m_dragBeforeItem = nullptr;
         OUITreeViewItemRef m_dragAfterItem = nullptr;
         Rect m_dragInBetweenRect;
+        mutable Rows m_rows;
+        mutable Expansions m_expansions; // isExpanded of the rows with children, when m_rows was built
+        mutable bool m_areRowsDirty = true;
     };
 };
 
@@ -116,28 +135,6 @@ namespace onut
         bool getIsSelected() const { return m_isSelected; }
 
     private:
-        template<typename TfnCallback>
-        void render(const TfnCallback& itemCallback, const OUITreeViewRef& pTreeView, const Rect& treeViewRect, Rect& rect)
-        {
-            itemCallback->render(OThis, rect);
-            rect.y += pTreeView->itemHeight;
-            if (isExpanded)
-            {
-                if (!m_items.empty())
-                {
-                    auto xOffset = pTreeView->expandedXOffset;
-                    rect.x += xOffset;
-                    rect.z -= xOffset;
-                    for (auto pItem : m_items)
-                    {
-                        pItem->render(itemCallback, pTreeView, treeViewRect, rect);
-                    }
-                    rect.z += xOffset;
-                    rect.x -= xOffset;
-                }
-            }
-        }
-
         template<typename TfnCallback>
         void renderDrag(const TfnCallback& itemCallback, const OUITreeViewRef& pTreeView, const Rect& treeViewRect, Rect& rect)
         {
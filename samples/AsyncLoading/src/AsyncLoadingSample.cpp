@@ -1,6 +1,5 @@
 // Oak Nut include
-#include <onut/Async.h>
-#include <onut/Dispatcher.h>
+#include <onut/ContentManager.h>
 #include <onut/Font.h>
 #include <onut/Log.h>
 #include <onut/Renderer.h>
@@ -10,6 +9,8 @@
 #include <onut/Timing.h>
 
 float loadingRotation = 0.f;
+float loadingTime = 0.f;
+int loadedCount = 0;
 bool loaded = false;
 
 // Main
@@ -20,27 +21,27 @@ void initSettings()
 
 void init()
 {
-    // Start loading
-    OAsync([]
+    // Start loading. The pngs are decoded on loader threads, and the textures
+    // are created on the main thread. Higher priority loads first.
+    float priority = 3.f;
+    for (auto name : {"img2.png", "img3.png", "img4.png"})
     {
-        OGetTexture("img2.png");
-        OGetTexture("img3.png");
-        OGetTexture("img4.png");
-        OLog("Loaded!");
-
-        // Since this is going to be very fast, force a sleep here so we can see the loading screen
-        std::this_thread::sleep_for(std::chrono::seconds(5));
-
-        OSync([] // Sync back to main loop
+        oContentManager->loadAsync<OTexture>(name, priority--, [](const OTextureRef& pTexture)
         {
-            loaded = true; // We could have used an std::atomic here. Its for showing you can trigger events safely from there
+            // Called on the main thread. nullptr if it failed
+            ++loadedCount;
+            if (pTexture) OLog("Loaded " + pTexture->getName());
         });
-    });
+    }
 }
 
 void update()
 {
     loadingRotation += ODT * 360.f;
+    loadingTime += ODT;
+
+    // Since this is going to be very fast, wait a bit so we can see the loading screen
+    loaded = loadedCount == 3 && loadingTime >= 5.f;
 }
 
 void render()
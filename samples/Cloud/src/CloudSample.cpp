@@ -424,6 +424,7 @@ static void onShowGameOver()
 void update()
 {
     pAchievementPopupCard->rect.x = achievementPopupAnim;
+    pAchievementPopupCard->invalidateLayout();
 
     if (gameState == GameState::Game)
     {
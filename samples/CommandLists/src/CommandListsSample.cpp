@@ -0,0 +1,94 @@
+// Oak Nut include
+#include <onut/onut.h>
+#include <onut/Renderer.h>
+#include <onut/RenderCommandList.h>
+#include <onut/Settings.h>
+#include <onut/SpriteBatch.h>
+#include <onut/Texture.h>
+#include <onut/Timing.h>
+
+// STL
+#include <cmath>
+#include <thread>
+
+// Two workers record their own sprite batch into a command list each frame.
+// The main loop replays them after render(), by sort key.
+static const int SPRITE_COUNT = 200;
+
+struct Recorder
+{
+    OSpriteBatchRef pSpriteBatch;
+    ORenderCommandListRef pCommandList;
+};
+
+Recorder background;
+Recorder foreground;
+OTextureRef pNutTexture;
+float g_time = 0.f;
+
+void initSettings()
+{
+    oSettings->setGameName("Command Lists Sample");
+}
+
+void init()
+{
+    // Created on the render thread, used on the workers
+    background = {OSpriteBatch::create(), ORenderCommandList::create(0)};
+    foreground = {OSpriteBatch::create(), ORenderCommandList::create(1)};
+    pNutTexture = OGetTexture("onutLogo.png");
+}
+
+void update()
+{
+    g_time += ODT;
+}
+
+// A ring of logos. The second half is added on top of the first
+static void recordBackground(const Vector2& center, float time)
+{
+    auto& pSpriteBatch = background.pSpriteBatch;
+    background.pCommandList->reset();
+    pSpriteBatch->begin(background.pCommandList);
+    for (int i = 0; i < SPRITE_COUNT; ++i)
+    {
+        if (i == SPRITE_COUNT / 2) pSpriteBatch->changeBlendMode(OBlendAdd);
+        auto angle = static_cast<float>(i) / static_cast<float>(SPRITE_COUNT) * OPI * 2.f + time * .5f;
+        auto radius = 150.f + std::sin(time + static_cast<float>(i) * .1f) * 100.f;
+        pSpriteBatch->drawSprite(pNutTexture, center + Vector2(std::cos(angle), std::sin(angle)) * radius, Color(.5f, .5f, .5f, .5f), OConvertToDegrees(angle), .25f);
+    }
+    pSpriteBatch->end();
+}
+
+// The same logo scaled up, nearest then linear
+static void recordForeground(const Vector2& center, float time)
+{
+    auto& pSpriteBatch = foreground.pSpriteBatch;
+    foreground.pCommandList->reset();
+    pSpriteBatch->begin(foreground.pCommandList);
+    pSpriteBatch->changeFiltering(OFilterNearest);
+    pSpriteBatch->drawSprite(pNutTexture, center - Vector2(100, 0), Color::White, time * 20.f, 1.5f);
+    pSpriteBatch->changeFiltering(OFilterLinear);
+    pSpriteBatch->drawSprite(pNutTexture, center + Vector2(100, 0), Color::White, time * 20.f, 1.5f);
+    pSpriteBatch->end();
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+
+    // Workers don't touch oRenderer, read what they need here
+    auto center = OScreenf / 2.f;
+    auto time = g_time;
+    std::thread backgroundThread([center, time] { recordBackground(center, time); });
+    std::thread foregroundThread([center, time] { recordForeground(center, time); });
+    backgroundThread.join();
+    foregroundThread.join();
+
+    oRenderer->submit(foreground.pCommandList);
+    oRenderer->submit(background.pCommandList); // Replays first anyway, lower sort key
+}
+
+void postRender()
+{
+}
@@ -0,0 +1,314 @@
+// Oak Nut include
+#include <onut/Http.h>
+#include <onut/Log.h>
+#include <onut/Renderer.h>
+#include <onut/Settings.h>
+#include <onut/SocketTCP.h>
+#include <onut/SocketTCPReactor.h>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// A stand-in web server on loopback, answering every GET after a delay with
+// its own path. Async requests are thrown at it in 3 rounds:
+//  - Concurrent: many at once, never more in flight than allowed
+//  - Cancel: half get cancelled, their callbacks must never be called
+//  - Priority: one at a time, High ones must go before Normal, then Low
+static const int PORT = 4446;
+static const int RESPONSE_DELAY_MS = 20;
+static const int CONCURRENT_COUNT = 64;
+static const int MAX_CONCURRENT_REQUESTS = 8;
+static const int CANCEL_COUNT = 32;
+static const int PRIORITY_COUNT = 8; // Per priority
+
+enum class Stage
+{
+    Concurrent,
+    Cancel,
+    Priority,
+    Done
+};
+
+struct PendingResponse
+{
+    OSocketTCPRef pSocket;
+    std::string path;
+    std::chrono::steady_clock::time_point due;
+};
+
+// Server side
+OSocketTCPReactorRef pServer;
+std::unordered_map<onut::SocketTCP*, std::string> requestPaths; // Only touched by the reactor thread
+std::mutex responseMutex;
+std::condition_variable responseCondition;
+std::deque<PendingResponse> responses;
+std::thread* pResponseThread = nullptr;
+bool isServerRunning = false;
+std::atomic<int> inFlightCount(0);
+std::atomic<int> peakInFlightCount(0);
+
+// Client side
+Stage stage = Stage::Concurrent;
+std::chrono::steady_clock::time_point stageStart;
+int expectedCount = 0;
+int successCount = 0;
+int errorCount = 0;
+int cancelledCallbackCount = 0;
+std::vector<OHttp::Priority> completedPriorities;
+
+static std::string getUrl(const std::string& path)
+{
+    return "http://127.0.0.1:" + std::to_string(PORT) + path;
+}
+
+static double getStageMs()
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - stageStart).count();
+}
+
+// The body is the path, so we know we got the right answer
+static void respond(const PendingResponse& response)
+{
+    auto header = "HTTP/1.1 200 OK\r\nContent-Type: text/plain\r\nContent-Length: " + std::to_string(response.path.size()) + "\r\n\r\n";
+    onut::SocketTCP::Buffer buffers[] = {
+        {header.data(), static_cast<int>(header.size())},
+        {response.path.data(), static_cast<int>(response.path.size())}
+    };
+    --inFlightCount;
+    response.pSocket->send(buffers, 2);
+}
+
+static void runResponses()
+{
+    std::unique_lock<std::mutex> lock(responseMutex);
+    while (isServerRunning)
+    {
+        if (responses.empty())
+        {
+            responseCondition.wait(lock);
+            continue;
+        }
+        auto response = responses.front();
+        if (std::chrono::steady_clock::now() < response.due)
+        {
+            responseCondition.wait_until(lock, response.due);
+            continue;
+        }
+        responses.pop_front();
+        lock.unlock();
+        respond(response);
+        lock.lock();
+    }
+}
+
+// Requests come one line at a time. An empty line ends it
+static void onServerMessage(const OSocketTCPRef& pSocket, const uint8_t* pData, size_t size)
+{
+    std::string line(reinterpret_cast<const char*>(pData), size);
+    if (!line.empty() && line.back() == '\r') line.pop_back();
+
+    auto& path = requestPaths[pSocket.get()];
+    if (!line.empty())
+    {
+        if (line.compare(0, 4, "GET ") == 0) path = line.substr(4, line.find(' ', 4) - 4);
+        return;
+    }
+
+    auto count = ++inFlightCount;
+    auto peak = peakInFlightCount.load();
+    while (count > peak && !peakInFlightCount.compare_exchange_weak(peak, count));
+
+    std::lock_guard<std::mutex> lock(responseMutex);
+    responses.push_back({pSocket, path, std::chrono::steady_clock::now() + std::chrono::milliseconds(RESPONSE_DELAY_MS)});
+    responseCondition.notify_one();
+}
+
+static bool startServer()
+{
+    pServer = OSocketTCPReactor::create('\n');
+    if (!pServer)
+    {
+        OLogE("SocketTCPReactor is not supported on this platform");
+        return false;
+    }
+    auto pListenSocket = OSocketTCP::listen(PORT);
+    if (!pListenSocket)
+    {
+        OLogE("Can't listen on port " + std::to_string(PORT));
+        return false;
+    }
+    pServer->addListener(pListenSocket, [](const OSocketTCPRef& pSocket)
+    {
+        pServer->add(pSocket, onServerMessage, [](const OSocketTCPRef& pSocket)
+        {
+            requestPaths.erase(pSocket.get());
+        });
+    });
+    isServerRunning = true;
+    pResponseThread = new std::thread(runResponses);
+    return true;
+}
+
+static void stopServer()
+{
+    {
+        std::lock_guard<std::mutex> lock(responseMutex);
+        isServerRunning = false;
+        responses.clear();
+        responseCondition.notify_one();
+    }
+    pResponseThread->join();
+    delete pResponseThread;
+    pResponseThread = nullptr;
+    pServer = nullptr;
+}
+
+static OHttp::RequestId get(const std::string& path, OHttp::Priority priority, bool isCancelled = false)
+{
+    return oHttp->getAsync(getUrl(path), {}, priority, [path, priority, isCancelled](OHttp::Body body)
+    {
+        if (isCancelled)
+        {
+            ++cancelledCallbackCount;
+            return;
+        }
+        if (std::string(body.begin(), body.end()) == path) ++successCount;
+        else ++errorCount;
+        completedPriorities.push_back(priority);
+    }, [path, isCancelled](long errCode, std::string message)
+    {
+        if (isCancelled) ++cancelledCallbackCount;
+        else ++errorCount;
+        OLogE(path + ": " + message);
+    });
+}
+
+static void startStage(Stage in_stage)
+{
+    stage = in_stage;
+    stageStart = std::chrono::steady_clock::now();
+    successCount = 0;
+    errorCount = 0;
+    cancelledCallbackCount = 0;
+    completedPriorities.clear();
+    peakInFlightCount = 0;
+
+    switch (stage)
+    {
+        case Stage::Concurrent:
+            oHttp->setMaxConcurrentRequests(MAX_CONCURRENT_REQUESTS);
+            expectedCount = CONCURRENT_COUNT;
+            for (int i = 0; i < CONCURRENT_COUNT; ++i)
+            {
+                get("/concurrent/" + std::to_string(i), OHttp::Priority::Normal);
+            }
+            break;
+        case Stage::Cancel:
+            expectedCount = CANCEL_COUNT / 2;
+            for (int i = 0; i < CANCEL_COUNT; ++i)
+            {
+                auto isCancelled = (i % 2) == 0;
+                auto requestId = get("/cancel/" + std::to_string(i), OHttp::Priority::Normal, isCancelled);
+                if (isCancelled) oHttp->cancel(requestId);
+            }
+            break;
+        case Stage::Priority:
+            // Only one in flight, so the rest is picked from the queues
+            oHttp->setMaxConcurrentRequests(1);
+            expectedCount = PRIORITY_COUNT * 3;
+            for (int i = 0; i < PRIORITY_COUNT; ++i)
+            {
+                get("/low/" + std::to_string(i), OHttp::Priority::Low);
+            }
+            for (int i = 0; i < PRIORITY_COUNT; ++i)
+            {
+                get("/normal/" + std::to_string(i), OHttp::Priority::Normal);
+            }
+            for (int i = 0; i < PRIORITY_COUNT; ++i)
+            {
+                get("/high/" + std::to_string(i), OHttp::Priority::High);
+            }
+            break;
+        case Stage::Done:
+            oHttp->setMaxConcurrentRequests(MAX_CONCURRENT_REQUESTS);
+            stopServer();
+            break;
+    }
+}
+
+static void endStage()
+{
+    auto elapsed = std::to_string(getStageMs()) + " ms";
+    switch (stage)
+    {
+        case Stage::Concurrent:
+            OLog(std::to_string(successCount) + " requests in " + elapsed + ", at most " + std::to_string(peakInFlightCount) +
+                 " in flight (Allowed " + std::to_string(MAX_CONCURRENT_REQUESTS) + ", " + std::to_string(RESPONSE_DELAY_MS) + " ms each)");
+            startStage(Stage::Cancel);
+            break;
+        case Stage::Cancel:
+        {
+            // Give the cancelled ones time to misbehave
+            if (getStageMs() < RESPONSE_DELAY_MS * CANCEL_COUNT / MAX_CONCURRENT_REQUESTS + 100) return;
+            OLog(std::to_string(successCount) + " requests in " + elapsed + ", " + std::to_string(CANCEL_COUNT - expectedCount) +
+                 " cancelled, " + std::to_string(cancelledCallbackCount) + " callbacks from cancelled ones");
+            if (cancelledCallbackCount) OLogE("Cancelled requests called back");
+            startStage(Stage::Priority);
+            break;
+        }
+        case Stage::Priority:
+        {
+            // The I/O thread might have grabbed the first one before the others were queued
+            auto isOrdered = completedPriorities.size() < 2 || std::is_sorted(completedPriorities.begin() + 1, completedPriorities.end(), [](OHttp::Priority a, OHttp::Priority b)
+            {
+                return a > b;
+            });
+            OLog(std::to_string(successCount) + " requests in " + elapsed + ", " + (isOrdered ? "served by priority" : "NOT served by priority"));
+            if (!isOrdered) OLogE("Requests were not served by priority");
+            startStage(Stage::Done);
+            break;
+        }
+        case Stage::Done:
+            break;
+    }
+}
+
+void initSettings()
+{
+    oSettings->setGameName("Http Async Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    if (!startServer())
+    {
+        stage = Stage::Done;
+        return;
+    }
+    startStage(Stage::Concurrent);
+}
+
+void update()
+{
+    if (stage == Stage::Done) return;
+    if (successCount + errorCount >= expectedCount) endStage();
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+}
+
+void postRender()
+{
+}
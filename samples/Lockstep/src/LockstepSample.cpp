@@ -0,0 +1,281 @@
+// Oak Nut include
+#include <onut/Log.h>
+#include <onut/Renderer.h>
+#include <onut/RTS.h>
+#include <onut/Settings.h>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+// System
+#if !defined(WIN32)
+#include <sys/select.h>
+#endif
+
+// A few RTS peers, all on loopback. Every pair talks through a relay that
+// drops a share of the datagrams, both ways. Peers send orders while the
+// game runs, then we make sure they all executed the same orders on the
+// same turns, and that none got lost.
+static const int PEER_COUNT = 4;
+static const int TURN_COUNT = 200;
+static const double LOSS = 0.1; // 10% of datagrams never make it
+static const int TIMEOUT_MS = 60000;
+static const uint8_t CMD_ORDER = 1;
+
+struct Order
+{
+    uint32_t turn;
+    uint64_t playerId;
+    uint32_t sequence;
+
+    bool operator<(const Order& other) const
+    {
+        return std::tie(turn, playerId, sequence) < std::tie(other.turn, other.playerId, other.sequence);
+    }
+    bool operator==(const Order& other) const
+    {
+        return turn == other.turn && playerId == other.playerId && sequence == other.sequence;
+    }
+};
+
+// One side of a pair. What comes in is sent to the other peer from the other side
+struct RelaySide
+{
+    onut::RTSSocket* pSocket;
+    onut::RTSSocket* pOut;
+    sockaddr_in to;
+};
+
+onut::RTS* peers[PEER_COUNT];
+onut::RTSSocket* sockets[PEER_COUNT];
+std::vector<Order> orders[PEER_COUNT]; // Executed, by each peer
+uint32_t sequences[PEER_COUNT] = {0};
+std::vector<RelaySide> relay;
+std::thread* pRelayThread = nullptr;
+std::atomic<bool> isRelayRunning(false);
+std::atomic<int> forwardCount(0);
+std::atomic<int> dropCount(0);
+
+static uint64_t getPlayerId(int index)
+{
+    return 100 + index;
+}
+
+static double getElapsedMs(const std::chrono::high_resolution_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static onut::RTSSocket* createLoopbackSocket()
+{
+    auto pSocket = new onut::RTSSocket();
+    pSocket->retain();
+    sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = inet_addr("127.0.0.1");
+    addr.sin_port = 0; // Any
+    bind(pSocket->getSock(), (const sockaddr*)&addr, sizeof(addr));
+#if defined(WIN32)
+    int len = sizeof(addr);
+#else
+    socklen_t len = sizeof(addr);
+#endif
+    getsockname(pSocket->getSock(), (sockaddr*)&addr, &len);
+    pSocket->setAddr(addr);
+    pSocket->setIPPort("127.0.0.1:" + std::to_string(ntohs(addr.sin_port)));
+    return pSocket;
+}
+
+static void runRelay()
+{
+    std::mt19937 random(1234);
+    std::uniform_real_distribution<double> chance(0.0, 1.0);
+    char buffer[onut::packetSize];
+
+    while (isRelayRunning)
+    {
+        fd_set fds;
+        FD_ZERO(&fds);
+        onut::RTSSocketHandle maxSock = 0;
+        for (auto& side : relay)
+        {
+            FD_SET(side.pSocket->getSock(), &fds);
+            maxSock = std::max(maxSock, side.pSocket->getSock());
+        }
+        timeval timeout = {0, 10000};
+        if (select(static_cast<int>(maxSock + 1), &fds, nullptr, nullptr, &timeout) <= 0) continue;
+
+        for (auto& side : relay)
+        {
+            if (!FD_ISSET(side.pSocket->getSock(), &fds)) continue;
+            auto size = recv(side.pSocket->getSock(), buffer, sizeof(buffer), 0);
+            if (size < 0) continue;
+            if (chance(random) < LOSS)
+            {
+                ++dropCount;
+                continue;
+            }
+            sendto(side.pOut->getSock(), buffer, static_cast<int>(size), 0, (const sockaddr*)&side.to, sizeof(side.to));
+            ++forwardCount;
+        }
+    }
+}
+
+static bool isEveryoneAtTurn(uint32_t turn)
+{
+    for (auto pRTS : peers)
+    {
+        if (pRTS->getTurn() < turn) return false;
+    }
+    return true;
+}
+
+// Every peer executed the same orders up to the turn they all reached, and
+// each player's orders came through in the order they were sent
+static bool checkLockstep()
+{
+    uint32_t lastTurn = peers[0]->getTurn();
+    for (auto pRTS : peers) lastTurn = std::min(lastTurn, pRTS->getTurn());
+
+    std::vector<Order> reference;
+    for (int i = 0; i < PEER_COUNT; ++i)
+    {
+        std::vector<uint32_t> nextSequences(PEER_COUNT, 0);
+        std::vector<Order> executed;
+        for (auto& order : orders[i])
+        {
+            auto& nextSequence = nextSequences[order.playerId - getPlayerId(0)];
+            if (order.sequence != nextSequence)
+            {
+                OLogE("Peer " + std::to_string(i) + " missed order " + std::to_string(nextSequence) + " from player " + std::to_string(order.playerId));
+                return false;
+            }
+            ++nextSequence;
+            if (order.turn < lastTurn) executed.push_back(order);
+        }
+        std::sort(executed.begin(), executed.end());
+        if (i == 0)
+        {
+            reference = executed;
+        }
+        else if (executed != reference)
+        {
+            OLogE("Peer " + std::to_string(i) + " is out of sync with peer 0");
+            return false;
+        }
+    }
+    OLog(std::to_string(reference.size()) + " orders executed identically by " + std::to_string(PEER_COUNT) + " peers over " + std::to_string(lastTurn) + " turns");
+    return true;
+}
+
+void initSettings()
+{
+    oSettings->setGameName("Lockstep Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    for (int i = 0; i < PEER_COUNT; ++i)
+    {
+        sockets[i] = createLoopbackSocket();
+    }
+
+    // A relay for each pair. Peer i knows peer j by the relay side facing it
+    std::vector<std::vector<std::string>> ipPorts(PEER_COUNT, std::vector<std::string>(PEER_COUNT));
+    for (int i = 0; i < PEER_COUNT; ++i)
+    {
+        for (int j = i + 1; j < PEER_COUNT; ++j)
+        {
+            auto pSideI = createLoopbackSocket();
+            auto pSideJ = createLoopbackSocket();
+            relay.push_back({pSideI, pSideJ, sockets[j]->getAddr()});
+            relay.push_back({pSideJ, pSideI, sockets[i]->getAddr()});
+            ipPorts[i][j] = pSideI->getIPPort();
+            ipPorts[j][i] = pSideJ->getIPPort();
+        }
+    }
+    isRelayRunning = true;
+    pRelayThread = new std::thread(runRelay);
+
+    for (int i = 0; i < PEER_COUNT; ++i)
+    {
+        auto pRTS = new onut::RTS();
+        pRTS->retain();
+        pRTS->addMe(sockets[i], getPlayerId(i));
+        pRTS->registerCommand(CMD_ORDER, sizeof(uint32_t), [i, pRTS](void* pData, onut::RTSPeer* pPeer)
+        {
+            uint32_t sequence;
+            memcpy(&sequence, pData, sizeof(sequence));
+            orders[i].push_back({pRTS->getTurn(), pPeer ? pPeer->getPlayerId() : getPlayerId(i), sequence});
+        });
+        for (int j = 0; j < PEER_COUNT; ++j)
+        {
+            if (j != i) pRTS->addPeer(new onut::RTSPeer(sockets[i], ipPorts[i][j], getPlayerId(j)));
+        }
+        pRTS->start();
+        peers[i] = pRTS;
+    }
+
+    // Play. Each peer gives an order every few frames
+    auto start = std::chrono::high_resolution_clock::now();
+    int frame = 0;
+    while (!isEveryoneAtTurn(TURN_COUNT))
+    {
+        if (getElapsedMs(start) > TIMEOUT_MS)
+        {
+            OLogE("Timed out at turn " + std::to_string(peers[0]->getTurn()));
+            break;
+        }
+        for (int i = 0; i < PEER_COUNT; ++i)
+        {
+            if ((frame + i) % 3 == 0)
+            {
+                peers[i]->sendCommand(CMD_ORDER, &sequences[i]);
+                ++sequences[i];
+            }
+            peers[i]->update();
+        }
+        ++frame;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    auto elapsed = getElapsedMs(start);
+
+    isRelayRunning = false;
+    pRelayThread->join();
+    delete pRelayThread;
+    pRelayThread = nullptr;
+
+    OLog(std::to_string(TURN_COUNT) + " turns in " + std::to_string(elapsed) + " ms, " +
+         std::to_string(dropCount) + " datagrams dropped, " + std::to_string(forwardCount) + " forwarded");
+    if (checkLockstep())
+    {
+        OLog("Peers stayed in lockstep");
+    }
+
+    for (auto pRTS : peers) pRTS->release();
+    for (auto pSocket : sockets) pSocket->release();
+    for (auto& side : relay) side.pSocket->release();
+    relay.clear();
+}
+
+void update()
+{
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+}
+
+void postRender()
+{
+}
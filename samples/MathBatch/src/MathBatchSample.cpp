@@ -0,0 +1,140 @@
+// Oak Nut include
+#include <onut/Log.h>
+#include <onut/MathBatch.h>
+#include <onut/Random.h>
+#include <onut/Renderer.h>
+#include <onut/Settings.h>
+#include <onut/SpriteBatch.h>
+
+// STL
+#include <chrono>
+#include <vector>
+
+// Times the batched math against the per value operators, then draws the
+// boxes that pass the culling of a moving view.
+static const size_t COUNT = 100000;
+static const int RUNS = 20;
+
+std::vector<Vector2> points;
+std::vector<float> xs, ys, outXs, outYs;
+std::vector<float> minXs, minYs, maxXs, maxYs;
+std::vector<uint8_t> visibles;
+std::vector<Vector2> froms, tos;
+std::vector<float> fromValues, toValues, outValues;
+float viewTime = 0.0f;
+
+template<typename Tfn>
+static double measure(Tfn fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < RUNS; ++i) fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count() / RUNS;
+}
+
+static void report(const std::string& name, double perValue, double batched)
+{
+    OLog(name + ": " + std::to_string(perValue) + " ms per value, " + std::to_string(batched) + " ms batched, " + std::to_string(perValue / batched) + "x");
+}
+
+void initSettings()
+{
+    oSettings->setGameName("Math Batch Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        auto position = ORandVector2(Vector2(-2560, -1440), Vector2(2560, 1440));
+        points.push_back(position);
+        xs.push_back(position.x);
+        ys.push_back(position.y);
+        minXs.push_back(position.x);
+        minYs.push_back(position.y);
+        maxXs.push_back(position.x + ORandFloat(4.0f, 16.0f));
+        maxYs.push_back(position.y + ORandFloat(4.0f, 16.0f));
+        froms.push_back(position);
+        tos.push_back(-position);
+        fromValues.push_back(position.x);
+        fromValues.push_back(position.y);
+        toValues.push_back(-position.x);
+        toValues.push_back(-position.y);
+    }
+    outXs.resize(COUNT);
+    outYs.resize(COUNT);
+    visibles.resize(COUNT);
+    outValues.resize(COUNT * 2);
+
+    // Transform
+    auto transform = Matrix::CreateRotationZ(.5f) * Matrix::CreateScale(2.0f) * Matrix::CreateTranslation(640, 360, 0);
+    std::vector<Vector2> transformed(COUNT);
+    auto perValue = measure([&]
+    {
+        for (size_t i = 0; i < COUNT; ++i) transformed[i] = Vector2::Transform(points[i], transform);
+    });
+    auto batched = measure([&]
+    {
+        onut::transformPoints(xs.data(), ys.data(), outXs.data(), outYs.data(), COUNT, transform);
+    });
+    report("Transform " + std::to_string(COUNT) + " points", perValue, batched);
+
+    // Culling
+    Rect view(-640, -360, 1280, 720);
+    size_t visibleCount = 0;
+    perValue = measure([&]
+    {
+        visibleCount = 0;
+        for (size_t i = 0; i < COUNT; ++i)
+        {
+            Rect box(minXs[i], minYs[i], maxXs[i] - minXs[i], maxYs[i] - minYs[i]);
+            auto isVisible = box.x + box.z >= view.x && box.x <= view.x + view.z && box.y + box.w >= view.y && box.y <= view.y + view.w;
+            visibles[i] = isVisible ? 1 : 0;
+            if (isVisible) ++visibleCount;
+        }
+    });
+    batched = measure([&]
+    {
+        visibleCount = onut::cullBoxes(minXs.data(), minYs.data(), maxXs.data(), maxYs.data(), COUNT, view, visibles.data());
+    });
+    report("Cull " + std::to_string(COUNT) + " boxes (" + std::to_string(visibleCount) + " visible)", perValue, batched);
+
+    // Lerp
+    std::vector<Vector2> lerped(COUNT);
+    perValue = measure([&]
+    {
+        for (size_t i = 0; i < COUNT; ++i) lerped[i] = onut::lerp(froms[i], tos[i], .25f);
+    });
+    batched = measure([&]
+    {
+        onut::lerpValues(fromValues.data(), toValues.data(), .25f, outValues.data(), COUNT * 2);
+    });
+    report("Lerp " + std::to_string(COUNT) + " Vector2", perValue, batched);
+}
+
+void update()
+{
+    viewTime += 1.0f / 120.0f;
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+
+    // The view wanders around the boxes, only the ones in it are drawn
+    Rect view(std::cos(viewTime * .3f) * 1500.0f - 640.0f, std::sin(viewTime * .4f) * 900.0f - 360.0f, 1280, 720);
+    onut::cullBoxes(minXs.data(), minYs.data(), maxXs.data(), maxYs.data(), COUNT, view, visibles.data());
+
+    oSpriteBatch->begin(Matrix::CreateTranslation(-view.x, -view.y, 0));
+    for (size_t i = 0; i < COUNT; ++i)
+    {
+        if (!visibles[i]) continue;
+        oSpriteBatch->drawRect(nullptr, Rect(minXs[i], minYs[i], maxXs[i] - minXs[i], maxYs[i] - minYs[i]), Color(.3f, .6f, 1, 1));
+    }
+    oSpriteBatch->end();
+}
+
+void postRender()
+{
+}
@@ -0,0 +1,153 @@
+// Oak Nut include
+#include <onut/Entity.h>
+#include <onut/Log.h>
+#include <onut/Random.h>
+#include <onut/Renderer.h>
+#include <onut/Replication.h>
+#include <onut/Settings.h>
+#include <onut/SpriteBatch.h>
+#include <onut/Timing.h>
+
+// STL
+#include <deque>
+
+// Server and clients all run in here. Snapshots go through a fake
+// network with latency and packet loss.
+static const int ENTITY_COUNT = 1000;
+static const int CLIENT_COUNT = 4;
+static const int LATENCY_TICKS = 3;
+static const float PACKET_LOSS = .05f;
+static const size_t SNAPSHOT_BUDGET = 1200; // Bytes, fits in one UDP packet
+
+struct Packet
+{
+    int arrivalTick;
+    std::vector<uint8_t> data;
+};
+
+struct Client
+{
+    onut::ReplicationServer::ClientId id;
+    OReplicationClientRef pReplicationClient;
+    std::deque<Packet> toClient;
+    std::deque<Packet> toServer;
+};
+
+OReplicationServerRef pServer;
+std::vector<OEntityRef> serverEntities;
+std::vector<Vector2> velocities;
+Client clients[CLIENT_COUNT];
+int tick = 0;
+size_t bytesSent = 0;
+int ticksSinceReport = 0;
+
+void initSettings()
+{
+    oSettings->setGameName("Replication Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    pServer = OReplicationServer::create();
+    for (int i = 0; i < ENTITY_COUNT; ++i)
+    {
+        auto pEntity = OEntity::create();
+        pEntity->setLocalTransform(Matrix::CreateTranslation(ORandFloat(1280.0f), ORandFloat(720.0f), 0.0f));
+        serverEntities.push_back(pEntity);
+        velocities.push_back(ORandVector2(Vector2(-120, -120), Vector2(120, 120)));
+
+        // Every tenth one is "important" and gets sent more often
+        pServer->add(pEntity, (i % 10) ? 1.0f : 4.0f);
+    }
+
+    for (auto& client : clients)
+    {
+        client.id = pServer->addClient();
+        client.pReplicationClient = OReplicationClient::create([](onut::replication::NetworkId id)
+        {
+            return OEntity::create();
+        });
+    }
+}
+
+void update()
+{
+    // Simulate
+    for (int i = 0; i < ENTITY_COUNT; ++i)
+    {
+        auto position = serverEntities[i]->getLocalTransform().Translation();
+        auto& velocity = velocities[i];
+        position += Vector3(velocity * ODT, 0.0f);
+        if (position.x < 0 || position.x > 1280) velocity.x = -velocity.x;
+        if (position.y < 0 || position.y > 720) velocity.y = -velocity.y;
+        serverEntities[i]->setLocalTransform(Matrix::CreateTranslation(position));
+    }
+
+    // Network tick
+    ++tick;
+    pServer->update();
+    uint8_t buffer[SNAPSHOT_BUDGET];
+    for (auto& client : clients)
+    {
+        auto size = pServer->writeSnapshot(client.id, buffer, SNAPSHOT_BUDGET);
+        bytesSent += size;
+        if (!ORandBool(PACKET_LOSS))
+        {
+            client.toClient.push_back({tick + LATENCY_TICKS, std::vector<uint8_t>(buffer, buffer + size)});
+        }
+
+        while (!client.toClient.empty() && client.toClient.front().arrivalTick <= tick)
+        {
+            auto& packet = client.toClient.front();
+            auto ackTick = client.pReplicationClient->readSnapshot(packet.data.data(), packet.data.size());
+            if (ackTick && !ORandBool(PACKET_LOSS))
+            {
+                client.toServer.push_back({tick + LATENCY_TICKS, std::vector<uint8_t>((uint8_t*)&ackTick, (uint8_t*)&ackTick + sizeof(ackTick))});
+            }
+            client.toClient.pop_front();
+        }
+
+        while (!client.toServer.empty() && client.toServer.front().arrivalTick <= tick)
+        {
+            onut::replication::Tick ackTick;
+            memcpy(&ackTick, client.toServer.front().data.data(), sizeof(ackTick));
+            pServer->onAck(client.id, ackTick);
+            client.toServer.pop_front();
+        }
+    }
+
+    if (++ticksSinceReport == 120)
+    {
+        OLog(std::to_string(bytesSent / ticksSinceReport / CLIENT_COUNT) + " bytes per client per tick, " + std::to_string(ENTITY_COUNT) + " entities");
+        bytesSent = 0;
+        ticksSinceReport = 0;
+    }
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+
+    oSpriteBatch->begin();
+
+    // Server in grey, what the first client sees in green
+    for (auto& pEntity : serverEntities)
+    {
+        auto position = pEntity->getLocalTransform().Translation();
+        oSpriteBatch->drawRect(nullptr, Rect(position.x - 2, position.y - 2, 4, 4), Color(.3f, .3f, .3f, 1));
+    }
+    for (int i = 0; i < ENTITY_COUNT; ++i)
+    {
+        auto pEntity = clients[0].pReplicationClient->getEntity(static_cast<onut::replication::NetworkId>(i + 1));
+        if (!pEntity) continue;
+        auto position = pEntity->getLocalTransform().Translation();
+        oSpriteBatch->drawRect(nullptr, Rect(position.x - 1, position.y - 1, 2, 2), Color(0, 1, 0, 1));
+    }
+
+    oSpriteBatch->end();
+}
+
+void postRender()
+{
+}
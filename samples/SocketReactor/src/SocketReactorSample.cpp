@@ -0,0 +1,200 @@
+// Oak Nut include
+#include <onut/Log.h>
+#include <onut/Renderer.h>
+#include <onut/Settings.h>
+#include <onut/SocketTCP.h>
+#include <onut/SocketTCPReactor.h>
+
+// STL
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+// System
+#if !defined(WIN32)
+#include <sys/resource.h>
+#endif
+
+// A stand-in for the match-making server and thousands of players, all on
+// loopback. Players join with the same null terminated json as Multiplayer,
+// and get their lobby once it is full. Then they ping the server.
+static const int PORT = 4445;
+static const int CLIENT_COUNT = 2000;
+static const int TEAM_SIZE = 4;
+static const int PING_ROUNDS = 20;
+static const int TIMEOUT_MS = 10000;
+
+OSocketTCPReactorRef pServer;
+OSocketTCPReactorRef pClients;
+std::vector<OSocketTCPRef> clients;
+
+std::mutex lobbyMutex;
+std::vector<std::pair<OSocketTCPRef, std::string>> lobby;
+std::atomic<int> lobbyCount(0);
+std::atomic<int> pongCount(0);
+
+static double getElapsedMs(const std::chrono::high_resolution_clock::time_point& start)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+}
+
+static bool waitFor(const std::atomic<int>& counter, int target)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    while (counter < target)
+    {
+        if (getElapsedMs(start) > TIMEOUT_MS) return false;
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+    return true;
+}
+
+// Each client and the server side of it both use a socket
+static int getMaxClientCount()
+{
+#if !defined(WIN32)
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == 0)
+    {
+        limit.rlim_cur = limit.rlim_max;
+        setrlimit(RLIMIT_NOFILE, &limit);
+        getrlimit(RLIMIT_NOFILE, &limit);
+        if (limit.rlim_cur != RLIM_INFINITY)
+        {
+            return std::min(CLIENT_COUNT, static_cast<int>(limit.rlim_cur - 64) / 2);
+        }
+    }
+#endif
+    return CLIENT_COUNT;
+}
+
+static void onServerMessage(const OSocketTCPRef& pSocket, const uint8_t* pData, size_t size)
+{
+    std::string message(reinterpret_cast<const char*>(pData), size);
+    if (message == "ping")
+    {
+        pSocket->send("pong", 5);
+        return;
+    }
+
+    // A player joined, send the lobby to everyone in it once it is full
+    std::vector<std::pair<OSocketTCPRef, std::string>> players;
+    {
+        std::lock_guard<std::mutex> lock(lobbyMutex);
+        lobby.push_back({pSocket, message});
+        if (lobby.size() < TEAM_SIZE) return;
+        players.swap(lobby);
+    }
+    std::vector<onut::SocketTCP::Buffer> buffers;
+    buffers.push_back({"{\"teams\":[[", 11});
+    for (size_t i = 0; i < players.size(); ++i)
+    {
+        if (i) buffers.push_back({",", 1});
+        buffers.push_back({players[i].second.data(), static_cast<int>(players[i].second.size())});
+    }
+    buffers.push_back({"]]}", 4}); // With the null terminator
+    for (auto& player : players)
+    {
+        player.first->send(buffers.data(), static_cast<int>(buffers.size()));
+    }
+}
+
+static void onClientMessage(const OSocketTCPRef& pSocket, const uint8_t* pData, size_t size)
+{
+    if (size == 4 && memcmp(pData, "pong", 4) == 0)
+    {
+        ++pongCount;
+    }
+    else
+    {
+        ++lobbyCount;
+    }
+}
+
+void initSettings()
+{
+    oSettings->setGameName("Socket Reactor Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    pServer = OSocketTCPReactor::create();
+    pClients = OSocketTCPReactor::create();
+    if (!pServer || !pClients)
+    {
+        OLogE("SocketTCPReactor is not supported on this platform");
+        return;
+    }
+    auto pListenSocket = OSocketTCP::listen(PORT);
+    if (!pListenSocket)
+    {
+        OLogE("Can't listen on port " + std::to_string(PORT));
+        return;
+    }
+    pServer->addListener(pListenSocket, [](const OSocketTCPRef& pSocket)
+    {
+        pServer->add(pSocket, onServerMessage);
+    });
+
+    // Connect and join
+    auto clientCount = getMaxClientCount() / TEAM_SIZE * TEAM_SIZE;
+    auto start = std::chrono::high_resolution_clock::now();
+    for (int i = 0; i < clientCount; ++i)
+    {
+        auto pSocket = OSocketTCP::connect("127.0.0.1", PORT);
+        if (!pSocket)
+        {
+            OLogE("Connection " + std::to_string(i) + " failed");
+            return;
+        }
+        pClients->add(pSocket, onClientMessage);
+        clients.push_back(pSocket);
+
+        auto join = "{\"id\":\"" + std::to_string(i) + "\",\"username\":\"Player" + std::to_string(i) + "\",\"rank\":1000,\"gameId\":\"sample\",\"modeId\":\"1v1v1v1\"}";
+        pSocket->send(join.c_str(), static_cast<int>(join.size()) + 1);
+    }
+    if (!waitFor(lobbyCount, clientCount))
+    {
+        OLogE("Only " + std::to_string(lobbyCount) + " of " + std::to_string(clientCount) + " lobbies received");
+        return;
+    }
+    OLog(std::to_string(clientCount) + " players connected and matched in " + std::to_string(getElapsedMs(start)) + " ms, " +
+         std::to_string(pServer->getConnectionCount()) + " sockets on the server reactor");
+
+    // Ping
+    start = std::chrono::high_resolution_clock::now();
+    for (int round = 1; round <= PING_ROUNDS; ++round)
+    {
+        for (auto& pSocket : clients)
+        {
+            pSocket->send("ping", 5);
+        }
+        if (!waitFor(pongCount, round * clientCount))
+        {
+            OLogE("Round " + std::to_string(round) + " timed out at " + std::to_string(pongCount) + " pongs");
+            return;
+        }
+    }
+    auto elapsed = getElapsedMs(start);
+    OLog(std::to_string(PING_ROUNDS * clientCount) + " round trips in " + std::to_string(elapsed) + " ms, " +
+         std::to_string(static_cast<double>(PING_ROUNDS * clientCount) / elapsed * 1000.0) + " per second");
+}
+
+void update()
+{
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+}
+
+void postRender()
+{
+}
@@ -0,0 +1,94 @@
+// Oak Nut include
+#include <onut/Input.h>
+#include <onut/Log.h>
+#include <onut/Random.h>
+#include <onut/Renderer.h>
+#include <onut/Settings.h>
+#include <onut/SpriteBatch.h>
+#include <onut/UIContext.h>
+#include <onut/UIControl.h>
+#include <onut/UIPanel.h>
+
+// STL
+#include <chrono>
+
+// 100 windows of 100 buttons. The hover is resolved twice per frame, once
+// walking every control and once from the hit test index.
+static const int WINDOW_COUNT = 100;
+static const int BUTTON_COUNT = 99;
+static const int FRAME_COUNT = 120;
+
+double walkTime = 0.0;
+double indexTime = 0.0;
+int frameCount = 0;
+
+template<typename Tfn>
+static double measure(Tfn fn)
+{
+    auto start = std::chrono::high_resolution_clock::now();
+    fn();
+    auto end = std::chrono::high_resolution_clock::now();
+    return std::chrono::duration<double, std::milli>(end - start).count();
+}
+
+void initSettings()
+{
+    oSettings->setGameName("UI Hit Test Sample");
+    oSettings->setResolution({1280, 720});
+}
+
+void init()
+{
+    for (int i = 0; i < WINDOW_COUNT; ++i)
+    {
+        auto pWindow = OUIPanel::create();
+        pWindow->rect = {ORandVector2(Vector2(0, 0), Vector2(1040, 520)), Vector2(240, 200)};
+        pWindow->color = Color(.2f, .2f, .25f, 1);
+        pWindow->clipChildren = true;
+        oUI->add(pWindow);
+
+        for (int j = 0; j < BUTTON_COUNT; ++j)
+        {
+            auto pButton = OUIPanel::create();
+            pButton->rect = {static_cast<float>(j % 10) * 24.f, static_cast<float>(j / 10) * 20.f + 8.f, 22, 18};
+            pButton->color = Color(.3f, .5f, .8f, 1);
+            pWindow->add(pButton);
+        }
+    }
+    OLog(std::to_string(WINDOW_COUNT * (BUTTON_COUNT + 1)) + " controls");
+}
+
+void update()
+{
+    const auto& mousePos = OGetMousePos();
+
+    oUIContext->useHitTestIndex = false;
+    walkTime += measure([&] { oUI->update(oUIContext, mousePos, false); });
+    oUIContext->useHitTestIndex = true;
+    indexTime += measure([&] { oUI->update(oUIContext, mousePos, false); });
+
+    if (++frameCount == FRAME_COUNT)
+    {
+        OLog("Hover walk: " + std::to_string(walkTime / frameCount) + " ms, index: " + std::to_string(indexTime / frameCount) + " ms");
+        walkTime = 0.0;
+        indexTime = 0.0;
+        frameCount = 0;
+    }
+}
+
+void render()
+{
+    oRenderer->clear(OColorHex(1d232d));
+}
+
+void postRender()
+{
+    // Outline what the index picked
+    auto pHover = oUIContext->getHoverControl();
+    if (pHover)
+    {
+        oSpriteBatch->begin();
+        oSpriteBatch->drawOutterOutlineRect(pHover->getWorldRect(oUIContext), 2.f, Color(1, 1, 0, 1));
+        oSpriteBatch->end();
+    }
+}
@@ -0,0 +1,231 @@
+// Onut
+#include <onut/Archive.h>
+#include <onut/Log.h>
+#include <onut/Strings.h>
+
+// STL
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+// Third party
+#include <zlib/zlib.h>
+
+namespace onut
+{
+    static const char SIGNATURE[4] = {'O', 'P', 'A', 'K'};
+    static const uint32_t VERSION = 1;
+    static const uint16_t FLAG_COMPRESSED = 1;
+
+    uint64_t Archive::hash(const std::string& path)
+    {
+        // FNV-1a. 0 marks empty buckets
+        uint64_t h = 14695981039346656037ULL;
+        for (auto c : path)
+        {
+            h ^= static_cast<uint8_t>(c);
+            h *= 1099511628211ULL;
+        }
+        return h ? h : 1;
+    }
+
+    bool Archive::pack(const std::string& archiveFilename, const std::string& folder)
+    {
+        return pack(archiveFilename, folder, PackOptions());
+    }
+
+    bool Archive::pack(const std::string& archiveFilename, const std::string& folder, const PackOptions& options)
+    {
+        auto filenames = findAllFiles(folder);
+        std::sort(filenames.begin(), filenames.end());
+
+        std::ofstream out(archiveFilename, std::ios::binary);
+        if (out.fail())
+        {
+            OLogE("Can't write " + archiveFilename);
+            return false;
+        }
+
+        Header header;
+        memcpy(header.signature, SIGNATURE, sizeof(SIGNATURE));
+        header.version = VERSION;
+        header.entryCount = static_cast<uint32_t>(filenames.size());
+        header.bucketCount = 1;
+        while (header.bucketCount < header.entryCount * 2) header.bucketCount <<= 1;
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+
+        // Data
+        std::vector<Entry> entries;
+        std::string names;
+        uint64_t offset = sizeof(header);
+        auto alignment = std::max<uint32_t>(1, options.alignment);
+        static const char padding[4096] = {0};
+        for (auto& filename : filenames)
+        {
+            auto path = filename.substr(folder.size() + 1);
+            std::replace(path.begin(), path.end(), '\\', '/');
+
+            auto data = getFileData(filename);
+            Entry entry;
+            entry.hash = hash(path);
+            entry.size = data.size();
+            entry.storedSize = data.size();
+            entry.nameOffset = static_cast<uint32_t>(names.size());
+            entry.nameLength = static_cast<uint16_t>(path.size());
+            entry.flags = 0;
+            names += path;
+
+            const auto& storeExtensions = options.storeExtensions;
+            if (options.compress && !data.empty() &&
+                std::find(storeExtensions.begin(), storeExtensions.end(), getExtension(path)) == storeExtensions.end())
+            {
+                auto compressedSize = compressBound(static_cast<uLong>(data.size()));
+                std::vector<uint8_t> compressed(compressedSize);
+                if (compress2(compressed.data(), &compressedSize, data.data(), static_cast<uLong>(data.size()), options.compressionLevel) == Z_OK &&
+                    compressedSize < data.size() - data.size() / 8)
+                {
+                    compressed.resize(compressedSize);
+                    data.swap(compressed);
+                    entry.storedSize = data.size();
+                    entry.flags |= FLAG_COMPRESSED;
+                }
+            }
+
+            auto pad = (alignment - offset % alignment) % alignment;
+            while (pad)
+            {
+                auto size = std::min<uint64_t>(pad, sizeof(padding));
+                out.write(padding, size);
+                offset += size;
+                pad -= size;
+            }
+            entry.offset = offset;
+            out.write(reinterpret_cast<const char*>(data.data()), data.size());
+            offset += data.size();
+            entries.push_back(entry);
+        }
+
+        // Table of content, open addressing
+        std::vector<Entry> buckets(header.bucketCount);
+        memset(buckets.data(), 0, sizeof(Entry) * buckets.size());
+        for (auto& entry : entries)
+        {
+            auto index = entry.hash & (header.bucketCount - 1);
+            while (buckets[index].hash) index = (index + 1) & (header.bucketCount - 1);
+            buckets[index] = entry;
+        }
+        auto pad = (8 - offset % 8) % 8;
+        out.write(padding, pad);
+        offset += pad;
+        header.tocOffset = offset;
+        out.write(reinterpret_cast<const char*>(buckets.data()), sizeof(Entry) * buckets.size());
+        header.namesOffset = header.tocOffset + sizeof(Entry) * buckets.size();
+        out.write(names.data(), names.size());
+
+        out.seekp(0);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        return !out.fail();
+    }
+
+    OArchiveRef Archive::open(const std::string& filename)
+    {
+        auto mapping = mapFileData(filename);
+        if (mapping.getSize() < sizeof(Header)) return nullptr;
+
+        auto pHeader = reinterpret_cast<const Header*>(mapping.getData());
+        if (memcmp(pHeader->signature, SIGNATURE, sizeof(SIGNATURE)) || pHeader->version != VERSION) return nullptr;
+        if (!pHeader->bucketCount || (pHeader->bucketCount & (pHeader->bucketCount - 1)) ||
+            pHeader->tocOffset > mapping.getSize() ||
+            sizeof(Entry) * pHeader->bucketCount > mapping.getSize() - pHeader->tocOffset ||
+            pHeader->namesOffset > mapping.getSize())
+        {
+            OLogE("Corrupted archive: " + filename);
+            return nullptr;
+        }
+
+        // Names are compared in place, they have to be in the file
+        auto pEntries = reinterpret_cast<const Entry*>(mapping.getData() + pHeader->tocOffset);
+        auto namesSize = mapping.getSize() - pHeader->namesOffset;
+        for (uint32_t i = 0; i < pHeader->bucketCount; ++i)
+        {
+            const auto& entry = pEntries[i];
+            if (entry.hash && static_cast<uint64_t>(entry.nameOffset) + entry.nameLength > namesSize)
+            {
+                OLogE("Corrupted archive: " + filename);
+                return nullptr;
+            }
+        }
+
+        auto pRet = std::shared_ptr<Archive>(new Archive());
+        pRet->m_filename = filename;
+        pRet->m_pHeader = pHeader;
+        pRet->m_pEntries = pEntries;
+        pRet->m_pNames = reinterpret_cast<const char*>(mapping.getData() + pHeader->namesOffset);
+        pRet->m_mapping = std::move(mapping);
+        return pRet;
+    }
+
+    Archive::~Archive()
+    {
+    }
+
+    const Archive::Entry* Archive::find(const std::string& path) const
+    {
+        auto h = hash(path);
+        auto mask = m_pHeader->bucketCount - 1;
+        auto index = h & mask;
+        for (uint32_t probe = 0; probe < m_pHeader->bucketCount; ++probe, index = (index + 1) & mask) // A full table has no empty bucket to stop at
+        {
+            auto pEntry = m_pEntries + index;
+            if (!pEntry->hash) return nullptr;
+            if (pEntry->hash == h &&
+                pEntry->nameLength == path.size() &&
+                !memcmp(m_pNames + pEntry->nameOffset, path.data(), path.size()))
+            {
+                return pEntry;
+            }
+        }
+        return nullptr;
+    }
+
+    bool Archive::contains(const std::string& path) const
+    {
+        return find(path) != nullptr;
+    }
+
+    FileData Archive::read(const std::string& path) const
+    {
+        auto pEntry = find(path);
+        if (!pEntry) return {};
+        if (pEntry->offset + pEntry->storedSize > m_mapping.getSize()) return {};
+        auto pData = m_mapping.getData() + pEntry->offset;
+
+        if (!(pEntry->flags & FLAG_COMPRESSED))
+        {
+            // Zero copy, the view keeps the mapping alive
+            return m_mapping.subData(pData, static_cast<size_t>(pEntry->size));
+        }
+
+        std::vector<uint8_t> data(static_cast<size_t>(pEntry->size));
+        auto size = static_cast<uLongf>(data.size());
+        if (uncompress(data.data(), &size, pData, static_cast<uLong>(pEntry->storedSize)) != Z_OK || size != data.size())
+        {
+            OLogE("Corrupted archive entry: " + path);
+            return {};
+        }
+        return FileData(std::move(data));
+    }
+
+    std::vector<std::string> Archive::getPaths() const
+    {
+        std::vector<std::string> paths;
+        paths.reserve(m_pHeader->entryCount);
+        for (uint32_t i = 0; i < m_pHeader->bucketCount; ++i)
+        {
+            auto pEntry = m_pEntries + i;
+            if (!pEntry->hash) continue;
+            paths.push_back(std::string(m_pNames + pEntry->nameOffset, pEntry->nameLength));
+        }
+        return paths;
+    }
+}
@@ -1,90 +1,369 @@
 // Onut
 #include <onut/ContentManager.h>
 #include <onut/CSV.h>
-#include <onut/Strings.h>
 
 // STL
 #include <cassert>
-#include <fstream>
+#include <cerrno>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ONUT_CSV_SSE2
+#include <emmintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#endif
 
 namespace onut
 {
-    OCSVRef CSV::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager)
+#if defined(ONUT_CSV_SSE2)
+    static int countTrailingZeros(unsigned int mask)
     {
-        return std::shared_ptr<OCSV>(new OCSV(filename));
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctz(mask);
+#endif
     }
+#endif
 
-    int CSV::getRowCount() const
+    // Calls back with every ',' and '\n', 16 bytes at a time when we can
+    template<typename Tcallback>
+    static void forEachDelimiter(const char* pText, const char* pTextEnd, Tcallback callback)
     {
-        return m_rowCount;
+#if defined(ONUT_CSV_SSE2)
+        auto commas = _mm_set1_epi8(',');
+        auto newLines = _mm_set1_epi8('\n');
+        for (; pTextEnd - pText >= 16; pText += 16)
+        {
+            auto chars = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pText));
+            auto mask = static_cast<unsigned int>(_mm_movemask_epi8(_mm_or_si128(_mm_cmpeq_epi8(chars, commas), _mm_cmpeq_epi8(chars, newLines))));
+            while (mask)
+            {
+                callback(pText + countTrailingZeros(mask));
+                mask &= mask - 1;
+            }
+        }
+#endif
+        for (; pText < pTextEnd; ++pText)
+        {
+            if (*pText == ',' || *pText == '\n') callback(pText);
+        }
     }
 
-    CSV::CSV(const std::string& filename)
+    // Open addressing over ids into the string list, no allocation per lookup
+    class StringInterner final
     {
-        std::string line;
-        std::ifstream fic(filename);
-        if (!fic) return;
-        std::getline(fic, line);
-        auto columnNames = onut::splitString(line, ',');
-        while (!fic.eof())
+    public:
+        StringInterner(std::vector<std::string>& strings)
+            : m_strings(strings)
+            , m_slots(1024, 0)
         {
-            std::getline(fic, line);
-            auto valuesSplit = onut::splitString(line, ',', false);
-            assert(valuesSplit.size() == columnNames.size()); // malformed
-            for (size_t i = 0; i < columnNames.size(); ++i)
+        }
+
+        uint32_t intern(const char* pValue, size_t length)
+        {
+            uint32_t hash = 2166136261u; // FNV-1a
+            for (size_t i = 0; i < length; ++i)
             {
-                m_columnMap[columnNames[i]].push_back(valuesSplit[i]);
+                hash = (hash ^ static_cast<uint8_t>(pValue[i])) * 16777619u;
             }
-            ++m_rowCount;
+            auto mask = m_slots.size() - 1;
+            for (auto slot = hash & mask;; slot = (slot + 1) & mask)
+            {
+                auto& slotValue = m_slots[slot];
+                if (!slotValue)
+                {
+                    auto id = static_cast<uint32_t>(m_strings.size());
+                    m_strings.emplace_back(pValue, length);
+                    slotValue = (static_cast<uint64_t>(hash) << 32) | (id + 1);
+                    if (m_strings.size() * 2 > m_slots.size()) grow();
+                    return id;
+                }
+                if (static_cast<uint32_t>(slotValue >> 32) == hash)
+                {
+                    auto id = static_cast<uint32_t>(slotValue) - 1;
+                    const auto& str = m_strings[id];
+                    if (str.size() == length && !memcmp(str.data(), pValue, length)) return id;
+                }
+            }
+        }
+
+    private:
+        void grow()
+        {
+            std::vector<uint64_t> slots(m_slots.size() * 2, 0);
+            auto mask = slots.size() - 1;
+            for (auto slotValue : m_slots)
+            {
+                if (!slotValue) continue;
+                auto slot = (slotValue >> 32) & mask;
+                while (slots[slot]) slot = (slot + 1) & mask;
+                slots[slot] = slotValue;
+            }
+            m_slots.swap(slots);
+        }
+
+        std::vector<std::string>& m_strings;
+        std::vector<uint64_t> m_slots; // Hash in the high bits, id + 1 in the low bits. 0 is free
+    };
+
+    // Same values std::stoi and std::stod give, 0 where they would throw.
+    // Returns true if the whole string was used
+    static bool parseInt(const char* szValue, int& out)
+    {
+        char* pEnd;
+        errno = 0;
+        auto value = std::strtol(szValue, &pEnd, 10);
+        if (pEnd == szValue || errno == ERANGE || value < INT_MIN || value > INT_MAX)
+        {
+            out = 0;
+            return false;
         }
-        fic.close();
+        out = static_cast<int>(value);
+        return *pEnd == '\0';
     }
 
-    const std::string& CSV::getValue(const std::string& column, int row) const
+    static bool parseNumber(const char* szValue, double& out)
     {
-        static std::string empty("");
-        const auto& itColumn = m_columnMap.find(column);
-        if (itColumn == m_columnMap.end()) return empty;
-        const auto& columnRows = itColumn->second;
-        if (row < 0 || row >= static_cast<int>(columnRows.size())) return empty;
-        return columnRows[row];
+        char* pEnd;
+        errno = 0;
+        auto value = std::strtod(szValue, &pEnd);
+        if (pEnd == szValue || errno == ERANGE)
+        {
+            out = 0.0;
+            return false;
+        }
+        out = value;
+        return *pEnd == '\0';
     }
 
-    int CSV::getInt(const std::string& column, int row) const
+    OCSVRef CSV::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager)
+    {
+        // Loose files are parsed straight from a mapping. Archives are mapped already
+        auto data = mapFileData(filename);
+        if (data.isEmpty()) data = readResourceFile(filename, pContentManager);
+        return std::shared_ptr<OCSV>(new OCSV(data));
+    }
+
+    bool CSV::reload(const OContentManagerRef& pContentManager)
+    {
+        // Keep what we have if the file is gone or caught mid-save
+        auto pNew = createFromFile(getFilename(), pContentManager);
+        if (pNew->m_columns.empty()) return false;
+
+        std::swap(m_columnMap, pNew->m_columnMap);
+        std::swap(m_columns, pNew->m_columns);
+        std::swap(m_strings, pNew->m_strings);
+        std::swap(m_parsedStrings, pNew->m_parsedStrings);
+        std::swap(m_rowCount, pNew->m_rowCount);
+        return true;
+    }
+
+    int CSV::getRowCount() const
     {
-        try
+        return m_rowCount;
+    }
+
+    CSV::CSV(const FileData& data)
+    {
+        if (data.isEmpty()) return;
+
+        // Id 0 is the empty string, for missing cells
+        StringInterner interner(m_strings);
+        interner.intern("", 0);
+
+        auto pText = reinterpret_cast<const char*>(data.getData());
+        auto pTextEnd = pText + data.getSize();
+        auto pCell = pText;
+        bool isHeader = true;
+        std::vector<std::string> columnNames;
+        std::vector<uint32_t> row;
+
+        auto addCell = [&](const char* pCellEnd)
+        {
+            if (pCellEnd > pCell && pCellEnd[-1] == '\r' && (pCellEnd == pTextEnd || *pCellEnd == '\n')) --pCellEnd;
+            if (isHeader)
+            {
+                columnNames.emplace_back(pCell, pCellEnd);
+                return;
+            }
+            row.push_back(interner.intern(pCell, static_cast<size_t>(pCellEnd - pCell)));
+        };
+
+        auto endRow = [&]()
+        {
+            if (isHeader)
+            {
+                isHeader = false;
+                m_columns.resize(columnNames.size());
+                for (size_t i = 0; i < columnNames.size(); ++i)
+                {
+                    m_columnMap.insert({columnNames[i], static_cast<ColumnHandle>(i)});
+                }
+                return;
+            }
+            if (row.size() == 1 && row[0] == 0)
+            {
+                row.clear(); // Empty line
+                return;
+            }
+            assert(row.size() == m_columns.size()); // malformed
+            row.resize(m_columns.size(), 0);
+            for (size_t i = 0; i < m_columns.size(); ++i)
+            {
+                m_columns[i].stringIds.push_back(row[i]);
+            }
+            row.clear();
+            ++m_rowCount;
+        };
+
+        forEachDelimiter(pText, pTextEnd, [&](const char* pDelimiter)
+        {
+            addCell(pDelimiter);
+            pCell = pDelimiter + 1;
+            if (*pDelimiter == '\n') endRow();
+        });
+        if (pCell < pTextEnd || !row.empty())
+        {
+            addCell(pTextEnd);
+            endRow();
+        }
+
+        // Parse each distinct string once. Empty cells fit in any column, as 0
+        std::vector<uint8_t> fitsInts(m_strings.size());
+        std::vector<uint8_t> fitsNumbers(m_strings.size());
+        m_parsedStrings.resize(m_strings.size());
+        for (size_t i = 0; i < m_strings.size(); ++i)
         {
-            return std::stoi(getValue(column, row));
+            auto& parsed = m_parsedStrings[i];
+            auto szValue = m_strings[i].c_str();
+            fitsInts[i] = parseInt(szValue, parsed.intValue) || !*szValue;
+            fitsNumbers[i] = parseNumber(szValue, parsed.number) || !*szValue;
         }
-        catch (...)
+
+        for (auto& column : m_columns)
         {
-            return 0;
+            column.type = ColumnType::Int;
+            for (auto id : column.stringIds)
+            {
+                if (!fitsNumbers[id])
+                {
+                    column.type = ColumnType::String;
+                    break;
+                }
+                if (!fitsInts[id]) column.type = ColumnType::Float;
+            }
+            if (column.type == ColumnType::String) continue;
+
+            column.ints.reserve(column.stringIds.size());
+            for (auto id : column.stringIds)
+            {
+                column.ints.push_back(m_parsedStrings[id].intValue);
+            }
+            if (column.type == ColumnType::Float)
+            {
+                column.numbers.reserve(column.stringIds.size());
+                for (auto id : column.stringIds)
+                {
+                    column.numbers.push_back(m_parsedStrings[id].number);
+                }
+            }
         }
     }
 
-    float CSV::getFloat(const std::string& column, int row) const
+    size_t CSV::getMemorySize() const
     {
-        try
+        size_t size = m_strings.size() * (sizeof(std::string) + sizeof(ParsedString));
+        for (const auto& str : m_strings)
         {
-            return std::stof(getValue(column, row));
+            size += str.capacity();
         }
-        catch (...)
+        for (const auto& column : m_columns)
         {
-            return 0.0f;
+            size += column.stringIds.size() * sizeof(uint32_t);
+            size += column.ints.size() * sizeof(int);
+            size += column.numbers.size() * sizeof(double);
         }
+        return size;
     }
 
-    double CSV::getDouble(const std::string& column, int row) const
+    CSV::ColumnHandle CSV::getColumn(const std::string& name) const
     {
-        try
-        {
-            return std::stod(getValue(column, row));
-        }
-        catch (...)
+        auto it = m_columnMap.find(name);
+        if (it == m_columnMap.end()) return -1;
+        return it->second;
+    }
+
+    CSV::ColumnType CSV::getColumnType(ColumnHandle column) const
+    {
+        if (column < 0 || column >= static_cast<ColumnHandle>(m_columns.size())) return ColumnType::String;
+        return m_columns[column].type;
+    }
+
+    const CSV::Column* CSV::getColumnData(ColumnHandle column, int row) const
+    {
+        if (column < 0 || column >= static_cast<ColumnHandle>(m_columns.size())) return nullptr;
+        if (row < 0 || row >= m_rowCount) return nullptr;
+        return &m_columns[column];
+    }
+
+    const std::string& CSV::getValue(ColumnHandle column, int row) const
+    {
+        static std::string empty("");
+        auto pColumn = getColumnData(column, row);
+        if (!pColumn) return empty;
+        return m_strings[pColumn->stringIds[row]];
+    }
+
+    int CSV::getInt(ColumnHandle column, int row) const
+    {
+        auto pColumn = getColumnData(column, row);
+        if (!pColumn) return 0;
+        if (pColumn->type == ColumnType::String) return m_parsedStrings[pColumn->stringIds[row]].intValue;
+        return pColumn->ints[row];
+    }
+
+    float CSV::getFloat(ColumnHandle column, int row) const
+    {
+        return static_cast<float>(getDouble(column, row));
+    }
+
+    double CSV::getDouble(ColumnHandle column, int row) const
+    {
+        auto pColumn = getColumnData(column, row);
+        if (!pColumn) return 0.0;
+        switch (pColumn->type)
         {
-            return 0.0;
+            case ColumnType::Int: return static_cast<double>(pColumn->ints[row]);
+            case ColumnType::Float: return pColumn->numbers[row];
+            default: return m_parsedStrings[pColumn->stringIds[row]].number;
         }
     }
+
+    const std::string& CSV::getValue(const std::string& column, int row) const
+    {
+        return getValue(getColumn(column), row);
+    }
+
+    int CSV::getInt(const std::string& column, int row) const
+    {
+        return getInt(getColumn(column), row);
+    }
+
+    float CSV::getFloat(const std::string& column, int row) const
+    {
+        return getFloat(getColumn(column), row);
+    }
+
+    double CSV::getDouble(const std::string& column, int row) const
+    {
+        return getDouble(getColumn(column), row);
+    }
 }
 
 OCSVRef OGetCSV(const std::string& name)
@@ -1,10 +1,26 @@
 // Onut
+#include <onut/Archive.h>
 #include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
+#include <onut/FileWatcher.h>
 #include <onut/Files.h>
+#include <onut/Log.h>
 #include <onut/Resource.h>
+#include <onut/Settings.h>
+#include <onut/Strings.h>
 
 // STL
+#include <algorithm>
 #include <cassert>
+#include <chrono>
+#include <string.h>
+
+// Third party
+#if defined(WIN32)
+#include <dirent/dirent.h>
+#elif defined(__linux__) || defined(__APPLE__)
+#include <dirent.h>
+#endif
 
 OContentManagerRef oContentManager;
 
@@ -22,6 +38,21 @@ namespace onut
 
     ContentManager::~ContentManager()
     {
+        if (m_pAsyncQueue)
+        {
+            {
+                std::unique_lock<std::mutex> locker(m_pAsyncQueue->mutex);
+                m_pAsyncQueue->isRunning = false;
+                m_pAsyncQueue->queue.clear();
+            }
+            m_pAsyncQueue->wakeUp.notify_all();
+            for (auto& thread : m_pAsyncQueue->threads)
+            {
+                // A loader thread can end up holding the last reference
+                if (thread.get_id() == std::this_thread::get_id()) thread.detach();
+                else thread.join();
+            }
+        }
         std::unique_lock<std::mutex> locker(m_mutex);
     }
 
@@ -35,8 +66,11 @@ namespace onut
 
     void ContentManager::clearSearchPaths()
     {
-        std::unique_lock<std::mutex> locker(m_mutex);
-        m_searchPaths.clear();
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_searchPaths.clear();
+        }
+        refreshSearchPaths();
     }
 
     const ContentManager::SearchPaths& ContentManager::getSearchPaths() const
@@ -46,29 +80,553 @@ namespace onut
 
     void ContentManager::addSearchPath(const std::string& path)
     {
-        std::unique_lock<std::mutex> locker(m_mutex);
-        m_searchPaths.push_back(path);
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            m_searchPaths.push_back(path);
+        }
+        refreshSearchPaths();
+    }
+
+    void ContentManager::refreshSearchPaths()
+    {
+        std::unique_lock<std::mutex> locker(m_searchIndexMutex);
+        std::atomic_store(&m_pSearchIndex, SearchIndexRef());
+    }
+
+    // Same order as findFile, so the same file wins when names collide
+    static void indexFolder(const std::string& path, std::unordered_map<std::string, std::string>& files)
+    {
+        auto dir = opendir(path.c_str());
+        if (!dir) return;
+        while (auto ent = readdir(dir))
+        {
+            if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) continue;
+            auto filename = path + "/" + ent->d_name;
+            files.insert({ent->d_name, filename});
+            if (ent->d_type & DT_DIR)
+            {
+                indexFolder(filename, files);
+            }
+        }
+        closedir(dir);
+    }
+
+    static void indexArchive(const std::string& path, const OArchiveRef& pArchive, std::unordered_map<std::string, std::string>& files)
+    {
+        for (auto& relPath : pArchive->getPaths())
+        {
+            files.insert({getFilename(relPath), path + "/" + relPath});
+        }
+    }
+
+    ContentManager::SearchIndexRef ContentManager::getSearchIndex()
+    {
+        auto pSearchIndex = std::atomic_load(&m_pSearchIndex);
+        if (pSearchIndex) return pSearchIndex;
+
+        std::unique_lock<std::mutex> indexLocker(m_searchIndexMutex);
+        pSearchIndex = std::atomic_load(&m_pSearchIndex);
+        if (pSearchIndex) return pSearchIndex; // Another thread just built it
+
+        SearchPaths searchPaths;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            searchPaths = m_searchPaths;
+        }
+
+        // In editor mode, keep the index up to date as files come and go
+        if (oSettings && oSettings->getIsEditorMode())
+        {
+            if (!m_pFileWatcher) m_pFileWatcher = FileWatcher::create();
+        }
+
+        auto pNewSearchIndex = std::make_shared<SearchIndex>();
+        for (auto& path : searchPaths)
+        {
+            auto pFileIndex = std::make_shared<FileIndex>();
+            pFileIndex->path = path;
+            if (getExtension(path) == "OPAK")
+            {
+                pFileIndex->pArchive = Archive::open(path);
+                if (pFileIndex->pArchive) indexArchive(path, pFileIndex->pArchive, pFileIndex->files);
+                pNewSearchIndex->push_back(pFileIndex);
+                continue;
+            }
+            indexFolder(path, pFileIndex->files);
+            pNewSearchIndex->push_back(pFileIndex);
+
+            if (m_pFileWatcher)
+            {
+                m_pFileWatcher->watch(path, [this, path](FileWatcher::Event event, const std::string& filename)
+                {
+                    if (event != FileWatcher::Event::Modified) onFileChanged(path, event == FileWatcher::Event::Removed, filename);
+                    else queueReload(filename);
+                });
+            }
+        }
+
+        std::atomic_store(&m_pSearchIndex, SearchIndexRef(pNewSearchIndex));
+        return pNewSearchIndex;
+    }
+
+    void ContentManager::onFileChanged(const std::string& searchPath, bool isRemoved, const std::string& filename)
+    {
+        std::unique_lock<std::mutex> indexLocker(m_searchIndexMutex);
+        auto pSearchIndex = std::atomic_load(&m_pSearchIndex);
+        if (!pSearchIndex) return; // Will be rebuilt anyway
+
+        auto name = getFilename(filename);
+        auto pNewSearchIndex = std::make_shared<SearchIndex>(*pSearchIndex);
+        for (auto& pFileIndex : *pNewSearchIndex)
+        {
+            if (pFileIndex->path != searchPath) continue;
+            auto it = pFileIndex->files.find(name);
+            if (isRemoved)
+            {
+                if (it == pFileIndex->files.end() || it->second != filename) return;
+
+                // Another file with the same name might take its place
+                auto pNewFileIndex = std::make_shared<FileIndex>();
+                pNewFileIndex->path = searchPath;
+                indexFolder(searchPath, pNewFileIndex->files);
+                pFileIndex = pNewFileIndex;
+            }
+            else
+            {
+                if (it != pFileIndex->files.end()) return;
+                auto pNewFileIndex = std::make_shared<FileIndex>(*pFileIndex);
+                pNewFileIndex->files[name] = filename;
+                pFileIndex = pNewFileIndex;
+            }
+            std::atomic_store(&m_pSearchIndex, SearchIndexRef(pNewSearchIndex));
+            return;
+        }
     }
 
     std::string ContentManager::findResourceFile(const std::string& name)
     {
-        std::string filename;
-        std::unique_lock<std::mutex> locker(m_mutex);
-        for (auto& path : m_searchPaths)
+        auto pSearchIndex = getSearchIndex();
+        for (auto& pFileIndex : *pSearchIndex)
+        {
+            auto it = pFileIndex->files.find(name);
+            if (it != pFileIndex->files.end())
+            {
+                return it->second;
+            }
+        }
+
+        // Editor without a file watcher, the index could be stale
+        if (!m_pFileWatcher && oSettings && oSettings->getIsEditorMode())
+        {
+            for (auto& pFileIndex : *pSearchIndex)
+            {
+                if (pFileIndex->pArchive) continue;
+                auto filename = findFile(name, pFileIndex->path, true);
+                if (!filename.empty())
+                {
+                    return filename;
+                }
+            }
+        }
+
+        return "";
+    }
+
+    void ContentManager::queueReload(const std::string& filename)
+    {
+        std::unique_lock<std::mutex> locker(m_reloadMutex);
+        if (std::find(m_reloadQueue.begin(), m_reloadQueue.end(), filename) == m_reloadQueue.end())
+        {
+            m_reloadQueue.push_back(filename);
+        }
+    }
+
+    void ContentManager::reload(const std::string& filename)
+    {
+        // A cooked texture is loaded in place of the image next to it
+        auto isCookedTexture = getExtension(filename) == toUpper(CookedTexture::EXTENSION);
+        auto baseFilename = filename.substr(0, filename.find_last_of('.'));
+
+        std::vector<std::pair<std::string, OResourceRef>> resources;
+        {
+            std::unique_lock<std::mutex> locker(m_mutex);
+            for (auto& kv : m_resources)
+            {
+                if (!kv.second.pResource) continue; // Failed to load
+                auto& resourceFilename = kv.second.pResource->getFilename();
+                if (resourceFilename == filename ||
+                    (isCookedTexture && kv.second.category == Resource::MemoryCategory::Texture &&
+                     resourceFilename.substr(0, resourceFilename.find_last_of('.')) == baseFilename))
+                {
+                    resources.push_back({kv.first, kv.second.pResource});
+                }
+            }
+        }
+
+        for (auto& resource : resources)
+        {
+            if (!resource.second->reload(shared_from_this()))
+            {
+                OLogW("Can't reload " + resource.first);
+                continue;
+            }
+            OLog("Reloaded " + resource.first);
+
+            std::unique_lock<std::mutex> locker(m_mutex);
+            auto it = m_resources.find(resource.first);
+            if (it == m_resources.end() || it->second.pResource != resource.second) continue;
+            auto size = resource.second->getMemorySize();
+            auto& stats = m_memoryStats[static_cast<int>(it->second.category)];
+            stats.size = stats.size - it->second.size + size;
+            it->second.size = size;
+        }
+    }
+
+    FileData ContentManager::readFile(const std::string& filename)
+    {
+        auto pSearchIndex = getSearchIndex();
+        for (auto& pFileIndex : *pSearchIndex)
+        {
+            auto& path = pFileIndex->path;
+            if (pFileIndex->pArchive &&
+                filename.size() > path.size() &&
+                filename[path.size()] == '/' &&
+                !filename.compare(0, path.size(), path))
+            {
+                return pFileIndex->pArchive->read(filename.substr(path.size() + 1));
+            }
+        }
+        return FileData(getFileData(filename));
+    }
+
+    FileData readResourceFile(const std::string& filename, OContentManagerRef pContentManager)
+    {
+        if (!pContentManager) pContentManager = oContentManager;
+        if (!pContentManager) return FileData(getFileData(filename));
+        return pContentManager->readFile(filename);
+    }
+
+    bool ContentManager::AsyncLoad::isDone() const
+    {
+        auto state = m_state.load();
+        return state == State::Loaded || state == State::Failed || state == State::Canceled;
+    }
+
+    OResourceRef ContentManager::AsyncLoad::getResource() const
+    {
+        if (m_state != State::Loaded) return nullptr;
+        return m_pResource;
+    }
+
+    void ContentManager::AsyncLoad::cancel()
+    {
+        auto state = m_state.load();
+        while (state != State::Loaded && state != State::Failed && state != State::Canceled)
+        {
+            if (m_state.compare_exchange_weak(state, State::Canceled)) break;
+        }
+    }
+
+    ContentManager::AsyncLoadRef ContentManager::loadAsync(const std::string& name, float priority, const AsyncPrepare& prepare, const AsyncCallback& onLoaded)
+    {
+        std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+
+        auto it = m_asyncLoads.find(name);
+        if (it != m_asyncLoads.end() && it->second->getState() != AsyncLoad::State::Canceled)
+        {
+            auto& pLoad = it->second;
+            if (priority > pLoad->m_priority) pLoad->m_priority = priority;
+            if (onLoaded) pLoad->m_callbacks.push_back(onLoaded);
+            return pLoad;
+        }
+
+        auto pLoad = std::make_shared<AsyncLoad>();
+        pLoad->m_name = name;
+        pLoad->m_priority = priority;
+        pLoad->m_order = ++m_asyncOrder;
+        if (onLoaded) pLoad->m_callbacks.push_back(onLoaded);
+
+        auto pResource = getResource(name);
+        if (pResource)
+        {
+            pLoad->m_pResource = pResource;
+            pLoad->m_state = AsyncLoad::State::Loaded;
+            if (onLoaded) m_asyncCompleted.push_back(pLoad);
+            return pLoad;
+        }
+        m_asyncLoads[name] = pLoad;
+
+        if (!m_pAsyncQueue)
+        {
+            m_pAsyncQueue = std::make_shared<AsyncQueue>();
+            auto threadCount = std::max(1, std::min(4, static_cast<int>(std::thread::hardware_concurrency()) - 1));
+            for (int i = 0; i < threadCount; ++i)
+            {
+                m_pAsyncQueue->threads.push_back(std::thread(loaderThread, m_pAsyncQueue, OContentManagerWeak(shared_from_this())));
+            }
+        }
+        {
+            std::unique_lock<std::mutex> locker(m_pAsyncQueue->mutex);
+            m_pAsyncQueue->queue.push_back({pLoad, prepare});
+        }
+        m_pAsyncQueue->wakeUp.notify_one();
+
+        return pLoad;
+    }
+
+    size_t ContentManager::getAsyncLoadCount()
+    {
+        std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+        return m_asyncLoads.size();
+    }
+
+    void ContentManager::loaderThread(AsyncQueueRef pAsyncQueue, OContentManagerWeak pWeakThis)
+    {
+        while (true)
+        {
+            AsyncRequest request;
+            {
+                std::unique_lock<std::mutex> locker(pAsyncQueue->mutex);
+                pAsyncQueue->wakeUp.wait(locker, [&pAsyncQueue]
+                {
+                    return !pAsyncQueue->isRunning || !pAsyncQueue->queue.empty();
+                });
+                if (!pAsyncQueue->isRunning) return;
+
+                // Highest priority first, then in order. Priorities can change while queued
+                auto& queue = pAsyncQueue->queue;
+                auto it = std::max_element(queue.begin(), queue.end(), [](const AsyncRequest& a, const AsyncRequest& b)
+                {
+                    float priorityA = a.pLoad->m_priority;
+                    float priorityB = b.pLoad->m_priority;
+                    if (priorityA != priorityB) return priorityA < priorityB;
+                    return a.pLoad->m_order > b.pLoad->m_order;
+                });
+                request = *it;
+                queue.erase(it);
+            }
+
+            auto pThis = pWeakThis.lock();
+            if (!pThis) return;
+            pThis->runAsync(request);
+        }
+    }
+
+    void ContentManager::runAsync(const AsyncRequest& request)
+    {
+        auto& pLoad = request.pLoad;
+        auto state = AsyncLoad::State::Queued;
+        if (!pLoad->m_state.compare_exchange_strong(state, AsyncLoad::State::Loading))
         {
-            filename = findFile(name, path, true);
-            if (!filename.empty())
+            completeAsync(pLoad, "", nullptr); // Canceled
+            return;
+        }
+
+        auto pResource = getResource(pLoad->m_name);
+        if (pResource)
+        {
+            completeAsync(pLoad, "", pResource);
+            return;
+        }
+
+        auto filename = findResourceFile(getFilename(pLoad->m_name));
+        if (filename.empty())
+        {
+            completeAsync(pLoad, "", nullptr);
+            return;
+        }
+
+        AsyncJob job;
+        job.pLoad = pLoad;
+        job.filename = filename;
+        job.steps = request.prepare(filename, shared_from_this(), pLoad->m_priority);
+        if (!job.steps.finish && job.steps.dependencies.empty())
+        {
+            completeAsync(pLoad, filename, job.steps.pResource);
+            return;
+        }
+
+        std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+        state = AsyncLoad::State::Loading;
+        pLoad->m_state.compare_exchange_strong(state, AsyncLoad::State::Waiting);
+        m_asyncJobs.push_back(std::move(job));
+    }
+
+    void ContentManager::completeAsync(const AsyncLoadRef& pLoad, const std::string& filename, const OResourceRef& pResource)
+    {
+        auto state = pLoad->m_state.load();
+        if (state != AsyncLoad::State::Canceled && pResource && !filename.empty())
+        {
+            pResource->setName(pLoad->m_name);
+            pResource->setFilename(filename);
+            addResource(pLoad->m_name, pResource);
+        }
+
+        std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+        auto it = m_asyncLoads.find(pLoad->m_name);
+        if (it != m_asyncLoads.end() && it->second == pLoad) m_asyncLoads.erase(it);
+
+        pLoad->m_pResource = pResource;
+        while (state != AsyncLoad::State::Canceled)
+        {
+            if (pLoad->m_state.compare_exchange_weak(state, pResource ? AsyncLoad::State::Loaded : AsyncLoad::State::Failed))
             {
+                if (!pLoad->m_callbacks.empty()) m_asyncCompleted.push_back(pLoad);
                 break;
             }
         }
-        return filename;
+    }
+
+    void ContentManager::update()
+    {
+        std::vector<std::string> reloadQueue;
+        {
+            std::unique_lock<std::mutex> locker(m_reloadMutex);
+            reloadQueue.swap(m_reloadQueue);
+        }
+        for (auto& filename : reloadQueue) reload(filename);
+
+        evict();
+
+        auto startTime = std::chrono::steady_clock::now();
+        auto budget = std::chrono::duration<float>(m_asyncBudget);
+
+        // Finish what needs the main thread, at least one per frame
+        while (true)
+        {
+            AsyncJob job;
+            {
+                std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+                auto best = m_asyncJobs.end();
+                for (auto it = m_asyncJobs.begin(); it != m_asyncJobs.end(); ++it)
+                {
+                    auto& pLoad = it->pLoad;
+                    if (pLoad->getState() != AsyncLoad::State::Canceled)
+                    {
+                        auto& dependencies = it->steps.dependencies;
+                        if (!std::all_of(dependencies.begin(), dependencies.end(), [](const AsyncLoadRef& pDependency) { return pDependency->isDone(); })) continue;
+                    }
+                    if (best == m_asyncJobs.end() ||
+                        pLoad->m_priority > best->pLoad->m_priority ||
+                        (pLoad->m_priority == best->pLoad->m_priority && pLoad->m_order < best->pLoad->m_order))
+                    {
+                        best = it;
+                    }
+                }
+                if (best == m_asyncJobs.end()) break;
+                job = std::move(*best);
+                m_asyncJobs.erase(best);
+            }
+
+            if (job.pLoad->getState() == AsyncLoad::State::Canceled)
+            {
+                completeAsync(job.pLoad, "", nullptr);
+                continue;
+            }
+            auto pResource = getResource(job.pLoad->m_name); // Could have been loaded synchronously meanwhile
+            if (pResource)
+            {
+                completeAsync(job.pLoad, "", pResource);
+                continue;
+            }
+            pResource = job.steps.finish ? job.steps.finish(shared_from_this()) : job.steps.pResource;
+            completeAsync(job.pLoad, job.filename, pResource);
+
+            if (std::chrono::steady_clock::now() - startTime >= budget) break;
+        }
+
+        // Callbacks
+        std::vector<AsyncLoadRef> completed;
+        {
+            std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+            completed.swap(m_asyncCompleted);
+        }
+        for (auto& pLoad : completed)
+        {
+            std::vector<AsyncCallback> callbacks;
+            {
+                std::unique_lock<std::mutex> asyncLocker(m_asyncMutex);
+                callbacks.swap(pLoad->m_callbacks);
+            }
+            if (pLoad->getState() == AsyncLoad::State::Canceled) continue;
+            auto pResource = pLoad->getResource();
+            for (auto& callback : callbacks) callback(pResource);
+        }
     }
 
     void ContentManager::addResource(const std::string& name, const OResourceRef& pResource)
+    {
+        OResourceRef pReplaced;
+        std::unique_lock<std::mutex> locker(m_mutex);
+        auto it = m_resources.find(name);
+        if (it != m_resources.end())
+        {
+            pReplaced = it->second.pResource; // Released after unlocking
+            removeEntry(it);
+        }
+
+        ResourceEntry entry;
+        entry.pResource = pResource;
+        entry.category = pResource ? pResource->getMemoryCategory() : Resource::MemoryCategory::Other;
+        entry.size = pResource ? pResource->getMemorySize() : 0;
+        entry.lastUsed = ++m_useCounter;
+        auto& stats = m_memoryStats[static_cast<int>(entry.category)];
+        ++stats.count;
+        stats.size += entry.size;
+        m_resources[name] = entry;
+    }
+
+    void ContentManager::removeEntry(ResourceMap::iterator it)
+    {
+        auto& stats = m_memoryStats[static_cast<int>(it->second.category)];
+        --stats.count;
+        stats.size -= it->second.size;
+        m_resources.erase(it);
+    }
+
+    void ContentManager::setMemoryBudget(Resource::MemoryCategory category, size_t budget)
     {
         std::unique_lock<std::mutex> locker(m_mutex);
-        m_resources[name] = pResource;
+        m_memoryStats[static_cast<int>(category)].budget = budget;
+    }
+
+    ContentManager::MemoryStats ContentManager::getMemoryStats(Resource::MemoryCategory category)
+    {
+        std::unique_lock<std::mutex> locker(m_mutex);
+        return m_memoryStats[static_cast<int>(category)];
+    }
+
+    void ContentManager::evict()
+    {
+        std::vector<OResourceRef> evicted; // Released after unlocking
+        std::unique_lock<std::mutex> locker(m_mutex);
+        for (int i = 0; i < Resource::MEMORY_CATEGORY_COUNT; ++i)
+        {
+            auto& stats = m_memoryStats[i];
+            if (!stats.budget || stats.size <= stats.budget) continue;
+
+            // Least recently used first, of those only we hold on to
+            std::vector<ResourceMap::iterator> candidates;
+            for (auto it = m_resources.begin(); it != m_resources.end(); ++it)
+            {
+                auto& entry = it->second;
+                if (static_cast<int>(entry.category) == i && entry.pResource.use_count() == 1)
+                {
+                    candidates.push_back(it);
+                }
+            }
+            std::sort(candidates.begin(), candidates.end(), [](const ResourceMap::iterator& a, const ResourceMap::iterator& b)
+            {
+                return a->second.lastUsed < b->second.lastUsed;
+            });
+            for (auto& it : candidates)
+            {
+                if (stats.size <= stats.budget) break;
+                evicted.push_back(it->second.pResource);
+                removeEntry(it);
+                ++stats.evictedCount;
+            }
+        }
     }
 
     bool ContentManager::isResourceLoaded(const std::string& name)
@@ -88,9 +646,9 @@ namespace onut
         std::unique_lock<std::mutex> locker(m_mutex);
         for (auto it = m_resources.begin(); it != m_resources.end(); ++it)
         {
-            if (it->second == pResource)
+            if (it->second.pResource == pResource)
             {
-                m_resources.erase(it);
+                removeEntry(it);
                 return;
             }
         }
@@ -104,8 +662,14 @@ namespace onut
 
     void ContentManager::clear()
     {
+        ResourceMap resources; // Released after unlocking
         std::unique_lock<std::mutex> locker(m_mutex);
-        m_resources.clear();
+        m_resources.swap(resources);
+        for (auto& stats : m_memoryStats)
+        {
+            stats.count = 0;
+            stats.size = 0;
+        }
     }
 
     OResourceRef ContentManager::getResource(const std::string& name)
@@ -114,7 +678,8 @@ namespace onut
         auto it = m_resources.find(name);
         if (it != m_resources.end())
         {
-            return it->second;
+            it->second.lastUsed = ++m_useCounter;
+            return it->second.pResource;
         }
         return nullptr;
     }
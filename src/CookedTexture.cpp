@@ -0,0 +1,433 @@
+// Onut
+#include <onut/CookedTexture.h>
+#include <onut/Files.h>
+#include <onut/Images.h>
+#include <onut/Log.h>
+
+// STL
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+
+namespace onut
+{
+    static const char SIGNATURE[4] = {'O', 'T', 'E', 'X'};
+    static const uint32_t VERSION = 1;
+    static const uint32_t MAX_LEVELS = 16;
+
+    const char* CookedTexture::EXTENSION = "otex";
+
+    size_t CookedTexture::getLevelDataSize(Format format, const Point& size)
+    {
+        auto blocks = static_cast<size_t>((size.x + 3) / 4) * static_cast<size_t>((size.y + 3) / 4);
+        switch (format)
+        {
+            case Format::BC1: return blocks * 8;
+            case Format::BC3: return blocks * 16;
+            default: return static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4;
+        }
+    }
+
+    //--- Block compression
+
+    static uint16_t toRGB565(const uint8_t* pColor)
+    {
+        return static_cast<uint16_t>(
+            (((pColor[0] * 31 + 127) / 255) << 11) |
+            (((pColor[1] * 63 + 127) / 255) << 5) |
+            ((pColor[2] * 31 + 127) / 255));
+    }
+
+    static void fromRGB565(uint16_t color, uint8_t* pColor)
+    {
+        auto r = (color >> 11) & 31;
+        auto g = (color >> 5) & 63;
+        auto b = color & 31;
+        pColor[0] = static_cast<uint8_t>((r << 3) | (r >> 2));
+        pColor[1] = static_cast<uint8_t>((g << 2) | (g >> 4));
+        pColor[2] = static_cast<uint8_t>((b << 3) | (b >> 2));
+        pColor[3] = 255;
+    }
+
+    static void writeU16(uint8_t* p, uint16_t value)
+    {
+        p[0] = static_cast<uint8_t>(value);
+        p[1] = static_cast<uint8_t>(value >> 8);
+    }
+
+    // Bounding box of the colors, inset a bit, as the two end points
+    static void encodeColorBlock(const uint8_t block[16][4], uint8_t* pOut)
+    {
+        uint8_t minColor[3] = {255, 255, 255};
+        uint8_t maxColor[3] = {0, 0, 0};
+        for (int i = 0; i < 16; ++i)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                minColor[c] = std::min(minColor[c], block[i][c]);
+                maxColor[c] = std::max(maxColor[c], block[i][c]);
+            }
+        }
+        for (int c = 0; c < 3; ++c)
+        {
+            auto inset = (maxColor[c] - minColor[c]) / 16;
+            minColor[c] += inset;
+            maxColor[c] -= inset;
+        }
+
+        auto color0 = toRGB565(maxColor);
+        auto color1 = toRGB565(minColor);
+        if (color0 < color1) std::swap(color0, color1);
+        writeU16(pOut, color0);
+        writeU16(pOut + 2, color1);
+        uint32_t indices = 0;
+        if (color0 != color1)
+        {
+            // color0 > color1 selects the 4 colors mode
+            uint8_t palette[4][4];
+            fromRGB565(color0, palette[0]);
+            fromRGB565(color1, palette[1]);
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] * 2 + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c] * 2) / 3);
+            }
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                int bestDistance = 0x7FFFFFFF;
+                for (int p = 0; p < 4; ++p)
+                {
+                    int distance = 0;
+                    for (int c = 0; c < 3; ++c)
+                    {
+                        auto d = static_cast<int>(block[i][c]) - static_cast<int>(palette[p][c]);
+                        distance += d * d;
+                    }
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint32_t>(best) << (i * 2);
+            }
+        }
+        for (int i = 0; i < 4; ++i) pOut[4 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    static void encodeAlphaBlock(const uint8_t block[16][4], uint8_t* pOut)
+    {
+        uint8_t alpha0 = 0;
+        uint8_t alpha1 = 255;
+        for (int i = 0; i < 16; ++i)
+        {
+            alpha0 = std::max(alpha0, block[i][3]);
+            alpha1 = std::min(alpha1, block[i][3]);
+        }
+        pOut[0] = alpha0;
+        pOut[1] = alpha1;
+        uint64_t indices = 0;
+        if (alpha0 != alpha1)
+        {
+            // alpha0 > alpha1 selects the 8 values mode
+            int palette[8] = {alpha0, alpha1};
+            for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+            for (int i = 0; i < 16; ++i)
+            {
+                int best = 0;
+                int bestDistance = 256;
+                for (int p = 0; p < 8; ++p)
+                {
+                    auto distance = std::abs(static_cast<int>(block[i][3]) - palette[p]);
+                    if (distance < bestDistance)
+                    {
+                        bestDistance = distance;
+                        best = p;
+                    }
+                }
+                indices |= static_cast<uint64_t>(best) << (i * 3);
+            }
+        }
+        for (int i = 0; i < 6; ++i) pOut[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+    }
+
+    static void decodeColorBlock(const uint8_t* pIn, bool allowTransparent, uint8_t block[16][4])
+    {
+        uint16_t color0 = static_cast<uint16_t>(pIn[0] | (pIn[1] << 8));
+        uint16_t color1 = static_cast<uint16_t>(pIn[2] | (pIn[3] << 8));
+        uint8_t palette[4][4];
+        fromRGB565(color0, palette[0]);
+        fromRGB565(color1, palette[1]);
+        if (color0 > color1 || !allowTransparent)
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] * 2 + palette[1][c]) / 3);
+                palette[3][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c] * 2) / 3);
+            }
+            palette[2][3] = palette[3][3] = 255;
+        }
+        else
+        {
+            for (int c = 0; c < 3; ++c)
+            {
+                palette[2][c] = static_cast<uint8_t>((palette[0][c] + palette[1][c]) / 2);
+                palette[3][c] = 0;
+            }
+            palette[2][3] = 255;
+            palette[3][3] = 0;
+        }
+        uint32_t indices = pIn[4] | (pIn[5] << 8) | (pIn[6] << 16) | (static_cast<uint32_t>(pIn[7]) << 24);
+        for (int i = 0; i < 16; ++i)
+        {
+            memcpy(block[i], palette[(indices >> (i * 2)) & 3], 4);
+        }
+    }
+
+    static void decodeAlphaBlock(const uint8_t* pIn, uint8_t block[16][4])
+    {
+        int alpha0 = pIn[0];
+        int alpha1 = pIn[1];
+        int palette[8] = {alpha0, alpha1};
+        if (alpha0 > alpha1)
+        {
+            for (int p = 1; p < 7; ++p) palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+        }
+        else
+        {
+            for (int p = 1; p < 5; ++p) palette[p + 1] = ((5 - p) * alpha0 + p * alpha1) / 5;
+            palette[6] = 0;
+            palette[7] = 255;
+        }
+        uint64_t indices = 0;
+        for (int i = 0; i < 6; ++i) indices |= static_cast<uint64_t>(pIn[2 + i]) << (i * 8);
+        for (int i = 0; i < 16; ++i)
+        {
+            block[i][3] = static_cast<uint8_t>(palette[(indices >> (i * 3)) & 7]);
+        }
+    }
+
+    static void encodeLevel(CookedTexture::Format format, const std::vector<uint8_t>& image, const Point& size, std::vector<uint8_t>& out)
+    {
+        if (format == CookedTexture::Format::RGBA8)
+        {
+            out.insert(out.end(), image.begin(), image.end());
+            return;
+        }
+
+        auto blockSize = (format == CookedTexture::Format::BC1) ? 8 : 16;
+        uint8_t block[16][4];
+        for (int by = 0; by < size.y; by += 4)
+        {
+            for (int bx = 0; bx < size.x; bx += 4)
+            {
+                // Edges of the small mips repeat their last pixel
+                for (int i = 0; i < 16; ++i)
+                {
+                    auto x = std::min(bx + (i & 3), size.x - 1);
+                    auto y = std::min(by + (i >> 2), size.y - 1);
+                    memcpy(block[i], image.data() + (static_cast<size_t>(y) * size.x + x) * 4, 4);
+                }
+                auto offset = out.size();
+                out.resize(offset + blockSize);
+                if (format == CookedTexture::Format::BC1)
+                {
+                    encodeColorBlock(block, out.data() + offset);
+                }
+                else
+                {
+                    encodeAlphaBlock(block, out.data() + offset);
+                    encodeColorBlock(block, out.data() + offset + 8);
+                }
+            }
+        }
+    }
+
+    //--- Cooking
+
+    std::vector<uint8_t> CookedTexture::cook(const uint8_t* pImage, const Point& size)
+    {
+        return cook(pImage, size, CookOptions());
+    }
+
+    std::vector<uint8_t> CookedTexture::cook(const uint8_t* pImage, const Point& size, const CookOptions& options)
+    {
+        std::vector<uint8_t> ret;
+        if (size.x <= 0 || size.y <= 0) return ret;
+
+        // Pre multiplied
+        auto pixelCount = static_cast<size_t>(size.x) * static_cast<size_t>(size.y);
+        std::vector<uint8_t> image(pImage, pImage + pixelCount * 4);
+        bool isOpaque = true;
+        for (size_t i = 0; i < image.size(); i += 4)
+        {
+            auto alpha = image[i + 3];
+            if (alpha == 255) continue;
+            isOpaque = false;
+            image[i + 0] = image[i + 0] * alpha / 255;
+            image[i + 1] = image[i + 1] * alpha / 255;
+            image[i + 2] = image[i + 2] * alpha / 255;
+        }
+
+        auto format = Format::RGBA8;
+        if (options.compress && size.x % 4 == 0 && size.y % 4 == 0)
+        {
+            format = isOpaque ? Format::BC1 : Format::BC3;
+        }
+
+        Header header;
+        memcpy(header.signature, SIGNATURE, sizeof(SIGNATURE));
+        header.version = VERSION;
+        header.format = format;
+        header.width = static_cast<uint32_t>(size.x);
+        header.height = static_cast<uint32_t>(size.y);
+        header.levelCount = 0;
+        header.reserved[0] = header.reserved[1] = 0;
+        ret.resize(sizeof(Header));
+
+        // Box filtered mips. Averaging premultiplied colors doesn't bleed transparent ones in
+        auto levelSize = size;
+        while (true)
+        {
+            encodeLevel(format, image, levelSize, ret);
+            ++header.levelCount;
+            if (!options.generateMipmaps || (levelSize.x == 1 && levelSize.y == 1) || header.levelCount == MAX_LEVELS) break;
+
+            Point mipSize(std::max(1, levelSize.x / 2), std::max(1, levelSize.y / 2));
+            std::vector<uint8_t> mip(static_cast<size_t>(mipSize.x) * static_cast<size_t>(mipSize.y) * 4);
+            for (int y = 0; y < mipSize.y; ++y)
+            {
+                auto y0 = std::min(y * 2, levelSize.y - 1);
+                auto y1 = std::min(y * 2 + 1, levelSize.y - 1);
+                for (int x = 0; x < mipSize.x; ++x)
+                {
+                    auto x0 = std::min(x * 2, levelSize.x - 1);
+                    auto x1 = std::min(x * 2 + 1, levelSize.x - 1);
+                    for (int c = 0; c < 4; ++c)
+                    {
+                        auto sum =
+                            image[(static_cast<size_t>(y0) * levelSize.x + x0) * 4 + c] +
+                            image[(static_cast<size_t>(y0) * levelSize.x + x1) * 4 + c] +
+                            image[(static_cast<size_t>(y1) * levelSize.x + x0) * 4 + c] +
+                            image[(static_cast<size_t>(y1) * levelSize.x + x1) * 4 + c];
+                        mip[(static_cast<size_t>(y) * mipSize.x + x) * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+                    }
+                }
+            }
+            image.swap(mip);
+            levelSize = mipSize;
+        }
+
+        memcpy(ret.data(), &header, sizeof(header));
+        return ret;
+    }
+
+    bool CookedTexture::cookFile(const std::string& imageFilename, const std::string& cookedFilename, const CookOptions& options)
+    {
+        auto data = getFileData(imageFilename);
+        Point size;
+        auto image = decodeImage(data.data(), data.size(), size);
+        if (image.empty())
+        {
+            OLogE("Can't decode " + imageFilename);
+            return false;
+        }
+
+        auto cooked = cook(image.data(), size, options);
+        std::ofstream out(cookedFilename, std::ios::binary);
+        if (out.fail())
+        {
+            OLogE("Can't write " + cookedFilename);
+            return false;
+        }
+        out.write(reinterpret_cast<const char*>(cooked.data()), cooked.size());
+        return !out.fail();
+    }
+
+    //--- Loading
+
+    bool CookedTexture::isCooked(const uint8_t* pData, size_t dataSize)
+    {
+        return dataSize >= sizeof(Header) && !memcmp(pData, SIGNATURE, sizeof(SIGNATURE));
+    }
+
+    bool CookedTexture::read(const uint8_t* pData, size_t dataSize)
+    {
+        m_levels.clear();
+        if (!isCooked(pData, dataSize)) return false;
+
+        Header header;
+        memcpy(&header, pData, sizeof(header));
+        if (header.version != VERSION ||
+            header.format > Format::BC3 ||
+            !header.width || !header.height || header.width > 0x4000 || header.height > 0x4000 ||
+            !header.levelCount || header.levelCount > MAX_LEVELS)
+        {
+            return false;
+        }
+
+        m_format = header.format;
+        m_size = Point(static_cast<int>(header.width), static_cast<int>(header.height));
+        auto offset = sizeof(Header);
+        auto levelSize = m_size;
+        for (uint32_t i = 0; i < header.levelCount; ++i)
+        {
+            auto levelDataSize = getLevelDataSize(m_format, levelSize);
+            if (offset + levelDataSize > dataSize)
+            {
+                m_levels.clear();
+                return false;
+            }
+            m_levels.push_back({levelSize, pData + offset, levelDataSize});
+            offset += levelDataSize;
+            levelSize = Point(std::max(1, levelSize.x / 2), std::max(1, levelSize.y / 2));
+        }
+        return true;
+    }
+
+    size_t CookedTexture::getMemorySize() const
+    {
+        size_t size = 0;
+        for (auto& level : m_levels) size += level.dataSize;
+        return size;
+    }
+
+    std::vector<uint8_t> CookedTexture::decompress(size_t levelIndex) const
+    {
+        auto& level = m_levels[levelIndex];
+        if (m_format == Format::RGBA8)
+        {
+            return std::vector<uint8_t>(level.pData, level.pData + level.dataSize);
+        }
+
+        std::vector<uint8_t> ret(static_cast<size_t>(level.size.x) * static_cast<size_t>(level.size.y) * 4);
+        auto pBlock = level.pData;
+        uint8_t block[16][4];
+        for (int by = 0; by < level.size.y; by += 4)
+        {
+            for (int bx = 0; bx < level.size.x; bx += 4)
+            {
+                if (m_format == Format::BC1)
+                {
+                    decodeColorBlock(pBlock, true, block);
+                    pBlock += 8;
+                }
+                else
+                {
+                    decodeColorBlock(pBlock + 8, false, block);
+                    decodeAlphaBlock(pBlock, block);
+                    pBlock += 16;
+                }
+                for (int i = 0; i < 16; ++i)
+                {
+                    auto x = bx + (i & 3);
+                    auto y = by + (i >> 2);
+                    if (x >= level.size.x || y >= level.size.y) continue;
+                    memcpy(ret.data() + (static_cast<size_t>(y) * level.size.x + x) * 4, block[i], 4);
+                }
+            }
+        }
+        return ret;
+    }
+}
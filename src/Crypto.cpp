@@ -429,6 +429,17 @@ namespace onut
             return hexstring;
         }
 
+        std::string sha1(const uint8_t* pData, size_t size)
+        {
+            unsigned char resultHash[20] = {0};
+            char hexstring[41];
+
+            sha1::calc(pData, static_cast<int>(size), resultHash);
+            sha1::toHexString(resultHash, hexstring);
+
+            return hexstring;
+        }
+
         bool validateEmail(const std::string& email)
         {
             return isValidEmailAddress(email.c_str());
@@ -75,6 +75,7 @@ namespace onut
     void Entity::setLocalTransform(const Matrix& localTransform)
     {
         m_localTransform = localTransform;
+        m_dirtyReplicatedFields |= REPLICATED_TRANSFORM;
         dirtyWorld();
     }
 
@@ -88,12 +89,15 @@ namespace onut
         }
         auto invParentWorld = parentWorld.Invert();
         m_localTransform = worldTransform * invParentWorld;
+        m_dirtyReplicatedFields |= REPLICATED_TRANSFORM;
         m_isWorldDirty = true;
+        if (m_isStatic && m_pSceneManager) m_pSceneManager->dirtyStatic2D(this);
     }
 
     void Entity::dirtyWorld()
     {
         m_isWorldDirty = true;
+        if (m_isStatic && m_pSceneManager) m_pSceneManager->dirtyStatic2D(this);
         for (auto& pChild : m_children)
         {
             pChild->dirtyWorld();
@@ -188,6 +192,7 @@ namespace onut
             }
         }
         m_isEnabled = isEnabled;
+        m_dirtyReplicatedFields |= REPLICATED_ENABLED;
     }
 
     bool Entity::isVisible() const
@@ -226,6 +231,7 @@ namespace onut
             }
         }
         m_isVisible = isVisible;
+        m_dirtyReplicatedFields |= REPLICATED_VISIBLE;
     }
 
     bool Entity::isStatic() const
@@ -258,6 +264,11 @@ namespace onut
                 }
             }
         }
+        if (m_isStatic != isStatic && m_pSceneManager)
+        {
+            // Its sprites move in or out of the static chunks
+            m_pSceneManager->m_isRender2DDirty = true;
+        }
         m_isStatic = isStatic;
     }
 
@@ -354,6 +365,7 @@ namespace onut
         if (m_drawIndex == drawIndex) return;
         auto previousIndex = m_drawIndex;
         m_drawIndex = drawIndex;
+        getSceneManager()->m_isRender2DDirty = true;
         auto pRenderableList = getSceneManager()->m_pComponentRender2Ds;
         Component* pOtherComponent;
         for (auto& pComponentRef : m_components)
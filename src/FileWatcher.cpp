@@ -0,0 +1,20 @@
+// Onut
+#include <onut/FileWatcher.h>
+
+namespace onut
+{
+#if !defined(__linux__)
+    OFileWatcherRef FileWatcher::create()
+    {
+        return nullptr;
+    }
+#endif
+
+    FileWatcher::FileWatcher()
+    {
+    }
+
+    FileWatcher::~FileWatcher()
+    {
+    }
+}
@@ -0,0 +1,191 @@
+// Onut
+#include <onut/Log.h>
+
+// Private
+#include "FileWatcherInotify.h"
+
+// System
+#include <dirent.h>
+#include <poll.h>
+#include <string.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+namespace onut
+{
+    static const uint32_t WATCH_MASK = IN_CREATE | IN_CLOSE_WRITE | IN_DELETE | IN_MOVED_FROM | IN_MOVED_TO;
+
+    OFileWatcherRef FileWatcher::create()
+    {
+        auto pRet = std::shared_ptr<FileWatcherInotify>(new FileWatcherInotify());
+        if (pRet->m_fd == -1) return nullptr;
+        return pRet;
+    }
+
+    FileWatcherInotify::FileWatcherInotify()
+    {
+        m_isRunning = false;
+        m_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (m_fd == -1)
+        {
+            OLogE("inotify_init1 failed");
+            return;
+        }
+        m_wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+        m_isRunning = true;
+        m_thread = std::thread(std::bind(&FileWatcherInotify::run, this));
+    }
+
+    FileWatcherInotify::~FileWatcherInotify()
+    {
+        if (m_isRunning)
+        {
+            m_isRunning = false;
+            uint64_t one = 1;
+            auto ret = ::write(m_wakeFd, &one, sizeof(one));
+            (void)ret;
+            m_thread.join();
+        }
+        if (m_wakeFd != -1) ::close(m_wakeFd);
+        if (m_fd != -1) ::close(m_fd);
+    }
+
+    bool FileWatcherInotify::watch(const std::string& path, const Callback& callback)
+    {
+        auto pRoot = std::make_shared<Root>();
+        pRoot->path = path;
+        pRoot->callback = callback;
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_roots.count(path)) return false;
+        auto watchCount = m_watches.size();
+        addWatches(path, pRoot, nullptr);
+        if (m_watches.size() == watchCount) return false;
+        m_roots[path] = pRoot;
+        return true;
+    }
+
+    void FileWatcherInotify::unwatch(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = m_roots.find(path);
+        if (it == m_roots.end()) return;
+        auto pRoot = it->second;
+        m_roots.erase(it);
+        for (auto watchIt = m_watches.begin(); watchIt != m_watches.end();)
+        {
+            if (watchIt->second.pRoot == pRoot)
+            {
+                inotify_rm_watch(m_fd, watchIt->first);
+                watchIt = m_watches.erase(watchIt);
+            }
+            else
+            {
+                ++watchIt;
+            }
+        }
+    }
+
+    // Inotify is not recursive, every sub folder needs its own watch.
+    // Files already in folders created after the fact are reported in pNewFiles.
+    void FileWatcherInotify::addWatches(const std::string& path, const RootRef& pRoot, Notifications* pNewFiles)
+    {
+        auto wd = inotify_add_watch(m_fd, path.c_str(), WATCH_MASK);
+        if (wd == -1) return;
+        m_watches[wd] = {path, pRoot};
+
+        auto dir = opendir(path.c_str());
+        if (!dir) return;
+        while (auto ent = readdir(dir))
+        {
+            if (!strcmp(ent->d_name, ".") || !strcmp(ent->d_name, "..")) continue;
+            auto filename = path + "/" + ent->d_name;
+            if (ent->d_type & DT_DIR)
+            {
+                addWatches(filename, pRoot, pNewFiles);
+            }
+            else if (pNewFiles)
+            {
+                pNewFiles->push_back({pRoot, Event::Created, filename});
+            }
+        }
+        closedir(dir);
+    }
+
+    void FileWatcherInotify::run()
+    {
+        alignas(inotify_event) char buffer[16 * 1024];
+        pollfd fds[2] = {{m_fd, POLLIN, 0}, {m_wakeFd, POLLIN, 0}};
+        Notifications notifications;
+
+        while (m_isRunning)
+        {
+            if (poll(fds, 2, -1) <= 0) continue;
+            if (!m_isRunning) break;
+
+            notifications.clear();
+            {
+                std::lock_guard<std::mutex> lock(m_mutex);
+                while (true)
+                {
+                    auto size = ::read(m_fd, buffer, sizeof(buffer));
+                    if (size <= 0) break;
+
+                    for (char* pHead = buffer; pHead < buffer + size;)
+                    {
+                        auto pEvent = reinterpret_cast<inotify_event*>(pHead);
+                        pHead += sizeof(inotify_event) + pEvent->len;
+
+                        auto it = m_watches.find(pEvent->wd);
+                        if (it == m_watches.end()) continue;
+                        if (pEvent->mask & IN_IGNORED)
+                        {
+                            m_watches.erase(it);
+                            continue;
+                        }
+                        if (!pEvent->len) continue;
+
+                        auto pRoot = it->second.pRoot;
+                        auto filename = it->second.path + "/" + pEvent->name;
+                        if (pEvent->mask & (IN_DELETE | IN_MOVED_FROM))
+                        {
+                            notifications.push_back({pRoot, Event::Removed, filename});
+                        }
+                        else if (pEvent->mask & IN_ISDIR)
+                        {
+                            if (pEvent->mask & (IN_CREATE | IN_MOVED_TO))
+                            {
+                                notifications.push_back({pRoot, Event::Created, filename});
+                                addWatches(filename, pRoot, &notifications);
+                            }
+                        }
+                        else if (pEvent->mask & IN_CREATE)
+                        {
+                            // Still being written, Modified follows on close
+                            notifications.push_back({pRoot, Event::Created, filename});
+                        }
+                        else if (pEvent->mask & IN_MOVED_TO)
+                        {
+                            // Moved in complete, like editors saving through a temporary file
+                            notifications.push_back({pRoot, Event::Created, filename});
+                            notifications.push_back({pRoot, Event::Modified, filename});
+                        }
+                        else if (pEvent->mask & IN_CLOSE_WRITE)
+                        {
+                            notifications.push_back({pRoot, Event::Modified, filename});
+                        }
+                    }
+                }
+            }
+
+            for (auto& notification : notifications)
+            {
+                if (notification.pRoot->callback)
+                {
+                    notification.pRoot->callback(notification.event, notification.filename);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,63 @@
+#ifndef FILEWATCHER_INOTIFY_H_INCLUDED
+#define FILEWATCHER_INOTIFY_H_INCLUDED
+
+// Onut
+#include <onut/FileWatcher.h>
+
+// STL
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace onut
+{
+    class FileWatcherInotify final : public FileWatcher
+    {
+    public:
+        FileWatcherInotify();
+        ~FileWatcherInotify();
+
+        bool watch(const std::string& path, const Callback& callback) override;
+        void unwatch(const std::string& path) override;
+
+    private:
+        friend class FileWatcher;
+
+        struct Root
+        {
+            std::string path;
+            Callback callback;
+        };
+        using RootRef = std::shared_ptr<Root>;
+
+        struct Watch
+        {
+            std::string path;
+            RootRef pRoot;
+        };
+
+        struct Notification
+        {
+            RootRef pRoot;
+            Event event;
+            std::string filename;
+        };
+        using Notifications = std::vector<Notification>;
+
+        void run();
+        void addWatches(const std::string& path, const RootRef& pRoot, Notifications* pNewFiles);
+
+        int m_fd = -1;
+        int m_wakeFd = -1;
+        std::atomic<bool> m_isRunning;
+        std::thread m_thread;
+
+        std::mutex m_mutex;
+        std::unordered_map<int, Watch> m_watches;
+        std::unordered_map<std::string, RootRef> m_roots;
+    };
+}
+
+#endif
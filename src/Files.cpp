@@ -12,10 +12,17 @@
 // Third party
 #if defined(WIN32)
 #include <dirent/dirent.h>
+#include <sys/stat.h>
 #include <windows.h>
 #elif defined(__linux__) || defined(__APPLE__)
 #include <dirent.h>
 #endif
+#if !defined(WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
 
 namespace onut
 {
@@ -173,6 +180,82 @@ namespace onut
         return std::move(data);
     }
 
+    FileData::FileData(std::vector<uint8_t>&& data)
+        : m_data(std::move(data))
+    {
+    }
+
+    FileData::FileData(const uint8_t* pData, size_t size, const std::shared_ptr<void>& pOwner)
+        : m_pData(pData)
+        , m_size(size)
+        , m_pOwner(pOwner)
+    {
+    }
+
+    // Unmapped when the last FileData viewing it goes away
+    class FileMapping final
+    {
+    public:
+        ~FileMapping()
+        {
+#if defined(WIN32)
+            if (pData) UnmapViewOfFile(pData);
+            if (hMapping) CloseHandle(hMapping);
+#else
+            if (pData) munmap(pData, size);
+#endif
+        }
+
+        void* pData = nullptr;
+        size_t size = 0;
+#if defined(WIN32)
+        HANDLE hMapping = NULL;
+#endif
+    };
+
+    FileData mapFileData(const std::string& filename)
+    {
+        auto pMapping = std::make_shared<FileMapping>();
+#if defined(WIN32)
+        auto hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return {};
+        LARGE_INTEGER size;
+        if (GetFileSizeEx(hFile, &size) && size.QuadPart > 0)
+        {
+            pMapping->hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+            if (pMapping->hMapping)
+            {
+                pMapping->pData = MapViewOfFile(pMapping->hMapping, FILE_MAP_READ, 0, 0, 0);
+                pMapping->size = static_cast<size_t>(size.QuadPart);
+            }
+        }
+        CloseHandle(hFile); // The mapping keeps it open
+#else
+        auto fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) return {};
+        struct stat st;
+        if (fstat(fd, &st) == 0 && st.st_size > 0)
+        {
+            auto pData = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (pData != MAP_FAILED)
+            {
+                pMapping->pData = pData;
+                pMapping->size = static_cast<size_t>(st.st_size);
+            }
+        }
+        ::close(fd); // The mapping keeps it open
+#endif
+        if (!pMapping->pData) return {};
+        return FileData(static_cast<const uint8_t*>(pMapping->pData), pMapping->size, pMapping);
+    }
+
+    uint64_t getFileTime(const std::string& filename)
+    {
+        struct stat st;
+        if (stat(filename.c_str(), &st) != 0) return 0;
+        return static_cast<uint64_t>(st.st_mtime);
+    }
+
 #if defined(WIN32)
     bool fileExists(const std::string& filename)
     {
@@ -9,7 +9,6 @@
 // STL
 #include <cassert>
 #include <sstream>
-#include <fstream>
 
 namespace onut
 {
@@ -37,10 +36,30 @@ namespace onut
         return "";
     }
 
+    ContentManager::AsyncSteps AsyncLoader<Font>::prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+    {
+        ContentManager::AsyncSteps steps;
+        auto data = readResourceFile(filename, pContentManager);
+        std::istringstream in(std::string(reinterpret_cast<const char*>(data.getData()), data.getSize()));
+        std::string line;
+        while (std::getline(in, line))
+        {
+            auto split = splitString(line, " \n\r");
+            if (split.empty() || split[0] != "page") continue;
+            steps.dependencies.push_back(pContentManager->loadAsync<OTexture>(Font::parseString("file", split), priority));
+        }
+        steps.finish = [filename](const OContentManagerRef& pContentManager) -> OResourceRef
+        {
+            return Font::createFromFile(filename, pContentManager);
+        };
+        return steps;
+    }
+
     OFontRef Font::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager)
     {
-        std::ifstream in(filename);
-        assert(!in.fail());
+        auto data = readResourceFile(filename, pContentManager);
+        if (data.isEmpty()) return nullptr;
+        std::istringstream in(std::string(reinterpret_cast<const char*>(data.getData()), data.getSize()));
 
         auto pFont = std::make_shared<OFont>();
 
@@ -81,29 +100,67 @@ namespace onut
             }
             else if (command == "char")
             {
-                fntChar* pNewChar = new fntChar();
-
-                pNewChar->id = parseInt("id", split);
-                pNewChar->x = parseInt("x", split);
-                pNewChar->y = parseInt("y", split);
-                pNewChar->width = parseInt("width", split);
-                pNewChar->height = parseInt("height", split);
-                pNewChar->xoffset = parseInt("xoffset", split);
-                pNewChar->yoffset = parseInt("yoffset", split);
-                pNewChar->xadvance = parseInt("xadvance", split);
-                pNewChar->page = parseInt("page", split);
-                pNewChar->chnl = parseInt("chnl", split);
-
-                pFont->m_chars[pNewChar->id] = pNewChar;
+                fntChar newChar;
+
+                newChar.id = parseInt("id", split);
+                newChar.x = parseInt("x", split);
+                newChar.y = parseInt("y", split);
+                newChar.width = parseInt("width", split);
+                newChar.height = parseInt("height", split);
+                newChar.xoffset = parseInt("xoffset", split);
+                newChar.yoffset = parseInt("yoffset", split);
+                newChar.xadvance = parseInt("xadvance", split);
+                newChar.page = parseInt("page", split);
+                newChar.chnl = parseInt("chnl", split);
+
+                pFont->m_chars.push_back(newChar);
+            }
+            else if (command == "kerning")
+            {
+                auto key = getKerningKey(parseInt("first", split), parseInt("second", split));
+                pFont->m_kernings[key] = parseInt("amount", split);
             }
 
             getline(in, line);
         }
-        in.close();
+
+        // Index the glyphs now that they won't move
+        for (auto& datChar : pFont->m_chars)
+        {
+            datChar.uvs = {
+                static_cast<float>(datChar.x) / static_cast<float>(pFont->m_common.scaleW),
+                static_cast<float>(datChar.y) / static_cast<float>(pFont->m_common.scaleH),
+                static_cast<float>(datChar.x + datChar.width) / static_cast<float>(pFont->m_common.scaleW),
+                static_cast<float>(datChar.y + datChar.height) / static_cast<float>(pFont->m_common.scaleH)
+            };
+            if (datChar.id >= 0 && datChar.id < DENSE_CHAR_COUNT) pFont->m_denseChars[datChar.id] = &datChar;
+            else pFont->m_sparseChars[datChar.id] = &datChar;
+        }
+        for (auto& kv : pFont->m_kernings)
+        {
+            auto pFirst = pFont->getChar(static_cast<int>(kv.first >> 32));
+            if (pFirst) const_cast<fntChar*>(pFirst)->hasKernings = true;
+        }
 
         return pFont;
     }
 
+    bool Font::reload(const OContentManagerRef& pContentManager)
+    {
+        auto pNew = createFromFile(getFilename(), pContentManager);
+        if (!pNew) return false;
+
+        // Its pages are resources too, they reload on their own
+        std::swap(m_common, pNew->m_common);
+        std::swap(m_pages, pNew->m_pages);
+        std::swap(m_charsCount, pNew->m_charsCount);
+        m_chars.swap(pNew->m_chars); // The buffers swap, the pointers below stay valid
+        std::swap(m_denseChars, pNew->m_denseChars);
+        m_sparseChars.swap(pNew->m_sparseChars);
+        m_kernings.swap(pNew->m_kernings);
+        return true;
+    }
+
     Font::~Font()
     {
         for (int i = 0; i < m_common.pages; ++i)
@@ -112,10 +169,51 @@ namespace onut
         }
         delete[] m_pages;
         m_pages = nullptr;
+    }
 
-        for (auto& kv : m_chars)
+    template<typename Tcallback>
+    void Font::forEachGlyph(const std::string& text, const Color& color, Tcallback callback) const
+    {
+        Vector2 curPos;
+        Color curColor = color;
+        const fntChar* pPrevChar = nullptr;
+        auto len = text.size();
+        for (decltype(len) i = 0; i < len; )
         {
-            delete kv.second;
+            char charId = text[i];
+            if (charId == '\n')
+            {
+                curPos.x = 0.f;
+                curPos.y += static_cast<float>(m_common.lineHeight);
+                pPrevChar = nullptr;
+                i += 1;
+                continue;
+            }
+            if (charId == '^' && i + 3 < len)
+            {
+                // Colored text!
+                auto r = (static_cast<float>(text[i + 1]) - static_cast<float>('0')) / 9.0f;
+                auto g = (static_cast<float>(text[i + 2]) - static_cast<float>('0')) / 9.0f;
+                auto b = (static_cast<float>(text[i + 3]) - static_cast<float>('0')) / 9.0f;
+                curColor = {r, g, b, color.a};
+                curColor.Premultiply();
+                i += 4;
+                continue;
+            }
+            auto iCharId = static_cast<int>(static_cast<unsigned char>(charId));
+            auto pDatChar = getChar(iCharId);
+            ++i;
+            if (!pDatChar)
+            {
+                pPrevChar = nullptr;
+                continue;
+            }
+            if (pPrevChar) curPos.x += getKerning(pPrevChar, iCharId);
+
+            callback(*pDatChar, curPos, curColor);
+
+            curPos.x += static_cast<float>(pDatChar->xadvance);
+            pPrevChar = pDatChar;
         }
     }
 
@@ -125,9 +223,10 @@ namespace onut
 
         result.y += (float)m_common.lineHeight;
         float curX = 0;
-        unsigned int len = in_text.length();
+        const fntChar* pPrevChar = nullptr;
+        auto len = in_text.length();
         char charId;
-        for (unsigned int i = 0; i < len; ++i)
+        for (decltype(len) i = 0; i < len; ++i)
         {
             charId = in_text[i];
             if (charId == '\n')
@@ -135,6 +234,7 @@ namespace onut
                 result.y += (float)m_common.lineHeight;
                 if (curX > result.x) result.x = curX;
                 curX = 0;
+                pPrevChar = nullptr;
                 continue;
             }
             if (charId == '^' && i + 3 < len)
@@ -143,11 +243,13 @@ namespace onut
                 continue;
             }
             auto iCharId = static_cast<int>(static_cast<unsigned char>(charId));
-            if (!m_chars.count(iCharId))
+            auto pDatChar = getChar(iCharId);
+            if (!pDatChar)
             {
+                pPrevChar = nullptr;
                 continue;
             }
-            auto pDatChar = m_chars[iCharId];
+            if (pPrevChar) curX += getKerning(pPrevChar, iCharId);
             if (i == len - 1)
             {
                 curX += static_cast<float>(pDatChar->xoffset) + static_cast<float>(pDatChar->width);
@@ -160,6 +262,7 @@ namespace onut
             {
                 curX += static_cast<float>(pDatChar->xadvance);
             }
+            pPrevChar = pDatChar;
         }
         if (curX > result.x) result.x = curX;
 
@@ -171,11 +274,12 @@ namespace onut
         decltype(std::string().size()) pos = 0;
 
         float curX = 0;
-        unsigned int len = in_text.length();
+        const fntChar* pPrevChar = nullptr;
+        auto len = in_text.length();
         int charId;
         for (; pos < len; ++pos)
         {
-            charId = in_text[pos];
+            charId = static_cast<int>(static_cast<unsigned char>(in_text[pos]));
             if (charId == '\n')
             {
                 return pos;
@@ -185,15 +289,20 @@ namespace onut
                 pos += 3;
                 continue;
             }
-            const auto& it = m_chars.find(charId);
-            if (it == m_chars.end()) continue;
-            auto pDatChar = it->second;
+            auto pDatChar = getChar(charId);
+            if (!pDatChar)
+            {
+                pPrevChar = nullptr;
+                continue;
+            }
             auto advance = static_cast<float>(pDatChar->xadvance);
+            if (pPrevChar) advance += getKerning(pPrevChar, charId);
             if (curX + advance * .75f >= at)
             {
                 return pos;
             }
             curX += advance;
+            pPrevChar = pDatChar;
         }
 
         return pos;
@@ -256,63 +365,84 @@ namespace onut
         {
             pos = {std::round(pos.x), std::round(pos.y)};
         }
-        Vector2 curPos = pos;
-        ret.x = curPos.x;
-        ret.y = curPos.y;
-        unsigned int len = text.length();
-        int page = -1;
-        float r, g, b;
-        Color curColor = color;
+        ret.x = pos.x;
+        ret.y = pos.y;
         bool bHandleBatch = !pSpriteBatch->isInBatch();
         if (bHandleBatch) pSpriteBatch->begin();
-        for (unsigned int i = 0; i < text.size(); )
+        forEachGlyph(text, color, [&](const fntChar& datChar, const Vector2& glyphPos, const Color& glyphColor)
         {
-            char charId = text[i];
-            if (charId == '\n')
-            {
-                curPos.x = pos.x;
-                curPos.y += static_cast<float>(m_common.lineHeight);
-                i += 1;
-                continue;
-            }
-            if (charId == '^' && i + 3 < len)
-            {
-                // Colored text!
-                r = (static_cast<float>(text[i + 1]) - static_cast<float>('0')) / 9.0f;
-                g = (static_cast<float>(text[i + 2]) - static_cast<float>('0')) / 9.0f;
-                b = (static_cast<float>(text[i + 3]) - static_cast<float>('0')) / 9.0f;
-                curColor = {r, g, b, color.a};
-                curColor.Premultiply();
-                i += 4;
-                continue;
-            }
-            auto iCharId = static_cast<int>(static_cast<unsigned char>(charId));
-            if (!m_chars.count(iCharId))
+            pSpriteBatch->drawRectWithUVs(
+                m_pages[datChar.page]->pTexture, {
+                    pos.x + glyphPos.x + static_cast<float>(datChar.xoffset), pos.y + glyphPos.y + static_cast<float>(datChar.yoffset),
+                    static_cast<float>(datChar.width), static_cast<float>(datChar.height)
+                }, datChar.uvs, glyphColor);
+        });
+        if (bHandleBatch) pSpriteBatch->end();
+
+        return std::move(ret);
+    }
+
+    void TextLayout::set(const OFontRef& pFont, const std::string& text, const Vector2& align, const Color& color)
+    {
+        clear();
+        if (!pFont) return;
+
+        auto& common = pFont->m_common;
+        m_size = pFont->measure(text);
+        Vector2 posFrom = {0.f, -static_cast<float>(common.lineHeight - common.base)};
+        Vector2 posTo = {-m_size.x, -m_size.y + static_cast<float>(common.lineHeight - common.base)};
+        m_alignOffset = posFrom + (posTo - posFrom) * align;
+
+        pFont->forEachGlyph(text, color, [&](const Font::fntChar& datChar, const Vector2& glyphPos, const Color& glyphColor)
+        {
+            auto& pTexture = pFont->m_pages[datChar.page]->pTexture;
+            if (m_runs.empty() || m_runs.back().pTexture != pTexture)
             {
-                ++i;
-                continue;
+                m_runs.push_back({pTexture, m_vertices.size() / 4, 0});
             }
-            auto pDatChar = m_chars[iCharId];
-            auto& pTexture = m_pages[pDatChar->page]->pTexture;
+            ++m_runs.back().quadCount;
+
+            // Same order as SpriteBatch::drawRectWithUVs
+            auto x = glyphPos.x + static_cast<float>(datChar.xoffset);
+            auto y = glyphPos.y + static_cast<float>(datChar.yoffset);
+            auto w = static_cast<float>(datChar.width);
+            auto h = static_cast<float>(datChar.height);
+            auto& uvs = datChar.uvs;
+            m_vertices.push_back({{x, y}, {uvs.x, uvs.y}, glyphColor});
+            m_vertices.push_back({{x, y + h}, {uvs.x, uvs.w}, glyphColor});
+            m_vertices.push_back({{x + w, y + h}, {uvs.z, uvs.w}, glyphColor});
+            m_vertices.push_back({{x + w, y}, {uvs.z, uvs.y}, glyphColor});
+        });
+    }
 
-            // Draw it here
-            pSpriteBatch->drawRectWithUVs(
-                pTexture, {
-                    curPos.x + static_cast<float>(pDatChar->xoffset), curPos.y + static_cast<float>(pDatChar->yoffset),
-                    static_cast<float>(pDatChar->width), static_cast<float>(pDatChar->height)
-                }, {
-                    static_cast<float>(pDatChar->x) / static_cast<float>(m_common.scaleW),
-                    static_cast<float>(pDatChar->y) / static_cast<float>(m_common.scaleH),
-                    static_cast<float>(pDatChar->x + pDatChar->width) / static_cast<float>(m_common.scaleW),
-                    static_cast<float>(pDatChar->y + pDatChar->height) / static_cast<float>(m_common.scaleH)
-                }, curColor);
+    void TextLayout::clear()
+    {
+        m_vertices.clear();
+        m_runs.clear();
+        m_size = Vector2::Zero;
+        m_alignOffset = Vector2::Zero;
+    }
 
-            curPos.x += static_cast<float>(pDatChar->xadvance);
-            ++i;
+    Rect TextLayout::draw(const Vector2& pos, bool snapPixels, const OSpriteBatchRef& in_pSpriteBatch) const
+    {
+        auto origin = pos + m_alignOffset;
+        if (snapPixels)
+        {
+            origin = {std::round(origin.x), std::round(origin.y)};
         }
-        if (bHandleBatch) pSpriteBatch->end();
-
-        return std::move(ret);
+        if (!m_runs.empty())
+        {
+            OSpriteBatchRef pSpriteBatch = in_pSpriteBatch;
+            if (!pSpriteBatch) pSpriteBatch = oSpriteBatch;
+            bool bHandleBatch = !pSpriteBatch->isInBatch();
+            if (bHandleBatch) pSpriteBatch->begin();
+            for (auto& run : m_runs)
+            {
+                pSpriteBatch->drawQuads(run.pTexture, m_vertices.data() + run.firstQuad * 4, run.quadCount, origin);
+            }
+            if (bHandleBatch) pSpriteBatch->end();
+        }
+        return Rect(origin.x, origin.y, m_size.x, m_size.y);
     }
 }
 
@@ -1,12 +1,16 @@
 // Onut
-#include <onut/Async.h>
 #include <onut/Dispatcher.h>
 #include <onut/Http.h>
+#include <onut/HttpCache.h>
+#include <onut/Settings.h>
 #include <onut/Strings.h>
 #include <onut/Texture.h>
 
 // STL
+#include <algorithm>
 #include <locale>
+#include <mutex>
+#include <thread>
 
 OHttpRef oHttp;
 
@@ -50,40 +54,167 @@ namespace onut
         return post(url, Body(args.begin(), args.end()), onError);
     }
 
-    void Http::postAsync(const std::string& url, const Body& body, const PostCallback& onSuccess, const ErrorCallback& onError)
+    static std::string bodyToString(const Http::Body& body)
     {
-        auto pThis = OThis;
-        OAsync([url, body, onSuccess, onError, pThis]
+        // Same as post(), text stops at the first null
+        auto it = std::find(body.begin(), body.end(), 0);
+        return std::string(body.begin(), it);
+    }
+
+    std::string Http::makeUrl(const std::string& url, const Arguments& arguments)
+    {
+        auto args = packArguments(arguments);
+        if (args.empty()) return url;
+        return url + "?" + args;
+    }
+
+    Http::Response Http::getConditional(const std::string& url, const std::string& /*etag*/, const std::string& /*lastModified*/, const ErrorCallback& onError)
+    {
+        // Can't validate, always a full get
+        bool failed = false;
+        Response response;
+        response.body = get(url, {}, [&failed, onError](long errCode, std::string message)
         {
-            auto ret = pThis->post(url, body, [onError](long errCode, std::string message)
+            failed = true;
+            if (onError) onError(errCode, message);
+        });
+        response.status = failed ? 0 : 200;
+        return std::move(response);
+    }
+
+    Http::RequestId Http::startAsync(Method method, const std::string& url, const Body& body, Priority priority, const ResponseCallback& onSuccess, const ErrorCallback& onError, const std::string& etag, const std::string& lastModified)
+    {
+        auto pRequest = std::make_shared<AsyncRequest>();
+        pRequest->method = method;
+        pRequest->url = url;
+        pRequest->body = body;
+        pRequest->etag = etag;
+        pRequest->lastModified = lastModified;
+        pRequest->priority = priority;
+        pRequest->onSuccess = onSuccess;
+        pRequest->onError = onError;
+        pRequest->isCancelled = false;
+
+        m_asyncMutex.lock();
+        pRequest->id = m_nextRequestId++;
+        m_asyncRequests[pRequest->id] = pRequest;
+        m_asyncMutex.unlock();
+
+        performAsync(pRequest);
+        return pRequest->id;
+    }
+
+    void Http::completeAsync(const AsyncRequestRef& pRequest, Response& response)
+    {
+        m_asyncMutex.lock();
+        m_asyncRequests.erase(pRequest->id);
+        m_asyncMutex.unlock();
+
+        if (pRequest->isCancelled || !pRequest->onSuccess) return;
+        if (response.body.empty() && response.status != 304) return; // Nothing to give
+        auto pResponse = std::make_shared<Response>(std::move(response));
+        OSync([pRequest, pResponse]
+        {
+            // Could have been cancelled while waiting in the dispatcher
+            if (!pRequest->isCancelled)
             {
-                if (onError)
-                {
-                    OSync([errCode, message, onError]
-                    {
-                        onError(errCode, message);
-                    });
-                }
-            });
-            if (!ret.empty() && onSuccess)
+                pRequest->onSuccess(*pResponse);
+            }
+        });
+    }
+
+    void Http::failAsync(const AsyncRequestRef& pRequest, long errCode, const std::string& message)
+    {
+        m_asyncMutex.lock();
+        m_asyncRequests.erase(pRequest->id);
+        m_asyncMutex.unlock();
+
+        if (pRequest->isCancelled || !pRequest->onError) return;
+        OSync([pRequest, errCode, message]
+        {
+            if (!pRequest->isCancelled)
             {
-                OSync([ret, onSuccess]
-                {
-                    onSuccess(ret);
-                });
+                pRequest->onError(errCode, message);
             }
         });
     }
 
-    void Http::postAsync(const std::string& url, const PostCallback& onSuccess, const ErrorCallback& onError)
+    void Http::performAsync(const AsyncRequestRef& pRequest)
+    {
+        auto pThis = OThis;
+        std::thread([pThis, pRequest]
+        {
+            if (pRequest->isCancelled) return;
+            bool failed = false;
+            auto onError = [pThis, pRequest, &failed](long errCode, std::string message)
+            {
+                failed = true;
+                pThis->failAsync(pRequest, errCode, message);
+            };
+            Response response;
+            if (pRequest->method == Method::Get)
+            {
+                response = pThis->getConditional(pRequest->url, pRequest->etag, pRequest->lastModified, onError);
+            }
+            else
+            {
+                auto str = pThis->post(pRequest->url, pRequest->body, onError);
+                response.body.assign(str.begin(), str.end());
+                response.status = 200;
+            }
+            if (!failed)
+            {
+                pThis->completeAsync(pRequest, response);
+            }
+        }).detach();
+    }
+
+    void Http::cancelAsync(const AsyncRequestRef& /*pRequest*/)
+    {
+    }
+
+    void Http::cancel(RequestId requestId)
+    {
+        m_asyncMutex.lock();
+        auto it = m_asyncRequests.find(requestId);
+        if (it == m_asyncRequests.end())
+        {
+            m_asyncMutex.unlock();
+            return;
+        }
+        auto pRequest = it->second;
+        m_asyncRequests.erase(it);
+        pRequest->isCancelled = true;
+        m_asyncMutex.unlock();
+
+        cancelAsync(pRequest);
+    }
+
+    void Http::setMaxConcurrentRequests(int /*maxConcurrentRequests*/)
+    {
+    }
+
+    Http::RequestId Http::postAsync(const std::string& url, const Body& body, const PostCallback& onSuccess, const ErrorCallback& onError)
+    {
+        return startAsync(Method::Post, url, body, Priority::Normal, [onSuccess](Response& response)
+        {
+            auto str = bodyToString(response.body);
+            if (!str.empty() && onSuccess)
+            {
+                onSuccess(str);
+            }
+        }, onError);
+    }
+
+    Http::RequestId Http::postAsync(const std::string& url, const PostCallback& onSuccess, const ErrorCallback& onError)
     {
-        postAsync(url, Body{}, onSuccess, onError);
+        return postAsync(url, Body{}, onSuccess, onError);
     }
 
-    void Http::postAsync(const std::string& url, const Arguments& arguments, const PostCallback& onSuccess, const ErrorCallback& onError)
+    Http::RequestId Http::postAsync(const std::string& url, const Arguments& arguments, const PostCallback& onSuccess, const ErrorCallback& onError)
     {
         auto args = packArguments(arguments);
-        postAsync(url, Body(args.begin(), args.end()), onSuccess, onError);
+        return postAsync(url, Body(args.begin(), args.end()), onSuccess, onError);
     }
 
     Http::Body Http::get(const std::string& url, const ErrorCallback& onError)
@@ -103,102 +234,189 @@ namespace onut
         return{reinterpret_cast<const char*>(body.data()), body.size()};
     }
 
-    void Http::getAsync(const std::string& url, const Arguments& arguments, const GetCallback& onSuccess, const ErrorCallback& onError)
+    Http::RequestId Http::getAsync(const std::string& url, const Arguments& arguments, Priority priority, const GetCallback& onSuccess, const ErrorCallback& onError)
     {
-        auto pThis = OThis;
-        OAsync([url, arguments, onSuccess, onError, pThis]
+        return startAsync(Method::Get, makeUrl(url, arguments), {}, priority, [onSuccess](Response& response)
         {
-            auto ret = pThis->get(url, arguments, [onError](long errCode, std::string message)
-            {
-                if (onError)
-                {
-                    OSync([errCode, message, onError]
-                    {
-                        onError(errCode, message);
-                    });
-                }
-            });
-            if (!ret.empty() && onSuccess)
+            if (onSuccess)
             {
-                OSync([ret, onSuccess]
-                {
-                    onSuccess(ret);
-                });
+                onSuccess(std::move(response.body));
             }
-        });
+        }, onError);
     }
 
-    void Http::getAsync(const std::string& url, const GetCallback& onSuccess, const ErrorCallback& onError)
+    Http::RequestId Http::getAsync(const std::string& url, const Arguments& arguments, const GetCallback& onSuccess, const ErrorCallback& onError)
     {
-        getAsync(url, {}, onSuccess, onError);
+        return getAsync(url, arguments, Priority::Normal, onSuccess, onError);
     }
 
-    void Http::getStringAsync(const std::string& url, const Arguments& arguments, const GetStringCallback& onSuccess, const ErrorCallback& onError)
+    Http::RequestId Http::getAsync(const std::string& url, const GetCallback& onSuccess, const ErrorCallback& onError)
     {
-        auto pThis = OThis;
-        OAsync([url, arguments, onSuccess, onError, pThis]
+        return getAsync(url, {}, onSuccess, onError);
+    }
+
+    Http::RequestId Http::getStringAsync(const std::string& url, const Arguments& arguments, const GetStringCallback& onSuccess, const ErrorCallback& onError)
+    {
+        return startAsync(Method::Get, makeUrl(url, arguments), {}, Priority::Normal, [onSuccess](Response& response)
         {
-            auto ret = pThis->getString(url, arguments, [onError](long errCode, std::string message)
-            {
-                if (onError)
-                {
-                    OSync([errCode, message, onError]
-                    {
-                        onError(errCode, message);
-                    });
-                }
-            });
-            if (!ret.empty() && onSuccess)
+            if (onSuccess)
             {
-                OSync([ret, onSuccess]
-                {
-                    onSuccess(ret);
-                });
+                onSuccess(std::string(reinterpret_cast<const char*>(response.body.data()), response.body.size()));
             }
-        });
+        }, onError);
+    }
+
+    Http::RequestId Http::getStringAsync(const std::string& url, const GetStringCallback& onSuccess, const ErrorCallback& onError)
+    {
+        return getStringAsync(url, {}, onSuccess, onError);
     }
 
-    void Http::getStringAsync(const std::string& url, const GetStringCallback& onSuccess, const ErrorCallback& onError)
+    Http::RequestId Http::getConditionalAsync(const std::string& url, const std::string& etag, const std::string& lastModified, Priority priority, const ResponseCallback& onResponse, const ErrorCallback& onError)
     {
-        getStringAsync(url, {}, onSuccess, onError);
+        return startAsync(Method::Get, url, {}, priority, onResponse, onError, etag, lastModified);
     }
 }
 
+static std::mutex g_httpCacheMutex;
+
+// Created on first use, games not downloading textures never touch the disk
+static OHttpCacheRef getHttpCache()
+{
+    std::lock_guard<std::mutex> lock(g_httpCacheMutex);
+    if (!oHttpCache && oSettings)
+    {
+        auto path = oSettings->getHttpCachePath();
+        if (path.empty()) path = onut::HttpCache::getUserPath(oSettings->getGameName());
+        oHttpCache = onut::HttpCache::create(path, oSettings->getHttpCacheMaxSize());
+    }
+    return oHttpCache;
+}
+
+static OTextureRef createCachedTexture(const OHttpCacheRef& pCache, const std::string& fullUrl, const onut::HttpCache::ViewRef& pView)
+{
+    if (!pView) return nullptr;
+    auto pTexture = OTexture::createFromFileData(pView->getData(), static_cast<uint32_t>(pView->getSize()));
+    pCache->setTexture(fullUrl, pTexture);
+    return pTexture;
+}
+
+static OTextureRef createDownloadedTexture(const OHttpCacheRef& pCache, const std::string& fullUrl, onut::Http::Response& response)
+{
+    if (response.status == 200)
+    {
+        auto pView = pCache->store(fullUrl, response);
+        if (pView) return createCachedTexture(pCache, fullUrl, pView);
+    }
+
+    // Not cacheable
+    if (response.body.empty()) return nullptr;
+    auto pTexture = OTexture::createFromFileData(response.body.data(), static_cast<uint32_t>(response.body.size()));
+    pCache->setTexture(fullUrl, pTexture);
+    return pTexture;
+}
+
 OTextureRef OHTTPGetTexture(const std::string& url, const onut::Http::Arguments& arguments, const onut::Http::ErrorCallback& onError)
 {
-    auto body = oHttp->get(url, arguments, onError);
-    if (!body.empty())
+    auto pCache = getHttpCache();
+    if (!pCache)
     {
-        return OTexture::createFromFileData(body.data(), body.size());
+        auto body = oHttp->get(url, arguments, onError);
+        if (!body.empty())
+        {
+            return OTexture::createFromFileData(body.data(), body.size());
+        }
+        return nullptr;
     }
-    return nullptr;
+
+    auto fullUrl = onut::Http::makeUrl(url, arguments);
+    auto pTexture = pCache->getTexture(fullUrl);
+    if (pTexture) return pTexture;
+
+    std::string etag, lastModified;
+    auto isCached = pCache->getValidators(fullUrl, etag, lastModified);
+
+    bool failed = false;
+    long errCode = 0;
+    std::string errMessage;
+    auto response = oHttp->getConditional(fullUrl, etag, lastModified, [&](long code, std::string message)
+    {
+        failed = true;
+        errCode = code;
+        errMessage = message;
+    });
+
+    if (isCached && (failed || response.status == 304))
+    {
+        pTexture = createCachedTexture(pCache, fullUrl, pCache->open(fullUrl));
+        if (pTexture) return pTexture;
+    }
+    if (failed)
+    {
+        if (onError) onError(errCode, errMessage);
+        return nullptr;
+    }
+    return createDownloadedTexture(pCache, fullUrl, response);
 }
 
-void OHTTPGetTextureAsync(const std::string& url, const onut::Http::Arguments& arguments, const onut::Http::TextureCallback& onSuccess, const onut::Http::ErrorCallback& onError)
+onut::Http::RequestId OHTTPGetTextureAsync(const std::string& url, const onut::Http::Arguments& arguments, const onut::Http::TextureCallback& onSuccess, const onut::Http::ErrorCallback& onError)
 {
-    OAsync([url, arguments, onSuccess, onError]
+    auto pCache = getHttpCache();
+    if (!pCache)
     {
-        auto ret = OHTTPGetTexture(url, arguments, [onError](long errCode, std::string message)
+        // Body arrives on the main thread, the texture has to be created there anyway
+        return oHttp->getAsync(url, arguments, [onSuccess](onut::Http::Body body)
         {
-            if (onError)
+            auto pTexture = OTexture::createFromFileData(body.data(), body.size());
+            if (pTexture && onSuccess)
             {
-                OSync([errCode, message, onError]
-                {
-                    onError(errCode, message);
-                });
+                onSuccess(pTexture);
             }
-        });
-        if (ret && onSuccess)
+        }, onError);
+    }
+
+    auto fullUrl = onut::Http::makeUrl(url, arguments);
+    auto pTexture = pCache->getTexture(fullUrl);
+    if (pTexture)
+    {
+        // Still called back later, like any other request. Nothing to cancel.
+        if (onSuccess) OSync([onSuccess, pTexture] { onSuccess(pTexture); });
+        return 0;
+    }
+
+    std::string etag, lastModified;
+    auto isCached = pCache->getValidators(fullUrl, etag, lastModified);
+
+    return oHttp->getConditionalAsync(fullUrl, etag, lastModified, onut::Http::Priority::Normal, [pCache, fullUrl, isCached, onSuccess](onut::Http::Response& response)
+    {
+        OTextureRef pTexture;
+        if (isCached && response.status == 304)
         {
-            OSync([ret, onSuccess]
-            {
-                onSuccess(ret);
-            });
+            pTexture = createCachedTexture(pCache, fullUrl, pCache->open(fullUrl));
+        }
+        else
+        {
+            pTexture = createDownloadedTexture(pCache, fullUrl, response);
+        }
+        if (pTexture && onSuccess)
+        {
+            onSuccess(pTexture);
+        }
+    }, [pCache, fullUrl, isCached, onSuccess, onError](long errCode, std::string message)
+    {
+        // Offline, use what we have
+        auto pTexture = isCached ? createCachedTexture(pCache, fullUrl, pCache->open(fullUrl)) : nullptr;
+        if (pTexture)
+        {
+            if (onSuccess) onSuccess(pTexture);
+        }
+        else if (onError)
+        {
+            onError(errCode, message);
         }
     });
 }
 
-void OHTTPGetTextureAsync(const std::string& url, const onut::Http::TextureCallback& onSuccess, const onut::Http::ErrorCallback& onError)
+onut::Http::RequestId OHTTPGetTextureAsync(const std::string& url, const onut::Http::TextureCallback& onSuccess, const onut::Http::ErrorCallback& onError)
 {
-    OHTTPGetTextureAsync(url, {}, onSuccess, onError);
+    return OHTTPGetTextureAsync(url, {}, onSuccess, onError);
 }
@@ -7,10 +7,8 @@
 // Internal
 #include "HttpCURL.h"
 
-// Third party
-#include <curl/curl.h>
-
 // STL
+#include <algorithm>
 #include <locale>
 
 namespace onut
@@ -20,13 +18,43 @@ namespace onut
         return std::shared_ptr<Http>(new HttpCURL());
     }
 
+    static const int DEFAULT_MAX_CONCURRENT_REQUESTS = 8;
+    static const long MAX_CACHED_CONNECTIONS = 16;
+
     HttpCURL::HttpCURL()
     {
         curl_global_init(CURL_GLOBAL_SSL);
+
+        // All async requests share the multi handle's connection cache,
+        // so connections are kept alive and reused between requests.
+        m_maxConcurrentRequests = DEFAULT_MAX_CONCURRENT_REQUESTS;
+        m_pMulti = curl_multi_init();
+        curl_multi_setopt(m_pMulti, CURLMOPT_MAXCONNECTS, MAX_CACHED_CONNECTIONS);
+        curl_multi_setopt(m_pMulti, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+
+        m_isRunning = true;
+        m_ioThread = std::thread(std::bind(&HttpCURL::ioThread, this));
     }
 
     HttpCURL::~HttpCURL()
     {
+        m_isRunning = false;
+        wakeUp();
+        if (m_ioThread.joinable())
+        {
+            m_ioThread.join();
+        }
+        for (auto& kv : m_transfers)
+        {
+            curl_multi_remove_handle(m_pMulti, kv.first);
+            curl_easy_cleanup(kv.first);
+            curl_slist_free_all(kv.second.pHeaders);
+        }
+        for (auto pEasy : m_idleEasies)
+        {
+            curl_easy_cleanup(pEasy);
+        }
+        curl_multi_cleanup(m_pMulti);
         curl_global_cleanup();
     }
 
@@ -40,6 +68,47 @@ namespace onut
         return totalSize;
     }
 
+    // Picks the validators out of the response headers
+    static size_t curlHeader(char *buffer, size_t size, size_t nitems, void *userp)
+    {
+        auto& response = *(Http::Response*)userp;
+        auto totalSize = size * nitems;
+        std::string line(buffer, totalSize);
+        auto colon = line.find(':');
+        if (colon == std::string::npos) return totalSize;
+        auto name = toLower(trim(line.substr(0, colon)));
+        if (name == "etag")
+        {
+            response.etag = trim(line.substr(colon + 1));
+        }
+        else if (name == "last-modified")
+        {
+            response.lastModified = trim(line.substr(colon + 1));
+        }
+        return totalSize;
+    }
+
+    static curl_slist* setupConditional(CURL* pEasy, Http::Response& response, const std::string& etag, const std::string& lastModified)
+    {
+        curl_easy_setopt(pEasy, CURLOPT_HEADERDATA, &response);
+        curl_easy_setopt(pEasy, CURLOPT_HEADERFUNCTION, curlHeader);
+
+        curl_slist* pHeaders = nullptr;
+        if (!etag.empty())
+        {
+            pHeaders = curl_slist_append(pHeaders, ("If-None-Match: " + etag).c_str());
+        }
+        if (!lastModified.empty())
+        {
+            pHeaders = curl_slist_append(pHeaders, ("If-Modified-Since: " + lastModified).c_str());
+        }
+        if (pHeaders)
+        {
+            curl_easy_setopt(pEasy, CURLOPT_HTTPHEADER, pHeaders);
+        }
+        return pHeaders;
+    }
+
     std::string HttpCURL::post(const std::string& url, const Body& body, const ErrorCallback& onError)
     {
         auto easyhandle = curl_easy_init();
@@ -80,12 +149,7 @@ namespace onut
 
     Http::Body HttpCURL::get(const std::string& url, const Arguments& arguments, const ErrorCallback& onError)
     {
-        auto args = packArguments(arguments);
-        auto fullUrl = url;
-        if (!args.empty())
-        {
-            fullUrl = url + "?" + args;
-        }
+        auto fullUrl = makeUrl(url, arguments);
 
         auto easyhandle = curl_easy_init();
         if (!easyhandle)
@@ -116,4 +180,226 @@ namespace onut
 
         return std::move(ret);
     }
+
+    Http::Response HttpCURL::getConditional(const std::string& url, const std::string& etag, const std::string& lastModified, const ErrorCallback& onError)
+    {
+        auto easyhandle = curl_easy_init();
+        if (!easyhandle)
+        {
+            if (onError)
+            {
+                onError(0, "curl_easy_init failed");
+            }
+            return {};
+        }
+
+        Response ret;
+
+        curl_easy_setopt(easyhandle, CURLOPT_URL, url.c_str());
+        curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &ret.body);
+        curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curlWrite);
+        auto pHeaders = setupConditional(easyhandle, ret, etag, lastModified);
+        auto performRet = curl_easy_perform(easyhandle);
+        curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &ret.status);
+        curl_easy_cleanup(easyhandle);
+        curl_slist_free_all(pHeaders);
+
+        if (performRet != CURLE_OK)
+        {
+            if (onError)
+            {
+                onError(0, "curl_easy_perform failed");
+            }
+            return {};
+        }
+
+        return std::move(ret);
+    }
+
+    void HttpCURL::setMaxConcurrentRequests(int maxConcurrentRequests)
+    {
+        m_maxConcurrentRequests = std::max(1, maxConcurrentRequests);
+        wakeUp();
+    }
+
+    void HttpCURL::performAsync(const AsyncRequestRef& pRequest)
+    {
+        m_queueMutex.lock();
+        m_pending[static_cast<int>(pRequest->priority)].push_back(pRequest);
+        m_queueMutex.unlock();
+        wakeUp();
+    }
+
+    void HttpCURL::cancelAsync(const AsyncRequestRef& pRequest)
+    {
+        std::lock_guard<std::mutex> lock(m_queueMutex);
+
+        // Still waiting, just forget it
+        auto& pending = m_pending[static_cast<int>(pRequest->priority)];
+        auto it = std::find(pending.begin(), pending.end(), pRequest);
+        if (it != pending.end())
+        {
+            pending.erase(it);
+            return;
+        }
+
+        // In flight, the I/O thread will abort it
+        m_cancelled.push_back(pRequest);
+        wakeUp();
+    }
+
+    void HttpCURL::wakeUp()
+    {
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+        curl_multi_wakeup(m_pMulti);
+#endif
+    }
+
+    CURL* HttpCURL::acquireEasy()
+    {
+        if (m_idleEasies.empty())
+        {
+            return curl_easy_init();
+        }
+        auto pEasy = m_idleEasies.back();
+        m_idleEasies.pop_back();
+        curl_easy_reset(pEasy);
+        return pEasy;
+    }
+
+    void HttpCURL::releaseEasy(CURL* pEasy)
+    {
+        curl_multi_remove_handle(m_pMulti, pEasy);
+        auto it = m_transfers.find(pEasy);
+        if (it != m_transfers.end())
+        {
+            curl_slist_free_all(it->second.pHeaders);
+            m_transfers.erase(it);
+        }
+        m_idleEasies.push_back(pEasy);
+    }
+
+    void HttpCURL::processCancels()
+    {
+        std::vector<AsyncRequestRef> cancelled;
+        m_queueMutex.lock();
+        cancelled.swap(m_cancelled);
+        m_queueMutex.unlock();
+
+        for (auto& pRequest : cancelled)
+        {
+            for (auto& kv : m_transfers)
+            {
+                if (kv.second.pRequest == pRequest)
+                {
+                    releaseEasy(kv.first);
+                    break;
+                }
+            }
+        }
+    }
+
+    void HttpCURL::startTransfers()
+    {
+        while (static_cast<int>(m_transfers.size()) < m_maxConcurrentRequests)
+        {
+            // Highest priority first, in order of request
+            AsyncRequestRef pRequest;
+            m_queueMutex.lock();
+            for (int priority = static_cast<int>(Priority::High); priority >= 0; --priority)
+            {
+                auto& pending = m_pending[priority];
+                if (!pending.empty())
+                {
+                    pRequest = pending.front();
+                    pending.pop_front();
+                    break;
+                }
+            }
+            m_queueMutex.unlock();
+            if (!pRequest) return;
+            if (pRequest->isCancelled) continue;
+
+            auto pEasy = acquireEasy();
+            if (!pEasy)
+            {
+                failAsync(pRequest, 0, "curl_easy_init failed");
+                continue;
+            }
+
+            auto& transfer = m_transfers[pEasy];
+            transfer.pRequest = pRequest;
+            transfer.response = Response();
+            transfer.pHeaders = nullptr;
+
+            curl_easy_setopt(pEasy, CURLOPT_URL, pRequest->url.c_str());
+            curl_easy_setopt(pEasy, CURLOPT_NOSIGNAL, 1L);
+            curl_easy_setopt(pEasy, CURLOPT_TCP_KEEPALIVE, 1L);
+            curl_easy_setopt(pEasy, CURLOPT_WRITEDATA, &transfer.response.body);
+            curl_easy_setopt(pEasy, CURLOPT_WRITEFUNCTION, curlWrite);
+            if (pRequest->method == Method::Get)
+            {
+                transfer.pHeaders = setupConditional(pEasy, transfer.response, pRequest->etag, pRequest->lastModified);
+            }
+            else
+            {
+                curl_easy_setopt(pEasy, CURLOPT_POST, 1L);
+                curl_easy_setopt(pEasy, CURLOPT_POSTFIELDSIZE, (long)pRequest->body.size());
+                curl_easy_setopt(pEasy, CURLOPT_POSTFIELDS, (char*)pRequest->body.data());
+            }
+            curl_multi_add_handle(m_pMulti, pEasy);
+        }
+    }
+
+    int HttpCURL::processDone()
+    {
+        int doneCount = 0;
+        int msgCount = 0;
+        while (auto pMsg = curl_multi_info_read(m_pMulti, &msgCount))
+        {
+            if (pMsg->msg != CURLMSG_DONE) continue;
+            auto pEasy = pMsg->easy_handle;
+            auto result = pMsg->data.result;
+            auto it = m_transfers.find(pEasy);
+            if (it == m_transfers.end()) continue;
+
+            auto pRequest = it->second.pRequest;
+            auto response = std::move(it->second.response);
+            curl_easy_getinfo(pEasy, CURLINFO_RESPONSE_CODE, &response.status);
+            releaseEasy(pEasy);
+            ++doneCount;
+
+            if (result != CURLE_OK)
+            {
+                failAsync(pRequest, 0, std::string("curl_easy_perform failed: ") + curl_easy_strerror(result));
+            }
+            else
+            {
+                completeAsync(pRequest, response);
+            }
+        }
+        return doneCount;
+    }
+
+    void HttpCURL::ioThread()
+    {
+        while (m_isRunning)
+        {
+            processCancels();
+            startTransfers();
+
+            int runningCount = 0;
+            curl_multi_perform(m_pMulti, &runningCount);
+            if (processDone() > 0)
+            {
+                continue; // Slots were freed, start what's waiting right away
+            }
+
+#if LIBCURL_VERSION_NUM >= 0x074400 // 7.68.0
+            curl_multi_poll(m_pMulti, nullptr, 0, 1000, nullptr);
+#else
+            curl_multi_wait(m_pMulti, nullptr, 0, 20, nullptr);
+#endif
+        }
+    }
 }
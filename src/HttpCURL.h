@@ -1,6 +1,17 @@
 // Onut
 #include <onut/Http.h>
 
+// STL
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Third party
+#include <curl/curl.h>
+
 namespace onut
 {
     class HttpCURL final : public Http
@@ -11,5 +22,41 @@ namespace onut
 
         std::string post(const std::string& url, const Body& body, const ErrorCallback& onError = nullptr) override;
         Body get(const std::string& url, const Arguments& arguments, const ErrorCallback& onError = nullptr) override;
+        Response getConditional(const std::string& url, const std::string& etag, const std::string& lastModified, const ErrorCallback& onError = nullptr) override;
+
+        void setMaxConcurrentRequests(int maxConcurrentRequests) override;
+
+    protected:
+        void performAsync(const AsyncRequestRef& pRequest) override;
+        void cancelAsync(const AsyncRequestRef& pRequest) override;
+
+    private:
+        // I/O thread only
+        struct Transfer
+        {
+            AsyncRequestRef pRequest;
+            Response response;
+            curl_slist* pHeaders = nullptr; // Validators, owned
+        };
+
+        void ioThread();
+        void wakeUp();
+        void startTransfers();
+        void processCancels();
+        int processDone();
+        CURL* acquireEasy();
+        void releaseEasy(CURL* pEasy);
+
+        CURLM* m_pMulti = nullptr;
+        std::thread m_ioThread;
+        std::atomic<bool> m_isRunning;
+        std::atomic<int> m_maxConcurrentRequests;
+
+        std::mutex m_queueMutex;
+        std::deque<AsyncRequestRef> m_pending[3]; // One per Priority
+        std::vector<AsyncRequestRef> m_cancelled;
+
+        std::unordered_map<CURL*, Transfer> m_transfers;
+        std::vector<CURL*> m_idleEasies; // Reused, they keep their DNS cache and settings
     };
 };
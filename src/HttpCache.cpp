@@ -0,0 +1,399 @@
+// Onut
+#include <onut/Crypto.h>
+#include <onut/HttpCache.h>
+#include <onut/Log.h>
+#include <onut/Texture.h>
+
+// STL
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+// System
+#if defined(WIN32)
+#include <direct.h>
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+OHttpCacheRef oHttpCache;
+
+namespace onut
+{
+    static const char* INDEX_FILENAME = "index";
+    static const char* INDEX_SIGNATURE = "OHC2";
+
+    HttpCache::View::~View()
+    {
+#if defined(WIN32)
+        if (m_pData) UnmapViewOfFile(m_pData);
+        if (m_hMapping) CloseHandle(m_hMapping);
+        if (m_hFile) CloseHandle(m_hFile);
+#else
+        if (m_pData) munmap(const_cast<uint8_t*>(m_pData), m_size);
+        if (m_fd != -1) ::close(m_fd);
+#endif
+    }
+
+    HttpCache::ViewRef HttpCache::mapFile(const std::string& filename)
+    {
+        auto pView = ViewRef(new View());
+#if defined(WIN32)
+        auto hFile = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (hFile == INVALID_HANDLE_VALUE) return nullptr;
+        pView->m_hFile = hFile;
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(hFile, &size) || size.QuadPart == 0) return nullptr;
+        pView->m_hMapping = CreateFileMappingA(hFile, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!pView->m_hMapping) return nullptr;
+        pView->m_pData = static_cast<const uint8_t*>(MapViewOfFile(pView->m_hMapping, FILE_MAP_READ, 0, 0, 0));
+        if (!pView->m_pData) return nullptr;
+        pView->m_size = static_cast<size_t>(size.QuadPart);
+#else
+        pView->m_fd = ::open(filename.c_str(), O_RDONLY);
+        if (pView->m_fd == -1) return nullptr;
+        struct stat st;
+        if (fstat(pView->m_fd, &st) == -1 || st.st_size == 0) return nullptr;
+        auto pData = mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, pView->m_fd, 0);
+        if (pData == MAP_FAILED) return nullptr;
+        pView->m_pData = static_cast<const uint8_t*>(pData);
+        pView->m_size = static_cast<size_t>(st.st_size);
+#endif
+        return pView;
+    }
+
+    static void createFolder(const std::string& path)
+    {
+#if defined(WIN32)
+        _mkdir(path.c_str());
+#else
+        mkdir(path.c_str(), 0755);
+#endif
+    }
+
+    static void createFolders(const std::string& path)
+    {
+        for (size_t i = 1; i < path.size(); ++i)
+        {
+            if (path[i] == '/' || path[i] == '\\') createFolder(path.substr(0, i));
+        }
+        createFolder(path);
+    }
+
+    std::string HttpCache::getUserPath(const std::string& appName)
+    {
+        std::string folderName;
+        for (auto c : appName)
+        {
+            folderName += (isalnum(static_cast<unsigned char>(c)) || c == ' ' || c == '-' || c == '_') ? c : '_';
+        }
+        if (folderName.empty()) folderName = "onut";
+
+#if defined(WIN32)
+        auto szLocalAppData = getenv("LOCALAPPDATA");
+        if (szLocalAppData && *szLocalAppData) return std::string(szLocalAppData) + "\\" + folderName + "\\httpcache";
+#elif defined(__APPLE__)
+        auto szHome = getenv("HOME");
+        if (szHome && *szHome) return std::string(szHome) + "/Library/Caches/" + folderName + "/httpcache";
+#else
+        auto szCacheHome = getenv("XDG_CACHE_HOME");
+        if (szCacheHome && *szCacheHome) return std::string(szCacheHome) + "/" + folderName + "/httpcache";
+        auto szHome = getenv("HOME");
+        if (szHome && *szHome) return std::string(szHome) + "/.cache/" + folderName + "/httpcache";
+#endif
+        return "httpcache";
+    }
+
+    OHttpCacheRef HttpCache::create(const std::string& path, size_t maxSize)
+    {
+        return std::shared_ptr<HttpCache>(new HttpCache(path, maxSize));
+    }
+
+    HttpCache::HttpCache(const std::string& path, size_t maxSize)
+        : m_path(path)
+        , m_maxSize(maxSize)
+    {
+        if (!m_path.empty() && m_path.back() != '/' && m_path.back() != '\\')
+        {
+            m_path += "/";
+        }
+        createFolders(m_path);
+        loadIndex();
+    }
+
+    HttpCache::~HttpCache()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (m_isIndexDirty) saveIndex();
+    }
+
+    std::string HttpCache::getFilename(const std::string& key) const
+    {
+        return m_path + key;
+    }
+
+    HttpCache::Entries::iterator HttpCache::find(const std::string& key)
+    {
+        auto it = m_entriesByKey.find(key);
+        if (it == m_entriesByKey.end()) return m_entries.end();
+        return it->second;
+    }
+
+    void HttpCache::touch(Entries::iterator it)
+    {
+        m_entries.splice(m_entries.end(), m_entries, it);
+        m_isIndexDirty = true;
+    }
+
+    // Only the first entry with this content counts toward the size
+    void HttpCache::addContent(const Entry& entry)
+    {
+        if (m_contentRefCounts[entry.contentKey]++ == 0) m_size += entry.size;
+    }
+
+    void HttpCache::releaseContent(const Entry& entry)
+    {
+        auto it = m_contentRefCounts.find(entry.contentKey);
+        if (--it->second > 0) return;
+
+        // Mapped views of it stay valid until they are released
+        std::remove(getFilename(entry.contentKey).c_str());
+        m_size -= entry.size;
+        m_contentRefCounts.erase(it);
+    }
+
+    void HttpCache::erase(Entries::iterator it)
+    {
+        releaseContent(*it);
+        m_entriesByKey.erase(it->key);
+        m_entries.erase(it);
+        m_isIndexDirty = true;
+    }
+
+    void HttpCache::evict()
+    {
+        while (m_size > m_maxSize && !m_entries.empty())
+        {
+            erase(m_entries.begin());
+        }
+    }
+
+    bool HttpCache::getValidators(const std::string& url, std::string& etag, std::string& lastModified)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(OSha1(url));
+        if (it == m_entries.end()) return false;
+        etag = it->etag;
+        lastModified = it->lastModified;
+        return true;
+    }
+
+    HttpCache::ViewRef HttpCache::open(const std::string& url)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(OSha1(url));
+        if (it == m_entries.end()) return nullptr;
+        auto pView = mapFile(getFilename(it->contentKey));
+        if (!pView)
+        {
+            // Deleted from under us
+            erase(it);
+            return nullptr;
+        }
+        touch(it);
+        return pView;
+    }
+
+    HttpCache::ViewRef HttpCache::store(const std::string& url, const Http::Response& response)
+    {
+        if (response.body.empty()) return nullptr;
+        auto key = OSha1(url);
+        auto contentKey = OSha1(response.body.data(), response.body.size());
+        auto filename = getFilename(contentKey);
+
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(key);
+        if (it != m_entries.end())
+        {
+            // Same bytes again, only the validators changed
+            if (it->contentKey == contentKey)
+            {
+                it->etag = response.etag;
+                it->lastModified = response.lastModified;
+                touch(it);
+                saveIndex();
+                return mapFile(filename);
+            }
+            erase(it);
+        }
+        if (response.body.size() > m_maxSize) return nullptr;
+
+        // Already there from another url
+        if (m_contentRefCounts.count(contentKey))
+        {
+            m_entries.push_back({key, contentKey, response.body.size(), response.etag, response.lastModified});
+            m_entriesByKey[key] = std::prev(m_entries.end());
+            addContent(m_entries.back());
+            evict();
+            saveIndex();
+            return mapFile(filename);
+        }
+
+        // Write aside then rename, so a crash never leaves a truncated file
+        auto tmpFilename = filename + ".tmp";
+        {
+            std::ofstream out(tmpFilename, std::ios::binary);
+            if (out.fail())
+            {
+                OLogE("Failed to write http cache: " + tmpFilename);
+                return nullptr;
+            }
+            out.write(reinterpret_cast<const char*>(response.body.data()), response.body.size());
+            if (out.fail())
+            {
+                out.close();
+                std::remove(tmpFilename.c_str());
+                return nullptr;
+            }
+        }
+        std::remove(filename.c_str());
+        if (std::rename(tmpFilename.c_str(), filename.c_str()) != 0)
+        {
+            std::remove(tmpFilename.c_str());
+            return nullptr;
+        }
+
+        m_entries.push_back({key, contentKey, response.body.size(), response.etag, response.lastModified});
+        m_entriesByKey[key] = std::prev(m_entries.end());
+        addContent(m_entries.back());
+        evict();
+        saveIndex();
+
+        return mapFile(filename);
+    }
+
+    void HttpCache::remove(const std::string& url)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto it = find(OSha1(url));
+        if (it == m_entries.end()) return;
+        erase(it);
+        saveIndex();
+    }
+
+    void HttpCache::clear()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            while (!m_entries.empty())
+            {
+                erase(m_entries.begin());
+            }
+            saveIndex();
+        }
+        clearTextures();
+    }
+
+    size_t HttpCache::getSize()
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return m_size;
+    }
+
+    void HttpCache::setMaxSize(size_t maxSize)
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_maxSize = maxSize;
+        evict();
+        if (m_isIndexDirty) saveIndex();
+    }
+
+    OTextureRef HttpCache::getTexture(const std::string& url)
+    {
+        std::lock_guard<std::mutex> lock(m_texturesMutex);
+        auto it = m_textures.find(url);
+        if (it == m_textures.end()) return nullptr;
+        return it->second.lock();
+    }
+
+    void HttpCache::setTexture(const std::string& url, const OTextureRef& pTexture)
+    {
+        std::lock_guard<std::mutex> lock(m_texturesMutex);
+        if (pTexture)
+        {
+            m_textures[url] = pTexture;
+            if (m_textures.size() > m_texturesSweepSize)
+            {
+                for (auto it = m_textures.begin(); it != m_textures.end();)
+                {
+                    if (it->second.expired()) it = m_textures.erase(it);
+                    else ++it;
+                }
+                m_texturesSweepSize = std::max<size_t>(64, m_textures.size() * 2);
+            }
+        }
+        else
+        {
+            m_textures.erase(url);
+        }
+    }
+
+    void HttpCache::clearTextures()
+    {
+        std::lock_guard<std::mutex> lock(m_texturesMutex);
+        m_textures.clear();
+    }
+
+    // One entry per line, least recently used first:
+    //   key contentKey size
+    //   etag
+    //   lastModified
+    void HttpCache::loadIndex()
+    {
+        std::ifstream in(m_path + INDEX_FILENAME);
+        if (in.fail()) return;
+
+        std::string line;
+        if (!std::getline(in, line) || line != INDEX_SIGNATURE) return;
+
+        Entry entry;
+        while (in >> entry.key >> entry.contentKey >> entry.size)
+        {
+            in.ignore(1);
+            if (!std::getline(in, entry.etag)) break;
+            if (!std::getline(in, entry.lastModified)) break;
+            if (m_entriesByKey.count(entry.key)) continue;
+            m_entries.push_back(entry);
+            m_entriesByKey[entry.key] = std::prev(m_entries.end());
+            addContent(entry);
+        }
+        evict();
+        if (m_isIndexDirty) saveIndex();
+    }
+
+    void HttpCache::saveIndex()
+    {
+        auto filename = m_path + INDEX_FILENAME;
+        auto tmpFilename = filename + ".tmp";
+        {
+            std::ofstream out(tmpFilename);
+            if (out.fail()) return;
+            out << INDEX_SIGNATURE << "\n";
+            for (auto& entry : m_entries)
+            {
+                out << entry.key << " " << entry.contentKey << " " << entry.size << "\n";
+                out << entry.etag << "\n";
+                out << entry.lastModified << "\n";
+            }
+        }
+        std::remove(filename.c_str());
+        std::rename(tmpFilename.c_str(), filename.c_str());
+        m_isIndexDirty = false;
+    }
+}
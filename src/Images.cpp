@@ -1,9 +1,17 @@
 // Onut
+#include <onut/Files.h>
 #include <onut/Images.h>
 
+// STL
+#include <cstring>
+#include <mutex>
+
 // Third party
 #include "lodepng/LodePNG.h"
 
+// Private
+#include "ImagesPNG.h"
+
 namespace onut
 {
     bool savePNG(const std::string& filename, const std::vector<uint8_t>& data, const Point& size)
@@ -25,26 +33,111 @@ namespace onut
         return ret;
     }
 
-    std::vector<uint8_t> loadPNG(const std::string& filename, Point& size)
+    static bool getPNGSizeLodePNG(const uint8_t* pData, size_t dataSize, Point& size)
     {
-        std::vector<uint8_t> ret;
         unsigned int w, h;
-        lodepng::decode(ret, w, h, filename);
+        lodepng::State state;
+        if (lodepng_inspect(&w, &h, &state, pData, dataSize)) return false;
         size.x = static_cast<int>(w);
         size.y = static_cast<int>(h);
-        return ret;
+        return true;
     }
 
-    std::vector<uint8_t> loadPNG(const std::vector<uint8_t>& data, Point& size)
+    static bool decodePNGLodePNG(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply)
     {
-        std::vector<uint8_t> ret;
+        std::vector<uint8_t> image;
         unsigned int w, h;
-        lodepng::decode(ret, w, h, data);
-        size.x = static_cast<int>(w);
-        size.y = static_cast<int>(h);
+        if (lodepng::decode(image, w, h, pData, dataSize)) return false;
+        memcpy(pOut, image.data(), image.size());
+        if (premultiply)
+        {
+            auto pEnd = pOut + image.size();
+            for (; pOut != pEnd; pOut += 4)
+            {
+                pOut[0] = pOut[0] * pOut[3] / 255;
+                pOut[1] = pOut[1] * pOut[3] / 255;
+                pOut[2] = pOut[2] * pOut[3] / 255;
+            }
+        }
+        return true;
+    }
+
+    struct ImageDecoders
+    {
+        std::mutex mutex;
+        std::vector<ImageDecoder> decoders = {
+            {getPNGSizeLodePNG, decodePNGLodePNG}, // Anything PNG, slower
+            {getPNGSize, decodePNG}
+        };
+    };
+
+    static ImageDecoders& getImageDecoders()
+    {
+        static ImageDecoders imageDecoders;
+        return imageDecoders;
+    }
+
+    static std::vector<ImageDecoder> copyImageDecoders()
+    {
+        auto& imageDecoders = getImageDecoders();
+        std::lock_guard<std::mutex> lock(imageDecoders.mutex);
+        return imageDecoders.decoders;
+    }
+
+    void addImageDecoder(const ImageDecoder& decoder)
+    {
+        auto& imageDecoders = getImageDecoders();
+        std::lock_guard<std::mutex> lock(imageDecoders.mutex);
+        imageDecoders.decoders.push_back(decoder);
+    }
+
+    bool getImageSize(const uint8_t* pData, size_t dataSize, Point& size)
+    {
+        auto decoders = copyImageDecoders();
+        for (auto it = decoders.rbegin(); it != decoders.rend(); ++it)
+        {
+            if (it->getSize(pData, dataSize, size)) return true;
+        }
+        return false;
+    }
+
+    bool decodeImage(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply)
+    {
+        // A decoder can accept the header and still give up, the next one gets a chance
+        auto decoders = copyImageDecoders();
+        Point size;
+        for (auto it = decoders.rbegin(); it != decoders.rend(); ++it)
+        {
+            if (it->getSize(pData, dataSize, size) && it->decode(pData, dataSize, pOut, premultiply)) return true;
+        }
+        return false;
+    }
+
+    std::vector<uint8_t> decodeImage(const uint8_t* pData, size_t dataSize, Point& size, bool premultiply)
+    {
+        std::vector<uint8_t> ret;
+        if (!getImageSize(pData, dataSize, size)) return ret;
+        ret.resize(static_cast<size_t>(size.x) * static_cast<size_t>(size.y) * 4);
+        if (!decodeImage(pData, dataSize, ret.data(), premultiply)) ret.clear();
         return ret;
     }
 
+    std::vector<uint8_t> loadPNG(const std::string& filename, Point& size)
+    {
+        auto data = getFileData(filename);
+        return decodeImage(data.data(), data.size(), size);
+    }
+
+    std::vector<uint8_t> loadPNG(const std::vector<uint8_t>& data, Point& size)
+    {
+        return decodeImage(data.data(), data.size(), size);
+    }
+
+    std::vector<uint8_t> loadPNG(const uint8_t* pData, size_t dataSize, Point& size)
+    {
+        return decodeImage(pData, dataSize, size);
+    }
+
 #if defined(WIN32)
     // Reference: https://www.codeproject.com/articles/5220/creating-a-color-cursor-from-a-bitmap
     void GetMaskBitmaps(HBITMAP hSourceBitmap,
@@ -0,0 +1,360 @@
+// STL
+#include <cstdlib>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+// Third party
+#include <zlib/zlib.h>
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ONUT_PNG_SSE2
+#include <emmintrin.h>
+#endif
+
+// Private
+#include "ImagesPNG.h"
+
+namespace onut
+{
+    static const uint8_t PNG_SIGNATURE[8] = {137, 80, 78, 71, 13, 10, 26, 10};
+
+    enum class PNGColorType : uint8_t
+    {
+        Gray = 0,
+        RGB = 2,
+        Palette = 3,
+        GrayAlpha = 4,
+        RGBA = 6
+    };
+
+    struct PNGHeader
+    {
+        uint32_t width;
+        uint32_t height;
+        uint8_t bitDepth;
+        PNGColorType colorType;
+        uint8_t interlace;
+        size_t channels;
+    };
+
+    struct PNGTransparency
+    {
+        uint8_t palette[256][4]; // RGBA
+        bool hasKey = false;
+        uint16_t key[3]; // Gray or RGB that is transparent
+    };
+
+    static uint32_t readU32(const uint8_t* p)
+    {
+        return (static_cast<uint32_t>(p[0]) << 24) | (static_cast<uint32_t>(p[1]) << 16) | (static_cast<uint32_t>(p[2]) << 8) | p[3];
+    }
+
+    static bool readHeader(const uint8_t* pData, size_t dataSize, PNGHeader& header)
+    {
+        if (dataSize < 33 || memcmp(pData, PNG_SIGNATURE, 8) || readU32(pData + 8) != 13 || memcmp(pData + 12, "IHDR", 4)) return false;
+        header.width = readU32(pData + 16);
+        header.height = readU32(pData + 20);
+        header.bitDepth = pData[24];
+        header.colorType = static_cast<PNGColorType>(pData[25]);
+        header.interlace = pData[28];
+        switch (header.colorType)
+        {
+            case PNGColorType::Gray: header.channels = 1; break;
+            case PNGColorType::RGB: header.channels = 3; break;
+            case PNGColorType::Palette: header.channels = 1; break;
+            case PNGColorType::GrayAlpha: header.channels = 2; break;
+            case PNGColorType::RGBA: header.channels = 4; break;
+            default: return false;
+        }
+
+        // Only what the fast path handles, lodepng does the rest
+        return header.width && header.height &&
+            header.width <= 0x4000 && header.height <= 0x4000 &&
+            header.bitDepth == 8 && header.interlace == 0;
+    }
+
+    bool getPNGSize(const uint8_t* pData, size_t dataSize, Point& size)
+    {
+        PNGHeader header;
+        if (!readHeader(pData, dataSize, header)) return false;
+        size.x = static_cast<int>(header.width);
+        size.y = static_cast<int>(header.height);
+        return true;
+    }
+
+    static uint8_t paeth(int a, int b, int c)
+    {
+        auto pa = std::abs(b - c);
+        auto pb = std::abs(a - c);
+        auto pc = std::abs(a + b - c - c);
+        if (pa <= pb && pa <= pc) return static_cast<uint8_t>(a);
+        if (pb <= pc) return static_cast<uint8_t>(b);
+        return static_cast<uint8_t>(c);
+    }
+
+#if defined(ONUT_PNG_SSE2)
+    // One RGBA pixel at a time. Each depends on the one on its left
+    static __m128i load4(const uint8_t* p)
+    {
+        int32_t value;
+        memcpy(&value, p, 4);
+        return _mm_cvtsi32_si128(value);
+    }
+
+    static void store4(uint8_t* p, __m128i v)
+    {
+        auto value = _mm_cvtsi128_si32(v);
+        memcpy(p, &value, 4);
+    }
+
+    static void unfilterSub4(uint8_t* pRow, size_t size)
+    {
+        auto a = _mm_setzero_si128();
+        for (size_t i = 0; i < size; i += 4)
+        {
+            a = _mm_add_epi8(a, load4(pRow + i));
+            store4(pRow + i, a);
+        }
+    }
+
+    static void unfilterAverage4(uint8_t* pRow, const uint8_t* pPrev, size_t size)
+    {
+        const auto one = _mm_set1_epi8(1);
+        auto a = _mm_setzero_si128();
+        for (size_t i = 0; i < size; i += 4)
+        {
+            auto b = load4(pPrev + i);
+            auto average = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), one)); // avg_epu8 rounds up
+            a = _mm_add_epi8(load4(pRow + i), average);
+            store4(pRow + i, a);
+        }
+    }
+
+    static __m128i abs16(__m128i v)
+    {
+        return _mm_max_epi16(v, _mm_sub_epi16(_mm_setzero_si128(), v));
+    }
+
+    static __m128i select16(__m128i mask, __m128i a, __m128i b)
+    {
+        return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+    }
+
+    static void unfilterPaeth4(uint8_t* pRow, const uint8_t* pPrev, size_t size)
+    {
+        const auto zero = _mm_setzero_si128();
+        const auto mask = _mm_set1_epi16(0xFF);
+        auto a = zero;
+        auto c = zero;
+        for (size_t i = 0; i < size; i += 4)
+        {
+            auto b = _mm_unpacklo_epi8(load4(pPrev + i), zero);
+            auto x = _mm_unpacklo_epi8(load4(pRow + i), zero);
+            auto pa = _mm_sub_epi16(b, c);
+            auto pb = _mm_sub_epi16(a, c);
+            auto pc = abs16(_mm_add_epi16(pa, pb));
+            pa = abs16(pa);
+            pb = abs16(pb);
+            auto smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+            auto nearest = select16(_mm_cmpeq_epi16(smallest, pa), a, select16(_mm_cmpeq_epi16(smallest, pb), b, c));
+            a = _mm_and_si128(_mm_add_epi16(x, nearest), mask);
+            store4(pRow + i, _mm_packus_epi16(a, a));
+            c = b;
+        }
+    }
+#endif
+
+    static bool unfilterRow(uint8_t filter, uint8_t* pRow, const uint8_t* pPrev, size_t size, size_t bpp)
+    {
+        switch (filter)
+        {
+            case 0: // None
+                return true;
+            case 1: // Sub
+#if defined(ONUT_PNG_SSE2)
+                if (bpp == 4)
+                {
+                    unfilterSub4(pRow, size);
+                    return true;
+                }
+#endif
+                for (size_t i = bpp; i < size; ++i) pRow[i] += pRow[i - bpp];
+                return true;
+            case 2: // Up, vectorized by the compiler
+                for (size_t i = 0; i < size; ++i) pRow[i] += pPrev[i];
+                return true;
+            case 3: // Average
+#if defined(ONUT_PNG_SSE2)
+                if (bpp == 4)
+                {
+                    unfilterAverage4(pRow, pPrev, size);
+                    return true;
+                }
+#endif
+                for (size_t i = 0; i < bpp; ++i) pRow[i] += pPrev[i] >> 1;
+                for (size_t i = bpp; i < size; ++i) pRow[i] += static_cast<uint8_t>((pRow[i - bpp] + pPrev[i]) >> 1);
+                return true;
+            case 4: // Paeth
+#if defined(ONUT_PNG_SSE2)
+                if (bpp == 4)
+                {
+                    unfilterPaeth4(pRow, pPrev, size);
+                    return true;
+                }
+#endif
+                for (size_t i = 0; i < bpp; ++i) pRow[i] += pPrev[i];
+                for (size_t i = bpp; i < size; ++i) pRow[i] += paeth(pRow[i - bpp], pPrev[i], pPrev[i - bpp]);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    static void convertRow(const PNGHeader& header, const PNGTransparency& transparency, const uint8_t* pRow, uint8_t* pOut, bool premultiply)
+    {
+        auto width = header.width;
+        auto pDst = pOut;
+        switch (header.colorType)
+        {
+            case PNGColorType::RGBA:
+                memcpy(pOut, pRow, width * 4);
+                break;
+            case PNGColorType::RGB:
+                for (uint32_t i = 0; i < width; ++i, pRow += 3, pDst += 4)
+                {
+                    pDst[0] = pRow[0];
+                    pDst[1] = pRow[1];
+                    pDst[2] = pRow[2];
+                    pDst[3] = (transparency.hasKey && pRow[0] == transparency.key[0] && pRow[1] == transparency.key[1] && pRow[2] == transparency.key[2]) ? 0 : 255;
+                }
+                break;
+            case PNGColorType::Gray:
+                for (uint32_t i = 0; i < width; ++i, ++pRow, pDst += 4)
+                {
+                    pDst[0] = pDst[1] = pDst[2] = pRow[0];
+                    pDst[3] = (transparency.hasKey && pRow[0] == transparency.key[0]) ? 0 : 255;
+                }
+                break;
+            case PNGColorType::GrayAlpha:
+                for (uint32_t i = 0; i < width; ++i, pRow += 2, pDst += 4)
+                {
+                    pDst[0] = pDst[1] = pDst[2] = pRow[0];
+                    pDst[3] = pRow[1];
+                }
+                break;
+            case PNGColorType::Palette:
+                for (uint32_t i = 0; i < width; ++i, ++pRow, pDst += 4)
+                {
+                    memcpy(pDst, transparency.palette[pRow[0]], 4);
+                }
+                break;
+        }
+
+        if (premultiply)
+        {
+            for (uint32_t i = 0; i < width; ++i, pOut += 4)
+            {
+                auto alpha = pOut[3];
+                if (alpha == 255) continue;
+                pOut[0] = pOut[0] * alpha / 255;
+                pOut[1] = pOut[1] * alpha / 255;
+                pOut[2] = pOut[2] * alpha / 255;
+            }
+        }
+    }
+
+    bool decodePNG(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply)
+    {
+        PNGHeader header;
+        if (!readHeader(pData, dataSize, header)) return false;
+
+        PNGTransparency transparency;
+        for (auto& color : transparency.palette)
+        {
+            color[0] = color[1] = color[2] = 0;
+            color[3] = 255;
+        }
+
+        // Two rows, each with its filter type byte in front. The first one has a blank row above
+        auto rowSize = header.width * header.channels;
+        std::vector<uint8_t> rows((rowSize + 1) * 2, 0);
+        auto pRow = rows.data();
+        auto pPrev = pRow + rowSize + 1;
+        size_t rowFill = 0;
+        uint32_t y = 0;
+
+        z_stream stream;
+        memset(&stream, 0, sizeof(stream));
+        if (inflateInit(&stream) != Z_OK) return false;
+
+        bool isValid = true;
+        auto pChunk = pData + 8;
+        auto pEnd = pData + dataSize;
+        while (isValid && y < header.height && pEnd - pChunk >= 12)
+        {
+            auto length = readU32(pChunk);
+            auto pType = pChunk + 4;
+            auto pChunkData = pChunk + 8;
+            if (length > static_cast<size_t>(pEnd - pChunkData - 4)) break;
+
+            if (!memcmp(pType, "PLTE", 4))
+            {
+                for (uint32_t i = 0; i < length / 3 && i < 256; ++i)
+                {
+                    memcpy(transparency.palette[i], pChunkData + i * 3, 3);
+                }
+            }
+            else if (!memcmp(pType, "tRNS", 4))
+            {
+                if (header.colorType == PNGColorType::Palette)
+                {
+                    for (uint32_t i = 0; i < length && i < 256; ++i) transparency.palette[i][3] = pChunkData[i];
+                }
+                else if (length >= header.channels * 2)
+                {
+                    transparency.hasKey = true;
+                    for (size_t i = 0; i < header.channels; ++i) transparency.key[i] = static_cast<uint16_t>((pChunkData[i * 2] << 8) | pChunkData[i * 2 + 1]);
+                }
+            }
+            else if (!memcmp(pType, "IDAT", 4))
+            {
+                stream.next_in = const_cast<Bytef*>(pChunkData);
+                stream.avail_in = length;
+                while (stream.avail_in && y < header.height)
+                {
+                    stream.next_out = pRow + rowFill;
+                    stream.avail_out = static_cast<uInt>(rowSize + 1 - rowFill);
+                    auto ret = inflate(&stream, Z_NO_FLUSH);
+                    if (ret != Z_OK && ret != Z_STREAM_END)
+                    {
+                        isValid = false;
+                        break;
+                    }
+                    rowFill = rowSize + 1 - stream.avail_out;
+                    if (rowFill == rowSize + 1)
+                    {
+                        if (!unfilterRow(pRow[0], pRow + 1, pPrev + 1, rowSize, header.channels))
+                        {
+                            isValid = false;
+                            break;
+                        }
+                        convertRow(header, transparency, pRow + 1, pOut + static_cast<size_t>(y) * header.width * 4, premultiply);
+                        std::swap(pRow, pPrev);
+                        rowFill = 0;
+                        ++y;
+                    }
+                    if (ret == Z_STREAM_END) break;
+                }
+            }
+            else if (!memcmp(pType, "IEND", 4))
+            {
+                break;
+            }
+
+            pChunk = pChunkData + length + 4; // Skip the CRC
+        }
+
+        inflateEnd(&stream);
+        return isValid && y == header.height;
+    }
+}
@@ -0,0 +1,23 @@
+#ifndef IMAGES_PNG_H_INCLUDED
+#define IMAGES_PNG_H_INCLUDED
+
+// Onut
+#include <onut/Point.h>
+
+// STL
+#include <cinttypes>
+#include <cstddef>
+
+namespace onut
+{
+    /*!
+        Fast path for the PNGs games mostly use: 8 bits per channel, not
+        interlaced. Inflated with zlib one row at a time, unfiltered (SSE2
+        when available) and converted to RGBA8 straight into pOut.
+        Returns false for anything else, lodepng handles those.
+    */
+    bool getPNGSize(const uint8_t* pData, size_t dataSize, Point& size);
+    bool decodePNG(const uint8_t* pData, size_t dataSize, uint8_t* pOut, bool premultiply);
+}
+
+#endif
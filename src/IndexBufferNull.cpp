@@ -0,0 +1,56 @@
+// Onut
+#include <onut/Renderer.h>
+#include <onut/RendererNull.h>
+
+// Private
+#include "IndexBufferNull.h"
+
+// STL
+#include <cassert>
+
+namespace onut
+{
+    OIndexBufferRef IndexBuffer::createStatic(const void* pIndexData, uint32_t size)
+    {
+        auto pRet = OMake<IndexBufferNull>();
+        pRet->setData(pIndexData, size);
+        return pRet;
+    }
+
+    OIndexBufferRef IndexBuffer::createDynamic(uint32_t size)
+    {
+        auto pRet = OMake<IndexBufferNull>();
+        pRet->m_size = size;
+        pRet->m_data.resize(size);
+        pRet->m_isDynamic = true;
+
+        oRenderer->renderStates.indexBuffer.forceDirty();
+
+        return pRet;
+    }
+
+    void IndexBufferNull::setData(const void* pIndexData, uint32_t size)
+    {
+        if (!m_isDynamic) m_size = size;
+        RendererNull::countUpload(size);
+        oRenderer->renderStates.indexBuffer.forceDirty();
+    }
+
+    void* IndexBufferNull::map()
+    {
+        assert(m_isDynamic);
+        return m_data.data();
+    }
+
+    void IndexBufferNull::unmap(uint32_t size)
+    {
+        assert(m_isDynamic);
+        RendererNull::countUpload(size);
+        oRenderer->renderStates.indexBuffer.forceDirty();
+    }
+
+    uint32_t IndexBufferNull::size()
+    {
+        return m_size;
+    }
+}
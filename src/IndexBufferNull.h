@@ -0,0 +1,33 @@
+#ifndef INDEXBUFFERNULL_H_INCLUDED
+#define INDEXBUFFERNULL_H_INCLUDED
+
+// Onut
+#include <onut/IndexBuffer.h>
+
+// STL
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(IndexBufferNull)
+
+namespace onut
+{
+    class IndexBufferNull final : public IndexBuffer
+    {
+    public:
+        void setData(const void* pIndexData, uint32_t size) override;
+        void* map() override;
+        void unmap(uint32_t size) override;
+        uint32_t size() override;
+
+    private:
+        friend class IndexBuffer;
+
+        uint32_t m_size = 0;
+        bool m_isDynamic = false;
+        std::vector<uint8_t> m_data; // What map gives when dynamic
+    };
+}
+
+#endif
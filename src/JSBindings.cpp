@@ -8302,6 +8302,7 @@ namespace onut
                     auto pUIControl = ppUIControl->get();
                     auto rectBefore = pUIControl->rect;
                     pUIControl->rect = JS_RECT(0, rectBefore);
+                    pUIControl->invalidateLayout();
                 }
                 return 0;
             }, 1);
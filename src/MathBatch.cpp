@@ -0,0 +1,161 @@
+// Onut
+#include <onut/MathBatch.h>
+
+// STL
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define ONUT_MATH_SSE2
+#include <emmintrin.h>
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+#define ONUT_MATH_NEON
+#include <arm_neon.h>
+#endif
+
+namespace onut
+{
+    void transformPoints(const float* pX, const float* pY, float* pOutX, float* pOutY, size_t count, const Matrix& transform)
+    {
+        size_t i = 0;
+#if defined(ONUT_MATH_SSE2)
+        auto m11 = _mm_set1_ps(transform._11);
+        auto m12 = _mm_set1_ps(transform._12);
+        auto m21 = _mm_set1_ps(transform._21);
+        auto m22 = _mm_set1_ps(transform._22);
+        auto m41 = _mm_set1_ps(transform._41);
+        auto m42 = _mm_set1_ps(transform._42);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto x = _mm_loadu_ps(pX + i);
+            auto y = _mm_loadu_ps(pY + i);
+            _mm_storeu_ps(pOutX + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m11, x), _mm_mul_ps(m21, y)), m41));
+            _mm_storeu_ps(pOutY + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(m12, x), _mm_mul_ps(m22, y)), m42));
+        }
+#elif defined(ONUT_MATH_NEON)
+        auto m11 = vdupq_n_f32(transform._11);
+        auto m12 = vdupq_n_f32(transform._12);
+        auto m21 = vdupq_n_f32(transform._21);
+        auto m22 = vdupq_n_f32(transform._22);
+        auto m41 = vdupq_n_f32(transform._41);
+        auto m42 = vdupq_n_f32(transform._42);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto x = vld1q_f32(pX + i);
+            auto y = vld1q_f32(pY + i);
+            vst1q_f32(pOutX + i, vaddq_f32(vaddq_f32(vmulq_f32(m11, x), vmulq_f32(m21, y)), m41));
+            vst1q_f32(pOutY + i, vaddq_f32(vaddq_f32(vmulq_f32(m12, x), vmulq_f32(m22, y)), m42));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            auto x = pX[i];
+            auto y = pY[i];
+            pOutX[i] = (transform._11 * x) + (transform._21 * y) + transform._41;
+            pOutY[i] = (transform._12 * x) + (transform._22 * y) + transform._42;
+        }
+    }
+
+    size_t cullBoxes(const float* pMinX, const float* pMinY, const float* pMaxX, const float* pMaxY, size_t count, const Rect& view, uint8_t* pVisible)
+    {
+        auto viewMaxX = view.x + view.z;
+        auto viewMaxY = view.y + view.w;
+        size_t visibleCount = 0;
+        size_t i = 0;
+#if defined(ONUT_MATH_SSE2)
+        auto left = _mm_set1_ps(view.x);
+        auto top = _mm_set1_ps(view.y);
+        auto right = _mm_set1_ps(viewMaxX);
+        auto bottom = _mm_set1_ps(viewMaxY);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto isVisible = _mm_and_ps(
+                _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(pMaxX + i), left), _mm_cmple_ps(_mm_loadu_ps(pMinX + i), right)),
+                _mm_and_ps(_mm_cmpge_ps(_mm_loadu_ps(pMaxY + i), top), _mm_cmple_ps(_mm_loadu_ps(pMinY + i), bottom)));
+            auto mask = _mm_movemask_ps(isVisible);
+            for (int j = 0; j < 4; ++j)
+            {
+                auto bit = static_cast<uint8_t>((mask >> j) & 1);
+                pVisible[i + j] = bit;
+                visibleCount += bit;
+            }
+        }
+#elif defined(ONUT_MATH_NEON)
+        auto left = vdupq_n_f32(view.x);
+        auto top = vdupq_n_f32(view.y);
+        auto right = vdupq_n_f32(viewMaxX);
+        auto bottom = vdupq_n_f32(viewMaxY);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto isVisible = vandq_u32(
+                vandq_u32(vcgeq_f32(vld1q_f32(pMaxX + i), left), vcleq_f32(vld1q_f32(pMinX + i), right)),
+                vandq_u32(vcgeq_f32(vld1q_f32(pMaxY + i), top), vcleq_f32(vld1q_f32(pMinY + i), bottom)));
+            uint32_t lanes[4];
+            vst1q_u32(lanes, isVisible);
+            for (int j = 0; j < 4; ++j)
+            {
+                auto bit = static_cast<uint8_t>(lanes[j] & 1);
+                pVisible[i + j] = bit;
+                visibleCount += bit;
+            }
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            auto bit = static_cast<uint8_t>(
+                pMaxX[i] >= view.x && pMinX[i] <= viewMaxX &&
+                pMaxY[i] >= view.y && pMinY[i] <= viewMaxY);
+            pVisible[i] = bit;
+            visibleCount += bit;
+        }
+        return visibleCount;
+    }
+
+    void lerpValues(const float* pFrom, const float* pTo, float t, float* pOut, size_t count)
+    {
+        size_t i = 0;
+#if defined(ONUT_MATH_SSE2)
+        auto t4 = _mm_set1_ps(t);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto from = _mm_loadu_ps(pFrom + i);
+            _mm_storeu_ps(pOut + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pTo + i), from), t4)));
+        }
+#elif defined(ONUT_MATH_NEON)
+        auto t4 = vdupq_n_f32(t);
+        for (; i + 4 <= count; i += 4)
+        {
+            auto from = vld1q_f32(pFrom + i);
+            vst1q_f32(pOut + i, vaddq_f32(from, vmulq_f32(vsubq_f32(vld1q_f32(pTo + i), from), t4)));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            pOut[i] = pFrom[i] + (pTo[i] - pFrom[i]) * t;
+        }
+    }
+
+    void lerpValues(const float* pFrom, const float* pTo, const float* pT, float* pOut, size_t count)
+    {
+        size_t i = 0;
+#if defined(ONUT_MATH_SSE2)
+        for (; i + 4 <= count; i += 4)
+        {
+            auto from = _mm_loadu_ps(pFrom + i);
+            _mm_storeu_ps(pOut + i, _mm_add_ps(from, _mm_mul_ps(_mm_sub_ps(_mm_loadu_ps(pTo + i), from), _mm_loadu_ps(pT + i))));
+        }
+#elif defined(ONUT_MATH_NEON)
+        for (; i + 4 <= count; i += 4)
+        {
+            auto from = vld1q_f32(pFrom + i);
+            vst1q_f32(pOut + i, vaddq_f32(from, vmulq_f32(vsubq_f32(vld1q_f32(pTo + i), from), vld1q_f32(pT + i))));
+        }
+#endif
+        for (; i < count; ++i)
+        {
+            pOut[i] = pFrom[i] + (pTo[i] - pFrom[i]) * pT[i];
+        }
+    }
+
+    void tweenValues(const float* pFrom, const float* pTo, float t, Tween tween, float* pOut, size_t count)
+    {
+        lerpValues(pFrom, pTo, applyTween(t, tween), pOut, count);
+    }
+}
@@ -21,6 +21,9 @@ namespace onut
 
         pRet->m_filename = filename;
 
+        // Loose files are mapped so the stream pages in as it plays
+        pRet->m_fileData = fileExists(filename) ? mapFileData(filename) : readResourceFile(filename, pContentManager);
+
         return pRet;
     }
 
@@ -48,7 +51,8 @@ namespace onut
         m_buffers.clear();
         m_bufferCount = 0;
 
-        m_pStream = stb_vorbis_open_filename((char*)m_filename.c_str(), NULL, NULL);
+        if (m_fileData.isEmpty()) return;
+        m_pStream = stb_vorbis_open_memory(m_fileData.getData(), static_cast<int>(m_fileData.getSize()), NULL, NULL);
         if (!m_pStream) return;
 
         m_info = stb_vorbis_get_info(m_pStream);
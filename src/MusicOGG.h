@@ -3,6 +3,7 @@
 
 // Onut
 #include <onut/AudioStream.h>
+#include <onut/Files.h>
 #include <onut/Music.h>
 #include <onut/Resource.h>
 
@@ -65,6 +66,7 @@ namespace onut
         int m_bufferMax;
         int m_engineChannelCount;
         std::string m_filename;
+        FileData m_fileData;
         stb_vorbis* m_pStream = nullptr;
         stb_vorbis_info m_info;
     };
@@ -153,7 +153,8 @@ namespace onut
     sPEX loadPEXFile(const std::string& filename)
     {
         tinyxml2::XMLDocument doc;
-        doc.LoadFile(filename.c_str());
+        auto data = readResourceFile(filename, nullptr);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
         assert(!doc.Error());
         auto pXmlParticleEmitterConfig = doc.FirstChildElement("particleEmitterConfig");
         assert(pXmlParticleEmitterConfig);
@@ -528,6 +529,14 @@ namespace onut
     {
         return m_emitters;
     }
+
+    bool ParticleSystem::reload(const OContentManagerRef& pContentManager)
+    {
+        auto pNew = createFromFile(getFilename(), pContentManager);
+        if (!pNew) return false;
+        m_emitters.swap(pNew->m_emitters);
+        return true;
+    }
 }
 
 OParticleSystemRef OGetParticleSystem(const std::string& name)
@@ -1,5 +1,5 @@
 // Onut
-#include <onut/Dispatcher.h>
+#include <onut/Log.h>
 #include <onut/RTS.h>
 #include <onut/Strings.h>
 
@@ -7,9 +7,148 @@
 #include <algorithm>
 #include <thread>
 
+// System
+#if !defined(WIN32)
+#include <errno.h>
+#include <netdb.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif
+#if defined(__linux__)
+#define ONUT_RTS_MMSG // recvmmsg/sendmmsg batching
+#endif
+
 namespace onut
 {
-    static const char signature[4] = {'O', 'R', 'T', '1'};
+    static const char signature[4] = {'O', 'R', 'T', '2'};
+
+    // An outgoing datagram. The packet is never copied, we point into the turn storage.
+    struct sOutgoing
+    {
+        const sPacket *pPacket;
+        int size;
+        sockaddr_in to;
+    };
+
+    static void closeSocketHandle(RTSSocketHandle sock)
+    {
+#if defined(WIN32)
+        closesocket(sock);
+#else
+        ::close(sock);
+#endif
+    }
+
+    static void setRecvTimeout(RTSSocketHandle sock, int milliseconds)
+    {
+#if defined(WIN32)
+        DWORD timeout = static_cast<DWORD>(milliseconds);
+#else
+        timeval timeout;
+        timeout.tv_sec = milliseconds / 1000;
+        timeout.tv_usec = (milliseconds % 1000) * 1000;
+#endif
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, (const char *)&timeout, sizeof(timeout));
+    }
+
+    static bool isTimeoutError()
+    {
+#if defined(WIN32)
+        return WSAGetLastError() == WSAETIMEDOUT;
+#else
+        return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+#endif
+    }
+
+    static void sendTo(RTSSocketHandle sock, const void *pData, int size, const sockaddr_in& to)
+    {
+        sendto(sock, (const char *)pData, size, 0, (const struct sockaddr *)&to, sizeof(to));
+    }
+
+    // Sends all datagrams with as few system calls as the platform allows
+    static void sendBatch(RTSSocketHandle sock, sOutgoing *pOutgoings, int count)
+    {
+#if defined(ONUT_RTS_MMSG)
+        static const int maxBatch = 64;
+        mmsghdr msgs[maxBatch];
+        iovec iovecs[maxBatch];
+        while (count > 0)
+        {
+            auto batchCount = std::min(count, maxBatch);
+            for (int i = 0; i < batchCount; ++i)
+            {
+                auto& outgoing = pOutgoings[i];
+                iovecs[i].iov_base = (void *)outgoing.pPacket->pBuf;
+                iovecs[i].iov_len = static_cast<size_t>(outgoing.size);
+                memset(&msgs[i], 0, sizeof(mmsghdr));
+                msgs[i].msg_hdr.msg_name = &outgoing.to;
+                msgs[i].msg_hdr.msg_namelen = sizeof(outgoing.to);
+                msgs[i].msg_hdr.msg_iov = &iovecs[i];
+                msgs[i].msg_hdr.msg_iovlen = 1;
+            }
+            auto sent = sendmmsg(sock, msgs, static_cast<unsigned int>(batchCount), 0);
+            if (sent <= 0)
+            {
+                // Skip the failing datagram. UDP, it will be resent.
+                sent = 1;
+            }
+            pOutgoings += sent;
+            count -= sent;
+        }
+#else
+        for (int i = 0; i < count; ++i)
+        {
+            auto& outgoing = pOutgoings[i];
+            sendTo(sock, outgoing.pPacket->pBuf, outgoing.size, outgoing.to);
+        }
+#endif
+    }
+
+    // Blocking receive (up to the socket timeout) directly into the ring slots.
+    // Returns the number of datagrams received, or -1 if the socket is dead.
+    static int recvBatch(RTSSocketHandle sock, sPacket **ppPackets, int count)
+    {
+#if defined(ONUT_RTS_MMSG)
+        mmsghdr msgs[recvBatchSize];
+        iovec iovecs[recvBatchSize];
+        count = std::min(count, recvBatchSize);
+        for (int i = 0; i < count; ++i)
+        {
+            auto pPacket = ppPackets[i];
+            iovecs[i].iov_base = pPacket->pBuf;
+            iovecs[i].iov_len = packetSize;
+            memset(&msgs[i], 0, sizeof(mmsghdr));
+            msgs[i].msg_hdr.msg_name = &pPacket->from;
+            msgs[i].msg_hdr.msg_namelen = sizeof(pPacket->from);
+            msgs[i].msg_hdr.msg_iov = &iovecs[i];
+            msgs[i].msg_hdr.msg_iovlen = 1;
+        }
+        auto received = recvmmsg(sock, msgs, static_cast<unsigned int>(count), MSG_WAITFORONE, nullptr);
+        if (received < 0)
+        {
+            return isTimeoutError() ? 0 : -1;
+        }
+        for (int i = 0; i < received; ++i)
+        {
+            ppPackets[i]->size = static_cast<int>(msgs[i].msg_len);
+        }
+        return received;
+#else
+        auto pPacket = ppPackets[0];
+#if defined(WIN32)
+        int slen = sizeof(pPacket->from);
+#else
+        socklen_t slen = sizeof(pPacket->from);
+#endif
+        auto recv_len = recvfrom(sock, (char *)pPacket->pBuf, packetSize, 0, (struct sockaddr *)&pPacket->from, &slen);
+        if (recv_len < 0)
+        {
+            return isTimeoutError() ? 0 : -1;
+        }
+        pPacket->size = static_cast<int>(recv_len);
+        return 1;
+#endif
+    }
 
     void Object::retain()
     {
@@ -25,22 +164,51 @@ namespace onut
         }
     }
 
+    int RTSPacketRing::acquire(sPacket **ppOut, int maxCount)
+    {
+        auto tail = m_tail.load(std::memory_order_relaxed);
+        auto head = m_head.load(std::memory_order_acquire);
+        auto freeCount = recvRingSize - static_cast<int>(tail - head);
+        auto index = static_cast<int>(tail & (recvRingSize - 1));
+        auto count = std::min(std::min(freeCount, recvRingSize - index), maxCount);
+        for (int i = 0; i < count; ++i)
+        {
+            ppOut[i] = &m_packets[index + i];
+        }
+        return count;
+    }
+
+    void RTSPacketRing::commit(int count)
+    {
+        m_tail.store(m_tail.load(std::memory_order_relaxed) + static_cast<uint32_t>(count), std::memory_order_release);
+    }
+
+    sPacket *RTSPacketRing::front()
+    {
+        auto head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) return nullptr;
+        return &m_packets[head & (recvRingSize - 1)];
+    }
+
+    void RTSPacketRing::pop()
+    {
+        m_head.store(m_head.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
     RTSSocket *natPunchThrough(const std::string& url)
     {
         // Decompose the address
         auto it = url.find_last_of(':');
         if (it == std::string::npos)
         {
-            OutputDebugStringA("natPunchThrough not port in: ");
-            OutputDebugStringA(url.c_str());
-            OutputDebugStringA("\n");
+            OLogE("natPunchThrough not port in: " + url);
             return nullptr;
         }
         auto portStr = url.substr(it + 1);
-        u_short port = 0;
+        uint16_t port = 0;
         try
         {
-            port = static_cast<u_short>(std::stoul(portStr));
+            port = static_cast<uint16_t>(std::stoul(portStr));
         }
         catch (std::exception e)
         {
@@ -53,14 +221,21 @@ namespace onut
         while (tries++ < 10)
         {
             // Setup the address
-            sockaddr_in toAddr = {0};
+            sockaddr_in toAddr;
+            memset(&toAddr, 0, sizeof(toAddr));
             toAddr.sin_family = AF_INET;
             toAddr.sin_port = htons(port);
             auto remoteHost = gethostbyname(addr.c_str());
+            if (!remoteHost)
+            {
+                OLogE("Stun failed to resolve: " + addr);
+                std::this_thread::sleep_for(std::chrono::seconds(1));
+                continue;
+            }
             int i = 0;
             while (remoteHost->h_addr_list[i])
             {
-                toAddr.sin_addr.S_un.S_addr = *(u_long *)remoteHost->h_addr_list[i++];
+                memcpy(&toAddr.sin_addr, remoteHost->h_addr_list[i++], sizeof(toAddr.sin_addr));
 
                 // Create the socket
                 auto pSocket = new RTSSocket();
@@ -70,53 +245,35 @@ namespace onut
                     continue;
                 }
 
-                if (sendto(pSocket->getSock(), NULL, 0, 0, (struct sockaddr *)&toAddr, sizeof(toAddr)) == SOCKET_ERROR)
+                if (sendto(pSocket->getSock(), NULL, 0, 0, (struct sockaddr *)&toAddr, sizeof(toAddr)) < 0)
                 {
-                    OutputDebugStringA("Stun failed sendto: ");
-                    OutputDebugStringA(addr.c_str());
-                    OutputDebugStringA("\n");
+                    OLogE("Stun failed sendto: " + addr);
                     pSocket->release();
                     continue;
                 }
 
-                int recv_len;
-                int curBuf = 0;
                 char pBuf[256];
-
-                static int timeout = 1000;
-                setsockopt(pSocket->getSock(), SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
+                setRecvTimeout(pSocket->getSock(), 1000);
 
                 // Try to receive some data, this is a blocking call (But it's ok, we're in a thread yo)
-                struct sockaddr_in si_other;
-                int slen = sizeof(si_other);
-                if ((recv_len = recvfrom(pSocket->getSock(), pBuf, 256, 0, (struct sockaddr *)&si_other, &slen)) == SOCKET_ERROR)
+                auto recv_len = recv(pSocket->getSock(), pBuf, 256, 0);
+                if (recv_len < 0)
                 {
                     // We might just have killed the thread
-                    OutputDebugStringA("Stun failed recvfrom: ");
-                    OutputDebugStringA(addr.c_str());
-                    OutputDebugStringA("\n");
+                    OLogE("Stun failed recvfrom: " + addr);
                     pSocket->release();
                     continue;
                 }
                 else
                 {
-                    if (recv_len)
-                    {
-                        pBuf[255] = '\0';
-                        if (recv_len < 255) pBuf[recv_len] = '\0';
-                    }
+                    pBuf[255] = '\0';
+                    if (recv_len < 255) pBuf[recv_len] = '\0';
 
-                    OutputDebugStringA("Stun response from ");
-                    OutputDebugStringA(addr.c_str());
-                    OutputDebugStringA(": ");
-                    OutputDebugStringA(pBuf);
-                    OutputDebugStringA("\n");
+                    OLog("Stun response from " + addr + ": " + pBuf);
 
                     pSocket->setIPPort(pBuf);
                     return pSocket;
                 }
-
-                pSocket->release();
             } /* while (remoteHost->h_addr_list[i]) */
 
             std::this_thread::sleep_for(std::chrono::seconds(1));
@@ -130,7 +287,7 @@ namespace onut
         std::vector<std::string> IPs;
 
         char ac[80];
-        if (gethostname(ac, sizeof(ac)) == SOCKET_ERROR)
+        if (gethostname(ac, sizeof(ac)) != 0)
         {
             return std::move(IPs);
         }
@@ -153,23 +310,34 @@ namespace onut
 
     RTSSocket::RTSSocket()
     {
-        if ((m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == INVALID_SOCKET)
+        memset(&m_addr, 0, sizeof(m_addr));
+        if ((m_sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) == InvalidRTSSocket)
         {
             return;
         }
         m_ownSocket = true;
     }
 
-    RTSSocket::RTSSocket(SOCKET parentSocket)
+    RTSSocket::RTSSocket(RTSSocketHandle parentSocket)
     {
+        memset(&m_addr, 0, sizeof(m_addr));
         m_sock = parentSocket;
     }
 
     RTSSocket::~RTSSocket()
     {
-        if (m_sock != INVALID_SOCKET && m_ownSocket)
+        if (m_ownSocket)
+        {
+            closeSock();
+        }
+    }
+
+    void RTSSocket::closeSock()
+    {
+        if (m_sock != InvalidRTSSocket)
         {
-            closesocket(m_sock);
+            if (m_ownSocket) closeSocketHandle(m_sock);
+            m_sock = InvalidRTSSocket;
         }
     }
 
@@ -186,17 +354,11 @@ namespace onut
         auto it = m_ipport.find_last_of(':');
         if (it == std::string::npos)
         {
-            OutputDebugStringA("RTSSocket no port in: ");
-            OutputDebugStringA(ipPort.c_str());
-            OutputDebugStringA("\n");
-            if (m_sock != INVALID_SOCKET)
-            {
-                closesocket(m_sock);
-                m_sock = INVALID_SOCKET;
-            }
+            OLogE("RTSSocket no port in: " + ipPort);
+            closeSock();
             return;
         }
-        auto portStr = ipPort.substr(it + 1);
+        auto portStr = m_ipport.substr(it + 1);
         int port = 0;
         try
         {
@@ -204,20 +366,16 @@ namespace onut
         }
         catch (std::exception e)
         {
-            if (m_sock != INVALID_SOCKET)
-            {
-                closesocket(m_sock);
-                m_sock = INVALID_SOCKET;
-            }
+            closeSock();
             return;
         }
-        auto addr = ipPort.substr(0, it);
+        auto addr = m_ipport.substr(0, it);
 
         // Setup the address
-        m_addr = {0};
+        memset(&m_addr, 0, sizeof(m_addr));
         m_addr.sin_family = AF_INET;
         m_addr.sin_port = htons(port);
-        m_addr.sin_addr.S_un.S_addr = inet_addr(addr.c_str());
+        m_addr.sin_addr.s_addr = inet_addr(addr.c_str());
     }
 
     void RTSSocket::setAddr(const sockaddr_in& addr)
@@ -268,19 +426,18 @@ namespace onut
         m_pSocket->setIPPort(m_ips[m_connectionAttemptId] + ":" + m_port);
 
         // Setup packet
-        static sPacket packet;
-        memset(packet.pBuf, 0, sizeof(packet.header));
-        memcpy(packet.header.signature, signature, 4);
-        packet.header.connection = 1;
-        packet.header.turnId = m_connectionAttemptId;
-        packet.header.playerId = parentPlayerId;
-        packet.size = sizeof(packet.header);
+        sPacketHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.signature, signature, 4);
+        header.connection = 1;
+        header.turnId = m_connectionAttemptId;
+        header.playerId = parentPlayerId;
 
         // Send
         auto toAddr = getSocket()->getAddr();
-        sendto(getSocket()->getSock(), (char *)packet.pBuf, packet.size, 0, (struct sockaddr *)&toAddr, sizeof(toAddr));
+        sendTo(getSocket()->getSock(), &header, sizeof(header), toAddr);
         std::string addrStr = inet_ntoa(toAddr.sin_addr);
-        OutputDebugStringA(("Trying to connect: " + addrStr + "\n").c_str());
+        OLog("Trying to connect: " + addrStr);
 
         // Increment to next IP for next try
         m_connectionAttemptId = (m_connectionAttemptId + 1) % m_ips.size();
@@ -289,114 +446,52 @@ namespace onut
     void RTSPeer::keepAlive()
     {
         // Setup packet
-        static sPacket packet;
-        memset(packet.pBuf, 0, sizeof(packet.header));
-        memcpy(packet.header.signature, signature, 4);
-        packet.header.connection = 1;
-        packet.header.turnId = m_connectionAttemptId;
-        packet.header.playerId = 0;
-        packet.size = sizeof(packet.header);
+        sPacketHeader header;
+        memset(&header, 0, sizeof(header));
+        memcpy(header.signature, signature, 4);
+        header.connection = 1;
+        header.turnId = m_connectionAttemptId;
+        header.playerId = 0;
 
         // Send
-        auto toAddr = getSocket()->getAddr();
-        sendto(getSocket()->getSock(), (char *)packet.pBuf, packet.size, 0, (struct sockaddr *)&toAddr, sizeof(toAddr));
+        sendTo(getSocket()->getSock(), &header, sizeof(header), getSocket()->getAddr());
     }
 
-    void RTSPeer::queueTurn(const sPacket& packet)
+    bool RTSPeer::queueTurn(const sPacket& packet)
     {
-        // make sure it's not already in there
-        for (auto &turn : queuedTurns)
-        {
-            if (turn.header.turnId == packet.header.turnId)
-            {
-                return;
-            }
-        }
+        auto turnBit = 1ull << packet.header.turnId;
+
+        // Make sure we didn't already receive it. It could be a resend because our ack got lost
+        if (m_receivedBits & turnBit) return false;
+        m_receivedBits |= turnBit;
+        m_queuedBits |= turnBit;
 
         // Add it!
-        queuedTurns.push_back(packet);
+        auto& turn = m_turns[packet.header.turnId];
+        memcpy(turn.pBuf, packet.pBuf, packet.size);
+        turn.size = packet.size;
+        return true;
     }
 
-    bool RTSPeer::isReadyForTurn(uint8_t turnId)
+    bool RTSPeer::isReadyForTurn(uint8_t turnId) const
     {
-        for (auto &turn : queuedTurns)
-        {
-            if (turn.header.turnId == turnId)
-            {
-                return true;
-            }
-        }
-        return false;
+        return (m_queuedBits & (1ull << turnId)) ? true : false;
     }
 
-    void RTSPeer::extractTurn(uint8_t turnId, sPacket *pOut)
+    const sPacket *RTSPeer::extractTurn(uint8_t turnId)
     {
-        for (decltype(queuedTurns.size()) i = 0; i < queuedTurns.size(); ++i)
-        {
-            auto &turn = queuedTurns[i];
-            if (turn.header.turnId == turnId)
-            {
-                memcpy(pOut, turn.pBuf, turn.size);
-                pOut->size = turn.size;
-                queuedTurns.erase(queuedTurns.begin() + i);
-                return;
-            }
-        }
-    }
+        m_queuedBits &= ~(1ull << turnId);
 
-    void RTS::extractTurn(uint8_t turnId, sPacket *pOut)
-    {
-        for (decltype(queuedTurns.size()) i = 0; i < queuedTurns.size(); ++i)
-        {
-            auto &turn = queuedTurns[i];
-            if (turn.header.turnId == turnId)
-            {
-                memcpy(pOut, turn.pBuf, turn.size);
-                pOut->size = turn.size;
-                queuedTurns.erase(queuedTurns.begin() + i);
-                return;
-            }
-        }
-    }
+        // Half the ring away is safe to forget, that turnId won't be reused for a while.
+        // This is the ack window.
+        m_receivedBits &= ~(1ull << ((turnId + turnCount / 2) % turnCount));
 
-    void RTSPeer::sendPacket(const sPacket& packet)
-    {
-        sending.push_back(packet);
-        auto toAddr = getSocket()->getAddr();
-        auto ret = sendto(getSocket()->getSock(), (char *)packet.pBuf, packet.size, 0, (struct sockaddr *)&toAddr, sizeof(toAddr));
-        if (ret == SOCKET_ERROR)
-        {
-            auto err = WSAGetLastError();
-            return;
-        }
+        return &m_turns[turnId];
     }
 
-    void RTSPeer::resendPackets()
+    void RTSPeer::ackReceived(uint64_t ackBits)
     {
-        auto toAddr = getSocket()->getAddr();
-        for (auto &packet : sending)
-        {
-            auto ret = sendto(getSocket()->getSock(), (char *)packet.pBuf, packet.size, 0, (struct sockaddr *)&toAddr, sizeof(toAddr));
-            if (ret == SOCKET_ERROR)
-            {
-                auto err = WSAGetLastError();
-                continue;
-            }
-        }
-    }
-
-    void RTSPeer::ackReceived(uint8_t turnId)
-    {
-        for (decltype(sending.size()) i = 0; i < sending.size();)
-        {
-            auto &turn = sending[i];
-            if (turn.header.turnId == turnId)
-            {
-                sending.erase(sending.begin() + i);
-                continue;
-            }
-            ++i;
-        }
+        m_unackedBits &= ~ackBits;
     }
 
     void RTSPeer::connectionAckReceived(const sPacket& packet)
@@ -407,15 +502,15 @@ namespace onut
         std::string ipport = m_ips[packet.header.turnId] + ":" + m_port;
         m_pSocket->setIPPort(ipport);
         m_pSocket->setAddr(packet.from);
-        OutputDebugStringA(("Connected to: " + ipport + "\n").c_str());
+        OLog("Connected to: " + ipport);
     }
 
     RTS::RTS()
     {
-        m_pDispatcher = ODispatcher::create();
-
+#if defined(WIN32)
         // Initialise winsock
         WSAStartup(MAKEWORD(2, 2), &m_wsa);
+#endif
     }
 
     RTS::~RTS()
@@ -426,7 +521,9 @@ namespace onut
             pPeer->release();
         }
         if (m_pMySocket) m_pMySocket->release();
+#if defined(WIN32)
         WSACleanup();
+#endif
     }
 
     void RTS::stopRecvThread()
@@ -442,7 +539,7 @@ namespace onut
 
     bool validatePacket(const sPacket& packet)
     {
-        if (packet.size < sizeof(sPacketHeader)) return false;
+        if (packet.size < static_cast<int>(sizeof(sPacketHeader))) return false;
         if (memcmp(packet.pBuf, signature, 4)) return false;
         return true;
     }
@@ -453,41 +550,27 @@ namespace onut
         m_isRecvThreadValid = true;
         m_pRecvThread = new std::thread([this]
         {
-            int recv_len;
-            int curBuf = 0;
-            char pBuf[packetSize];
-            struct sockaddr_in si_other;
-            int slen = sizeof(si_other);
+            auto sock = m_pMySocket->getSock();
+            setRecvTimeout(sock, 100); // Short burst of 100 ms
 
+            sPacket *pSlots[recvBatchSize];
             while (m_isRecvThreadValid)
             {
-                int timeout = 100; // Short burst of 100 ms
-                setsockopt(m_pMySocket->getSock(), SOL_SOCKET, SO_RCVTIMEO, (char*)&timeout, sizeof(timeout));
-
-                // Try to receive some data, this is a blocking call (But it's ok, we're in a thread yo)
-                if ((recv_len = recvfrom(m_pMySocket->getSock(), pBuf, packetSize, 0, (struct sockaddr *)&si_other, &slen)) == SOCKET_ERROR)
+                auto slotCount = m_recvRing.acquire(pSlots, recvBatchSize);
+                if (!slotCount)
                 {
-                    if (!recv_len)
-                    {
-                        // Socket was closed :|
-                        return;
-                    }
-                    auto err = WSAGetLastError();
-                    if (err == WSAETIMEDOUT) continue;
-                    return; // Shiiiet!
+                    // Main thread is not keeping up
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                    continue;
                 }
 
-                if (recv_len)
+                // Try to receive some data, this is a blocking call (But it's ok, we're in a thread yo)
+                auto received = recvBatch(sock, pSlots, slotCount);
+                if (received < 0)
                 {
-                    sPacket packet(pBuf, recv_len, si_other);
-                    if (validatePacket(packet))
-                    {
-                        m_pDispatcher->dispatch([this, packet]
-                        {
-                            onPacket(packet);
-                        });
-                    }
+                    return; // Shiiiet!
                 }
+                m_recvRing.commit(received);
             }
         });
     }
@@ -504,6 +587,18 @@ namespace onut
         return nullptr;
     }
 
+    void RTS::processPackets()
+    {
+        while (auto pPacket = m_recvRing.front())
+        {
+            if (validatePacket(*pPacket))
+            {
+                onPacket(*pPacket);
+            }
+            m_recvRing.pop();
+        }
+    }
+
     void RTS::onPacket(const sPacket& packet)
     {
         auto pPeer = getPeerFromPacket(packet);
@@ -512,30 +607,34 @@ namespace onut
 
         if (packet.header.ack)
         {
-            // It's a ack. We can safely delete that packet from the sending queue
+            // It's a ack. We can safely stop resending what this peer has
             if (packet.header.connection)
             {
                 pPeer->connectionAckReceived(packet);
             }
-            else
+            else if (packet.size >= static_cast<int>(sizeof(sAckPacket)))
             {
-                pPeer->ackReceived(packet.header.turnId);
+                sAckPacket ackPacket;
+                memcpy(&ackPacket, packet.pBuf, sizeof(ackPacket));
+                pPeer->ackReceived(ackPacket.ackBits);
             }
             return;
         }
 
-        // Send back a confirmation to the peer
-        static sPacket replyPacket;
-        memcpy(&replyPacket, &packet, sizeof(sPacketHeader));
+        if (!packet.header.connection)
+        {
+            // Add to queue
+            pPeer->queueTurn(packet);
+        }
+
+        // Send back a confirmation to the peer, with everything we have so far
+        sAckPacket replyPacket;
+        memcpy(&replyPacket.header, packet.pBuf, sizeof(sPacketHeader));
         replyPacket.header.ack = 1;
         replyPacket.header.playerId = m_myPlayerId;
-        auto toAddr = pPeer->getSocket()->getAddr();
-        sendto(pPeer->getSocket()->getSock(), (char *)replyPacket.pBuf, sizeof(sPacketHeader), 0, (struct sockaddr *)&toAddr, sizeof(toAddr));
-
-        if (packet.header.connection) return;
-
-        // Add to queue
-        pPeer->queueTurn(packet);
+        replyPacket.ackBits = pPeer->m_receivedBits;
+        auto replySize = packet.header.connection ? sizeof(sPacketHeader) : sizeof(sAckPacket);
+        sendTo(pPeer->getSocket()->getSock(), &replyPacket, static_cast<int>(replySize), pPeer->getSocket()->getAddr());
     }
 
     void RTSPeer::setIsConnected(const sockaddr_in& addr)
@@ -545,7 +644,7 @@ namespace onut
             m_pSocket->setAddr(addr);
             m_isConnected = true;
             std::string addrStr = inet_ntoa(addr.sin_addr);
-            OutputDebugStringA(("Connected to: " + addrStr + "\n").c_str());
+            OLog("Connected to: " + addrStr);
         }
     }
 
@@ -612,32 +711,40 @@ namespace onut
         }
     }
 
+    sPacket *RTS::prepareTurn(uint8_t turnId)
+    {
+        auto pTurn = &m_myTurns[turnId];
+        memset(pTurn->pBuf, 0, sizeof(sPacketHeader));
+        memcpy(pTurn->header.signature, signature, 4);
+        pTurn->header.ack = 0;
+        pTurn->header.playerId = m_myPlayerId;
+        pTurn->header.turnId = turnId;
+        pTurn->size = sizeof(sPacketHeader);
+
+        // This slot is being reused. Whatever was not acked from 64 turns ago is irrelevant now
+        for (auto pPeer : m_peers)
+        {
+            pPeer->m_unackedBits &= ~(1ull << turnId);
+        }
+
+        return pTurn;
+    }
+
     void RTS::start()
     {
         m_isStarted = true;
         lastKeepAlive = lastConnectionAttempt = lastResend = lastTurnTime = std::chrono::steady_clock::now();
         m_currentTurn = 0;
         m_frame = 0;
-        memset(&m_commandBuffer, 0, sizeof(m_commandBuffer));
-        m_commandBuffer.size = sizeof(m_commandBuffer.header);
+        m_myQueuedBits = 0;
 
         // Send the turn for the next ones, #1 and #2
-        memset(&m_commandBuffer, 0, sizeof(m_commandBuffer));
-        memcpy(m_commandBuffer.header.signature, signature, 4);
-        m_commandBuffer.header.ack = 0;
-        m_commandBuffer.header.playerId = m_myPlayerId;
-        m_commandBuffer.size = sizeof(sPacketHeader);
-        m_commandBuffer.header.turnId = 1;
-        for (auto pPeer : m_peers)
-        {
-            pPeer->sendPacket(m_commandBuffer);
-        }
-        m_commandBuffer.header.turnId = 2;
-        for (auto pPeer : m_peers)
-        {
-            pPeer->sendPacket(m_commandBuffer);
-        }
-        m_commandBuffer.size = sizeof(m_commandBuffer.header);
+        prepareTurn(1);
+        sendTurn(1);
+        prepareTurn(2);
+        sendTurn(2);
+
+        m_pCommandBuffer = prepareTurn(3);
     }
 
     static const int FPT = 6;
@@ -647,7 +754,7 @@ namespace onut
 
     int RTS::update()
     {
-        m_pDispatcher->processQueue();
+        processPackets();
 
         auto now = std::chrono::steady_clock::now();
 
@@ -689,7 +796,7 @@ namespace onut
                     auto bProcessed = processTurn();
                     if (bProcessed)
                     {
-                        m_currentTurn = (m_currentTurn + 1) % 64;
+                        m_currentTurn = (m_currentTurn + 1) % turnCount;
                         m_realTurn++;
                         m_frame -= FPT;
                     }
@@ -740,12 +847,42 @@ namespace onut
         return true;
     }
 
+    void RTS::sendTurn(uint8_t turnId)
+    {
+        auto pTurn = &m_myTurns[turnId];
+        auto turnBit = 1ull << turnId;
+        m_myQueuedBits |= turnBit;
+        if (!m_pMySocket) return;
+
+        std::vector<sOutgoing> outgoings;
+        outgoings.reserve(m_peers.size());
+        for (auto pPeer : m_peers)
+        {
+            pPeer->m_unackedBits |= turnBit;
+            outgoings.push_back({pTurn, pTurn->size, pPeer->getSocket()->getAddr()});
+        }
+        sendBatch(m_pMySocket->getSock(), outgoings.data(), static_cast<int>(outgoings.size()));
+    }
+
     void RTS::resendPackets()
     {
+        if (!m_pMySocket) return;
+
+        // Only what is still missing, for everyone, in one go
+        std::vector<sOutgoing> outgoings;
         for (auto pPeer : m_peers)
         {
-            pPeer->resendPackets();
+            auto unackedBits = pPeer->m_unackedBits;
+            for (int turnId = 0; unackedBits; ++turnId, unackedBits >>= 1)
+            {
+                if (unackedBits & 1)
+                {
+                    auto pTurn = &m_myTurns[turnId];
+                    outgoings.push_back({pTurn, pTurn->size, pPeer->getSocket()->getAddr()});
+                }
+            }
         }
+        sendBatch(m_pMySocket->getSock(), outgoings.data(), static_cast<int>(outgoings.size()));
     }
 
     bool RTS::arePlayersReadyForTurn(uint8_t turn)
@@ -764,16 +901,17 @@ namespace onut
 
     void RTS::sendCommand(uint8_t cmdId, void *pData)
     {
+        if (!m_pCommandBuffer) return;
         auto pCmd = getCommand(cmdId);
         if (!pCmd) return;
-        if (m_commandBuffer.size + pCmd->size + 1 > packetSize)
+        if (m_pCommandBuffer->size + pCmd->size + 1 > packetSize)
         {
             //TODO: Queue it for next turn I guess
             return;
         }
-        *(m_commandBuffer.pBuf + m_commandBuffer.size) = cmdId;
-        memcpy(m_commandBuffer.pBuf + m_commandBuffer.size + 1, pData, pCmd->size);
-        m_commandBuffer.size += pCmd->size + 1;
+        *(m_pCommandBuffer->pBuf + m_pCommandBuffer->size) = cmdId;
+        memcpy(m_pCommandBuffer->pBuf + m_pCommandBuffer->size + 1, pData, pCmd->size);
+        m_pCommandBuffer->size += pCmd->size + 1;
     }
 
     RTS::sCmd *RTS::getCommand(uint8_t cmdId)
@@ -783,52 +921,46 @@ namespace onut
         return &(it->second);
     }
 
-    void RTS::processCommands(uint8_t *pCommands, int size, RTSPeer *pPeer)
+    void RTS::processCommands(const uint8_t *pCommands, int size, RTSPeer *pPeer)
     {
-        while (size)
+        while (size > 0)
         {
             auto cmdId = *pCommands;
             auto *pCmd = getCommand(cmdId);
             if (!pCmd) return; // That's bad
-            auto pCmdData = pCommands + 1;
+            if (1 + pCmd->size > size) return; // Truncated
+            auto pCmdData = const_cast<uint8_t *>(pCommands + 1);
             if (pCmd->callback)
             {
                 pCmd->callback(pCmdData, pPeer);
             }
             pCommands += 1 + pCmd->size;
-            size += 1 + pCmd->size;
+            size -= 1 + pCmd->size;
         }
     }
 
     bool RTS::processTurn()
     {
-        auto turnId = (m_currentTurn + 1) % 64;
+        uint8_t turnId = (m_currentTurn + 1) % turnCount;
         if (!arePlayersReadyForTurn(turnId)) return false;
 
-        // Process commands for this turn on all peers
-        static sPacket extractedPacket;
+        // Process commands for this turn on all peers, straight from where they were received
+        auto headerSize = static_cast<int>(sizeof(sPacketHeader));
         for (auto pPeer : m_peers)
         {
-            pPeer->extractTurn(turnId, &extractedPacket);
-            auto headerSize = sizeof(sPacketHeader);
-            processCommands(extractedPacket.pBuf + headerSize, extractedPacket.size - headerSize, pPeer);
+            auto pTurn = pPeer->extractTurn(turnId);
+            processCommands(pTurn->pBuf + headerSize, pTurn->size - headerSize, pPeer);
         }
-        extractTurn(turnId, &extractedPacket);
-        auto headerSize = sizeof(sPacketHeader);
-        processCommands(extractedPacket.pBuf + headerSize, extractedPacket.size - headerSize, nullptr);
-
-        // Package commands for next turn (in 2 turns)
-        memcpy(m_commandBuffer.header.signature, signature, 4);
-        m_commandBuffer.header.ack = 0;
-        m_commandBuffer.header.playerId = m_myPlayerId;
-        m_commandBuffer.header.turnId = (turnId + 2) % 64;
-        for (auto pPeer : m_peers)
+        if (m_myQueuedBits & (1ull << turnId))
         {
-            pPeer->sendPacket(m_commandBuffer);
+            m_myQueuedBits &= ~(1ull << turnId);
+            auto pTurn = &m_myTurns[turnId];
+            processCommands(pTurn->pBuf + headerSize, pTurn->size - headerSize, nullptr);
         }
-        queuedTurns.push_back(m_commandBuffer);
-        memset(&m_commandBuffer, 0, sizeof(m_commandBuffer));
-        m_commandBuffer.size = sizeof(m_commandBuffer.header);
+
+        // Send commands for next turn (in 2 turns), and start filling the one after
+        sendTurn((turnId + 2) % turnCount);
+        m_pCommandBuffer = prepareTurn((turnId + 3) % turnCount);
 
         return true;
     }
@@ -0,0 +1,289 @@
+// Onut
+#include <onut/IndexBuffer.h>
+#include <onut/RenderCommandList.h>
+#include <onut/Renderer.h>
+#include <onut/Shader.h>
+#include <onut/Texture.h>
+#include <onut/VertexBuffer.h>
+
+// STL
+#include <cassert>
+#include <cstring>
+
+namespace onut
+{
+    ORenderCommandListRef RenderCommandList::create(int sortKey)
+    {
+        return OMake<RenderCommandList>(sortKey);
+    }
+
+    RenderCommandList::RenderCommandList(int sortKey)
+        : m_sortKey(sortKey)
+    {
+    }
+
+    void RenderCommandList::reset()
+    {
+        m_commands.clear();
+        m_data.clear();
+        m_textures.clear();
+        m_shaders.clear();
+        m_vertexBuffers.clear();
+        m_indexBuffers.clear();
+    }
+
+    void RenderCommandList::add(CommandType type, uint32_t value, uint8_t slot)
+    {
+        m_commands.push_back({type, slot, value, 0, 0});
+    }
+
+    void RenderCommandList::addData(CommandType type, uint32_t value, const void* pData, uint32_t size)
+    {
+        auto offset = static_cast<uint32_t>(m_data.size());
+        m_data.resize(m_data.size() + size);
+        if (size) memcpy(m_data.data() + offset, pData, size);
+        m_commands.push_back({type, 0, value, offset, size});
+    }
+
+    void RenderCommandList::clear(const Color& color)
+    {
+        addValue(CommandType::Clear, color);
+    }
+
+    void RenderCommandList::clearDepth()
+    {
+        add(CommandType::ClearDepth, 0);
+    }
+
+    void RenderCommandList::setTexture(const OTextureRef& pTexture, int slot)
+    {
+        assert(slot >= 0 && slot < RenderStates::MAX_TEXTURES);
+        add(CommandType::Texture, addResource(m_textures, pTexture), static_cast<uint8_t>(slot));
+    }
+
+    void RenderCommandList::setBlendMode(BlendMode blendMode)
+    {
+        add(CommandType::BlendMode, static_cast<uint32_t>(blendMode));
+    }
+
+    void RenderCommandList::setSampleFiltering(sample::Filtering filtering)
+    {
+        add(CommandType::SampleFiltering, static_cast<uint32_t>(filtering));
+    }
+
+    void RenderCommandList::setSampleAddressMode(sample::AddressMode addressMode)
+    {
+        add(CommandType::SampleAddressMode, static_cast<uint32_t>(addressMode));
+    }
+
+    void RenderCommandList::setViewport(const iRect& viewport)
+    {
+        addValue(CommandType::Viewport, viewport);
+    }
+
+    void RenderCommandList::setScissor(const iRect& scissor)
+    {
+        addValue(CommandType::Scissor, scissor);
+    }
+
+    void RenderCommandList::setScissorEnabled(bool enabled)
+    {
+        add(CommandType::ScissorEnabled, enabled ? 1 : 0);
+    }
+
+    void RenderCommandList::setProjection(const Matrix& projection)
+    {
+        addValue(CommandType::Projection, projection);
+    }
+
+    void RenderCommandList::setView(const Matrix& view)
+    {
+        addValue(CommandType::View, view);
+    }
+
+    void RenderCommandList::setWorld(const Matrix& world)
+    {
+        addValue(CommandType::World, world);
+    }
+
+    void RenderCommandList::setDepthEnabled(bool enabled)
+    {
+        add(CommandType::DepthEnabled, enabled ? 1 : 0);
+    }
+
+    void RenderCommandList::setDepthWrite(bool enabled)
+    {
+        add(CommandType::DepthWrite, enabled ? 1 : 0);
+    }
+
+    void RenderCommandList::setBackFaceCull(bool enabled)
+    {
+        add(CommandType::BackFaceCull, enabled ? 1 : 0);
+    }
+
+    void RenderCommandList::setPrimitiveMode(PrimitiveMode primitiveMode)
+    {
+        add(CommandType::PrimitiveMode, static_cast<uint32_t>(primitiveMode));
+    }
+
+    void RenderCommandList::setVertexShader(const OShaderRef& pShader)
+    {
+        add(CommandType::VertexShader, addResource(m_shaders, pShader));
+    }
+
+    void RenderCommandList::setPixelShader(const OShaderRef& pShader)
+    {
+        add(CommandType::PixelShader, addResource(m_shaders, pShader));
+    }
+
+    void RenderCommandList::setVertexBuffer(const OVertexBufferRef& pVertexBuffer)
+    {
+        add(CommandType::VertexBuffer, addResource(m_vertexBuffers, pVertexBuffer));
+    }
+
+    void RenderCommandList::setIndexBuffer(const OIndexBufferRef& pIndexBuffer)
+    {
+        add(CommandType::IndexBuffer, addResource(m_indexBuffers, pIndexBuffer));
+    }
+
+    void RenderCommandList::setRenderTarget(const OTextureRef& pRenderTarget)
+    {
+        add(CommandType::RenderTarget, addResource(m_textures, pRenderTarget));
+    }
+
+    void RenderCommandList::setupFor2D(const Matrix& transform)
+    {
+        addValue(CommandType::SetupFor2D, transform);
+    }
+
+    void RenderCommandList::uploadVertices(const OVertexBufferRef& pVertexBuffer, const void* pVertexData, uint32_t size)
+    {
+        addData(CommandType::UploadVertices, addResource(m_vertexBuffers, pVertexBuffer), pVertexData, size);
+    }
+
+    void RenderCommandList::uploadIndices(const OIndexBufferRef& pIndexBuffer, const void* pIndexData, uint32_t size)
+    {
+        addData(CommandType::UploadIndices, addResource(m_indexBuffers, pIndexBuffer), pIndexData, size);
+    }
+
+    void RenderCommandList::draw(uint32_t vertexCount)
+    {
+        add(CommandType::Draw, vertexCount);
+    }
+
+    void RenderCommandList::drawIndexed(uint32_t indexCount)
+    {
+        add(CommandType::DrawIndexed, indexCount);
+    }
+
+    void RenderCommandList::execute(Renderer& renderer) const
+    {
+        auto& renderStates = renderer.renderStates;
+        auto pData = m_data.data();
+        Matrix matrix;
+        iRect rect;
+        Color color;
+
+        for (const auto& command : m_commands)
+        {
+            switch (command.type)
+            {
+                case CommandType::Clear:
+                    memcpy(&color, pData + command.dataOffset, sizeof(color));
+                    renderer.clear(color);
+                    break;
+                case CommandType::ClearDepth:
+                    renderer.clearDepth();
+                    break;
+                case CommandType::Texture:
+                    renderStates.textures[command.slot] = m_textures[command.value];
+                    break;
+                case CommandType::BlendMode:
+                    renderStates.blendMode = static_cast<BlendMode>(command.value);
+                    break;
+                case CommandType::SampleFiltering:
+                    renderStates.sampleFiltering = static_cast<sample::Filtering>(command.value);
+                    break;
+                case CommandType::SampleAddressMode:
+                    renderStates.sampleAddressMode = static_cast<sample::AddressMode>(command.value);
+                    break;
+                case CommandType::Viewport:
+                    memcpy(&rect, pData + command.dataOffset, sizeof(rect));
+                    renderStates.viewport = rect;
+                    break;
+                case CommandType::Scissor:
+                    memcpy(&rect, pData + command.dataOffset, sizeof(rect));
+                    renderStates.scissor = rect;
+                    break;
+                case CommandType::ScissorEnabled:
+                    renderStates.scissorEnabled = command.value != 0;
+                    break;
+                case CommandType::Projection:
+                    memcpy(&matrix, pData + command.dataOffset, sizeof(matrix));
+                    renderStates.projection = matrix;
+                    break;
+                case CommandType::View:
+                    memcpy(&matrix, pData + command.dataOffset, sizeof(matrix));
+                    renderStates.view = matrix;
+                    break;
+                case CommandType::World:
+                    memcpy(&matrix, pData + command.dataOffset, sizeof(matrix));
+                    renderStates.world = matrix;
+                    break;
+                case CommandType::DepthEnabled:
+                    renderStates.depthEnabled = command.value != 0;
+                    break;
+                case CommandType::DepthWrite:
+                    renderStates.depthWrite = command.value != 0;
+                    break;
+                case CommandType::BackFaceCull:
+                    renderStates.backFaceCull = command.value != 0;
+                    break;
+                case CommandType::PrimitiveMode:
+                    renderStates.primitiveMode = static_cast<PrimitiveMode>(command.value);
+                    break;
+                case CommandType::VertexShader:
+                    renderStates.vertexShader = m_shaders[command.value];
+                    break;
+                case CommandType::PixelShader:
+                    renderStates.pixelShader = m_shaders[command.value];
+                    break;
+                case CommandType::VertexBuffer:
+                    renderStates.vertexBuffer = m_vertexBuffers[command.value];
+                    break;
+                case CommandType::IndexBuffer:
+                    renderStates.indexBuffer = m_indexBuffers[command.value];
+                    break;
+                case CommandType::RenderTarget:
+                    renderStates.renderTarget = m_textures[command.value];
+                    break;
+                case CommandType::SetupFor2D:
+                    memcpy(&matrix, pData + command.dataOffset, sizeof(matrix));
+                    renderer.setupFor2D(matrix);
+                    break;
+                case CommandType::UploadVertices:
+                {
+                    const auto& pVertexBuffer = m_vertexBuffers[command.value];
+                    auto pMapped = pVertexBuffer->map();
+                    memcpy(pMapped, pData + command.dataOffset, command.dataSize);
+                    pVertexBuffer->unmap(command.dataSize);
+                    break;
+                }
+                case CommandType::UploadIndices:
+                {
+                    const auto& pIndexBuffer = m_indexBuffers[command.value];
+                    auto pMapped = pIndexBuffer->map();
+                    memcpy(pMapped, pData + command.dataOffset, command.dataSize);
+                    pIndexBuffer->unmap(command.dataSize);
+                    break;
+                }
+                case CommandType::Draw:
+                    renderer.draw(command.value);
+                    break;
+                case CommandType::DrawIndexed:
+                    renderer.drawIndexed(command.value);
+                    break;
+            }
+        }
+    }
+}
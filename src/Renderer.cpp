@@ -1,5 +1,6 @@
 // Onut
 #include <onut/IndexBuffer.h>
+#include <onut/RenderCommandList.h>
 #include <onut/Renderer.h>
 #include <onut/Settings.h>
 #include <onut/Shader.h>
@@ -8,6 +9,8 @@
 #include <onut/Window.h>
 
 // STL
+#include <algorithm>
+#include <cassert>
 #include <fstream>
 #include <vector>
 
@@ -39,6 +42,7 @@ namespace onut
         vertexShader = nullptr;
         pixelShader = nullptr;
         vertexBuffer = nullptr;
+        instanceBuffer = nullptr;
         indexBuffer = nullptr;
         renderTarget = nullptr;
         clearColor = Color::fromHexRGB(0x1d232d);
@@ -66,6 +70,7 @@ namespace onut
         vertexShader = other.vertexShader;
         pixelShader = other.pixelShader;
         vertexBuffer = other.vertexBuffer;
+        instanceBuffer = other.instanceBuffer;
         indexBuffer = other.indexBuffer;
         clearColor = other.clearColor;
     }
@@ -92,6 +97,7 @@ namespace onut
         vertexShader = other.vertexShader;
         pixelShader = other.pixelShader;
         vertexBuffer = other.vertexBuffer;
+        instanceBuffer = other.instanceBuffer;
         indexBuffer = other.indexBuffer;
         clearColor = other.clearColor;
 
@@ -120,6 +126,7 @@ namespace onut
         vertexShader.reset();
         pixelShader.reset();
         vertexBuffer.reset();
+        instanceBuffer.reset();
         indexBuffer.reset();
         renderTarget.reset();
         clearColor.reset();
@@ -133,10 +140,15 @@ namespace onut
     {
     }
 
+    void Renderer::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount)
+    {
+        assert(false); // No instanced vertex shader on this renderer
+    }
+
     void Renderer::init(const OWindowRef& pWindow)
     {
         loadShaders();
-#if !defined(__unix__)
+#if !defined(__unix__) || defined(ONUT_USE_NULL_RENDERER)
         const float vertices[] = {
             -1, -1,
             -1, 1,
@@ -149,6 +161,40 @@ namespace onut
 #endif
     }
 
+    void Renderer::submit(const ORenderCommandListRef& pCommandList)
+    {
+        if (!pCommandList || pCommandList->isEmpty()) return;
+        std::lock_guard<std::mutex> lock(m_commandListsMutex);
+        m_submittedCommandLists.push_back(pCommandList);
+    }
+
+    void Renderer::executeCommandLists()
+    {
+        // Lists submitted from now on are for the next call
+        {
+            std::lock_guard<std::mutex> lock(m_commandListsMutex);
+            m_executingCommandLists.swap(m_submittedCommandLists);
+        }
+        if (m_executingCommandLists.empty()) return;
+
+        std::stable_sort(m_executingCommandLists.begin(), m_executingCommandLists.end(), [](const ORenderCommandListRef& a, const ORenderCommandListRef& b)
+        {
+            return a->getSortKey() < b->getSortKey();
+        });
+
+        // Copying the states leaves out the render target
+        RenderStates previousStates = renderStates;
+        auto pPreviousRenderTarget = renderStates.renderTarget.get();
+        for (const auto& pCommandList : m_executingCommandLists)
+        {
+            pCommandList->execute(*this);
+        }
+        renderStates = previousStates;
+        renderStates.renderTarget = pPreviousRenderTarget;
+
+        m_executingCommandLists.clear();
+    }
+
     void Renderer::setupFor2D()
     {
         setupFor2D(Matrix::Identity);
@@ -208,7 +254,7 @@ namespace onut
 
     void Renderer::loadShaders()
     {
-#if !defined(__unix__)
+#if !defined(__unix__) || defined(ONUT_USE_NULL_RENDERER)
         // Create 2D shaders
         {
             m_p2DVertexShader = OShader::createFromSource(SHADER_SRC_2D_VS, OVertexShader);
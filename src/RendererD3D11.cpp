@@ -18,6 +18,41 @@
 #include <fstream>
 #include <vector>
 
+// One SpriteBatch::SInstance per sprite, corners from the static quad
+static const char* SHADER_SRC_2D_INSTANCED_VS = ""
+    "cbuffer OViewProjection : register(b0)\n"
+    "{\n"
+    "    matrix oViewProjection;\n"
+    "}\n"
+    "\n"
+    "struct oVSInput\n"
+    "{\n"
+    "    float2 corner : INPUT_ELEMENT0;\n"
+    "    float2 topLeft : INPUT_ELEMENT1;\n"
+    "    float2 right : INPUT_ELEMENT2;\n"
+    "    float2 down : INPUT_ELEMENT3;\n"
+    "    float4 uvs : INPUT_ELEMENT4;\n"
+    "    float4 color : INPUT_ELEMENT5;\n"
+    "};\n"
+    "\n"
+    "struct oVSOutput\n"
+    "{\n"
+    "    float4 position : SV_POSITION;\n"
+    "    float2 texCoord : OUTPUT_ELEMENT0;\n"
+    "    float4 color : OUTPUT_ELEMENT1;\n"
+    "};\n"
+    "\n"
+    "oVSOutput main(oVSInput oInput)\n"
+    "{\n"
+    "    oVSOutput oOutput;\n"
+    "    float2 position = oInput.topLeft + oInput.right * oInput.corner.x + oInput.down * oInput.corner.y;\n"
+    "    oOutput.position = mul(float4(position, 0.0, 1.0), oViewProjection);\n"
+    "    oOutput.texCoord = lerp(oInput.uvs.xy, oInput.uvs.zw, oInput.corner);\n"
+    "    oOutput.color = oInput.color;\n"
+    "    return oOutput;\n"
+    "}\n"
+"";
+
 namespace onut
 {
     ORendererRef Renderer::create(const OWindowRef& pWindow)
@@ -41,6 +76,16 @@ namespace onut
         createUniforms();
 
         Renderer::init(pWindow);
+
+        // Layout of SpriteBatch::SInstance
+        m_p2DInstancedVertexShader = OShader::createFromNativeSource(SHADER_SRC_2D_INSTANCED_VS, OVertexShader, {
+            {2, "INPUT_ELEMENT"}, // Corner
+            {2, "INPUT_ELEMENT", true}, // Top left
+            {2, "INPUT_ELEMENT", true}, // Right
+            {2, "INPUT_ELEMENT", true}, // Down
+            {4, "INPUT_ELEMENT", true}, // UVs
+            {4, "INPUT_ELEMENT", true, OShader::VertexElement::Format::UNorm8} // Color
+        });
     }
 
     RendererD3D11::~RendererD3D11()
@@ -513,6 +558,12 @@ namespace onut
         m_pDeviceContext->DrawIndexed(static_cast<UINT>(indexCount), 0, 0);
     }
 
+    void RendererD3D11::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount)
+    {
+        applyRenderStates();
+        m_pDeviceContext->DrawIndexedInstanced(static_cast<UINT>(indexCount), static_cast<UINT>(instanceCount), 0, 0, 0);
+    }
+
     void RendererD3D11::applyRenderStates()
     {
         // Render target
@@ -787,6 +838,18 @@ namespace onut
             }
             renderStates.vertexBuffer.resetDirty();
         }
+        if (renderStates.instanceBuffer.isDirty())
+        {
+            if (renderStates.instanceBuffer.get())
+            {
+                auto pVertexBufferD3D11 = ODynamicCast<OVertexBufferD3D11>(renderStates.instanceBuffer.get());
+                auto pD3DBuffer = pVertexBufferD3D11->getBuffer();
+                UINT stride = static_cast<UINT>(renderStates.vertexShader.get()->getInstanceSize());
+                UINT offset = 0;
+                m_pDeviceContext->IASetVertexBuffers(1, 1, &pD3DBuffer, &stride, &offset);
+            }
+            renderStates.instanceBuffer.resetDirty();
+        }
         if (renderStates.indexBuffer.isDirty())
         {
             if (renderStates.indexBuffer.get())
@@ -28,6 +28,7 @@ namespace onut
 
         void draw(uint32_t vertexCount) override;
         void drawIndexed(uint32_t indexCount) override;
+        void drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount) override;
 
         Point getTrueResolution() const override;
         void onResize(const Point& newSize);
@@ -20,12 +20,43 @@
 
 // STL
 #include <cassert>
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <vector>
 
 namespace onut
 {
+    // Blend, sampling, raster and depth states packed in one id. The same id needs no calls
+    static const uint32_t STATE_BLEND_MASK = 0x7;
+    static const uint32_t STATE_SAMPLE_MASK = 0x18;
+    static const uint32_t STATE_SCISSOR = 0x20;
+    static const uint32_t STATE_CULL = 0x40;
+    static const uint32_t STATE_DEPTH = 0x80;
+    static const uint32_t STATE_DEPTH_WRITE = 0x100;
+    static const uint32_t STATE_INVALID = 0xFFFFFFFF;
+
+    // Pre-baked blend states, by BlendMode
+    static const struct
+    {
+        bool enabled;
+        GLenum src;
+        GLenum dst;
+    } BLEND_BLOCKS[] = {
+        {false, GL_ONE, GL_ZERO}, // Opaque
+        {true, GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA}, // Alpha
+        {true, GL_SRC_ALPHA, GL_ONE}, // Add
+        {true, GL_ONE, GL_ONE_MINUS_SRC_ALPHA}, // PreMultiplied
+        {true, GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA}, // Multiply
+        {true, GL_ONE, GL_ZERO} // ForceWrite
+    };
+    static_assert(sizeof(BLEND_BLOCKS) / sizeof(BLEND_BLOCKS[0]) == static_cast<size_t>(BlendMode::COUNT), "A blend state per blend mode");
+
+    static int getSamplerIndex(sample::Filtering filtering, sample::AddressMode addressMode, bool hasMipmaps)
+    {
+        return (static_cast<int>(filtering) * static_cast<int>(sample::AddressMode::COUNT) + static_cast<int>(addressMode)) * 2 + (hasMipmaps ? 1 : 0);
+    }
+
     ORendererRef Renderer::create(const OWindowRef& pWindow)
     {
         return OMake<RendererGL>(pWindow);
@@ -33,6 +64,16 @@ namespace onut
 
     RendererGL::RendererGL(const OWindowRef& pWindow)
     {
+        memset(m_samplers, 0, sizeof(m_samplers));
+        memset(m_boundSamplers, 0xFF, sizeof(m_boundSamplers));
+        resetBindings();
+    }
+
+    void RendererGL::resetBindings()
+    {
+        memset(m_boundTextures, 0xFF, sizeof(m_boundTextures));
+        m_activeTexture = -1;
+        m_boundFramebuffer = 0xFFFFFFFF;
     }
 
     void RendererGL::init(const OWindowRef& pWindow)
@@ -47,6 +88,12 @@ namespace onut
 
     RendererGL::~RendererGL()
     {
+#if !defined(__APPLE__)
+        if (m_useSamplerObjects)
+        {
+            glDeleteSamplers(static_cast<GLsizei>(sizeof(m_samplers) / sizeof(m_samplers[0])), m_samplers);
+        }
+#endif
 #if defined(WIN32)
         wglMakeCurrent(NULL, NULL);
         wglDeleteContext(m_hRC);
@@ -135,6 +182,38 @@ namespace onut
         glEnableClientState(GL_VERTEX_ARRAY);
         glEnableClientState(GL_TEXTURE_COORD_ARRAY);
         glEnableClientState(GL_COLOR_ARRAY);
+
+        // Sampler objects, so changing sampling doesn't change the textures
+#if !defined(__APPLE__)
+        m_useSamplerObjects = GLEW_ARB_sampler_objects != GL_FALSE;
+        if (m_useSamplerObjects)
+        {
+            glGenSamplers(static_cast<GLsizei>(sizeof(m_samplers) / sizeof(m_samplers[0])), m_samplers);
+            for (int filtering = 0; filtering < static_cast<int>(sample::Filtering::COUNT); ++filtering)
+            {
+                for (int addressMode = 0; addressMode < static_cast<int>(sample::AddressMode::COUNT); ++addressMode)
+                {
+                    for (int hasMipmaps = 0; hasMipmaps < 2; ++hasMipmaps)
+                    {
+                        auto sampler = m_samplers[getSamplerIndex(static_cast<sample::Filtering>(filtering), static_cast<sample::AddressMode>(addressMode), hasMipmaps != 0)];
+                        if (static_cast<sample::Filtering>(filtering) == sample::Filtering::Nearest)
+                        {
+                            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                        }
+                        else
+                        {
+                            glSamplerParameteri(sampler, GL_TEXTURE_MIN_FILTER, hasMipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                            glSamplerParameteri(sampler, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                        }
+                        auto wrap = (static_cast<sample::AddressMode>(addressMode) == sample::AddressMode::Wrap) ? GL_REPEAT : GL_CLAMP_TO_EDGE;
+                        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_S, wrap);
+                        glSamplerParameteri(sampler, GL_TEXTURE_WRAP_T, wrap);
+                    }
+                }
+            }
+        }
+#endif
     }
 
     void RendererGL::createUniforms()
@@ -158,6 +237,9 @@ namespace onut
 
     void RendererGL::endFrame()
     {
+        m_lastFrameCallStats = m_callStats;
+        m_callStats = CallStats();
+
 #if defined(WIN32)
         SwapBuffers(m_hDC);
 #else
@@ -210,6 +292,7 @@ namespace onut
         }
 
         glDrawArrays(mode, 0, vertexCount);
+        ++m_callStats.drawCalls;
     }
 
     void RendererGL::drawIndexed(uint32_t indexCount)
@@ -239,6 +322,7 @@ namespace onut
         }
 
         glDrawElements(mode, indexCount, GL_UNSIGNED_SHORT, NULL);
+        ++m_callStats.drawCalls;
     }
 
     void RendererGL::applyRenderStates()
@@ -255,156 +339,81 @@ namespace onut
         if (renderStates.renderTarget.isDirty())
         {
             auto& pRenderTarget = renderStates.renderTarget.get();
-            if (pRenderTarget)
+            GLuint frameBuffer = pRenderTarget ? ODynamicCast<OTextureGL>(pRenderTarget)->getFramebuffer() : 0;
+            if (frameBuffer != m_boundFramebuffer)
             {
-                auto pRenderTargetGL = ODynamicCast<OTextureGL>(pRenderTarget);
-                auto frameBuffer = pRenderTargetGL->getFramebuffer();
                 glBindFramebuffer(GL_FRAMEBUFFER, frameBuffer);
+                m_boundFramebuffer = frameBuffer;
+                ++m_callStats.stateCalls;
             }
-            else
-            {
-                glBindFramebuffer(GL_FRAMEBUFFER, 0);
-            }
+            else ++m_callStats.skippedCalls;
+            renderStates.renderTarget.resetDirty();
         }
 
-        // Textures
-        bool isSampleDirty = 
-            renderStates.sampleFiltering.isDirty() ||
-            renderStates.sampleAddressMode.isDirty();
-        for (int i = 0; i < RenderStates::MAX_TEXTURES; ++i)
+        // Blend, sampling, raster and depth
+        auto stateBlockId = getStateBlockId();
+        bool isSampleDirty = m_stateBlockId == STATE_INVALID || ((stateBlockId ^ m_stateBlockId) & STATE_SAMPLE_MASK);
+        if (stateBlockId != m_stateBlockId)
         {
-            auto& pTextureState = renderStates.textures[i];
-            if (pTextureState.isDirty() || isSampleDirty)
-            {
-                auto pTexture = pTextureState.get().get();
-                if (pTexture != nullptr)
-                {
-                    auto pTextureEGLS2 = static_cast<TextureGL*>(pTexture);
-                    glActiveTexture(GL_TEXTURE0 + i);
-                    glBindTexture(GL_TEXTURE_2D, pTextureEGLS2->getHandle());
-                    
-                    if (renderStates.sampleFiltering.get() != pTextureEGLS2->filtering)
-                    {
-                        pTextureEGLS2->filtering = renderStates.sampleFiltering.get();
-                        if (pTextureEGLS2->filtering == sample::Filtering::Nearest)
-                        {
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
-                        }
-                        else if (pTextureEGLS2->filtering == sample::Filtering::Linear)
-                        {
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-                        }
-                    }
-                    if (renderStates.sampleAddressMode.get() != pTextureEGLS2->addressMode)
-                    {
-                        pTextureEGLS2->addressMode = renderStates.sampleAddressMode.get();
-                        if (pTextureEGLS2->addressMode == sample::AddressMode::Wrap)
-                        {
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-                        }
-                        else if (pTextureEGLS2->addressMode == sample::AddressMode::Clamp)
-                        {
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-                            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-                        }
-                    }
-                }
-                pTextureState.resetDirty();
-            }
+            applyStateBlock(stateBlockId);
         }
-        if (isSampleDirty)
+        else
         {
-            renderStates.sampleFiltering.resetDirty();
-            renderStates.sampleAddressMode.resetDirty();
+            if (renderStates.blendMode.isDirty()) ++m_callStats.skippedCalls;
+            if (renderStates.scissorEnabled.isDirty()) ++m_callStats.skippedCalls;
+            if (renderStates.backFaceCull.isDirty()) ++m_callStats.skippedCalls;
+            if (renderStates.depthEnabled.isDirty()) ++m_callStats.skippedCalls;
+            if (renderStates.depthWrite.isDirty()) ++m_callStats.skippedCalls;
         }
-        
-        // Blend
-        if (renderStates.blendMode.isDirty())
-        {
-            switch (renderStates.blendMode.get())
-            {
-                case onut::BlendMode::Opaque:
-                    glDisable(GL_BLEND);
-                    break;
-                case onut::BlendMode::Alpha:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA);
-                    break;
-                case onut::BlendMode::Add:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_SRC_ALPHA, GL_ONE);
-                    break;
-                case onut::BlendMode::PreMultiplied:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-                    break;
-                case onut::BlendMode::Multiply:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_DST_COLOR, GL_ONE_MINUS_SRC_ALPHA);
-                    break;
-                case onut::BlendMode::ForceWrite:
-                    glEnable(GL_BLEND);
-                    glBlendFunc(GL_ONE, GL_ZERO);
-                    break;
-                default: 
-                    break;
-            }
-            renderStates.blendMode.resetDirty();
-        }
-        
+        renderStates.blendMode.resetDirty();
+        renderStates.scissorEnabled.resetDirty();
+        renderStates.backFaceCull.resetDirty();
+        renderStates.depthEnabled.resetDirty();
+        renderStates.depthWrite.resetDirty();
+
+        // Textures
+        applyTextures(isSampleDirty || renderStates.sampleFiltering.isDirty() || renderStates.sampleAddressMode.isDirty());
+        renderStates.sampleFiltering.resetDirty();
+        renderStates.sampleAddressMode.resetDirty();
+
         // Viewport
         if (renderStates.viewport.isDirty())
         {
             auto& rect = renderStates.viewport.get();
-            glViewport(
-                static_cast<GLint>(rect.left), 
-                static_cast<GLint>(getResolution().y) - static_cast<GLint>(rect.top) - static_cast<GLint>(rect.bottom - rect.top), 
-                static_cast<GLsizei>(rect.right - rect.left),
-                static_cast<GLsizei>(rect.bottom - rect.top));
-            renderStates.viewport.resetDirty();
-        }
-        
-        // Scissor enabled
-        if (renderStates.scissorEnabled.isDirty())
-        {
-            if (renderStates.scissorEnabled.get())
-            {
-                glEnable(GL_SCISSOR_TEST);
-            }
-            else
+            GLint viewport[4] = {
+                static_cast<GLint>(rect.left),
+                static_cast<GLint>(getResolution().y) - static_cast<GLint>(rect.top) - static_cast<GLint>(rect.bottom - rect.top),
+                static_cast<GLint>(rect.right - rect.left),
+                static_cast<GLint>(rect.bottom - rect.top)};
+            if (!m_isViewportSet || memcmp(viewport, m_viewport, sizeof(viewport)))
             {
-                glDisable(GL_SCISSOR_TEST);
+                glViewport(viewport[0], viewport[1], static_cast<GLsizei>(viewport[2]), static_cast<GLsizei>(viewport[3]));
+                memcpy(m_viewport, viewport, sizeof(viewport));
+                m_isViewportSet = true;
+                ++m_callStats.stateCalls;
             }
-            renderStates.scissorEnabled.resetDirty();
-        }
-        
-        // Culling
-        if (renderStates.backFaceCull.isDirty())
-        {
-            if (renderStates.backFaceCull.get())
-            {
-                glEnable(GL_CULL_FACE);
-            }
-            else
-            {
-                glDisable(GL_CULL_FACE);
-            }
-            renderStates.backFaceCull.resetDirty();
+            else ++m_callStats.skippedCalls;
+            renderStates.viewport.resetDirty();
         }
-        
+
         // Scissor
         if (renderStates.scissorEnabled.get() &&
             renderStates.scissor.isDirty())
         {
             auto& rect = renderStates.scissor.get();
-            glScissor(
-                static_cast<GLint>(rect.left), 
-                static_cast<GLint>(getResolution().y) - static_cast<GLint>(rect.top) - static_cast<GLint>(rect.bottom - rect.top), 
-                static_cast<GLsizei>(rect.right - rect.left),
-                static_cast<GLsizei>(rect.bottom - rect.top));
+            GLint scissor[4] = {
+                static_cast<GLint>(rect.left),
+                static_cast<GLint>(getResolution().y) - static_cast<GLint>(rect.top) - static_cast<GLint>(rect.bottom - rect.top),
+                static_cast<GLint>(rect.right - rect.left),
+                static_cast<GLint>(rect.bottom - rect.top)};
+            if (!m_isScissorSet || memcmp(scissor, m_scissor, sizeof(scissor)))
+            {
+                glScissor(scissor[0], scissor[1], static_cast<GLsizei>(scissor[2]), static_cast<GLsizei>(scissor[3]));
+                memcpy(m_scissor, scissor, sizeof(scissor));
+                m_isScissorSet = true;
+                ++m_callStats.stateCalls;
+            }
+            else ++m_callStats.skippedCalls;
             renderStates.scissor.resetDirty();
         }
         
@@ -429,34 +438,6 @@ namespace onut
             renderStates.world.resetDirty();
         }
         
-        // Depth write
-        if (renderStates.depthWrite.isDirty())
-        {
-            if (renderStates.depthWrite.get())
-            {
-                glDepthMask(GL_TRUE);
-            }
-            else
-            {
-                glDepthMask(GL_FALSE);
-            }
-            renderStates.depthWrite.resetDirty();
-        }
-        
-        // Depth test
-        if (renderStates.depthEnabled.isDirty())
-        {
-            if (renderStates.depthEnabled.get())
-            {
-                glEnable(GL_DEPTH_TEST);
-            }
-            else
-            {
-                glDisable(GL_DEPTH_TEST);
-            }
-            renderStates.depthEnabled.resetDirty();
-        }
-
         // Shaders
         if (renderStates.vertexShader.isDirty() ||
             renderStates.pixelShader.isDirty())
@@ -548,4 +529,137 @@ namespace onut
             renderStates.indexBuffer.resetDirty();
         }
     }
+
+    uint32_t RendererGL::getStateBlockId() const
+    {
+        return static_cast<uint32_t>(renderStates.blendMode.get()) |
+            (static_cast<uint32_t>(renderStates.sampleFiltering.get()) << 3) |
+            (static_cast<uint32_t>(renderStates.sampleAddressMode.get()) << 4) |
+            (renderStates.scissorEnabled.get() ? STATE_SCISSOR : 0) |
+            (renderStates.backFaceCull.get() ? STATE_CULL : 0) |
+            (renderStates.depthEnabled.get() ? STATE_DEPTH : 0) |
+            (renderStates.depthWrite.get() ? STATE_DEPTH_WRITE : 0);
+    }
+
+    void RendererGL::setCapability(GLenum capability, bool enabled)
+    {
+        if (enabled) glEnable(capability);
+        else glDisable(capability);
+        ++m_callStats.stateCalls;
+    }
+
+    void RendererGL::applyStateBlock(uint32_t stateBlockId)
+    {
+        // Only what changed from the block that's set. Sampling is applied with the textures
+        bool isInvalid = m_stateBlockId == STATE_INVALID;
+        auto changed = stateBlockId ^ m_stateBlockId;
+
+        if (isInvalid || (changed & STATE_BLEND_MASK))
+        {
+            const auto& blend = BLEND_BLOCKS[stateBlockId & STATE_BLEND_MASK];
+            if (isInvalid || blend.enabled != BLEND_BLOCKS[m_stateBlockId & STATE_BLEND_MASK].enabled)
+            {
+                setCapability(GL_BLEND, blend.enabled);
+            }
+            if (blend.enabled && (blend.src != m_blendSrc || blend.dst != m_blendDst))
+            {
+                glBlendFunc(blend.src, blend.dst);
+                m_blendSrc = blend.src;
+                m_blendDst = blend.dst;
+                ++m_callStats.stateCalls;
+            }
+        }
+        if (isInvalid || (changed & STATE_SCISSOR)) setCapability(GL_SCISSOR_TEST, (stateBlockId & STATE_SCISSOR) != 0);
+        if (isInvalid || (changed & STATE_CULL)) setCapability(GL_CULL_FACE, (stateBlockId & STATE_CULL) != 0);
+        if (isInvalid || (changed & STATE_DEPTH)) setCapability(GL_DEPTH_TEST, (stateBlockId & STATE_DEPTH) != 0);
+        if (isInvalid || (changed & STATE_DEPTH_WRITE))
+        {
+            glDepthMask((stateBlockId & STATE_DEPTH_WRITE) ? GL_TRUE : GL_FALSE);
+            ++m_callStats.stateCalls;
+        }
+
+        m_stateBlockId = stateBlockId;
+    }
+
+    void RendererGL::applyTextures(bool isSampleDirty)
+    {
+        for (int i = 0; i < RenderStates::MAX_TEXTURES; ++i)
+        {
+            auto& pTextureState = renderStates.textures[i];
+            bool isTextureDirty = pTextureState.isDirty();
+            if (!isTextureDirty && !isSampleDirty) continue;
+            pTextureState.resetDirty();
+
+            auto pTextureGL = static_cast<TextureGL*>(pTextureState.get().get());
+            if (!pTextureGL) continue;
+
+            // First, it might upload on unit 0
+            auto handle = pTextureGL->getHandle();
+            if (handle != m_boundTextures[i])
+            {
+                if (m_activeTexture != i)
+                {
+                    glActiveTexture(GL_TEXTURE0 + i);
+                    m_activeTexture = i;
+                }
+                glBindTexture(GL_TEXTURE_2D, handle);
+                m_boundTextures[i] = handle;
+                ++m_callStats.textureBinds;
+            }
+            else if (isTextureDirty) ++m_callStats.skippedCalls;
+
+#if !defined(__APPLE__)
+            if (m_useSamplerObjects)
+            {
+                auto sampler = m_samplers[getSamplerIndex(renderStates.sampleFiltering.get(), renderStates.sampleAddressMode.get(), pTextureGL->getLevelCount() > 1)];
+                if (sampler != m_boundSamplers[i])
+                {
+                    glBindSampler(static_cast<GLuint>(i), sampler);
+                    m_boundSamplers[i] = sampler;
+                    ++m_callStats.samplerBinds;
+                }
+                continue;
+            }
+#endif
+
+            // No sampler objects, the texture keeps its sampling
+            if ((renderStates.sampleFiltering.get() != pTextureGL->filtering ||
+                 renderStates.sampleAddressMode.get() != pTextureGL->addressMode) &&
+                m_activeTexture != i)
+            {
+                glActiveTexture(GL_TEXTURE0 + i);
+                m_activeTexture = i;
+            }
+            if (renderStates.sampleFiltering.get() != pTextureGL->filtering)
+            {
+                pTextureGL->filtering = renderStates.sampleFiltering.get();
+                if (pTextureGL->filtering == sample::Filtering::Nearest)
+                {
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+                }
+                else if (pTextureGL->filtering == sample::Filtering::Linear)
+                {
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (pTextureGL->getLevelCount() > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                }
+                ++m_callStats.samplerBinds;
+            }
+            if (renderStates.sampleAddressMode.get() != pTextureGL->addressMode)
+            {
+                pTextureGL->addressMode = renderStates.sampleAddressMode.get();
+                if (pTextureGL->addressMode == sample::AddressMode::Wrap)
+                {
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+                }
+                else if (pTextureGL->addressMode == sample::AddressMode::Clamp)
+                {
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                }
+                ++m_callStats.samplerBinds;
+            }
+        }
+    }
 }
@@ -38,12 +38,21 @@ namespace onut
         void applyRenderStates() override;
         void init(const OWindowRef& pWindow) override;
 
+        // Textures bind on unit 0 and render targets bind their frame buffer
+        // when they are created or uploaded. Forgets what we know is bound
+        void resetBindings();
+
     private:
         void createDevice(const OWindowRef& pWindow);
         void createRenderTarget();
         void createRenderStates();
         void createUniforms();
 
+        uint32_t getStateBlockId() const;
+        void applyStateBlock(uint32_t stateBlockId);
+        void applyTextures(bool isSampleDirty);
+        void setCapability(GLenum capability, bool enabled);
+
         // Device stuff
 #if defined(WIN32)
         HGLRC m_hRC = nullptr;  // Permanent Rendering Context
@@ -57,11 +66,24 @@ namespace onut
         // Render target
         Point m_resolution;
 
-        // Render states
+        // Render states. What's set on the device, to skip calls that wouldn't change it
+        uint32_t m_stateBlockId = 0xFFFFFFFF;
+        GLenum m_blendSrc = 0;
+        GLenum m_blendDst = 0;
+        GLuint m_boundTextures[RenderStates::MAX_TEXTURES];
+        GLuint m_boundSamplers[RenderStates::MAX_TEXTURES];
+        GLint m_activeTexture = -1;
+        GLuint m_boundFramebuffer = 0xFFFFFFFF;
+        GLint m_viewport[4];
+        GLint m_scissor[4];
+        bool m_isViewportSet = false;
+        bool m_isScissorSet = false;
+
+        // Sampler objects, by filtering, address mode and if the texture has mipmaps
+        bool m_useSamplerObjects = false;
+        GLuint m_samplers[static_cast<int>(sample::Filtering::COUNT) * static_cast<int>(sample::AddressMode::COUNT) * 2];
 
         // Constant buffers
-
-     //   OTextureRef m_boundTextures[RenderStates::MAX_TEXTURES];
     };
 };
 
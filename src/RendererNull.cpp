@@ -0,0 +1,147 @@
+// Onut
+#include <onut/RendererNull.h>
+#include <onut/Settings.h>
+#include <onut/Shader.h>
+
+namespace onut
+{
+    ORendererRef Renderer::create(const OWindowRef& pWindow)
+    {
+        return OMake<RendererNull>(pWindow);
+    }
+
+    RendererNull::RendererNull(const OWindowRef& pWindow)
+    {
+    }
+
+    void RendererNull::init(const OWindowRef& pWindow)
+    {
+        if (oSettings) m_resolution = oSettings->getResolution();
+
+        Renderer::init(pWindow);
+
+        // Same layout as the D3D11 one, so instanced uploads count the same
+        m_p2DInstancedVertexShader = OShader::createFromNativeSource("", OVertexShader, {
+            {2, "INPUT_ELEMENT"}, // Corner
+            {2, "INPUT_ELEMENT", true}, // Top left
+            {2, "INPUT_ELEMENT", true}, // Right
+            {2, "INPUT_ELEMENT", true}, // Down
+            {4, "INPUT_ELEMENT", true}, // UVs
+            {4, "INPUT_ELEMENT", true, OShader::VertexElement::Format::UNorm8} // Color
+        });
+    }
+
+    void RendererNull::countUpload(size_t size)
+    {
+        if (!oRenderer) return;
+        static_cast<RendererNull*>(oRenderer.get())->m_counters.uploadedBytes += size;
+    }
+
+    void RendererNull::onResize(const Point& newSize)
+    {
+        m_resolution = newSize;
+    }
+
+    void RendererNull::beginFrame()
+    {
+        // Bind render target
+        renderStates.reset();
+
+        // Set viewport/scissor
+        const auto& res = getResolution();
+        renderStates.viewport = iRect{0, 0, res.x, res.y};
+        renderStates.scissorEnabled = false;
+        renderStates.scissor = renderStates.viewport.get();
+
+        // Reset 2d view
+        set2DCamera(Vector2::Zero);
+    }
+
+    void RendererNull::endFrame()
+    {
+        ++m_counters.frames;
+    }
+
+    Point RendererNull::getTrueResolution() const
+    {
+        return m_resolution;
+    }
+
+    void RendererNull::clear(const Color& color)
+    {
+        renderStates.clearColor = color;
+        applyRenderStates();
+        ++m_counters.clears;
+    }
+
+    void RendererNull::clearDepth()
+    {
+        applyRenderStates();
+        ++m_counters.clears;
+    }
+
+    void RendererNull::draw(uint32_t vertexCount)
+    {
+        applyRenderStates();
+        ++m_counters.drawCalls;
+        m_counters.vertexCount += vertexCount;
+    }
+
+    void RendererNull::drawIndexed(uint32_t indexCount)
+    {
+        applyRenderStates();
+        ++m_counters.drawCalls;
+        m_counters.vertexCount += indexCount;
+    }
+
+    void RendererNull::drawIndexedInstanced(uint32_t indexCount, uint32_t instanceCount)
+    {
+        applyRenderStates();
+        ++m_counters.drawCalls;
+        m_counters.vertexCount += indexCount * instanceCount;
+    }
+
+    template<typename Ttype>
+    bool RendererNull::applyState(RenderState<Ttype>& state)
+    {
+        if (!state.isDirty()) return false;
+        state.resetDirty();
+        ++m_counters.stateChanges;
+        return true;
+    }
+
+    void RendererNull::applyRenderStates()
+    {
+        applyState(renderStates.clearColor);
+        if (applyState(renderStates.renderTarget)) ++m_counters.renderTargetChanges;
+
+        // Textures. Like in OpenGL, sampling is a texture parameter
+        bool isSampleDirty = 
+            renderStates.sampleFiltering.isDirty() ||
+            renderStates.sampleAddressMode.isDirty();
+        for (auto& textureState : renderStates.textures)
+        {
+            if (isSampleDirty && textureState.get()) textureState.forceDirty();
+            if (applyState(textureState)) ++m_counters.textureChanges;
+        }
+        applyState(renderStates.sampleFiltering);
+        applyState(renderStates.sampleAddressMode);
+
+        applyState(renderStates.blendMode);
+        applyState(renderStates.viewport);
+        applyState(renderStates.scissorEnabled);
+        applyState(renderStates.backFaceCull);
+        if (renderStates.scissorEnabled.get()) applyState(renderStates.scissor);
+        applyState(renderStates.projection);
+        applyState(renderStates.view);
+        applyState(renderStates.world);
+        applyState(renderStates.depthWrite);
+        applyState(renderStates.depthEnabled);
+        if (applyState(renderStates.vertexShader)) ++m_counters.shaderChanges;
+        if (applyState(renderStates.pixelShader)) ++m_counters.shaderChanges;
+        applyState(renderStates.vertexBuffer);
+        applyState(renderStates.instanceBuffer);
+        applyState(renderStates.indexBuffer);
+        applyState(renderStates.primitiveMode);
+    }
+}
@@ -0,0 +1,536 @@
+// Onut
+#include <onut/Entity.h>
+#include <onut/Log.h>
+#include <onut/Replication.h>
+
+// STL
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace onut
+{
+    namespace replication
+    {
+        static const uint8_t FIELD_POSITION = 1;
+        static const uint8_t FIELD_ANGLE = 2;
+        static const uint8_t FIELD_SCALE = 4;
+        static const uint8_t FIELD_FLAGS = 8;
+
+        static const uint8_t FLAG_ENABLED = 1;
+        static const uint8_t FLAG_VISIBLE = 2;
+
+        // Baseline age is packed with the field mask. This one means it follows as a varint
+        static const uint32_t AGE_EXTENDED = 15;
+
+        static const size_t MAX_ENTRY_SIZE = 32;
+
+        bool State::operator==(const State& other) const
+        {
+            return x == other.x && y == other.y && angle == other.angle && scale == other.scale && flags == other.flags;
+        }
+
+        static State zeroState()
+        {
+            State state;
+            memset(&state, 0, sizeof(state));
+            return state;
+        }
+
+        static State quantize(Entity& entity)
+        {
+            const auto& transform = entity.getLocalTransform();
+            State state;
+            state.x = static_cast<int32_t>(std::round(transform._41 * POSITION_PRECISION));
+            state.y = static_cast<int32_t>(std::round(transform._42 * POSITION_PRECISION));
+            auto turns = std::atan2(transform._12, transform._11) / (2.0f * OPI);
+            state.angle = static_cast<uint16_t>(static_cast<int32_t>(std::round(turns * 65536.0f)));
+            auto scale = std::sqrt(transform._11 * transform._11 + transform._12 * transform._12);
+            state.scale = static_cast<uint16_t>(std::min(65535.0f, std::round(scale * SCALE_PRECISION)));
+            state.flags = (entity.isEnabled() ? FLAG_ENABLED : 0) | (entity.isVisible() ? FLAG_VISIBLE : 0);
+            return state;
+        }
+
+        static void apply(Entity& entity, const State& state)
+        {
+            auto angle = static_cast<float>(state.angle) / 65536.0f * 2.0f * OPI;
+            entity.setLocalTransform(
+                Matrix::CreateScale(static_cast<float>(state.scale) / SCALE_PRECISION) *
+                Matrix::CreateRotationZ(angle) *
+                Matrix::CreateTranslation(static_cast<float>(state.x) / POSITION_PRECISION, static_cast<float>(state.y) / POSITION_PRECISION, 0.0f));
+            entity.setEnabled((state.flags & FLAG_ENABLED) != 0);
+            entity.setVisible((state.flags & FLAG_VISIBLE) != 0);
+        }
+
+        static size_t varintSize(uint32_t value)
+        {
+            size_t size = 1;
+            while (value >= 0x80)
+            {
+                value >>= 7;
+                ++size;
+            }
+            return size;
+        }
+
+        static uint8_t* writeVarint(uint8_t* pOut, uint32_t value)
+        {
+            while (value >= 0x80)
+            {
+                *pOut++ = static_cast<uint8_t>(value | 0x80);
+                value >>= 7;
+            }
+            *pOut++ = static_cast<uint8_t>(value);
+            return pOut;
+        }
+
+        static uint8_t* writeSigned(uint8_t* pOut, int32_t value)
+        {
+            // Zig zag, small deltas in either direction stay small
+            return writeVarint(pOut, (static_cast<uint32_t>(value) << 1) ^ static_cast<uint32_t>(value >> 31));
+        }
+
+        class Reader
+        {
+        public:
+            Reader(const uint8_t* pData, size_t size) : m_pData(pData), m_pEnd(pData + size) {}
+
+            bool isValid() const { return m_isValid; }
+
+            uint8_t readByte()
+            {
+                if (m_pData >= m_pEnd)
+                {
+                    m_isValid = false;
+                    return 0;
+                }
+                return *m_pData++;
+            }
+
+            uint32_t readVarint()
+            {
+                uint32_t value = 0;
+                for (int shift = 0; shift < 35; shift += 7)
+                {
+                    auto byte = readByte();
+                    value |= static_cast<uint32_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80)) return value;
+                }
+                m_isValid = false;
+                return 0;
+            }
+
+            int32_t readSigned()
+            {
+                auto value = readVarint();
+                return static_cast<int32_t>((value >> 1) ^ (~(value & 1) + 1));
+            }
+
+        private:
+            const uint8_t* m_pData;
+            const uint8_t* m_pEnd;
+            bool m_isValid = true;
+        };
+
+        // Returns the end of the entry. At most MAX_ENTRY_SIZE
+        static uint8_t* writeEntry(uint8_t* pOut, const State& state, const State& baseline, uint32_t age)
+        {
+            uint8_t mask = 0;
+            if (state.x != baseline.x || state.y != baseline.y) mask |= FIELD_POSITION;
+            if (state.angle != baseline.angle) mask |= FIELD_ANGLE;
+            if (state.scale != baseline.scale) mask |= FIELD_SCALE;
+            if (state.flags != baseline.flags) mask |= FIELD_FLAGS;
+
+            *pOut++ = mask | static_cast<uint8_t>(std::min(age, AGE_EXTENDED) << 4);
+            if (age >= AGE_EXTENDED) pOut = writeVarint(pOut, age);
+            if (mask & FIELD_POSITION)
+            {
+                pOut = writeSigned(pOut, state.x - baseline.x);
+                pOut = writeSigned(pOut, state.y - baseline.y);
+            }
+            if (mask & FIELD_ANGLE) pOut = writeSigned(pOut, static_cast<int16_t>(state.angle - baseline.angle));
+            if (mask & FIELD_SCALE) pOut = writeSigned(pOut, static_cast<int16_t>(state.scale - baseline.scale));
+            if (mask & FIELD_FLAGS) *pOut++ = state.flags;
+            return pOut;
+        }
+
+        static State readEntry(Reader& reader, uint8_t mask, const State& baseline)
+        {
+            auto state = baseline;
+            if (mask & FIELD_POSITION)
+            {
+                state.x += reader.readSigned();
+                state.y += reader.readSigned();
+            }
+            if (mask & FIELD_ANGLE) state.angle = static_cast<uint16_t>(state.angle + reader.readSigned());
+            if (mask & FIELD_SCALE) state.scale = static_cast<uint16_t>(state.scale + reader.readSigned());
+            if (mask & FIELD_FLAGS) state.flags = reader.readByte();
+            return state;
+        }
+    }
+
+    //
+    // Server
+    //
+
+    OReplicationServerRef ReplicationServer::create()
+    {
+        return std::shared_ptr<ReplicationServer>(new ReplicationServer());
+    }
+
+    ReplicationServer::ReplicationServer()
+    {
+    }
+
+    ReplicationServer::~ReplicationServer()
+    {
+    }
+
+    replication::NetworkId ReplicationServer::add(const OEntityRef& pEntity, float priority)
+    {
+        auto it = m_slotsByEntity.find(pEntity.get());
+        if (it != m_slotsByEntity.end()) return m_slots[it->second].id;
+
+        uint32_t index;
+        if (m_freeSlots.empty())
+        {
+            index = static_cast<uint32_t>(m_slots.size());
+            m_slots.resize(m_slots.size() + 1);
+        }
+        else
+        {
+            index = m_freeSlots.back();
+            m_freeSlots.pop_back();
+        }
+
+        auto& slot = m_slots[index];
+        slot.pEntity = pEntity;
+        slot.id = m_nextId++;
+        slot.priority = priority;
+        slot.state = replication::quantize(*pEntity);
+        pEntity->m_dirtyReplicatedFields = 0;
+        m_slotsByEntity[pEntity.get()] = index;
+        return slot.id;
+    }
+
+    void ReplicationServer::remove(const OEntityRef& pEntity)
+    {
+        auto it = m_slotsByEntity.find(pEntity.get());
+        if (it == m_slotsByEntity.end()) return;
+        auto index = it->second;
+        m_slotsByEntity.erase(it);
+
+        auto& slot = m_slots[index];
+        for (auto& kv : m_clients)
+        {
+            auto& client = *kv.second;
+            if (index >= client.slots.size()) continue;
+            auto& clientSlot = client.slots[index];
+            if (clientSlot.id == slot.id)
+            {
+                // It was sent, it might exist over there
+                client.removals.push_back({slot.id, 0});
+            }
+            clientSlot = ClientSlot();
+        }
+
+        slot = Slot();
+        m_freeSlots.push_back(index);
+    }
+
+    void ReplicationServer::setPriority(const OEntityRef& pEntity, float priority)
+    {
+        auto it = m_slotsByEntity.find(pEntity.get());
+        if (it == m_slotsByEntity.end()) return;
+        m_slots[it->second].priority = priority;
+    }
+
+    ReplicationServer::ClientId ReplicationServer::addClient()
+    {
+        auto clientId = m_nextClientId++;
+        m_clients[clientId] = std::make_shared<Client>();
+        return clientId;
+    }
+
+    void ReplicationServer::removeClient(ClientId clientId)
+    {
+        m_clients.erase(clientId);
+    }
+
+    void ReplicationServer::update()
+    {
+        ++m_tick;
+        for (auto& slot : m_slots)
+        {
+            if (!slot.pEntity) continue;
+            if (!slot.pEntity->m_dirtyReplicatedFields) continue;
+            slot.state = replication::quantize(*slot.pEntity);
+            slot.pEntity->m_dirtyReplicatedFields = 0;
+        }
+    }
+
+    size_t ReplicationServer::writeSnapshot(ClientId clientId, uint8_t* pOut, size_t maxSize)
+    {
+        auto it = m_clients.find(clientId);
+        if (it == m_clients.end() || maxSize < 16) return 0;
+        auto& client = *it->second;
+        client.slots.resize(m_slots.size());
+
+        auto pHead = pOut;
+        auto pEnd = pOut + maxSize;
+
+        // Tick
+        *pHead++ = static_cast<uint8_t>(m_tick);
+        *pHead++ = static_cast<uint8_t>(m_tick >> 8);
+        *pHead++ = static_cast<uint8_t>(m_tick >> 16);
+        *pHead++ = static_cast<uint8_t>(m_tick >> 24);
+
+        // Removals are repeated until a snapshot containing them is acked
+        size_t removalCount = 0;
+        size_t removalSize = 0;
+        for (auto& removal : client.removals)
+        {
+            auto size = replication::varintSize(removal.id);
+            if (removalSize + size + 16 > maxSize) break;
+            removalSize += size;
+            ++removalCount;
+        }
+        pHead = replication::writeVarint(pHead, static_cast<uint32_t>(removalCount));
+        for (size_t i = 0; i < removalCount; ++i)
+        {
+            auto& removal = client.removals[i];
+            if (!removal.firstSentTick) removal.firstSentTick = m_tick;
+            pHead = replication::writeVarint(pHead, removal.id);
+        }
+
+        // Everything the client doesn't have yet accumulates priority
+        auto& candidates = client.candidates;
+        candidates.clear();
+        for (uint32_t i = 0; i < static_cast<uint32_t>(m_slots.size()); ++i)
+        {
+            auto& slot = m_slots[i];
+            if (!slot.pEntity) continue;
+            auto& clientSlot = client.slots[i];
+            if (clientSlot.id != slot.id)
+            {
+                clientSlot = ClientSlot();
+                clientSlot.id = slot.id;
+            }
+            if (clientSlot.ackedTick && clientSlot.acked == slot.state) continue;
+            clientSlot.priority += slot.priority;
+            candidates.push_back(i);
+        }
+        std::sort(candidates.begin(), candidates.end(), [&client](uint32_t a, uint32_t b)
+        {
+            return client.slots[a].priority > client.slots[b].priority;
+        });
+
+        // Encode the most important first, until the budget is spent. Leave room for the count
+        struct Selected
+        {
+            replication::NetworkId id;
+            uint32_t slot;
+            uint8_t data[replication::MAX_ENTRY_SIZE];
+            uint8_t size;
+        };
+        static thread_local std::vector<Selected> selected;
+        selected.clear();
+        auto remaining = static_cast<size_t>(pEnd - pHead) - replication::varintSize(static_cast<uint32_t>(candidates.size()));
+        auto zero = replication::zeroState();
+        for (auto index : candidates)
+        {
+            auto& slot = m_slots[index];
+            auto& clientSlot = client.slots[index];
+
+            uint32_t age = 0;
+            const replication::State* pBaseline = &zero;
+            if (clientSlot.ackedTick && m_tick - clientSlot.ackedTick < replication::HISTORY_SIZE)
+            {
+                age = m_tick - clientSlot.ackedTick;
+                pBaseline = &clientSlot.acked;
+            }
+
+            Selected entry;
+            entry.id = slot.id;
+            entry.slot = index;
+            entry.size = static_cast<uint8_t>(replication::writeEntry(entry.data, slot.state, *pBaseline, age) - entry.data);
+
+            // Id is written as a delta, the absolute value is the worst case
+            auto size = entry.size + replication::varintSize(slot.id);
+            if (size > remaining)
+            {
+                if (remaining < 8) break;
+                continue;
+            }
+            remaining -= size;
+            selected.push_back(entry);
+            clientSlot.priority = 0.0f;
+        }
+
+        // Write them by id, so ids delta encode to a byte or so
+        std::sort(selected.begin(), selected.end(), [](const Selected& a, const Selected& b)
+        {
+            return a.id < b.id;
+        });
+        auto& sentSnapshot = client.history[m_tick % replication::HISTORY_SIZE];
+        sentSnapshot.tick = m_tick;
+        sentSnapshot.entities.clear();
+        pHead = replication::writeVarint(pHead, static_cast<uint32_t>(selected.size()));
+        replication::NetworkId prevId = 0;
+        for (auto& entry : selected)
+        {
+            pHead = replication::writeVarint(pHead, entry.id - prevId);
+            memcpy(pHead, entry.data, entry.size);
+            pHead += entry.size;
+            prevId = entry.id;
+            sentSnapshot.entities.push_back({entry.slot, entry.id, m_slots[entry.slot].state});
+        }
+
+        return static_cast<size_t>(pHead - pOut);
+    }
+
+    void ReplicationServer::onAck(ClientId clientId, replication::Tick tick)
+    {
+        auto it = m_clients.find(clientId);
+        if (it == m_clients.end() || !tick || tick > m_tick) return;
+        auto& client = *it->second;
+
+        auto& sentSnapshot = client.history[tick % replication::HISTORY_SIZE];
+        if (sentSnapshot.tick != tick) return; // Too old
+        for (auto& sent : sentSnapshot.entities)
+        {
+            if (sent.slot >= client.slots.size()) continue;
+            auto& clientSlot = client.slots[sent.slot];
+            if (clientSlot.id != sent.id || clientSlot.ackedTick >= tick) continue;
+            clientSlot.ackedTick = tick;
+            clientSlot.acked = sent.state;
+        }
+        sentSnapshot.tick = 0;
+        sentSnapshot.entities.clear();
+
+        client.removals.erase(std::remove_if(client.removals.begin(), client.removals.end(), [tick](const Removal& removal)
+        {
+            return removal.firstSentTick && removal.firstSentTick <= tick;
+        }), client.removals.end());
+    }
+
+    //
+    // Client
+    //
+
+    OReplicationClientRef ReplicationClient::create(const CreateCallback& onCreate, const DestroyCallback& onDestroy)
+    {
+        auto pRet = std::shared_ptr<ReplicationClient>(new ReplicationClient());
+        pRet->m_onCreate = onCreate;
+        pRet->m_onDestroy = onDestroy;
+        return pRet;
+    }
+
+    ReplicationClient::ReplicationClient()
+    {
+    }
+
+    ReplicationClient::~ReplicationClient()
+    {
+    }
+
+    OEntityRef ReplicationClient::getEntity(replication::NetworkId id) const
+    {
+        auto it = m_entities.find(id);
+        if (it == m_entities.end()) return nullptr;
+        return it->second->pEntity;
+    }
+
+    replication::Tick ReplicationClient::readSnapshot(const uint8_t* pData, size_t size)
+    {
+        if (size < 4) return 0;
+        replication::Tick tick =
+            static_cast<replication::Tick>(pData[0]) |
+            static_cast<replication::Tick>(pData[1]) << 8 |
+            static_cast<replication::Tick>(pData[2]) << 16 |
+            static_cast<replication::Tick>(pData[3]) << 24;
+
+        // Late snapshots are dropped and never acked, so the server never uses them as baseline
+        if (tick <= m_lastTick) return 0;
+
+        replication::Reader reader(pData + 4, size - 4);
+
+        auto removalCount = reader.readVarint();
+        for (uint32_t i = 0; i < removalCount && reader.isValid(); ++i)
+        {
+            auto id = reader.readVarint();
+            auto it = m_entities.find(id);
+            if (it == m_entities.end()) continue;
+            auto pEntity = it->second->pEntity;
+            m_entities.erase(it);
+            if (m_onDestroy)
+            {
+                m_onDestroy(id, pEntity);
+            }
+            else if (pEntity)
+            {
+                pEntity->destroy();
+            }
+        }
+
+        auto entityCount = reader.readVarint();
+        replication::NetworkId id = 0;
+        bool isComplete = true;
+        auto zero = replication::zeroState();
+        for (uint32_t i = 0; i < entityCount && reader.isValid(); ++i)
+        {
+            id += reader.readVarint();
+            auto header = reader.readByte();
+            uint8_t mask = header & 0x0F;
+            uint32_t age = header >> 4;
+            if (age == replication::AGE_EXTENDED) age = reader.readVarint();
+
+            ReplicaRef pReplica;
+            auto it = m_entities.find(id);
+            if (it != m_entities.end()) pReplica = it->second;
+
+            const replication::State* pBaseline = &zero;
+            if (age)
+            {
+                auto baselineTick = tick - age;
+                auto historyIndex = baselineTick % replication::HISTORY_SIZE;
+                if (!pReplica || pReplica->historyTicks[historyIndex] != baselineTick)
+                {
+                    // Can't decode this one. Still have to read past it
+                    replication::readEntry(reader, mask, zero);
+                    isComplete = false;
+                    continue;
+                }
+                pBaseline = &pReplica->history[historyIndex];
+            }
+            auto state = replication::readEntry(reader, mask, *pBaseline);
+            if (!reader.isValid()) break;
+
+            if (!pReplica)
+            {
+                pReplica = std::make_shared<Replica>();
+                memset(pReplica->historyTicks, 0, sizeof(pReplica->historyTicks));
+                if (m_onCreate) pReplica->pEntity = m_onCreate(id);
+                m_entities[id] = pReplica;
+            }
+            auto historyIndex = tick % replication::HISTORY_SIZE;
+            pReplica->historyTicks[historyIndex] = tick;
+            pReplica->history[historyIndex] = state;
+            pReplica->lastTick = tick;
+            if (pReplica->pEntity) replication::apply(*pReplica->pEntity, state);
+        }
+
+        if (!reader.isValid())
+        {
+            OLogW("Corrupted replication snapshot");
+            return 0;
+        }
+        m_lastTick = tick;
+        if (!isComplete)
+        {
+            OLogW("Replication snapshot referenced a missing baseline");
+            return 0;
+        }
+        return tick;
+    }
+}
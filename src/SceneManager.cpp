@@ -4,16 +4,22 @@
 #include <onut/Component.h>
 #include <onut/Entity.h>
 #include <onut/Font.h>
+#include <onut/IndexBuffer.h>
 #include <onut/SceneManager.h>
 #include <onut/Renderer.h>
+#include <onut/Settings.h>
 #include <onut/SpriteBatch.h>
+#include <onut/SpriteComponent.h>
+#include <onut/Texture.h>
 #include <onut/Timing.h>
 #include <onut/Updater.h>
+#include <onut/VertexBuffer.h>
 
 // Third parties
 #include <Box2D/Box2D.h>
 
 // STL
+#include <algorithm>
 #include <atomic>
 
 OSceneManagerRef oSceneManager;
@@ -165,11 +171,18 @@ namespace onut
                         }
                     }
                     if (!pComponent) m_pComponentRender2Ds->InsertTail(componentAction.pComponent.get());
+                    m_isRender2DDirty = true;
                     break;
                 }
                 case ComponentAction::Action::RemoveRender2D:
+                {
+                    // Its chunk can't be reused as is, even if a new sprite gets its address
+                    auto it = m_staticChunkByComponent.find(componentAction.pComponent.get());
+                    if (it != m_staticChunkByComponent.end()) m_staticChunks[it->second].isDirty = true;
                     componentAction.pComponent->m_render2DLink.Unlink();
+                    m_isRender2DDirty = true;
                     break;
+                }
             }
         }
         m_componentActions.clear();
@@ -285,13 +298,62 @@ namespace onut
 #if defined(_DEBUG)
         m_render2DCount = 0;
 #endif
-        for (auto pComponent = m_pComponentRender2Ds->Head(); pComponent; pComponent = pComponent->m_render2DLink.Next())
+
+        // Visible part of the world, static chunks outside of it are skipped
+        updateRender2DItems();
+        auto invTransform = transform.Invert();
+        auto screen = OScreenf;
+        Vector2 corners[4] = {
+            Vector2::Transform(Vector2::Zero, invTransform),
+            Vector2::Transform(Vector2(screen.x, 0), invTransform),
+            Vector2::Transform(Vector2(0, screen.y), invTransform),
+            Vector2::Transform(screen, invTransform)
+        };
+        Vector2 viewMin = corners[0];
+        Vector2 viewMax = corners[0];
+        for (auto& corner : corners)
         {
+            viewMin = Vector2::Min(viewMin, corner);
+            viewMax = Vector2::Max(viewMax, corner);
+        }
+
+        auto& renderStates = oRenderer->renderStates;
+        for (auto& item : m_render2DItems)
+        {
+            if (item.pComponent)
+            {
 #if defined(_DEBUG)
-            ++m_render2DCount;
+                ++m_render2DCount;
 #endif
-            pComponent->onRender2d();
+                if (!oSpriteBatch->isInBatch()) oSpriteBatch->begin(transform);
+                item.pComponent->onRender2d();
+                continue;
+            }
+
+            auto& chunk = m_staticChunks[item.staticChunk];
+            if (chunk.isDirty) bakeStaticChunk(chunk);
+            if (chunk.boundsMax.x < viewMin.x || chunk.boundsMin.x > viewMax.x ||
+                chunk.boundsMax.y < viewMin.y || chunk.boundsMin.y > viewMax.y) continue;
+#if defined(_DEBUG)
+            m_render2DCount += static_cast<int>(chunk.sprites.size());
+#endif
+
+            // Same states the batch would have used
+            if (oSpriteBatch->isInBatch())
+            {
+                auto filtering = oSpriteBatch->getFiltering();
+                oSpriteBatch->end();
+                oRenderer->setupFor2D(transform);
+                renderStates.blendMode = OBlendPreMultiplied;
+                renderStates.sampleFiltering = filtering;
+                renderStates.primitiveMode = OPrimitiveTriangleList;
+                renderStates.indexBuffer = m_pStaticIndexBuffer;
+            }
+            renderStates.textures[0] = chunk.pTexture;
+            renderStates.vertexBuffer = chunk.pVertexBuffer;
+            oRenderer->drawIndexed(static_cast<uint32_t>(chunk.sprites.size() * 6));
         }
+        if (!oSpriteBatch->isInBatch()) oSpriteBatch->begin(transform);
 
 #if defined(_DEBUG)
         auto pPhysic = getPhysic2DWorld();
@@ -340,6 +402,130 @@ namespace onut
         oSpriteBatch->end();
     }
 
+    void SceneManager::updateRender2DItems()
+    {
+        if (!m_isRender2DDirty) return;
+        m_isRender2DDirty = false;
+
+        // Chunks that end up with the same sprites keep their vertex buffer
+        std::unordered_map<SpriteComponent*, StaticChunk> previousChunks;
+        for (auto& chunk : m_staticChunks)
+        {
+            previousChunks[chunk.sprites.front()] = std::move(chunk);
+        }
+        m_staticChunks.clear();
+        m_staticChunkByComponent.clear();
+        m_render2DItems.clear();
+
+        StaticChunk chunk;
+        for (auto pComponent = m_pComponentRender2Ds->Head(); pComponent; pComponent = pComponent->m_render2DLink.Next())
+        {
+            SpriteComponent* pSprite = nullptr;
+            if (pComponent->m_pEntity->isStatic())
+            {
+                pSprite = dynamic_cast<SpriteComponent*>(pComponent);
+                if (pSprite && !pSprite->getTexture()) pSprite = nullptr;
+            }
+
+            if (!pSprite || 
+                pSprite->getTexture() != chunk.pTexture || 
+                chunk.sprites.size() == static_cast<size_t>(STATIC_CHUNK_SIZE))
+            {
+                addStaticChunk(chunk, previousChunks);
+            }
+
+            if (pSprite)
+            {
+                chunk.pTexture = pSprite->getTexture();
+                chunk.sprites.push_back(pSprite);
+            }
+            else
+            {
+                m_render2DItems.push_back({pComponent, 0});
+            }
+        }
+        addStaticChunk(chunk, previousChunks);
+
+        if (!m_staticChunks.empty() && !m_pStaticIndexBuffer)
+        {
+            std::vector<uint16_t> indices(STATIC_CHUNK_SIZE * 6);
+            for (uint16_t i = 0; i < STATIC_CHUNK_SIZE; ++i)
+            {
+                indices[i * 6 + 0] = i * 4 + 0;
+                indices[i * 6 + 1] = i * 4 + 1;
+                indices[i * 6 + 2] = i * 4 + 2;
+                indices[i * 6 + 3] = i * 4 + 2;
+                indices[i * 6 + 4] = i * 4 + 3;
+                indices[i * 6 + 5] = i * 4 + 0;
+            }
+            m_pStaticIndexBuffer = OIndexBuffer::createStatic(indices.data(), static_cast<uint32_t>(indices.size() * sizeof(uint16_t)));
+        }
+    }
+
+    void SceneManager::addStaticChunk(StaticChunk& chunk, std::unordered_map<SpriteComponent*, StaticChunk>& previousChunks)
+    {
+        if (chunk.sprites.empty()) return;
+
+        auto it = previousChunks.find(chunk.sprites.front());
+        if (it != previousChunks.end() && 
+            it->second.pTexture == chunk.pTexture &&
+            it->second.sprites == chunk.sprites)
+        {
+            chunk = std::move(it->second);
+            previousChunks.erase(it);
+        }
+
+        auto index = m_staticChunks.size();
+        for (auto pSprite : chunk.sprites)
+        {
+            m_staticChunkByComponent[pSprite] = index;
+        }
+        m_render2DItems.push_back({nullptr, index});
+        m_staticChunks.push_back(std::move(chunk));
+        chunk = StaticChunk();
+    }
+
+    void SceneManager::bakeStaticChunk(StaticChunk& chunk)
+    {
+        std::vector<SpriteBatch::SVertexP2T2C4> vertices(chunk.sprites.size() * 4);
+        auto pVertices = vertices.data();
+        for (auto pSprite : chunk.sprites)
+        {
+            pSprite->getVertices(pVertices);
+            pVertices += 4;
+        }
+
+        // Like the sprite batch in retro mode
+        auto snapToPixel = oSettings->getIsRetroMode();
+        chunk.boundsMin = vertices.front().position;
+        chunk.boundsMax = vertices.front().position;
+        for (auto& vertex : vertices)
+        {
+            if (snapToPixel)
+            {
+                vertex.position.x = std::round(vertex.position.x);
+                vertex.position.y = std::round(vertex.position.y);
+            }
+            chunk.boundsMin = Vector2::Min(chunk.boundsMin, vertex.position);
+            chunk.boundsMax = Vector2::Max(chunk.boundsMax, vertex.position);
+        }
+
+        chunk.pVertexBuffer = OVertexBuffer::createStatic(vertices.data(), static_cast<uint32_t>(vertices.size() * sizeof(SpriteBatch::SVertexP2T2C4)));
+        chunk.isDirty = false;
+    }
+
+    void SceneManager::dirtyStatic2D(Entity* pEntity)
+    {
+        for (auto& pComponent : pEntity->m_components)
+        {
+            auto it = m_staticChunkByComponent.find(pComponent.get());
+            if (it != m_staticChunkByComponent.end())
+            {
+                m_staticChunks[it->second].isDirty = true;
+            }
+        }
+    }
+
     void SceneManager::DrawDebugInfo()
     {
 #if defined(_DEBUG)
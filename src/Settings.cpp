@@ -147,6 +147,16 @@ namespace onut
         m_matchMakingPort = matchMakingPort;
     }
 
+    void Settings::setHttpCachePath(const std::string& httpCachePath)
+    {
+        m_httpCachePath = httpCachePath;
+    }
+
+    void Settings::setHttpCacheMaxSize(size_t httpCacheMaxSize)
+    {
+        m_httpCacheMaxSize = httpCacheMaxSize;
+    }
+
     void Settings::setUserSettingDefault(const std::string& key, const std::string& value)
     {
         std::lock_guard<std::mutex> locker(m_mutex);
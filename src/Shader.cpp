@@ -12,21 +12,10 @@ namespace onut
 {
     static std::string readShaderFileContent(const std::string& filename)
     {
-        FILE* pFic;
-#if defined(WIN32)
-        fopen_s(&pFic, filename.c_str(), "rb");
-#else
-        pFic = fopen(filename.c_str(), "rb");
-#endif
-        assert(pFic);
-        fseek(pFic, 0, SEEK_END);
-        auto filesize = static_cast<size_t>(ftell(pFic));
-        fseek(pFic, 0, SEEK_SET);
-        std::string content;
-        content.resize(filesize + 1);
-        fread(const_cast<char*>(content.data()), 1, filesize, pFic);
-        content[filesize] = '\0';
-        fclose(pFic);
+        auto data = readResourceFile(filename, nullptr);
+        assert(!data.isEmpty());
+        std::string content(reinterpret_cast<const char*>(data.getData()), data.getSize());
+        content.push_back('\0');
 
         return std::move(content);
     }
@@ -57,12 +46,19 @@ namespace onut
         return createFromSource(content, in_type, vertexElements);
     }
 
-    Shader::VertexElement::VertexElement(uint32_t in_size, const std::string& in_semanticName)
+    Shader::VertexElement::VertexElement(uint32_t in_size, const std::string& in_semanticName, bool in_isPerInstance, Format in_format)
         : size(in_size)
         , semanticName(in_semanticName)
+        , isPerInstance(in_isPerInstance)
+        , format(in_format)
     {
     }
 
+    uint32_t Shader::VertexElement::getByteSize() const
+    {
+        return (format == Format::UNorm8) ? size : size * 4;
+    }
+
     Shader::Shader()
     {
     }
@@ -81,6 +77,11 @@ namespace onut
         return m_vertexSize;
     }
 
+    uint32_t Shader::getInstanceSize() const
+    {
+        return m_instanceSize;
+    }
+
     Shader::ParsedElements Shader::parseElements(std::string& content, const std::string& type)
     {
         ParsedElements ret;
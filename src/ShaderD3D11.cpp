@@ -353,30 +353,54 @@ namespace onut
                 std::unordered_map<std::string, UINT> semanticIndexes;
                 for (auto& element : vertexElements)
                 {
-                    DXGI_FORMAT format;
-                    switch (element.size)
+                    DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+                    if (element.format == VertexElement::Format::UNorm8)
                     {
-                        case 1:
-                            format = DXGI_FORMAT_R32_FLOAT;
-                            break;
-                        case 2:
-                            format = DXGI_FORMAT_R32G32_FLOAT;
-                            break;
-                        case 3:
-                            format = DXGI_FORMAT_R32G32B32_FLOAT;
-                            break;
-                        case 4:
-                            format = DXGI_FORMAT_R32G32B32A32_FLOAT;
-                            break;
-                        default:
-                            assert(false);
+                        switch (element.size)
+                        {
+                            case 1:
+                                format = DXGI_FORMAT_R8_UNORM;
+                                break;
+                            case 2:
+                                format = DXGI_FORMAT_R8G8_UNORM;
+                                break;
+                            case 4:
+                                format = DXGI_FORMAT_R8G8B8A8_UNORM;
+                                break;
+                            default:
+                                assert(false);
+                        }
                     }
+                    else
+                    {
+                        switch (element.size)
+                        {
+                            case 1:
+                                format = DXGI_FORMAT_R32_FLOAT;
+                                break;
+                            case 2:
+                                format = DXGI_FORMAT_R32G32_FLOAT;
+                                break;
+                            case 3:
+                                format = DXGI_FORMAT_R32G32B32_FLOAT;
+                                break;
+                            case 4:
+                                format = DXGI_FORMAT_R32G32B32A32_FLOAT;
+                                break;
+                            default:
+                                assert(false);
+                        }
+                    }
+
+                    // Instances come from the second vertex buffer slot
+                    if (element.isPerInstance) pRet->m_instanceSize += element.getByteSize();
+                    else pRet->m_vertexSize += element.getByteSize();
 
-                    pRet->m_vertexSize += element.size * 4;
-                    
                     D3D11_INPUT_ELEMENT_DESC inputElement = {
                         element.semanticName.c_str(), semanticIndexes[element.semanticName], 
-                        format, 0, D3D11_APPEND_ALIGNED_ELEMENT, D3D11_INPUT_PER_VERTEX_DATA, 0
+                        format, element.isPerInstance ? 1u : 0u, D3D11_APPEND_ALIGNED_ELEMENT,
+                        element.isPerInstance ? D3D11_INPUT_PER_INSTANCE_DATA : D3D11_INPUT_PER_VERTEX_DATA,
+                        element.isPerInstance ? 1u : 0u
                     };
                     semanticIndexes[element.semanticName]++;
                     layout.push_back(inputElement);
@@ -0,0 +1,111 @@
+// Onut
+#include <onut/RendererNull.h>
+
+// Private
+#include "ShaderNull.h"
+
+namespace onut
+{
+    OShaderRef Shader::createFromBinaryFile(const std::string& filename, Type in_type, const VertexElements& vertexElements)
+    {
+        return nullptr;
+    }
+
+    OShaderRef Shader::createFromBinaryData(const uint8_t* pData, uint32_t size, Type in_type, const VertexElements& vertexElements)
+    {
+        return nullptr;
+    }
+
+    OShaderRef Shader::createFromSource(const std::string& source, Type in_type, const VertexElements& vertexElements)
+    {
+        // Parsed like the other renderers do, for the uniforms
+        auto pRet = std::make_shared<ShaderNull>();
+        pRet->m_type = in_type;
+        if (in_type == OVertexShader)
+        {
+            auto parsed = parseVertexShader(source);
+            for (auto& uniform : parsed.uniforms) pRet->m_uniformNames.push_back(uniform.name);
+            for (auto& input : parsed.inputs) pRet->m_vertexSize += input.size * 4;
+        }
+        else
+        {
+            auto parsed = parsePixelShader(source);
+            for (auto& uniform : parsed.uniforms) pRet->m_uniformNames.push_back(uniform.name);
+        }
+        return pRet;
+    }
+
+    OShaderRef Shader::createFromNativeSource(const std::string& source, Type in_type, const VertexElements& vertexElements)
+    {
+        auto pRet = std::make_shared<ShaderNull>();
+        pRet->m_type = in_type;
+        for (auto& element : vertexElements)
+        {
+            if (element.isPerInstance) pRet->m_instanceSize += element.getByteSize();
+            else pRet->m_vertexSize += element.getByteSize();
+        }
+        return pRet;
+    }
+
+    int ShaderNull::getUniformId(const std::string& varName) const
+    {
+        for (int i = 0; i < (int)m_uniformNames.size(); ++i)
+        {
+            if (m_uniformNames[i] == varName)
+            {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    void ShaderNull::setFloat(int varId, float value)
+    {
+        RendererNull::countUpload(sizeof(value));
+    }
+
+    void ShaderNull::setVector2(int varId, const Vector2& value)
+    {
+        RendererNull::countUpload(sizeof(value));
+    }
+
+    void ShaderNull::setVector3(int varId, const Vector3& value)
+    {
+        RendererNull::countUpload(sizeof(value));
+    }
+
+    void ShaderNull::setVector4(int varId, const Vector4& value)
+    {
+        RendererNull::countUpload(sizeof(value));
+    }
+
+    void ShaderNull::setMatrix(int varId, const Matrix& value)
+    {
+        RendererNull::countUpload(sizeof(value));
+    }
+
+    void ShaderNull::setFloat(const std::string& varName, float value)
+    {
+        setFloat(getUniformId(varName), value);
+    }
+
+    void ShaderNull::setVector2(const std::string& varName, const Vector2& value)
+    {
+        setVector2(getUniformId(varName), value);
+    }
+
+    void ShaderNull::setVector3(const std::string& varName, const Vector3& value)
+    {
+        setVector3(getUniformId(varName), value);
+    }
+
+    void ShaderNull::setVector4(const std::string& varName, const Vector4& value)
+    {
+        setVector4(getUniformId(varName), value);
+    }
+
+    void ShaderNull::setMatrix(const std::string& varName, const Matrix& value)
+    {
+        setMatrix(getUniformId(varName), value);
+    }
+}
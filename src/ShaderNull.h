@@ -0,0 +1,39 @@
+#ifndef SHADERNULL_H_INCLUDED
+#define SHADERNULL_H_INCLUDED
+
+// Onut
+#include <onut/Shader.h>
+
+// STL
+#include <string>
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(ShaderNull)
+
+namespace onut
+{
+    class ShaderNull final : public Shader
+    {
+    public:
+        int getUniformId(const std::string& varName) const override;
+        void setFloat(int varId, float value) override;
+        void setVector2(int varId, const Vector2& value) override;
+        void setVector3(int varId, const Vector3& value) override;
+        void setVector4(int varId, const Vector4& value) override;
+        void setMatrix(int varId, const Matrix& value) override;
+        void setFloat(const std::string& varName, float value) override;
+        void setVector2(const std::string& varName, const Vector2& value) override;
+        void setVector3(const std::string& varName, const Vector3& value) override;
+        void setVector4(const std::string& varName, const Vector4& value) override;
+        void setMatrix(const std::string& varName, const Matrix& value) override;
+
+    private:
+        friend class Shader;
+
+        std::vector<std::string> m_uniformNames;
+    };
+}
+
+#endif
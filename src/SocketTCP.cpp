@@ -10,4 +10,12 @@ namespace onut
     SocketTCP::~SocketTCP()
     {
     }
+
+    void SocketTCP::send(const Buffer *pBuffers, int count)
+    {
+        for (int i = 0; i < count; ++i)
+        {
+            send(pBuffers[i].pData, pBuffers[i].size);
+        }
+    }
 }
@@ -0,0 +1,20 @@
+// Onut
+#include <onut/SocketTCPReactor.h>
+
+namespace onut
+{
+#if !defined(__linux__)
+    OSocketTCPReactorRef SocketTCPReactor::create(uint8_t frameDelimiter)
+    {
+        return nullptr;
+    }
+#endif
+
+    SocketTCPReactor::SocketTCPReactor()
+    {
+    }
+
+    SocketTCPReactor::~SocketTCPReactor()
+    {
+    }
+}
@@ -0,0 +1,512 @@
+// Onut
+#include <onut/Log.h>
+#include <onut/Pool.h>
+
+// Private
+#include "SocketTCP_Unix.h"
+#include "SocketTCPReactorEpoll.h"
+
+// STL
+#include <cstring>
+
+// System
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/uio.h>
+
+namespace onut
+{
+    static const int MAX_EVENTS = 256;
+    static const int MAX_IOV = 64;
+    static const int POOLED_CHUNK_COUNT = 256;
+
+    OSocketTCPReactorRef SocketTCPReactor::create(uint8_t frameDelimiter)
+    {
+        auto pRet = std::shared_ptr<SocketTCPReactorEpoll>(new SocketTCPReactorEpoll(frameDelimiter));
+        if (pRet->m_epoll < 0)
+        {
+            return nullptr;
+        }
+        return pRet;
+    }
+
+    static void setNonBlocking(int fd, bool nonBlocking)
+    {
+        auto flags = fcntl(fd, F_GETFL, 0);
+        if (flags < 0) return;
+        fcntl(fd, F_SETFL, nonBlocking ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK));
+    }
+
+    SocketTCPReactorEpoll::SocketTCPReactorEpoll(uint8_t frameDelimiter)
+        : m_frameDelimiter(frameDelimiter)
+    {
+        m_pChunkPool = OPool::create(sizeof(Chunk), POOLED_CHUNK_COUNT, Pool::FailAction::AllocateOnHeap);
+        m_epoll = epoll_create1(EPOLL_CLOEXEC);
+        if (m_epoll < 0)
+        {
+            OLogE("epoll_create1 failed");
+            return;
+        }
+        m_isRunning = true;
+        m_thread = std::thread(std::bind(&SocketTCPReactorEpoll::run, this));
+    }
+
+    SocketTCPReactorEpoll::~SocketTCPReactorEpoll()
+    {
+        m_isRunning = false;
+        if (m_thread.joinable())
+        {
+            m_thread.join();
+        }
+
+        // Give sockets back to their owners, blocking again
+        std::unordered_map<int, ConnectionRef> connections;
+        m_connectionsMutex.lock();
+        connections.swap(m_connections);
+        m_connectionsMutex.unlock();
+        for (auto& kv : connections)
+        {
+            releaseConnection(*kv.second);
+        }
+
+        if (m_epoll >= 0)
+        {
+            ::close(m_epoll);
+        }
+    }
+
+    SocketTCPReactorEpoll::Chunk *SocketTCPReactorEpoll::allocChunk()
+    {
+        std::lock_guard<std::mutex> lock(m_chunkPoolMutex);
+        return m_pChunkPool->alloc<Chunk>();
+    }
+
+    void SocketTCPReactorEpoll::freeChunk(Chunk *pChunk)
+    {
+        std::lock_guard<std::mutex> lock(m_chunkPoolMutex);
+        m_pChunkPool->dealloc(pChunk);
+    }
+
+    SocketTCPReactorEpoll::Connection::~Connection()
+    {
+        // Last reference is gone, nobody can be reading into it anymore
+        if (pRecvChunk)
+        {
+            pReactor->freeChunk(pRecvChunk);
+        }
+        for (auto pChunk : writeQueue)
+        {
+            pReactor->freeChunk(pChunk);
+        }
+    }
+
+    bool SocketTCPReactorEpoll::addConnection(const ConnectionRef& pConnection)
+    {
+        pConnection->pReactor = this;
+        pConnection->pUnixSocket = dynamic_cast<SocketTCP_Unix *>(pConnection->pSocket.get());
+        if (!pConnection->pUnixSocket || pConnection->pUnixSocket->m_socket < 0)
+        {
+            return false;
+        }
+        pConnection->fd = pConnection->pUnixSocket->m_socket;
+        setNonBlocking(pConnection->fd, true);
+
+        m_connectionsMutex.lock();
+        m_connections[pConnection->fd] = pConnection;
+        pConnection->pUnixSocket->m_pReactor = this;
+        m_connectionsMutex.unlock();
+
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = pConnection->fd;
+        if (epoll_ctl(m_epoll, EPOLL_CTL_ADD, pConnection->fd, &ev) < 0)
+        {
+            OLogE("epoll_ctl add failed");
+            detach(pConnection->fd);
+            return false;
+        }
+        return true;
+    }
+
+    bool SocketTCPReactorEpoll::addListener(const OSocketTCPRef& pListenSocket, const AcceptCallback& onAccept)
+    {
+        auto pConnection = std::make_shared<Connection>();
+        pConnection->pSocket = pListenSocket;
+        pConnection->onAccept = onAccept;
+        return addConnection(pConnection);
+    }
+
+    bool SocketTCPReactorEpoll::add(const OSocketTCPRef& pSocket, const MessageCallback& onMessage, const CloseCallback& onClose)
+    {
+        auto pConnection = std::make_shared<Connection>();
+        pConnection->pSocket = pSocket;
+        pConnection->onMessage = onMessage;
+        pConnection->onClose = onClose;
+        if (!addConnection(pConnection))
+        {
+            return false;
+        }
+        int noDelay = 1;
+        setsockopt(pConnection->fd, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay));
+        return true;
+    }
+
+    void SocketTCPReactorEpoll::remove(const OSocketTCPRef& pSocket)
+    {
+        auto pUnixSocket = dynamic_cast<SocketTCP_Unix *>(pSocket.get());
+        if (pUnixSocket && pUnixSocket->m_pReactor == this)
+        {
+            detach(pUnixSocket->m_socket);
+        }
+    }
+
+    size_t SocketTCPReactorEpoll::getConnectionCount()
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        return m_connections.size();
+    }
+
+    SocketTCPReactorEpoll::ConnectionRef SocketTCPReactorEpoll::getConnection(int fd)
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        auto it = m_connections.find(fd);
+        if (it == m_connections.end()) return nullptr;
+        return it->second;
+    }
+
+    SocketTCPReactorEpoll::ConnectionRef SocketTCPReactorEpoll::unregister(int fd)
+    {
+        std::lock_guard<std::mutex> lock(m_connectionsMutex);
+        auto it = m_connections.find(fd);
+        if (it == m_connections.end()) return nullptr;
+        auto pConnection = it->second;
+        m_connections.erase(it);
+        epoll_ctl(m_epoll, EPOLL_CTL_DEL, fd, nullptr);
+        return pConnection;
+    }
+
+    void SocketTCPReactorEpoll::detach(int fd)
+    {
+        auto pConnection = unregister(fd);
+        if (pConnection)
+        {
+            releaseConnection(*pConnection);
+        }
+    }
+
+    void SocketTCPReactorEpoll::releaseConnection(Connection& connection)
+    {
+        {
+            // Waits for a recv in progress. The owner closes the fd after this
+            std::lock_guard<std::mutex> lock(connection.readMutex);
+            connection.isRemoved = true;
+        }
+        connection.pUnixSocket->m_pReactor = nullptr;
+        if (connection.pUnixSocket->m_socket >= 0)
+        {
+            setNonBlocking(connection.pUnixSocket->m_socket, false);
+        }
+
+        std::lock_guard<std::mutex> lock(connection.writeMutex);
+        for (auto pChunk : connection.writeQueue)
+        {
+            freeChunk(pChunk);
+        }
+        connection.writeQueue.clear();
+    }
+
+    void SocketTCPReactorEpoll::armWrite(Connection& connection, bool arm)
+    {
+        if (connection.isWriteArmed == arm) return;
+        connection.isWriteArmed = arm;
+        epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        uint32_t events = EPOLLIN | EPOLLRDHUP;
+        if (arm) events |= EPOLLOUT;
+        ev.events = events;
+        ev.data.fd = connection.fd;
+        epoll_ctl(m_epoll, EPOLL_CTL_MOD, connection.fd, &ev);
+    }
+
+    void SocketTCPReactorEpoll::send(SocketTCP_Unix *pSocket, const SocketTCP::Buffer *pBuffers, int count)
+    {
+        auto pConnection = getConnection(pSocket->m_socket);
+        if (!pConnection) return;
+        auto& connection = *pConnection;
+        std::lock_guard<std::mutex> lock(connection.writeMutex);
+        if (connection.isRemoved) return;
+
+        // Try to send right away if nothing is waiting. Keeps ordering.
+        size_t sent = 0;
+        if (connection.writeQueue.empty())
+        {
+            iovec iovecs[MAX_IOV];
+            auto iovCount = std::min(count, MAX_IOV);
+            for (int i = 0; i < iovCount; ++i)
+            {
+                iovecs[i].iov_base = const_cast<void *>(pBuffers[i].pData);
+                iovecs[i].iov_len = static_cast<size_t>(pBuffers[i].size);
+            }
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iovecs;
+            msg.msg_iovlen = iovCount;
+            auto ret = ::sendmsg(connection.fd, &msg, MSG_NOSIGNAL | MSG_DONTWAIT);
+            if (ret > 0)
+            {
+                sent = static_cast<size_t>(ret);
+            }
+            else if (ret < 0 && errno != EAGAIN && errno != EWOULDBLOCK)
+            {
+                return; // Reactor will see the error and drop it
+            }
+        }
+
+        // Queue the rest into pooled chunks
+        for (int i = 0; i < count; ++i)
+        {
+            auto pData = static_cast<const uint8_t *>(pBuffers[i].pData);
+            auto size = static_cast<size_t>(pBuffers[i].size);
+            if (sent >= size)
+            {
+                sent -= size;
+                continue;
+            }
+            pData += sent;
+            size -= sent;
+            sent = 0;
+            while (size)
+            {
+                auto pChunk = connection.writeQueue.empty() ? nullptr : connection.writeQueue.back();
+                if (!pChunk || pChunk->end == CHUNK_SIZE)
+                {
+                    pChunk = allocChunk();
+                    connection.writeQueue.push_back(pChunk);
+                }
+                auto toCopy = std::min(size, static_cast<size_t>(CHUNK_SIZE - pChunk->end));
+                memcpy(pChunk->data + pChunk->end, pData, toCopy);
+                pChunk->end += static_cast<int>(toCopy);
+                pData += toCopy;
+                size -= toCopy;
+            }
+        }
+
+        if (!connection.writeQueue.empty())
+        {
+            armWrite(connection, true);
+        }
+    }
+
+    bool SocketTCPReactorEpoll::flush(Connection& connection)
+    {
+        while (!connection.writeQueue.empty())
+        {
+            iovec iovecs[MAX_IOV];
+            int iovCount = 0;
+            for (auto pChunk : connection.writeQueue)
+            {
+                if (iovCount == MAX_IOV) break;
+                iovecs[iovCount].iov_base = pChunk->data + pChunk->begin;
+                iovecs[iovCount].iov_len = static_cast<size_t>(pChunk->end - pChunk->begin);
+                ++iovCount;
+            }
+            auto ret = ::writev(connection.fd, iovecs, iovCount);
+            if (ret < 0)
+            {
+                return errno == EAGAIN || errno == EWOULDBLOCK;
+            }
+            auto sent = static_cast<size_t>(ret);
+            while (sent && !connection.writeQueue.empty())
+            {
+                auto pChunk = connection.writeQueue.front();
+                auto chunkSize = static_cast<size_t>(pChunk->end - pChunk->begin);
+                if (sent < chunkSize)
+                {
+                    pChunk->begin += static_cast<int>(sent);
+                    break;
+                }
+                sent -= chunkSize;
+                connection.writeQueue.pop_front();
+                freeChunk(pChunk);
+            }
+        }
+        return true;
+    }
+
+    void SocketTCPReactorEpoll::drop(const ConnectionRef& pConnection)
+    {
+        auto pDropped = unregister(pConnection->fd);
+        if (!pDropped) return;
+        releaseConnection(*pDropped);
+        if (pDropped->onClose)
+        {
+            pDropped->onClose(pDropped->pSocket);
+        }
+        pDropped->pSocket->close();
+    }
+
+    void SocketTCPReactorEpoll::onAcceptable(const ConnectionRef& pConnection)
+    {
+        while (true)
+        {
+            int clientSocket;
+            {
+                std::lock_guard<std::mutex> lock(pConnection->readMutex);
+                if (pConnection->isRemoved) return;
+                clientSocket = ::accept4(pConnection->fd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+            }
+            if (clientSocket < 0)
+            {
+                if (errno == EINTR || errno == ECONNABORTED) continue;
+                return; // EAGAIN, or out of file descriptors
+            }
+            auto pClientSocket = std::shared_ptr<SocketTCP_Unix>(new SocketTCP_Unix());
+            pClientSocket->m_socket = clientSocket;
+            if (pConnection->onAccept)
+            {
+                pConnection->onAccept(pClientSocket);
+            }
+        }
+    }
+
+    void SocketTCPReactorEpoll::onReadable(const ConnectionRef& pConnection)
+    {
+        auto& connection = *pConnection;
+        while (!connection.isRemoved)
+        {
+            if (!connection.pRecvChunk)
+            {
+                connection.pRecvChunk = allocChunk();
+            }
+            auto pChunk = connection.pRecvChunk;
+
+            // Make room
+            if (pChunk->end == CHUNK_SIZE)
+            {
+                if (pChunk->begin > 0)
+                {
+                    memmove(pChunk->data, pChunk->data + pChunk->begin, pChunk->end - pChunk->begin);
+                    pChunk->end -= pChunk->begin;
+                    pChunk->begin = 0;
+                }
+                else
+                {
+                    // This message is bigger than a chunk
+                    connection.bigMessage.insert(connection.bigMessage.end(), pChunk->data, pChunk->data + pChunk->end);
+                    pChunk->begin = pChunk->end = 0;
+                }
+            }
+
+            auto requested = CHUNK_SIZE - pChunk->end;
+            ssize_t ret;
+            {
+                std::lock_guard<std::mutex> lock(connection.readMutex);
+                if (connection.isRemoved) break;
+                ret = ::recv(connection.fd, pChunk->data + pChunk->end, requested, MSG_DONTWAIT);
+            }
+            if (ret == 0)
+            {
+                drop(pConnection);
+                break;
+            }
+            if (ret < 0)
+            {
+                if (errno == EINTR) continue;
+                if (errno != EAGAIN && errno != EWOULDBLOCK)
+                {
+                    drop(pConnection);
+                }
+                break;
+            }
+
+            // Dispatch complete messages. Straight from the chunk when we can
+            auto pScan = pChunk->data + pChunk->end;
+            auto pEnd = pScan + ret;
+            pChunk->end += static_cast<int>(ret);
+            while (pScan < pEnd && !connection.isRemoved)
+            {
+                auto pDelimiter = static_cast<uint8_t *>(memchr(pScan, m_frameDelimiter, pEnd - pScan));
+                if (!pDelimiter) break;
+                auto pMessage = pChunk->data + pChunk->begin;
+                if (connection.bigMessage.empty())
+                {
+                    if (connection.onMessage)
+                    {
+                        connection.onMessage(connection.pSocket, pMessage, pDelimiter - pMessage);
+                    }
+                }
+                else
+                {
+                    connection.bigMessage.insert(connection.bigMessage.end(), pMessage, pDelimiter);
+                    if (connection.onMessage)
+                    {
+                        connection.onMessage(connection.pSocket, connection.bigMessage.data(), connection.bigMessage.size());
+                    }
+                    connection.bigMessage.clear();
+                }
+                pScan = pDelimiter + 1;
+                pChunk->begin = static_cast<int>(pScan - pChunk->data);
+            }
+
+            // Give the chunk back if nothing is pending
+            if (pChunk->begin == pChunk->end || connection.isRemoved)
+            {
+                freeChunk(pChunk);
+                connection.pRecvChunk = nullptr;
+            }
+
+            if (ret < requested) break; // Drained
+        }
+    }
+
+    void SocketTCPReactorEpoll::onWritable(const ConnectionRef& pConnection)
+    {
+        auto& connection = *pConnection;
+        bool ok;
+        {
+            std::lock_guard<std::mutex> lock(connection.writeMutex);
+            if (connection.isRemoved) return;
+            ok = flush(connection);
+            if (ok && connection.writeQueue.empty())
+            {
+                armWrite(connection, false);
+            }
+        }
+        if (!ok)
+        {
+            drop(pConnection);
+        }
+    }
+
+    void SocketTCPReactorEpoll::run()
+    {
+        epoll_event events[MAX_EVENTS];
+        while (m_isRunning)
+        {
+            auto count = epoll_wait(m_epoll, events, MAX_EVENTS, 100);
+            for (int i = 0; i < count; ++i)
+            {
+                auto& ev = events[i];
+                auto pConnection = getConnection(ev.data.fd);
+                if (!pConnection) continue;
+
+                if (pConnection->onAccept)
+                {
+                    onAcceptable(pConnection);
+                    continue;
+                }
+                if (ev.events & EPOLLOUT)
+                {
+                    onWritable(pConnection);
+                }
+                if (ev.events & (EPOLLIN | EPOLLRDHUP | EPOLLHUP | EPOLLERR))
+                {
+                    onReadable(pConnection);
+                }
+            }
+        }
+    }
+}
@@ -0,0 +1,111 @@
+#ifndef SOCKET_TCP_REACTOR_EPOLL_H_INCLUDED
+#define SOCKET_TCP_REACTOR_EPOLL_H_INCLUDED
+
+// Onut
+#include <onut/SocketTCP.h>
+#include <onut/SocketTCPReactor.h>
+
+// STL
+#include <atomic>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(Pool)
+OForwardDeclare(SocketTCPReactorEpoll)
+
+namespace onut
+{
+    class SocketTCP_Unix;
+
+    class SocketTCPReactorEpoll final : public SocketTCPReactor
+    {
+    public:
+        SocketTCPReactorEpoll(uint8_t frameDelimiter);
+        ~SocketTCPReactorEpoll();
+
+        bool addListener(const OSocketTCPRef& pListenSocket, const AcceptCallback& onAccept) override;
+        bool add(const OSocketTCPRef& pSocket, const MessageCallback& onMessage, const CloseCallback& onClose = nullptr) override;
+        void remove(const OSocketTCPRef& pSocket) override;
+        size_t getConnectionCount() override;
+
+    private:
+        friend class SocketTCP_Unix;
+        friend class SocketTCPReactor;
+
+        static const int CHUNK_SIZE = 16 * 1024;
+
+        // Pooled I/O buffer. Receive chunks are only held by a connection
+        // while it has an incomplete message, so idle connections cost nothing.
+        struct Chunk
+        {
+            Chunk() : begin(0), end(0) {}
+
+            int begin;
+            int end;
+            uint8_t data[CHUNK_SIZE];
+        };
+
+        struct Connection
+        {
+            ~Connection();
+
+            SocketTCPReactorEpoll *pReactor = nullptr;
+            OSocketTCPRef pSocket;
+            SocketTCP_Unix *pUnixSocket = nullptr;
+            int fd = -1;
+            std::atomic<bool> isRemoved{false};
+            AcceptCallback onAccept;
+            MessageCallback onMessage;
+            CloseCallback onClose;
+
+            // Held across the isRemoved check and the recv/accept, so the
+            // owner can't close the fd under the reactor thread
+            std::mutex readMutex;
+
+            // Reactor thread only
+            Chunk *pRecvChunk = nullptr;
+            std::vector<uint8_t> bigMessage; // Messages that don't fit in one chunk
+
+            std::mutex writeMutex;
+            std::deque<Chunk *> writeQueue;
+            bool isWriteArmed = false;
+        };
+        using ConnectionRef = std::shared_ptr<Connection>;
+
+        bool addConnection(const ConnectionRef& pConnection);
+        ConnectionRef getConnection(int fd);
+        void send(SocketTCP_Unix *pSocket, const SocketTCP::Buffer *pBuffers, int count);
+        void detach(int fd);
+        ConnectionRef unregister(int fd);
+        void releaseConnection(Connection& connection);
+
+        void run();
+        void onAcceptable(const ConnectionRef& pConnection);
+        void onReadable(const ConnectionRef& pConnection);
+        void onWritable(const ConnectionRef& pConnection);
+        void drop(const ConnectionRef& pConnection);
+        bool flush(Connection& connection);
+        void armWrite(Connection& connection, bool arm);
+
+        Chunk *allocChunk();
+        void freeChunk(Chunk *pChunk);
+
+        uint8_t m_frameDelimiter;
+        int m_epoll = -1;
+        std::atomic<bool> m_isRunning;
+        std::thread m_thread;
+
+        std::mutex m_connectionsMutex;
+        std::unordered_map<int, ConnectionRef> m_connections;
+
+        std::mutex m_chunkPoolMutex;
+        OPoolRef m_pChunkPool;
+    };
+}
+
+#endif
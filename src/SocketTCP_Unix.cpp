@@ -3,12 +3,28 @@
 
 // Private
 #include "SocketTCP_Unix.h"
+#if defined(__linux__)
+#include "SocketTCPReactorEpoll.h"
+#endif
 
 // STL
 #include <memory.h>
+#include <string>
+
+// System
+#include <netdb.h>
+#include <sys/uio.h>
+
+#if defined(MSG_NOSIGNAL)
+#define ONUT_SEND_FLAGS MSG_NOSIGNAL
+#else
+#define ONUT_SEND_FLAGS 0
+#endif
 
 namespace onut
 {
+    static const size_t RECV_SIZE = 4096;
+
     OSocketTCPRef SocketTCP::listen(int port)
     {
         auto pRet = std::shared_ptr<SocketTCP_Unix>(new SocketTCP_Unix());
@@ -22,7 +38,9 @@ namespace onut
             return nullptr;
         }
 
-        // Bind socket
+        // Bind socket
+        int reuse = 1;
+        setsockopt(pRaw->m_socket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
         struct sockaddr_in serv_addr;
         memset(&serv_addr, 0, sizeof(serv_addr));
         serv_addr.sin_family = AF_INET;
@@ -46,7 +64,49 @@ namespace onut
 
     OSocketTCPRef SocketTCP::connect(const std::string& ip, int port)
     {
-        return nullptr;
+        auto pRet = std::shared_ptr<SocketTCP_Unix>(new SocketTCP_Unix());
+        auto pRaw = pRet.get();
+
+        struct addrinfo hints, *pAddr = nullptr;
+        memset(&hints, 0, sizeof(hints));
+        hints.ai_family = AF_UNSPEC;
+        hints.ai_socktype = SOCK_STREAM;
+        hints.ai_protocol = IPPROTO_TCP;
+
+        if (getaddrinfo(ip.c_str(), std::to_string(port).c_str(), &hints, &pAddr) != 0)
+        {
+            OLog("Failed to resolve: " + ip + ":" + std::to_string(port));
+            return nullptr;
+        }
+
+        // Attempt to connect to an address until one succeeds
+        for (auto ptr = pAddr; ptr != NULL; ptr = ptr->ai_next)
+        {
+            pRaw->m_socket = socket(ptr->ai_family, ptr->ai_socktype, ptr->ai_protocol);
+            if (pRaw->m_socket < 0)
+            {
+                continue;
+            }
+
+            if (::connect(pRaw->m_socket, ptr->ai_addr, ptr->ai_addrlen) < 0)
+            {
+                ::close(pRaw->m_socket);
+                pRaw->m_socket = -1;
+                continue;
+            }
+
+            break;
+        }
+
+        freeaddrinfo(pAddr);
+
+        if (pRaw->m_socket < 0)
+        {
+            OLog("Failed to connect: " + ip + ":" + std::to_string(port));
+            return nullptr;
+        }
+
+        return pRet;
     }
 
     SocketTCP_Unix::SocketTCP_Unix()
@@ -75,45 +135,97 @@ namespace onut
 
     bool SocketTCP_Unix::recv(std::vector<uint8_t> &out)
     {
-        int size = ::recv(m_socket, m_recvbuf, 512, 0);
-        if (size > 0)
+        if (m_socket == -1)
         {
-            auto pos = out.size();
-            out.resize(pos + size);
-            memcpy(out.data() + pos, m_recvbuf, size);
-            return true;
+            return false;
         }
-        else if (size < 0)
+
+        // Receive straight at the end of out
+        auto pos = out.size();
+        out.resize(pos + RECV_SIZE);
+        auto size = ::recv(m_socket, out.data() + pos, RECV_SIZE, 0);
+        out.resize(pos + (size > 0 ? static_cast<size_t>(size) : 0));
+        if (size > 0)
         {
-            ::close(m_socket);
-            m_socket = -1;
-            return false;
+            return true;
         }
-        return true;
+
+        // 0 is a graceful close from the other end
+        ::close(m_socket);
+        m_socket = -1;
+        return false;
     }
 
     void SocketTCP_Unix::send(const void *pData, int size)
+    {
+        Buffer buffer = {pData, size};
+        send(&buffer, 1);
+    }
+
+    void SocketTCP_Unix::send(const Buffer *pBuffers, int count)
     {
         if (m_socket == -1)
         {
             return;
         }
-        int ret = 0;
-        while (ret >= 0 && ret < size)
+#if defined(__linux__)
+        if (m_pReactor)
         {
-            ret = ::send(m_socket, (const char *)pData, size, 0);
-            if (ret >= 0 && ret <= size)
+            m_pReactor->send(this, pBuffers, count);
+            return;
+        }
+#endif
+
+        // Blocking, gather everything in as few calls as possible
+        static const int MAX_IOV = 64;
+        iovec iovecs[MAX_IOV];
+        while (count > 0)
+        {
+            auto iovCount = count < MAX_IOV ? count : MAX_IOV;
+            for (int i = 0; i < iovCount; ++i)
             {
-                size -= ret;
-                pData = (const char *)pData + ret;
-                continue;
+                iovecs[i].iov_base = const_cast<void *>(pBuffers[i].pData);
+                iovecs[i].iov_len = static_cast<size_t>(pBuffers[i].size);
             }
-            return;
+            msghdr msg;
+            memset(&msg, 0, sizeof(msg));
+            msg.msg_iov = iovecs;
+            msg.msg_iovlen = iovCount;
+            while (msg.msg_iovlen > 0)
+            {
+                auto ret = ::sendmsg(m_socket, &msg, ONUT_SEND_FLAGS);
+                if (ret < 0)
+                {
+                    return;
+                }
+
+                // Skip what was sent
+                auto sent = static_cast<size_t>(ret);
+                while (msg.msg_iovlen > 0 && sent >= msg.msg_iov->iov_len)
+                {
+                    sent -= msg.msg_iov->iov_len;
+                    ++msg.msg_iov;
+                    --msg.msg_iovlen;
+                }
+                if (msg.msg_iovlen > 0)
+                {
+                    msg.msg_iov->iov_base = static_cast<uint8_t *>(msg.msg_iov->iov_base) + sent;
+                    msg.msg_iov->iov_len -= sent;
+                }
+            }
+            pBuffers += iovCount;
+            count -= iovCount;
         }
     }
 
     void SocketTCP_Unix::close()
     {
+#if defined(__linux__)
+        if (m_pReactor)
+        {
+            m_pReactor->detach(m_socket); // Returns once the reactor thread is done with the fd
+        }
+#endif
         if (m_socket >= 0)
         {
             ::shutdown(m_socket, SHUT_RDWR);
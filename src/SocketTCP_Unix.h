@@ -19,6 +19,8 @@ OForwardDeclare(SocketTCP_Unix)
 
 namespace onut
 {
+    class SocketTCPReactorEpoll;
+
     class SocketTCP_Unix final : public SocketTCP
     {
     public:
@@ -28,13 +30,15 @@ namespace onut
         OSocketTCPRef accept() override;
         bool recv(std::vector<uint8_t> &out) override;
         void send(const void *pData, int size) override;
+        void send(const Buffer *pBuffers, int count) override;
         void close() override;
 
     private:
         friend class SocketTCP;
+        friend class SocketTCPReactorEpoll;
 
         int m_socket = -1;
-        char m_recvbuf[512];
+        SocketTCPReactorEpoll *m_pReactor = nullptr; // Set while driven by a reactor
     };
 }
 
@@ -19,6 +19,8 @@ namespace onut
     class SocketTCP_Win32 final : public SocketTCP
     {
     public:
+        using SocketTCP::send;
+
         OSocketTCPRef accept() override;
         bool recv(std::vector<uint8_t> &out) override;
         void send(const void *pData, int size) override;
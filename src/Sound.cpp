@@ -9,7 +9,9 @@
 #include <tinyxml2/tinyxml2.h>
 
 // STL
+#include <algorithm>
 #include <cassert>
+#include <cstring>
 
 namespace onut
 {
@@ -42,13 +44,21 @@ namespace onut
             Extensible = 0xFFFE
         };
 
-        FILE* pFic;
-#if defined(WIN32)
-        fopen_s(&pFic, filename.c_str(), "rb");
-#else
-        pFic = fopen(filename.c_str(), "rb");
-#endif
-        assert(pFic);
+        // Parsed in place. From an archive, samples are read straight from the mapping
+        auto fileData = readResourceFile(filename, pContentManager);
+        auto pFic = fileData.getData();
+        auto pEnd = pFic + fileData.getSize();
+        auto read = [&pFic, pEnd](void* pOut, size_t size)
+        {
+            if (pEnd - pFic < static_cast<ptrdiff_t>(size)) return false;
+            memcpy(pOut, pFic, size);
+            pFic += size;
+            return true;
+        };
+        auto skip = [&pFic, pEnd](size_t size)
+        {
+            pFic += std::min<size_t>(size, pEnd - pFic);
+        };
 
         int32_t chunkid = 0;
         int32_t formatsize;
@@ -72,42 +82,42 @@ namespace onut
         bool datachunk = false;
         while (!datachunk)
         {
-            fread(&chunkid, 4, 1, pFic);
+            if (!read(&chunkid, 4)) break;
             switch ((WavChunks)chunkid)
             {
                 case WavChunks::Format:
                 {
-                    fread(&formatsize, 4, 1, pFic);
+                    read(&formatsize, 4);
                     int16_t format16;
-                    fread(&format16, 2, 1, pFic);
+                    read(&format16, 2);
                     format = (WavFormat)format16;
-                    fread(&channels, 2, 1, pFic);
+                    read(&channels, 2);
                     channelcount = (int)channels;
-                    fread(&samplerate, 4, 1, pFic);
-                    fread(&bitspersecond, 4, 1, pFic);
-                    fread(&formatblockalign, 2, 1, pFic);
-                    fread(&bitdepth, 2, 1, pFic);
+                    read(&samplerate, 4);
+                    read(&bitspersecond, 4);
+                    read(&formatblockalign, 2);
+                    read(&bitdepth, 2);
                     if (formatsize == 18)
                     {
                         int16_t extradata;
-                        fread(&extradata, 2, 1, pFic);
-                        fseek(pFic, (long)extradata, SEEK_CUR);
+                        read(&extradata, 2);
+                        skip((size_t)extradata);
                     }
                     break;
                 }
                 case WavChunks::RiffHeader:
                 {
                     headerid = chunkid;
-                    fread(&memsize, 4, 1, pFic);
-                    fread(&riffstyle, 4, 1, pFic);
+                    read(&memsize, 4);
+                    read(&riffstyle, 4);
                     break;
                 }
                 case WavChunks::Data:
                 {
                     datachunk = true;
-                    fread(&datasize, 4, 1, pFic);
-                    uint8_t* pData = new uint8_t[datasize];
-                    fread(pData, bitdepth / 8, datasize / (bitdepth / 8), pFic);
+                    read(&datasize, 4);
+                    if (datasize < 0 || pEnd - pFic < datasize) break;
+                    auto pData = pFic;
 
                     sampleCount = (int)datasize / ((int)bitdepth / 8) / channelcount;
 
@@ -154,22 +164,19 @@ namespace onut
                         default:
                             assert(false);
                     }
-
-                    delete[] pData;
                     break;
                 }
                 default:
                 {
-                    int32_t skipsize;
-                    fread(&skipsize, 4, 1, pFic);
-                    fseek(pFic, (long)skipsize, SEEK_CUR);
+                    int32_t skipsize = 0;
+                    read(&skipsize, 4);
+                    skip((size_t)skipsize);
                     break;
                 }
             }
+            if (pFic == pEnd) break;
         }
 
-        fclose(pFic);
-
         if (!pBuffer) return nullptr;
         auto pRet = createFromData(pBuffer, sampleCount, channelcount, samplerate, pContentManager);
         delete[] pBuffer;
@@ -183,6 +190,7 @@ namespace onut
         auto pRet = std::make_shared<OSound>();
 
         pRet->m_bufferSampleCount = sampleCount;
+        pRet->m_bufferChannelCount = engineChannels;
         pRet->m_pBuffer = new float[sampleCount * engineChannels];
 
         switch (engineChannels)
@@ -435,7 +443,8 @@ namespace onut
         auto pSoundCue = std::make_shared<OSoundCue>();
 
         tinyxml2::XMLDocument doc;
-        doc.LoadFile(filename.c_str());
+        auto data = pContentManager->readFile(filename);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
         assert(!doc.Error());
         auto pXmlCue = doc.FirstChildElement("cue");
         assert(pXmlCue);
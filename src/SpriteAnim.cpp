@@ -12,6 +12,24 @@
 
 namespace onut
 {
+    ContentManager::AsyncSteps AsyncLoader<SpriteAnim>::prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+    {
+        ContentManager::AsyncSteps steps;
+        tinyxml2::XMLDocument doc;
+        auto data = readResourceFile(filename, pContentManager);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
+        auto pXMLSheet = doc.FirstChildElement("sheet");
+        if (pXMLSheet && pXMLSheet->Attribute("texture"))
+        {
+            steps.dependencies.push_back(pContentManager->loadAsync<OTexture>(pXMLSheet->Attribute("texture"), priority));
+        }
+        steps.finish = [filename](const OContentManagerRef& pContentManager) -> OResourceRef
+        {
+            return SpriteAnim::createFromFile(filename, pContentManager);
+        };
+        return steps;
+    }
+
     OSpriteAnimRef SpriteAnim::createFromFile(const std::string& filename, const OContentManagerRef& in_pContentManager)
     {
         auto pContentManager = in_pContentManager;
@@ -26,7 +44,8 @@ namespace onut
         }
 
         tinyxml2::XMLDocument doc;
-        doc.LoadFile(pRet->m_filename.c_str());
+        auto data = readResourceFile(pRet->m_filename, pContentManager);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
         auto pXMLSheet = doc.FirstChildElement("sheet");
         assert(pXMLSheet);
         std::string textureName = pXMLSheet->Attribute("texture");
@@ -1,6 +1,7 @@
 // Onut
 #include <onut/IndexBuffer.h>
 #include <onut/PrimitiveMode.h>
+#include <onut/RenderCommandList.h>
 #include <onut/Renderer.h>
 #include <onut/Settings.h>
 #include <onut/SpriteBatch.h>
@@ -10,6 +11,7 @@
 // STL
 #include <cassert>
 #include <cmath>
+#include <cstring>
 
 OSpriteBatchRef oSpriteBatch;
 
@@ -42,6 +44,15 @@ namespace onut
         }
         m_pIndexBuffer = OIndexBuffer::createStatic(indices, sizeof(indices));
 
+        // Instanced path. The first 6 indices draw the quad
+        if (oRenderer->get2DInstancedVertexShader())
+        {
+            const Vector2 corners[4] = {{0, 0}, {0, 1}, {1, 1}, {1, 0}};
+            m_pQuadVertexBuffer = OVertexBuffer::createStatic(corners, sizeof(corners));
+            m_pInstanceBuffer = OVertexBuffer::createDynamic(sizeof(SInstance) * MAX_SPRITE_COUNT);
+            m_instances.resize(MAX_SPRITE_COUNT);
+        }
+
         m_snapToPixel = oSettings->getIsRetroMode();
     }
 
@@ -54,6 +65,14 @@ namespace onut
         begin(Matrix::Identity, blendMode);
     }
 
+    void SpriteBatch::begin(const ORenderCommandListRef& pCommandList, const Matrix& transform, BlendMode blendMode)
+    {
+        if (m_isDrawing) return;
+
+        m_pCommandList = pCommandList;
+        begin(transform, blendMode);
+    }
+
     void SpriteBatch::begin(const Matrix& in_transform, BlendMode blendMode)
     {
         if (m_isDrawing) return;
@@ -65,31 +84,46 @@ namespace onut
             transform._42 = std::round(transform._42);
         }
 
-        oRenderer->setupFor2D(transform);
+        if (m_pCommandList) m_pCommandList->setupFor2D(transform);
+        else oRenderer->setupFor2D(transform);
 
         m_currentTransform = transform;
         m_curBlendMode = blendMode;
         m_pTexture = nullptr;
         m_isDrawing = true;
 
-        m_pMappedVertexBuffer = reinterpret_cast<SVertexP2T2C4*>(m_pVertexBuffer->map());
+        if (m_pCommandList)
+        {
+            m_recordedVertices.resize(MAX_SPRITE_COUNT * 4);
+            m_pMappedVertexBuffer = m_recordedVertices.data();
+        }
+        else
+        {
+            m_pMappedVertexBuffer = reinterpret_cast<SVertexP2T2C4*>(m_pVertexBuffer->map());
+        }
+
+        // Snapping is done per vertex, and recorded lists replay on any renderer
+        m_isInstancing = m_pInstanceBuffer && !m_pCommandList && !m_snapToPixel;
+        if (m_isInstancing) m_pBatchVertexShader = oRenderer->renderStates.vertexShader.get();
     }
 
     void SpriteBatch::changeBlendMode(BlendMode blendMode)
     {
         if (!isInBatch()) return;
         if (m_curBlendMode == blendMode) return;
+        auto pCommandList = m_pCommandList; // end() lets go of it
         end();
-        begin(m_currentTransform, blendMode);
+        begin(pCommandList, m_currentTransform, blendMode);
     }
 
     void SpriteBatch::changeFiltering(sample::Filtering filtering)
     {
         if (m_curFiltering == filtering) return;
         auto bManageBatch = isInBatch();
+        auto pCommandList = m_pCommandList; // end() lets go of it
         if (bManageBatch) end();
         m_curFiltering = filtering;
-        if (bManageBatch) begin(m_currentTransform, m_curBlendMode);
+        if (bManageBatch) begin(pCommandList, m_currentTransform, m_curBlendMode);
     }
 
     void SpriteBatch::drawRectWithColors(const OTextureRef& pTexture, const Rect& rect, const std::vector<Color>& colors)
@@ -99,7 +133,7 @@ namespace onut
 
         changeTexture(pTexture);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = {rect.x, rect.y};
         pVerts[0].texCoord = {0, 0};
         pVerts[0].color = colors[0];
@@ -145,7 +179,9 @@ namespace onut
 
         changeTexture(pTexture);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (addInstance({rect.x, rect.y}, {rect.z, 0}, {0, rect.w}, {0, 0, 1, 1}, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = {rect.x, rect.y};
         pVerts[0].texCoord = {0, 0};
         pVerts[0].color = color;
@@ -170,6 +206,33 @@ namespace onut
         }
     }
 
+    void SpriteBatch::drawQuads(const OTextureRef& pTexture, const SVertexP2T2C4* pVertices, size_t quadCount, const Vector2& offset)
+    {
+        assert(m_isDrawing); // Should call begin() before calling draw()
+
+        while (quadCount)
+        {
+            changeTexture(pTexture);
+
+            auto pVerts = nextVertices();
+            auto count = std::min<size_t>(quadCount, MAX_SPRITE_COUNT - m_spriteCount);
+            for (size_t i = 0; i < count * 4; ++i)
+            {
+                pVerts[i].position = pVertices[i].position + offset;
+                pVerts[i].texCoord = pVertices[i].texCoord;
+                pVerts[i].color = pVertices[i].color;
+            }
+            m_spriteCount += static_cast<unsigned int>(count);
+            pVertices += count * 4;
+            quadCount -= count;
+
+            if (m_spriteCount == MAX_SPRITE_COUNT)
+            {
+                flush();
+            }
+        }
+    }
+
     void SpriteBatch::drawRectScaled9(const OTextureRef& pTexture, const Rect& rect, const Vector4& padding, const Color& color)
     {
         assert(m_isDrawing); // Should call begin() before calling draw()
@@ -296,7 +359,9 @@ namespace onut
 
         changeTexture(pTexture);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (addInstance({rect.x, rect.y}, {rect.z, 0}, {inclinedRatio * rect.w, rect.w}, {0, 0, 1, 1}, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = {rect.x, rect.y};
         pVerts[0].texCoord = {0, 0};
         pVerts[0].color = color;
@@ -327,7 +392,9 @@ namespace onut
 
         changeTexture(pTexture);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (addInstance({rect.x, rect.y}, {rect.z, 0}, {0, rect.w}, uvs, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = {rect.x, rect.y};
         pVerts[0].texCoord = {uvs.x, uvs.y};
         pVerts[0].color = color;
@@ -359,7 +426,7 @@ namespace onut
 
         changeTexture(pTexture);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = {rect.x, rect.y};
         pVerts[0].texCoord = {uvs.x, uvs.y};
         pVerts[0].color = colors[0];
@@ -384,6 +451,78 @@ namespace onut
         }
     }
 
+    SpriteBatch::SVertexP2T2C4* SpriteBatch::nextVertices()
+    {
+        // Same texture, so the pending instances join these vertices in one draw
+        if (m_instanceCount)
+        {
+            auto pVerts = m_pMappedVertexBuffer;
+            for (unsigned int i = 0; i < m_instanceCount; ++i, pVerts += 4)
+            {
+                const auto& instance = m_instances[i];
+                uint8_t rgba[4];
+                memcpy(rgba, &instance.color, sizeof(rgba));
+                Color color(static_cast<float>(rgba[0]) / 255.f, static_cast<float>(rgba[1]) / 255.f, static_cast<float>(rgba[2]) / 255.f, static_cast<float>(rgba[3]) / 255.f);
+
+                pVerts[0].position = instance.topLeft;
+                pVerts[0].texCoord = {instance.uvs.x, instance.uvs.y};
+                pVerts[0].color = color;
+
+                pVerts[1].position = instance.topLeft + instance.down;
+                pVerts[1].texCoord = {instance.uvs.x, instance.uvs.w};
+                pVerts[1].color = color;
+
+                pVerts[2].position = instance.topLeft + instance.right + instance.down;
+                pVerts[2].texCoord = {instance.uvs.z, instance.uvs.w};
+                pVerts[2].color = color;
+
+                pVerts[3].position = instance.topLeft + instance.right;
+                pVerts[3].texCoord = {instance.uvs.z, instance.uvs.y};
+                pVerts[3].color = color;
+            }
+            m_spriteCount = m_instanceCount;
+            m_instanceCount = 0;
+        }
+        return m_pMappedVertexBuffer + (m_spriteCount * 4);
+    }
+
+    bool SpriteBatch::addInstance(const Vector2& topLeft, const Vector2& right, const Vector2& down, const Vector4& uvs, const Color& color)
+    {
+        // Once there are vertices, the rest of this draw stays vertices
+        if (!m_isInstancing || m_spriteCount) return false;
+
+        // The color is 8 bits per channel on this path
+        if (color.r < 0.f || color.r > 1.f ||
+            color.g < 0.f || color.g > 1.f ||
+            color.b < 0.f || color.b > 1.f ||
+            color.a < 0.f || color.a > 1.f) return false;
+
+        // A custom vertex shader was set after begin()
+        const auto& pVertexShader = oRenderer->renderStates.vertexShader.get();
+        if (pVertexShader != m_pBatchVertexShader && pVertexShader != oRenderer->get2DInstancedVertexShader()) return false;
+
+        auto& instance = m_instances[m_instanceCount];
+        instance.topLeft = topLeft;
+        instance.right = right;
+        instance.down = down;
+        instance.uvs = uvs;
+        uint8_t rgba[4] = {
+            static_cast<uint8_t>(color.r * 255.f + .5f),
+            static_cast<uint8_t>(color.g * 255.f + .5f),
+            static_cast<uint8_t>(color.b * 255.f + .5f),
+            static_cast<uint8_t>(color.a * 255.f + .5f)
+        };
+        memcpy(&instance.color, rgba, sizeof(rgba));
+
+        ++m_instanceCount;
+
+        if (m_instanceCount == MAX_SPRITE_COUNT)
+        {
+            flush();
+        }
+        return true;
+    }
+
     void SpriteBatch::changeTexture(const OTextureRef& pTexture)
     {
         if (!pTexture && m_pTexture == m_pTexWhite) return;
@@ -427,7 +566,15 @@ namespace onut
 
         auto invOrigin = Vector2(1.f - origin.x, 1.f - origin.y);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (m_isInstancing)
+        {
+            auto topLeft = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
+            auto right = Vector2::Transform(Vector2(sizef.x * invOrigin.x, -sizef.y * origin.y), transform) - topLeft;
+            auto down = Vector2::Transform(Vector2(-sizef.x * origin.x, sizef.y * invOrigin.y), transform) - topLeft;
+            if (addInstance(topLeft, right, down, {0, 0, 1, 1}, color)) return;
+        }
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
         pVerts[0].texCoord = {0, 0};
         pVerts[0].color = color;
@@ -458,7 +605,15 @@ namespace onut
 
         auto invOrigin = Vector2(1.f - origin.x, 1.f - origin.y);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (m_isInstancing)
+        {
+            auto topLeft = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
+            auto right = Vector2::Transform(Vector2(sizef.x * invOrigin.x, -sizef.y * origin.y), transform) - topLeft;
+            auto down = Vector2::Transform(Vector2(-sizef.x * origin.x, sizef.y * invOrigin.y), transform) - topLeft;
+            if (addInstance(topLeft, right, down, {0, 0, 1, 1}, color)) return;
+        }
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
         pVerts[0].texCoord = {0, 0};
         pVerts[0].color = color;
@@ -492,7 +647,15 @@ namespace onut
 
         auto invOrigin = Vector2(1.f - origin.x, 1.f - origin.y);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (m_isInstancing)
+        {
+            auto topLeft = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
+            auto right = Vector2::Transform(Vector2(sizef.x * invOrigin.x, -sizef.y * origin.y), transform) - topLeft;
+            auto down = Vector2::Transform(Vector2(-sizef.x * origin.x, sizef.y * invOrigin.y), transform) - topLeft;
+            if (addInstance(topLeft, right, down, uvs, color)) return;
+        }
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
         pVerts[0].texCoord = {uvs.x, uvs.y};
         pVerts[0].color = color;
@@ -528,7 +691,15 @@ namespace onut
 
         auto invOrigin = Vector2(1.f - origin.x, 1.f - origin.y);
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (m_isInstancing)
+        {
+            auto topLeft = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
+            auto right = Vector2::Transform(Vector2(sizef.x * invOrigin.x, -sizef.y * origin.y), transform) - topLeft;
+            auto down = Vector2::Transform(Vector2(-sizef.x * origin.x, sizef.y * invOrigin.y), transform) - topLeft;
+            if (addInstance(topLeft, right, down, uvs, color)) return;
+        }
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = Vector2::Transform(Vector2(-sizef.x * origin.x, -sizef.y * origin.y), transform);
         pVerts[0].texCoord = {uvs.x, uvs.y};
         pVerts[0].color = color;
@@ -570,7 +741,9 @@ namespace onut
         Vector2 right{cosTheta * hSize.x, sinTheta * hSize.x};
         Vector2 down{-sinTheta * hSize.y, cosTheta * hSize.y};
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (addInstance(position - right * origin.x * 2.f - down * origin.y * 2.f, right * 2.f, down * 2.f, uvs, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = position;
         pVerts[0].position -= right * origin.x * 2.f;
         pVerts[0].position -= down * origin.y * 2.f;
@@ -615,7 +788,10 @@ namespace onut
         Vector2 right{-dir.y, dir.x};
         right *= size * .5f;
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        auto uEnd = uOffset + len * uScale / texSize.x;
+        if (addInstance(from - right, to - from, right * 2.f, {uOffset, 0, uEnd, 1}, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = Vector2(from.x - right.x, from.y - right.y);
         pVerts[0].texCoord = {uOffset, 0};
         pVerts[0].color = color;
@@ -662,7 +838,9 @@ namespace onut
         Vector2 right{cosTheta * hSize.x, sinTheta * hSize.x};
         Vector2 down{-sinTheta * hSize.y, cosTheta * hSize.y};
 
-        SVertexP2T2C4* pVerts = m_pMappedVertexBuffer + (m_spriteCount * 4);
+        if (addInstance(position - right * origin.x * 2.f - down * origin.y * 2.f, right * 2.f, down * 2.f, {0, 0, 1, 1}, color)) return;
+
+        SVertexP2T2C4* pVerts = nextVertices();
         pVerts[0].position = position;
         pVerts[0].position -= right * origin.x * 2.f;
         pVerts[0].position -= down * origin.y * 2.f;
@@ -700,21 +878,46 @@ namespace onut
         if (!m_isDrawing) return;
 
         m_isDrawing = false;
-        if (m_spriteCount)
+        if (m_spriteCount || m_instanceCount)
         {
             flush();
         }
 
+        if (m_pCommandList)
+        {
+            m_pCommandList = nullptr;
+            m_pMappedVertexBuffer = nullptr;
+            return;
+        }
         m_pVertexBuffer->unmap(sizeof(SVertexP2T2C4) * m_spriteCount * 4);
+        if (m_isInstancing)
+        {
+            auto& vertexShader = oRenderer->renderStates.vertexShader;
+            if (vertexShader.get() == oRenderer->get2DInstancedVertexShader()) vertexShader = m_pBatchVertexShader;
+            m_pBatchVertexShader = nullptr;
+        }
     }
 
     void SpriteBatch::flush()
     {
-        if (!m_spriteCount)
+        if (!m_spriteCount && !m_instanceCount)
         {
             return; // Nothing to flush
         }
 
+        flushVertices();
+        flushInstances();
+
+        m_pTexture = nullptr;
+    }
+
+    void SpriteBatch::flushVertices()
+    {
+        if (!m_spriteCount)
+        {
+            return;
+        }
+
         if (m_snapToPixel)
         {
             auto len = m_spriteCount * 4;
@@ -729,8 +932,27 @@ namespace onut
             }
         }
 
+        if (m_pCommandList)
+        {
+            m_pCommandList->uploadVertices(m_pVertexBuffer, m_pMappedVertexBuffer, sizeof(SVertexP2T2C4) * m_spriteCount * 4);
+            m_pCommandList->setTexture(m_pTexture);
+            m_pCommandList->setBlendMode(m_curBlendMode);
+            m_pCommandList->setSampleFiltering(m_curFiltering);
+            m_pCommandList->setPrimitiveMode(OPrimitiveTriangleList);
+            m_pCommandList->setIndexBuffer(m_pIndexBuffer);
+            m_pCommandList->setVertexBuffer(m_pVertexBuffer);
+            m_pCommandList->drawIndexed(6 * m_spriteCount);
+
+            m_spriteCount = 0;
+            return;
+        }
+
         m_pVertexBuffer->unmap(sizeof(SVertexP2T2C4) * m_spriteCount * 4);
 
+        if (m_isInstancing && oRenderer->renderStates.vertexShader.get() == oRenderer->get2DInstancedVertexShader())
+        {
+            oRenderer->renderStates.vertexShader = m_pBatchVertexShader;
+        }
         oRenderer->renderStates.textures[0] = m_pTexture;
         oRenderer->renderStates.blendMode = m_curBlendMode;
         oRenderer->renderStates.sampleFiltering = m_curFiltering;
@@ -742,6 +964,31 @@ namespace onut
         m_pMappedVertexBuffer = reinterpret_cast<SVertexP2T2C4*>(m_pVertexBuffer->map());
 
         m_spriteCount = 0;
-        m_pTexture = nullptr;
+    }
+
+    void SpriteBatch::flushInstances()
+    {
+        if (!m_instanceCount)
+        {
+            return;
+        }
+
+        auto pMapped = m_pInstanceBuffer->map();
+        memcpy(pMapped, m_instances.data(), sizeof(SInstance) * m_instanceCount);
+        m_pInstanceBuffer->unmap(sizeof(SInstance) * m_instanceCount);
+
+        // Stays set for the next instanced draws, the vertex path puts it back
+        auto& renderStates = oRenderer->renderStates;
+        renderStates.textures[0] = m_pTexture;
+        renderStates.blendMode = m_curBlendMode;
+        renderStates.sampleFiltering = m_curFiltering;
+        renderStates.primitiveMode = OPrimitiveTriangleList;
+        renderStates.indexBuffer = m_pIndexBuffer;
+        renderStates.vertexShader = oRenderer->get2DInstancedVertexShader();
+        renderStates.vertexBuffer = m_pQuadVertexBuffer;
+        renderStates.instanceBuffer = m_pInstanceBuffer;
+        oRenderer->drawIndexedInstanced(6, m_instanceCount);
+
+        m_instanceCount = 0;
     }
 }
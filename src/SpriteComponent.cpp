@@ -1,5 +1,6 @@
 // onut includes
 #include <onut/Entity.h>
+#include <onut/SceneManager.h>
 #include <onut/SpriteBatch.h>
 #include <onut/SpriteComponent.h>
 #include <onut/Texture.h>
@@ -13,7 +14,15 @@ namespace onut
 
     void SpriteComponent::setTexture(const OTextureRef& pTexture)
     {
+        if (m_pTexture == pTexture) return;
         m_pTexture = pTexture;
+
+        // Static chunks are per texture
+        auto& pEntity = getEntity();
+        if (pEntity && pEntity->isStatic() && pEntity->getSceneManager())
+        {
+            pEntity->getSceneManager()->m_isRender2DDirty = true;
+        }
     }
 
     const OTextureRef& SpriteComponent::getTexture() const
@@ -24,6 +33,7 @@ namespace onut
     void SpriteComponent::setScale(const Vector2& scale)
     {
         m_scale = scale;
+        dirtyStatic();
     }
 
     const Vector2& SpriteComponent::getScale() const
@@ -34,6 +44,7 @@ namespace onut
     void SpriteComponent::setColor(const Color& color)
     {
         m_color = color;
+        dirtyStatic();
     }
 
     const Color& SpriteComponent::getColor() const
@@ -44,6 +55,7 @@ namespace onut
     void SpriteComponent::setOrigin(const Vector2& origin)
     {
         m_origin = origin;
+        dirtyStatic();
     }
 
     const Vector2& SpriteComponent::getOrigin() const
@@ -56,4 +68,36 @@ namespace onut
         auto& transform = getEntity()->getWorldTransform();
         oSpriteBatch->drawSprite(m_pTexture, transform, Vector2(m_scale), m_color, m_origin);
     }
+
+    void SpriteComponent::getVertices(OSpriteBatch::SVertexP2T2C4* pVertices)
+    {
+        auto& transform = getEntity()->getWorldTransform();
+        auto sizef = m_pTexture->getSizef() * m_scale;
+        auto invOrigin = Vector2(1.f - m_origin.x, 1.f - m_origin.y);
+
+        pVertices[0].position = Vector2::Transform(Vector2(-sizef.x * m_origin.x, -sizef.y * m_origin.y), transform);
+        pVertices[0].texCoord = {0, 0};
+        pVertices[0].color = m_color;
+
+        pVertices[1].position = Vector2::Transform(Vector2(-sizef.x * m_origin.x, sizef.y * invOrigin.y), transform);
+        pVertices[1].texCoord = {0, 1};
+        pVertices[1].color = m_color;
+
+        pVertices[2].position = Vector2::Transform(Vector2(sizef.x * invOrigin.x, sizef.y * invOrigin.y), transform);
+        pVertices[2].texCoord = {1, 1};
+        pVertices[2].color = m_color;
+
+        pVertices[3].position = Vector2::Transform(Vector2(sizef.x * invOrigin.x, -sizef.y * m_origin.y), transform);
+        pVertices[3].texCoord = {1, 0};
+        pVertices[3].color = m_color;
+    }
+
+    void SpriteComponent::dirtyStatic()
+    {
+        auto& pEntity = getEntity();
+        if (pEntity && pEntity->isStatic() && pEntity->getSceneManager())
+        {
+            pEntity->getSceneManager()->dirtyStatic2D(pEntity.get());
+        }
+    }
 };
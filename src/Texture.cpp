@@ -1,6 +1,10 @@
 // Onut
 #include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
+#include <onut/Files.h>
+#include <onut/Images.h>
 #include <onut/Renderer.h>
+#include <onut/Strings.h>
 #include <onut/Texture.h>
 
 // STL
@@ -10,10 +14,60 @@ bool oGenerateMipmaps = true;
 
 namespace onut
 {
+    ContentManager::AsyncSteps AsyncLoader<Texture>::prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+    {
+        ContentManager::AsyncSteps steps;
+        auto data = Texture::readTextureFile(filename, pContentManager);
+        if (data.isEmpty()) return steps;
+        if (CookedTexture::isCooked(data.getData(), data.getSize()))
+        {
+            // Nothing to decode, it's uploaded as is
+            auto pData = std::make_shared<FileData>(std::move(data));
+            steps.finish = [pData](const OContentManagerRef& pContentManager) -> OResourceRef
+            {
+                return Texture::createFromFileData(pData->getData(), static_cast<uint32_t>(pData->getSize()));
+            };
+            return steps;
+        }
+        Point size;
+        auto pImage = std::make_shared<std::vector<uint8_t>>(decodeImage(data.getData(), data.getSize(), size, true));
+        if (pImage->empty()) return steps;
+
+        steps.finish = [pImage, size](const OContentManagerRef& pContentManager) -> OResourceRef
+        {
+            return Texture::createFromData(pImage->data(), size);
+        };
+        return steps;
+    }
+
+    FileData Texture::readTextureFile(const std::string& filename, const OContentManagerRef& pContentManager)
+    {
+        if (getExtension(filename) != toUpper(CookedTexture::EXTENSION))
+        {
+            auto pCookedContentManager = pContentManager ? pContentManager : oContentManager;
+            if (pCookedContentManager)
+            {
+                auto cookedFilename = pCookedContentManager->findResourceFile(getFilenameWithoutExtension(filename) + "." + CookedTexture::EXTENSION);
+                if (!cookedFilename.empty())
+                {
+                    auto data = pCookedContentManager->readFile(cookedFilename);
+                    if (!data.isEmpty()) return data;
+                }
+            }
+        }
+        return readResourceFile(filename, pContentManager);
+    }
+
     Texture::~Texture()
     {
     }
 
+    size_t Texture::getMemorySize() const
+    {
+        if (m_memorySize) return m_memorySize;
+        return static_cast<size_t>(m_size.x) * static_cast<size_t>(m_size.y) * 4; // RGBA8, mipmaps not counted
+    }
+
     const Point& Texture::getSize() const
     {
         return m_size;
@@ -1,16 +1,15 @@
 #if defined(WIN32)
 // Onut
 #include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
 #include <onut/Files.h>
+#include <onut/Images.h>
 #include <onut/Settings.h>
 
 // Private
 #include "RendererD3D11.h"
 #include "TextureD3D11.h"
 
-// Third party
-#include <lodepng/LodePNG.h>
-
 // STL
 #include <cassert>
 #include <vector>
@@ -90,23 +89,10 @@ namespace onut
 
     OTextureRef Texture::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        auto ret = lodepng::decode(image, w, h, filename);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = &(image[0]);
-        auto len = size.x * size.y;
-        for (decltype(len) i = 0; i < len; ++i, pImageData += 4)
-        {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
-        }
-
-        auto pRet = createFromData(image.data(), size, generateMipmaps);
+        auto data = readTextureFile(filename, pContentManager);
+        if (data.isEmpty()) return nullptr;
+        auto pRet = createFromFileData(data.getData(), static_cast<uint32_t>(data.getSize()), generateMipmaps);
+        if (!pRet) return nullptr;
         pRet->setName(onut::getFilename(filename));
         pRet->m_type = Type::Static;
         return pRet;
@@ -114,24 +100,70 @@ namespace onut
 
     OTextureRef Texture::createFromFileData(const uint8_t* pData, uint32_t dataSize, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        lodepng::State state;
-        auto ret = lodepng::decode(image, w, h, state, pData, dataSize);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = image.data();
-        auto len = size.x * size.y;
-        for (int i = 0; i < len; ++i, pImageData += 4)
+        if (CookedTexture::isCooked(pData, dataSize)) return createFromCookedData(pData, dataSize);
+
+        Point size;
+        auto image = decodeImage(pData, dataSize, size, true);
+        if (image.empty()) return nullptr;
+        return createFromData(image.data(), size, generateMipmaps);
+    }
+
+    OTextureRef Texture::createFromCookedData(const uint8_t* pData, size_t dataSize)
+    {
+        CookedTexture cooked;
+        if (!cooked.read(pData, dataSize)) return nullptr;
+
+        auto pRet = std::shared_ptr<TextureD3D11>(new TextureD3D11());
+
+#if defined(WIN32)
+        // BC1 and BC3 are supported by every D3D11 device
+        auto& levels = cooked.getLevels();
+        std::vector<D3D11_SUBRESOURCE_DATA> levelsData(levels.size());
+        for (size_t i = 0; i < levels.size(); ++i)
         {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
+            auto& level = levels[i];
+            levelsData[i].pSysMem = level.pData;
+            levelsData[i].SysMemPitch = static_cast<UINT>(CookedTexture::getLevelDataSize(cooked.getFormat(), Point(level.size.x, 1))); // A row of pixels or blocks
+            levelsData[i].SysMemSlicePitch = 0;
         }
 
-        return createFromData(image.data(), size, generateMipmaps);
+        D3D11_TEXTURE2D_DESC desc;
+        desc.Width = static_cast<UINT>(cooked.getSize().x);
+        desc.Height = static_cast<UINT>(cooked.getSize().y);
+        desc.MipLevels = static_cast<UINT>(levels.size());
+        desc.ArraySize = 1;
+        switch (cooked.getFormat())
+        {
+            case CookedTexture::Format::BC1: desc.Format = DXGI_FORMAT_BC1_UNORM; break;
+            case CookedTexture::Format::BC3: desc.Format = DXGI_FORMAT_BC3_UNORM; break;
+            default: desc.Format = DXGI_FORMAT_R8G8B8A8_UNORM; break;
+        }
+        desc.SampleDesc.Count = 1;
+        desc.SampleDesc.Quality = 0;
+        desc.Usage = D3D11_USAGE_IMMUTABLE;
+        desc.BindFlags = D3D11_BIND_SHADER_RESOURCE;
+        desc.CPUAccessFlags = 0;
+        desc.MiscFlags = 0;
+
+        ID3D11Texture2D* pTexture = NULL;
+        ID3D11ShaderResourceView* pTextureView = NULL;
+        auto pRendererD3D11 = std::dynamic_pointer_cast<ORendererD3D11>(oRenderer);
+        auto pDevice = pRendererD3D11->getDevice();
+        auto ret = pDevice->CreateTexture2D(&desc, levelsData.data(), &pTexture);
+        assert(ret == S_OK);
+        ret = pDevice->CreateShaderResourceView(pTexture, NULL, &pTextureView);
+        assert(ret == S_OK);
+        pTexture->Release();
+
+        pRet->m_size = cooked.getSize();
+        pRet->m_pTextureView = pTextureView;
+        pRet->m_memorySize = cooked.getMemorySize();
+#else
+#error
+#endif
+
+        pRet->m_type = Type::Static;
+        return pRet;
     }
 
     OTextureRef Texture::createFromData(const uint8_t* pData, const Point& size, bool generateMipmaps)
@@ -276,6 +308,23 @@ namespace onut
         pDeviceContext->Unmap(m_pTexture, 0);
     }
 
+    bool TextureD3D11::reload(const OContentManagerRef& pContentManager)
+    {
+        if (m_type != Type::Static) return false;
+        auto pNew = std::dynamic_pointer_cast<TextureD3D11>(createFromFile(getFilename(), pContentManager));
+        if (!pNew) return false;
+
+        // Take its views, it releases ours
+        std::swap(m_pTexture, pNew->m_pTexture);
+        std::swap(m_pTextureView, pNew->m_pTextureView);
+        m_size = pNew->m_size;
+        m_memorySize = pNew->m_memorySize;
+
+        // Same pointer, but it has to be bound again
+        for (auto& texture : oRenderer->renderStates.textures) texture.forceDirty();
+        return true;
+    }
+
     TextureD3D11::~TextureD3D11()
     {
         if (m_pTextureView) m_pTextureView->Release();
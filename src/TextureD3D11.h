@@ -37,6 +37,7 @@ namespace onut
         void vignette(float amount = .5f) override; // 0 - 1
 
         void setData(const uint8_t* pData) override;
+        bool reload(const OContentManagerRef& pContentManager) override;
         void resizeTarget(const Point& size) override;
 
     protected:
@@ -1,21 +1,27 @@
 // Onut
 #include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
 #include <onut/Files.h>
+#include <onut/Images.h>
 #include <onut/Settings.h>
 
 // Private
 #include "RendererGL.h"
 #include "TextureGL.h"
 
-// Third party
-#include <lodepng/LodePNG.h>
-
 // STL
 #include <cassert>
 #include <vector>
 
 namespace onut
 {
+    // The renderer skips binds it thinks are done. Tell it when we bind or delete behind it
+    static void resetRendererBindings()
+    {
+        auto pRendererGL = ODynamicCast<ORendererGL>(oRenderer);
+        if (pRendererGL) pRendererGL->resetBindings();
+    }
+
     OTextureRef Texture::createRenderTarget(const Point& size, bool willUseFX)
     {
         auto pRet = std::shared_ptr<TextureGL>(new TextureGL());
@@ -47,6 +53,7 @@ namespace onut
         // Because opengl uses a global state and its dumb as fuck
         oRenderer->renderStates.renderTarget.forceDirty();
         oRenderer->renderStates.textures[0].forceDirty();
+        resetRendererBindings();
         
         return pRet;
     }
@@ -84,6 +91,7 @@ namespace onut
         
         // Because opengl uses a global state and its dumb as fuck
         oRenderer->renderStates.textures[0].forceDirty();
+        resetRendererBindings();
 
         pRet->m_type = Type::Dynamic;
         pRet->m_size = size;
@@ -94,23 +102,10 @@ namespace onut
 
     OTextureRef Texture::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        auto ret = lodepng::decode(image, w, h, filename);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = &(image[0]);
-        auto len = size.x * size.y;
-        for (decltype(len) i = 0; i < len; ++i, pImageData += 4)
-        {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
-        }
-
-        auto pRet = createFromData(image.data(), size, generateMipmaps);
+        auto data = readTextureFile(filename, pContentManager);
+        if (data.isEmpty()) return nullptr;
+        auto pRet = createFromFileData(data.getData(), static_cast<uint32_t>(data.getSize()), generateMipmaps);
+        if (!pRet) return nullptr;
         pRet->setName(onut::getFilename(filename));
         pRet->m_type = Type::Static;
         return pRet;
@@ -118,24 +113,66 @@ namespace onut
 
     OTextureRef Texture::createFromFileData(const uint8_t* pData, uint32_t dataSize, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        lodepng::State state;
-        auto ret = lodepng::decode(image, w, h, state, pData, dataSize);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = image.data();
-        auto len = size.x * size.y;
-        for (int i = 0; i < len; ++i, pImageData += 4)
+        if (CookedTexture::isCooked(pData, dataSize)) return createFromCookedData(pData, dataSize);
+
+        Point size;
+        auto image = decodeImage(pData, dataSize, size, true);
+        if (image.empty()) return nullptr;
+
+        // Decoded straight into the upload buffer
+        auto pRet = std::shared_ptr<TextureGL>(new TextureGL());
+        pRet->m_isDirty = true;
+        pRet->m_dirtyData = std::move(image);
+        oRenderer->renderStates.textures[0].forceDirty();
+        pRet->m_type = Type::Static;
+        pRet->m_size = size;
+        return pRet;
+    }
+
+    static bool isS3TCSupported()
+    {
+#if defined(__APPLE__)
+        return true; // Every Mac GPU has it
+#else
+        return GLEW_EXT_texture_compression_s3tc != 0;
+#endif
+    }
+
+    OTextureRef Texture::createFromCookedData(const uint8_t* pData, size_t dataSize)
+    {
+        CookedTexture cooked;
+        if (!cooked.read(pData, dataSize)) return nullptr;
+
+        auto pRet = std::shared_ptr<TextureGL>(new TextureGL());
+        auto format = cooked.getFormat();
+        auto isSupported = format == CookedTexture::Format::RGBA8 || isS3TCSupported();
+        if (isSupported && format == CookedTexture::Format::BC1) pRet->m_dirtyFormat = GL_COMPRESSED_RGB_S3TC_DXT1_EXT;
+        else if (isSupported && format == CookedTexture::Format::BC3) pRet->m_dirtyFormat = GL_COMPRESSED_RGBA_S3TC_DXT5_EXT;
+
+        auto& levels = cooked.getLevels();
+        for (size_t i = 0; i < levels.size(); ++i)
         {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
+            auto& level = levels[i];
+            auto offset = pRet->m_dirtyData.size();
+            if (isSupported)
+            {
+                pRet->m_dirtyData.insert(pRet->m_dirtyData.end(), level.pData, level.pData + level.dataSize);
+            }
+            else
+            {
+                auto image = cooked.decompress(i);
+                pRet->m_dirtyData.insert(pRet->m_dirtyData.end(), image.begin(), image.end());
+            }
+            pRet->m_dirtyLevels.push_back({level.size, offset, pRet->m_dirtyData.size() - offset});
         }
+        pRet->m_isDirty = true;
+        pRet->m_levelCount = static_cast<GLint>(levels.size());
+        pRet->m_memorySize = pRet->m_dirtyData.size();
+        oRenderer->renderStates.textures[0].forceDirty();
 
-        return createFromData(image.data(), size, generateMipmaps);
+        pRet->m_type = Type::Static;
+        pRet->m_size = cooked.getSize();
+        return pRet;
     }
 
     OTextureRef Texture::createFromData(const uint8_t* pData, const Point& size, bool generateMipmaps)
@@ -162,6 +199,30 @@ namespace onut
         
         // Because opengl uses a global state and its dumb as fuck
         oRenderer->renderStates.textures[0].forceDirty();
+        resetRendererBindings();
+    }
+
+    bool TextureGL::reload(const OContentManagerRef& pContentManager)
+    {
+        if (m_type != Type::Static) return false;
+        auto pNew = std::dynamic_pointer_cast<TextureGL>(createFromFile(getFilename(), pContentManager));
+        if (!pNew) return false;
+
+        // Take its GL texture, it deletes ours
+        std::swap(m_handle, pNew->m_handle);
+        std::swap(m_isDirty, pNew->m_isDirty);
+        m_dirtyData.swap(pNew->m_dirtyData);
+        m_dirtyLevels.swap(pNew->m_dirtyLevels);
+        m_dirtyFormat = pNew->m_dirtyFormat;
+        m_levelCount = pNew->m_levelCount;
+        filtering = pNew->filtering;
+        addressMode = pNew->addressMode;
+        m_size = pNew->m_size;
+        m_memorySize = pNew->m_memorySize;
+
+        // Same pointer, but it has to be bound again
+        for (auto& texture : oRenderer->renderStates.textures) texture.forceDirty();
+        return true;
     }
 
     TextureGL::~TextureGL()
@@ -174,6 +235,9 @@ namespace onut
         {
             glDeleteFramebuffers(1, &m_frameBuffer);
         }
+
+        // Deleted names get reused
+        if (m_handle || m_frameBuffer) resetRendererBindings();
     }
 
     void TextureGL::resizeTarget(const Point& size)
@@ -220,15 +284,39 @@ namespace onut
             glGenTextures(1, &handle);
             glActiveTexture(GL_TEXTURE0);
             glBindTexture(GL_TEXTURE_2D, handle);
-            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_dirtyData.data());
+            if (m_dirtyLevels.empty())
+            {
+                glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, m_size.x, m_size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, m_dirtyData.data());
+            }
+            else
+            {
+                // Cooked, the mipmaps come with it
+                for (size_t i = 0; i < m_dirtyLevels.size(); ++i)
+                {
+                    auto& level = m_dirtyLevels[i];
+                    auto pLevelData = m_dirtyData.data() + level.offset;
+                    if (m_dirtyFormat == GL_RGBA)
+                    {
+                        glTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), GL_RGBA, level.size.x, level.size.y, 0, GL_RGBA, GL_UNSIGNED_BYTE, pLevelData);
+                    }
+                    else
+                    {
+                        glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), m_dirtyFormat, level.size.x, level.size.y, 0, static_cast<GLsizei>(level.dataSize), pLevelData);
+                    }
+                }
+                glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, m_levelCount - 1);
+                m_dirtyLevels.clear();
+            }
             m_dirtyData.clear();
+            m_dirtyData.shrink_to_fit();
 
-            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, (m_levelCount > 1) ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
             glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
 
             m_handle = handle;
+            resetRendererBindings();
         }
         return m_handle;
     }
@@ -33,10 +33,12 @@ namespace onut
         void vignette(float amount = .5f) override; // 0 - 1
 
         void setData(const uint8_t* pData) override;
+        bool reload(const OContentManagerRef& pContentManager) override;
         void resizeTarget(const Point& size) override;
         
         GLuint getHandle() const;
         GLuint getFramebuffer() const;
+        GLint getLevelCount() const { return m_levelCount; }
         
         // Renderer need to keep track of the sample states per texture in OpenGL
         sample::Filtering filtering = sample::Filtering::Linear;
@@ -47,11 +49,21 @@ namespace onut
 
     private:
         friend Texture;
+
+        struct DirtyLevel
+        {
+            Point size;
+            size_t offset;
+            size_t dataSize;
+        };
         
         mutable GLuint m_handle = 0;
         GLuint m_frameBuffer = 0;
         mutable bool m_isDirty = false;
         mutable std::vector<uint8_t> m_dirtyData;
+        mutable std::vector<DirtyLevel> m_dirtyLevels; // Cooked, the levels in m_dirtyData
+        GLenum m_dirtyFormat = GL_RGBA;
+        GLint m_levelCount = 1;
     };
 }
 
@@ -1,16 +1,15 @@
 #if defined(__unix__)
 // Onut
 #include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
 #include <onut/Files.h>
+#include <onut/Images.h>
 #include <onut/Settings.h>
 
 // Private
 #include "RendererGLES2.h"
 #include "TextureGLES2.h"
 
-// Third party
-#include <lodepng/LodePNG.h>
-
 // STL
 #include <cassert>
 #include <vector>
@@ -95,23 +94,10 @@ namespace onut
 
     OTextureRef Texture::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        auto ret = lodepng::decode(image, w, h, filename);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = &(image[0]);
-        auto len = size.x * size.y;
-        for (decltype(len) i = 0; i < len; ++i, pImageData += 4)
-        {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
-        }
-
-        auto pRet = createFromData(image.data(), size, generateMipmaps);
+        auto data = readTextureFile(filename, pContentManager);
+        if (data.isEmpty()) return nullptr;
+        auto pRet = createFromFileData(data.getData(), static_cast<uint32_t>(data.getSize()), generateMipmaps);
+        if (!pRet) return nullptr;
         pRet->setName(onut::getFilename(filename));
         pRet->m_type = Type::Static;
         return pRet;
@@ -119,26 +105,23 @@ namespace onut
 
     OTextureRef Texture::createFromFileData(const uint8_t* pData, uint32_t dataSize, bool generateMipmaps)
     {
-        std::vector<uint8_t> image; //the raw pixels (holy crap that must be slow)
-        unsigned int w, h;
-        lodepng::State state;
-        auto ret = lodepng::decode(image, w, h, state, pData, dataSize);
-        assert(!ret);
-        Point size{static_cast<int>(w), static_cast<int>(h)};
-
-        // Pre multiplied
-        uint8_t* pImageData = image.data();
-        auto len = size.x * size.y;
-        for (int i = 0; i < len; ++i, pImageData += 4)
-        {
-            pImageData[0] = pImageData[0] * pImageData[3] / 255;
-            pImageData[1] = pImageData[1] * pImageData[3] / 255;
-            pImageData[2] = pImageData[2] * pImageData[3] / 255;
-        }
+        if (CookedTexture::isCooked(pData, dataSize)) return createFromCookedData(pData, dataSize);
 
+        Point size;
+        auto image = decodeImage(pData, dataSize, size, true);
+        if (image.empty()) return nullptr;
         return createFromData(image.data(), size, generateMipmaps);
     }
 
+    OTextureRef Texture::createFromCookedData(const uint8_t* pData, size_t dataSize)
+    {
+        // No block compression on the Pi, and no mipmaps for npot textures in GLES2
+        CookedTexture cooked;
+        if (!cooked.read(pData, dataSize)) return nullptr;
+        auto image = cooked.decompress(0);
+        return createFromData(image.data(), cooked.getSize(), false);
+    }
+
     OTextureRef Texture::createFromData(const uint8_t* pData, const Point& size, bool generateMipmaps)
     {
         auto pRet = std::shared_ptr<TextureGLES2>(new TextureGLES2());
@@ -175,6 +158,24 @@ namespace onut
         oRenderer->renderStates.textures[0].forceDirty();
     }
 
+    bool TextureGLES2::reload(const OContentManagerRef& pContentManager)
+    {
+        if (m_type != Type::Static) return false;
+        auto pNew = std::dynamic_pointer_cast<TextureGLES2>(createFromFile(getFilename(), pContentManager));
+        if (!pNew) return false;
+
+        // Take its GL texture, it deletes ours
+        std::swap(m_handle, pNew->m_handle);
+        filtering = pNew->filtering;
+        addressMode = pNew->addressMode;
+        m_size = pNew->m_size;
+        m_memorySize = pNew->m_memorySize;
+
+        // Same pointer, but it has to be bound again
+        for (auto& texture : oRenderer->renderStates.textures) texture.forceDirty();
+        return true;
+    }
+
     TextureGLES2::~TextureGLES2()
     {
         if (m_handle)
@@ -0,0 +1,145 @@
+// Onut
+#include <onut/ContentManager.h>
+#include <onut/CookedTexture.h>
+#include <onut/Files.h>
+#include <onut/Images.h>
+#include <onut/RendererNull.h>
+#include <onut/Settings.h>
+
+// Private
+#include "TextureNull.h"
+
+// STL
+#include <cassert>
+
+namespace onut
+{
+    OTextureRef Texture::createRenderTarget(const Point& size, bool willUseFX)
+    {
+        auto pRet = std::shared_ptr<TextureNull>(new TextureNull());
+        pRet->m_size = size;
+        pRet->m_type = Type::RenderTarget;
+        return pRet;
+    }
+
+    OTextureRef Texture::createScreenRenderTarget(bool willBeUsedInEffects)
+    {
+        Point res = oRenderer->getTrueResolution();
+        if (oSettings->getIsRetroMode())
+        {
+            res = oSettings->getRetroResolution();
+        }
+
+        auto pRet = createRenderTarget(res, willBeUsedInEffects);
+        pRet->m_isScreenRenderTarget = true;
+        pRet->m_type = Type::ScreenRenderTarget;
+        return pRet;
+    }
+
+    OTextureRef Texture::createDynamic(const Point& size)
+    {
+        auto pRet = std::shared_ptr<TextureNull>(new TextureNull());
+        pRet->m_type = Type::Dynamic;
+        pRet->m_size = size;
+        return pRet;
+    }
+
+    OTextureRef Texture::createFromFile(const std::string& filename, const OContentManagerRef& pContentManager, bool generateMipmaps)
+    {
+        auto data = readTextureFile(filename, pContentManager);
+        if (data.isEmpty()) return nullptr;
+        auto pRet = createFromFileData(data.getData(), static_cast<uint32_t>(data.getSize()), generateMipmaps);
+        if (!pRet) return nullptr;
+        pRet->setName(onut::getFilename(filename));
+        pRet->m_type = Type::Static;
+        return pRet;
+    }
+
+    OTextureRef Texture::createFromFileData(const uint8_t* pData, uint32_t dataSize, bool generateMipmaps)
+    {
+        if (CookedTexture::isCooked(pData, dataSize)) return createFromCookedData(pData, dataSize);
+
+        // Decoded like the other renderers do, it's part of the CPU cost
+        Point size;
+        auto image = decodeImage(pData, dataSize, size, true);
+        if (image.empty()) return nullptr;
+        RendererNull::countUpload(image.size());
+
+        auto pRet = std::shared_ptr<TextureNull>(new TextureNull());
+        pRet->m_type = Type::Static;
+        pRet->m_size = size;
+        return pRet;
+    }
+
+    OTextureRef Texture::createFromCookedData(const uint8_t* pData, size_t dataSize)
+    {
+        CookedTexture cooked;
+        if (!cooked.read(pData, dataSize)) return nullptr;
+        RendererNull::countUpload(cooked.getMemorySize());
+
+        auto pRet = std::shared_ptr<TextureNull>(new TextureNull());
+        pRet->m_memorySize = cooked.getMemorySize();
+        pRet->m_type = Type::Static;
+        pRet->m_size = cooked.getSize();
+        return pRet;
+    }
+
+    OTextureRef Texture::createFromData(const uint8_t* pData, const Point& size, bool generateMipmaps)
+    {
+        RendererNull::countUpload(static_cast<size_t>(size.x * size.y * 4));
+
+        auto pRet = std::shared_ptr<TextureNull>(new TextureNull());
+        pRet->m_type = Type::Static;
+        pRet->m_size = size;
+        return pRet;
+    }
+
+    void TextureNull::setData(const uint8_t* pData)
+    {
+        assert(isDynamic()); // Only dynamic texture can be set data
+        RendererNull::countUpload(static_cast<size_t>(m_size.x * m_size.y * 4));
+    }
+
+    bool TextureNull::reload(const OContentManagerRef& pContentManager)
+    {
+        if (m_type != Type::Static) return false;
+        auto pNew = std::dynamic_pointer_cast<TextureNull>(createFromFile(getFilename(), pContentManager));
+        if (!pNew) return false;
+
+        m_size = pNew->m_size;
+        m_memorySize = pNew->m_memorySize;
+
+        // Same pointer, but it has to be bound again
+        for (auto& texture : oRenderer->renderStates.textures) texture.forceDirty();
+        return true;
+    }
+
+    void TextureNull::resizeTarget(const Point& size)
+    {
+        m_size = size;
+    }
+
+    void TextureNull::clearRenderTarget(const Color& color)
+    {
+    }
+
+    void TextureNull::blur(float amount)
+    {
+    }
+
+    void TextureNull::sepia(const Vector3& tone, float saturation, float sepiaAmount)
+    {
+    }
+
+    void TextureNull::crt()
+    {
+    }
+
+    void TextureNull::cartoon(const Vector3& tone)
+    {
+    }
+
+    void TextureNull::vignette(float amount)
+    {
+    }
+}
@@ -0,0 +1,38 @@
+#ifndef TEXTURENULL_H_INCLUDED
+#define TEXTURENULL_H_INCLUDED
+
+// Onut
+#include <onut/Texture.h>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(TextureNull);
+
+namespace onut
+{
+    class TextureNull final : public Texture
+    {
+    public:
+        void clearRenderTarget(const Color& color) override;
+
+        void blur(float amount = 16.f) override;
+        void sepia(const Vector3& tone = Vector3(1.40f, 1.10f, 0.90f),
+                   float saturation = 0,
+                   float sepiaAmount = .75f) override;
+        void crt() override;
+        void cartoon(const Vector3& tone = Vector3(2, 5, 1)) override;
+        void vignette(float amount = .5f) override;
+
+        void setData(const uint8_t* pData) override;
+        bool reload(const OContentManagerRef& pContentManager) override;
+        void resizeTarget(const Point& size) override;
+
+    protected:
+        TextureNull() {}
+
+    private:
+        friend Texture;
+    };
+}
+
+#endif
@@ -56,6 +56,37 @@ namespace onut
         return pRet;
     }
 
+    ContentManager::AsyncSteps AsyncLoader<TiledMap>::prepare(const std::string& filename, const OContentManagerRef& pContentManager, float priority)
+    {
+        ContentManager::AsyncSteps steps;
+        tinyxml2::XMLDocument doc;
+        auto data = readResourceFile(filename, pContentManager);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
+        auto pXMLMap = doc.FirstChildElement("map");
+        for (auto pXMLTileset = pXMLMap ? pXMLMap->FirstChildElement("tileset") : nullptr; pXMLTileset; pXMLTileset = pXMLTileset->NextSiblingElement("tileset"))
+        {
+            auto pXMLImage = pXMLTileset->FirstChildElement("image");
+            auto szSource = pXMLTileset->Attribute("source");
+            tinyxml2::XMLDocument docTXS;
+            if (szSource && onut::getExtension(szSource) == "TSX")
+            {
+                auto dataTXS = pContentManager->readFile(pContentManager->findResourceFile(onut::getFilename(szSource)));
+                docTXS.Parse(reinterpret_cast<const char*>(dataTXS.getData()), dataTXS.getSize());
+                auto pTXSTileset = docTXS.FirstChildElement("tileset");
+                pXMLImage = pTXSTileset ? pTXSTileset->FirstChildElement("image") : nullptr;
+            }
+            if (pXMLImage && pXMLImage->Attribute("source"))
+            {
+                steps.dependencies.push_back(pContentManager->loadAsync<OTexture>(onut::getFilename(pXMLImage->Attribute("source")), priority));
+            }
+        }
+        steps.finish = [filename](const OContentManagerRef& pContentManager) -> OResourceRef
+        {
+            return TiledMap::createFromFile(filename, pContentManager);
+        };
+        return steps;
+    }
+
     OTiledMapRef TiledMap::createFromFile(const std::string &filename, const OContentManagerRef& in_pContentManager)
     {
         OContentManagerRef pContentManager = in_pContentManager;
@@ -64,7 +95,8 @@ namespace onut
         auto pRet = std::make_shared<OTiledMap>();
 
         tinyxml2::XMLDocument doc;
-        doc.LoadFile(filename.c_str());
+        auto data = readResourceFile(filename, pContentManager);
+        doc.Parse(reinterpret_cast<const char*>(data.getData()), data.getSize());
         assert(!doc.Error());
         auto pXMLMap = doc.FirstChildElement("map");
         assert(pXMLMap);
@@ -88,7 +120,8 @@ namespace onut
             {
                 tinyxml2::XMLDocument docTXS;
                 auto fullpathTXS = pContentManager->findResourceFile(onut::getFilename(szSource));
-                docTXS.LoadFile(fullpathTXS.c_str());
+                auto dataTXS = pContentManager->readFile(fullpathTXS);
+                docTXS.Parse(reinterpret_cast<const char*>(dataTXS.getData()), dataTXS.getSize());
                 assert(!docTXS.Error());
                 auto pTXSTileset = docTXS.FirstChildElement("tileset");
                 assert(pTXSTileset);
@@ -0,0 +1,230 @@
+// Private
+#include "UIBinary.h"
+
+// STL
+#include <cstring>
+
+namespace onut
+{
+    static const char SIGNATURE[4] = {'O', 'U', 'I', 'B'};
+    static const uint32_t VERSION = 1;
+
+    const char* UIBinaryReader::EXTENSION = "uib";
+
+    void UIBinaryWriter::writeByte(uint8_t value)
+    {
+        m_data.push_back(value);
+    }
+
+    void UIBinaryWriter::writeInt(int32_t value)
+    {
+        writeUInt(static_cast<uint32_t>(value));
+    }
+
+    void UIBinaryWriter::writeUInt(uint32_t value)
+    {
+        auto offset = m_data.size();
+        m_data.resize(offset + sizeof(value));
+        memcpy(m_data.data() + offset, &value, sizeof(value));
+    }
+
+    void UIBinaryWriter::writeFloat(float value)
+    {
+        uint32_t bits;
+        memcpy(&bits, &value, sizeof(bits));
+        writeUInt(bits);
+    }
+
+    void UIBinaryWriter::writeString(const std::string& value)
+    {
+        auto it = m_stringIds.find(value);
+        if (it == m_stringIds.end())
+        {
+            it = m_stringIds.insert({value, static_cast<uint32_t>(m_strings.size())}).first;
+            m_strings.push_back(value);
+        }
+        writeUInt(it->second);
+    }
+
+    void UIBinaryWriter::writeColor(const Color& value)
+    {
+        writeFloat(value.r);
+        writeFloat(value.g);
+        writeFloat(value.b);
+        writeFloat(value.a);
+    }
+
+    void UIBinaryWriter::writeVector4(const Vector4& value)
+    {
+        writeFloat(value.x);
+        writeFloat(value.y);
+        writeFloat(value.z);
+        writeFloat(value.w);
+    }
+
+    std::vector<uint8_t> UIBinaryWriter::finish() const
+    {
+        std::vector<uint32_t> offsets;
+        std::string strings;
+        for (auto& str : m_strings)
+        {
+            offsets.push_back(static_cast<uint32_t>(strings.size()));
+            strings.append(str.c_str(), str.size() + 1);
+        }
+
+        uint32_t header[3] = {VERSION, static_cast<uint32_t>(offsets.size()), static_cast<uint32_t>(strings.size())};
+        std::vector<uint8_t> ret(sizeof(SIGNATURE) + sizeof(header));
+        memcpy(ret.data(), SIGNATURE, sizeof(SIGNATURE));
+        memcpy(ret.data() + sizeof(SIGNATURE), header, sizeof(header));
+        ret.insert(ret.end(), reinterpret_cast<const uint8_t*>(offsets.data()), reinterpret_cast<const uint8_t*>(offsets.data() + offsets.size()));
+        ret.insert(ret.end(), strings.begin(), strings.end());
+        ret.insert(ret.end(), m_data.begin(), m_data.end());
+        return ret;
+    }
+
+    UIBinaryReader::UIBinaryReader(const uint8_t* pData, size_t dataSize)
+    {
+        uint32_t header[3];
+        if (!pData || dataSize < sizeof(SIGNATURE) + sizeof(header) || memcmp(pData, SIGNATURE, sizeof(SIGNATURE))) return;
+        memcpy(header, pData + sizeof(SIGNATURE), sizeof(header));
+        if (header[0] != VERSION) return;
+
+        auto tableSize = static_cast<uint64_t>(header[1]) * sizeof(uint32_t) + header[2];
+        auto pTable = pData + sizeof(SIGNATURE) + sizeof(header);
+        if (tableSize > static_cast<uint64_t>(pData + dataSize - pTable)) return;
+        if (header[2] && pTable[tableSize - 1] != '\0') return; // Every string has to be terminated
+
+        m_stringCount = header[1];
+        m_pStringOffsets = pTable;
+        m_pStrings = reinterpret_cast<const char*>(pTable + m_stringCount * sizeof(uint32_t));
+        m_pStringsEnd = reinterpret_cast<const char*>(pTable + tableSize);
+        m_pData = pTable + tableSize;
+        m_pEnd = pData + dataSize;
+        m_isValid = true;
+    }
+
+    bool UIBinaryReader::read(void* pOut, size_t size)
+    {
+        if (!m_isValid || static_cast<size_t>(m_pEnd - m_pData) < size)
+        {
+            m_isValid = false;
+            memset(pOut, 0, size);
+            return false;
+        }
+        memcpy(pOut, m_pData, size);
+        m_pData += size;
+        return true;
+    }
+
+    uint8_t UIBinaryReader::readByte()
+    {
+        uint8_t value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    int32_t UIBinaryReader::readInt()
+    {
+        return static_cast<int32_t>(readUInt());
+    }
+
+    uint32_t UIBinaryReader::readUInt()
+    {
+        uint32_t value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    float UIBinaryReader::readFloat()
+    {
+        float value;
+        read(&value, sizeof(value));
+        return value;
+    }
+
+    const char* UIBinaryReader::readString()
+    {
+        auto index = readUInt();
+        if (index >= m_stringCount)
+        {
+            m_isValid = false;
+            return "";
+        }
+        uint32_t offset;
+        memcpy(&offset, m_pStringOffsets + index * sizeof(uint32_t), sizeof(offset));
+        if (offset >= static_cast<uint32_t>(m_pStringsEnd - m_pStrings))
+        {
+            m_isValid = false;
+            return "";
+        }
+        return m_pStrings + offset;
+    }
+
+    Color UIBinaryReader::readColor()
+    {
+        Color ret;
+        ret.r = readFloat();
+        ret.g = readFloat();
+        ret.b = readFloat();
+        ret.a = readFloat();
+        return ret;
+    }
+
+    Vector4 UIBinaryReader::readVector4()
+    {
+        Vector4 ret;
+        ret.x = readFloat();
+        ret.y = readFloat();
+        ret.z = readFloat();
+        ret.w = readFloat();
+        return ret;
+    }
+
+    void writeTextComponent(UIBinaryWriter& writer, const UITextComponent& textComponent)
+    {
+        auto& font = textComponent.font;
+        writer.writeString(textComponent.text);
+        writer.writeColor(font.color);
+        writer.writeEnum(font.align);
+        writer.writeVector4(font.padding);
+        writer.writeString(font.typeFace);
+        writer.writeFloat(font.size);
+        writer.writeByte(font.flags);
+        writer.writeFloat(font.minSize);
+    }
+
+    void writeScale9Component(UIBinaryWriter& writer, const UIScale9Component& scale9Component)
+    {
+        writer.writeString(scale9Component.image.filename);
+        writer.writeColor(scale9Component.image.color);
+        writer.writeBool(scale9Component.isScaled9);
+        writer.writeBool(scale9Component.isRepeat);
+        writer.writeVector4(scale9Component.padding);
+    }
+
+    UITextComponent readTextComponent(UIBinaryReader& reader)
+    {
+        UITextComponent ret;
+        auto& font = ret.font;
+        ret.text = reader.readString();
+        font.color = reader.readColor();
+        font.align = reader.readEnum<onut::Align>();
+        font.padding = reader.readVector4();
+        font.typeFace = reader.readString();
+        font.size = reader.readFloat();
+        font.flags = reader.readByte();
+        font.minSize = reader.readFloat();
+        return ret;
+    }
+
+    UIScale9Component readScale9Component(UIBinaryReader& reader)
+    {
+        UIScale9Component ret;
+        ret.image.filename = reader.readString();
+        ret.image.color = reader.readColor();
+        ret.isScaled9 = reader.readBool();
+        ret.isRepeat = reader.readBool();
+        ret.padding = reader.readVector4();
+        return ret;
+    }
+}
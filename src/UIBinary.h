@@ -0,0 +1,85 @@
+#ifndef UIBINARY_H_INCLUDED
+#define UIBINARY_H_INCLUDED
+
+// Onut
+#include <onut/Maths.h>
+#include <onut/UIComponents.h>
+
+// STL
+#include <cinttypes>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace onut
+{
+    /*!
+        Binary UI layout (.uib). A string table followed by the controls,
+        parent first, each one's fields in the order its save writes them.
+        Read in place from the file's data, strings point into it.
+    */
+    class UIBinaryWriter final
+    {
+    public:
+        void writeByte(uint8_t value);
+        void writeBool(bool value) { writeByte(value ? 1 : 0); }
+        void writeInt(int32_t value);
+        void writeUInt(uint32_t value);
+        void writeFloat(float value);
+        void writeString(const std::string& value); // Stored once in the table
+        void writeColor(const Color& value);
+        void writeVector4(const Vector4& value);
+
+        template<typename Tenum>
+        void writeEnum(Tenum value) { writeByte(static_cast<uint8_t>(value)); }
+
+        std::vector<uint8_t> finish() const;
+
+    private:
+        std::vector<uint8_t> m_data;
+        std::vector<std::string> m_strings;
+        std::unordered_map<std::string, uint32_t> m_stringIds;
+    };
+
+    class UIBinaryReader final
+    {
+    public:
+        static const char* EXTENSION; // "uib"
+
+        // Invalid if it's not a binary layout
+        UIBinaryReader(const uint8_t* pData, size_t dataSize);
+
+        // Reading past the end gives zeros and makes it invalid
+        bool isValid() const { return m_isValid; }
+
+        uint8_t readByte();
+        bool readBool() { return readByte() != 0; }
+        int32_t readInt();
+        uint32_t readUInt();
+        float readFloat();
+        const char* readString();
+        Color readColor();
+        Vector4 readVector4();
+
+        template<typename Tenum>
+        Tenum readEnum() { return static_cast<Tenum>(readByte()); }
+
+    private:
+        bool read(void* pOut, size_t size);
+
+        const uint8_t* m_pData = nullptr;
+        const uint8_t* m_pEnd = nullptr;
+        const uint8_t* m_pStringOffsets = nullptr;
+        const char* m_pStrings = nullptr;
+        const char* m_pStringsEnd = nullptr; // The last one is terminated, so any offset before this is
+        uint32_t m_stringCount = 0;
+        bool m_isValid = false;
+    };
+
+    void writeTextComponent(UIBinaryWriter& writer, const UITextComponent& textComponent);
+    void writeScale9Component(UIBinaryWriter& writer, const UIScale9Component& scale9Component);
+    UITextComponent readTextComponent(UIBinaryReader& reader);
+    UIScale9Component readScale9Component(UIBinaryReader& reader);
+}
+
+#endif
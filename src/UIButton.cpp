@@ -3,6 +3,7 @@
 #include <onut/UIContext.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 namespace onut
@@ -42,6 +43,20 @@ namespace onut
         setJsonScale9Component(jsonNode, scale9Component, allocator);
     }
 
+    void UIButton::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        textComponent = readTextComponent(reader);
+        scale9Component = readScale9Component(reader);
+    }
+
+    void UIButton::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writeTextComponent(writer, textComponent);
+        writeScale9Component(writer, scale9Component);
+    }
+
     void UIButton::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UIButton>(getStyle());
@@ -3,6 +3,7 @@
 #include <onut/UIContext.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 namespace onut
@@ -33,6 +34,7 @@ namespace onut
 
     void UICheckBox::setIsChecked(bool in_isChecked)
     {
+        invalidateRender();
         switch (behavior)
         {
             case CheckBehavior::Normal:
@@ -115,6 +117,22 @@ namespace onut
         setJsonString(jsonNode, "behavior", enumToString(checkBehaviorMap, behavior), allocator, "NORMAL");
     }
 
+    void UICheckBox::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        textComponent = readTextComponent(reader);
+        m_isChecked = reader.readBool();
+        behavior = reader.readEnum<CheckBehavior>();
+    }
+
+    void UICheckBox::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writeTextComponent(writer, textComponent);
+        writer.writeBool(m_isChecked);
+        writer.writeEnum(behavior);
+    }
+
     void UICheckBox::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UICheckBox>(getStyle());
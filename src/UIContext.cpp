@@ -9,6 +9,10 @@
 #include <onut/UIControl.h>
 #include <onut/UITextBox.h>
 
+// STL
+#include <algorithm>
+#include <cmath>
+
 // Third parties
 #if defined(WIN32)
 #include <Windows.h>
@@ -48,10 +52,10 @@ namespace onut
         oSpriteBatch->flush();
         oRenderer->renderStates.scissorEnabled.push(true);
         oRenderer->renderStates.scissor.push(iRect{
-            static_cast<int>(rect.x),
-            static_cast<int>(rect.y),
-            static_cast<int>(rect.x + rect.z),
-            static_cast<int>(rect.y + rect.w)
+            static_cast<int>(rect.x - m_clipOffset.x),
+            static_cast<int>(rect.y - m_clipOffset.y),
+            static_cast<int>(rect.x + rect.z - m_clipOffset.x),
+            static_cast<int>(rect.y + rect.w - m_clipOffset.y)
         });
     }
 
@@ -62,6 +66,155 @@ namespace onut
         oRenderer->renderStates.scissor.pop();
     }
 
+    void UIContext::pushHitClip(const Rect& rect)
+    {
+        m_hitClips.push_back(getHitRect(rect));
+    }
+
+    void UIContext::popHitClip()
+    {
+        m_hitClips.pop_back();
+    }
+
+    Rect UIContext::getHitRect(const Rect& rect) const
+    {
+        if (m_hitClips.empty()) return rect;
+
+        // Fully clipped gives a negative size, which contains nothing
+        const auto& clip = m_hitClips.back();
+        auto left = std::max(rect.x, clip.x);
+        auto top = std::max(rect.y, clip.y);
+        auto right = std::min(rect.x + rect.z, clip.x + clip.z);
+        auto bottom = std::min(rect.y + rect.w, clip.y + clip.w);
+        return Rect(left, top, right - left, bottom - top);
+    }
+
+    void UIContext::beginHitEntries(const UIControl* pRoot)
+    {
+        if (pRoot != m_pHitRoot || m_hitGeneration != UIControl::s_hierarchyGeneration)
+        {
+            m_pHitRoot = pRoot;
+            m_hitGeneration = UIControl::s_hierarchyGeneration;
+            m_areHitCellsDirty = true;
+        }
+        m_hitEntryCount = 0;
+        m_hitClips.clear();
+        m_isHitEnabled = true;
+    }
+
+    void UIContext::addHitEntry(UIControl* pControl, const Rect& rect)
+    {
+        HitEntry entry = {pControl, rect, getHitRect(rect), m_isHitEnabled && !pControl->isClickThrough};
+
+        // Most frames render the same thing, the cells are only rebuilt if an
+        // entry differs from last time
+        if (m_hitEntryCount < m_hitEntries.size())
+        {
+            auto& previous = m_hitEntries[m_hitEntryCount];
+            if (!(previous == entry))
+            {
+                previous = entry;
+                m_areHitCellsDirty = true;
+            }
+        }
+        else
+        {
+            m_hitEntries.push_back(entry);
+            m_areHitCellsDirty = true;
+        }
+        ++m_hitEntryCount;
+    }
+
+    void UIContext::endHitEntries()
+    {
+        if (m_hitEntryCount != m_hitEntries.size())
+        {
+            m_hitEntries.resize(m_hitEntryCount);
+            m_areHitCellsDirty = true;
+        }
+
+        // Render changed the hierarchy, what was recorded can't be trusted
+        if (m_hitGeneration != UIControl::s_hierarchyGeneration)
+        {
+            m_pHitRoot = nullptr;
+        }
+    }
+
+    void UIContext::buildHitCells()
+    {
+        m_hitCellCountX = std::max(1, static_cast<int>(std::ceil(m_screenSize.x / HIT_CELL_SIZE)));
+        m_hitCellCountY = std::max(1, static_cast<int>(std::ceil(m_screenSize.y / HIT_CELL_SIZE)));
+        m_hitCells.resize(m_hitCellCountX * m_hitCellCountY);
+        for (auto& cell : m_hitCells)
+        {
+            cell.clear();
+        }
+
+        auto entryCount = static_cast<uint32_t>(m_hitEntries.size());
+        for (uint32_t i = 0; i < entryCount; ++i)
+        {
+            const auto& entry = m_hitEntries[i];
+            if (!entry.isHitTestable) continue;
+            const auto& hitRect = entry.hitRect;
+            if (hitRect.z < 0.f || hitRect.w < 0.f) continue;
+            if (hitRect.x + hitRect.z < 0.f || hitRect.x > m_screenSize.x) continue;
+            if (hitRect.y + hitRect.w < 0.f || hitRect.y > m_screenSize.y) continue;
+
+            auto fromX = std::max(0, static_cast<int>(hitRect.x / HIT_CELL_SIZE));
+            auto fromY = std::max(0, static_cast<int>(hitRect.y / HIT_CELL_SIZE));
+            auto toX = std::min(m_hitCellCountX - 1, static_cast<int>((hitRect.x + hitRect.z) / HIT_CELL_SIZE));
+            auto toY = std::min(m_hitCellCountY - 1, static_cast<int>((hitRect.y + hitRect.w) / HIT_CELL_SIZE));
+            for (auto y = fromY; y <= toY; ++y)
+            {
+                for (auto x = fromX; x <= toX; ++x)
+                {
+                    m_hitCells[y * m_hitCellCountX + x].push_back(i);
+                }
+            }
+        }
+        m_areHitCellsDirty = false;
+    }
+
+    bool UIContext::hitTest(const UIControl* pRoot)
+    {
+        // Only answer for the hierarchy that was last rendered
+        if (pRoot != m_pHitRoot || m_hitGeneration != UIControl::s_hierarchyGeneration) return false;
+        auto& mouseEvt = m_mouseEvents[0];
+        const auto& mousePos = mouseEvt.mousePos;
+        if (mousePos.x < 0.f || mousePos.y < 0.f || mousePos.x > m_screenSize.x || mousePos.y > m_screenSize.y) return false;
+
+        if (m_areHitCellsDirty)
+        {
+            buildHitCells();
+        }
+        auto x = std::min(m_hitCellCountX - 1, static_cast<int>(mousePos.x / HIT_CELL_SIZE));
+        auto y = std::min(m_hitCellCountY - 1, static_cast<int>(mousePos.y / HIT_CELL_SIZE));
+        const auto& cell = m_hitCells[y * m_hitCellCountX + x];
+
+        // Last rendered is on top
+        auto itend = cell.rend();
+        for (auto it = cell.rbegin(); it != itend; ++it)
+        {
+            const auto& entry = m_hitEntries[*it];
+            if (!entry.hitRect.Contains(mousePos)) continue;
+
+            // States could have changed since the render. Let the full walk decide
+            if (entry.pControl->isClickThrough) return false;
+            for (auto pControl = entry.pControl->shared_from_this(); pControl; pControl = pControl->getParent())
+            {
+                if (!pControl->isEnabled || !pControl->isVisible) return false;
+            }
+
+            mouseEvt.localMousePos.x = mousePos.x - entry.rect.x;
+            mouseEvt.localMousePos.y = mousePos.y - entry.rect.y;
+            m_mouseEvents[1].localMousePos = mouseEvt.localMousePos;
+            m_mouseEvents[2].localMousePos = mouseEvt.localMousePos;
+            m_pHoverControl = entry.pControl->shared_from_this();
+            return true;
+        }
+        return true;
+    }
+
     void UIContext::resolve()
     {
         // If it's the first mouse down since last frame, and there is an hover
@@ -176,6 +329,20 @@ namespace onut
                     {
                         m_pHoverControl->onMouseScroll(m_pHoverControl, m_mouseEvents[0]);
                     }
+
+                    // The wheel over a scroll view's rows scrolls it
+                    auto hoverType = m_pHoverControl->getType();
+                    if (hoverType != UIControl::Type::ScrollView && hoverType != UIControl::Type::TreeView)
+                    {
+                        for (auto pParent = m_pHoverControl->getParent(); pParent; pParent = pParent->getParent())
+                        {
+                            if (pParent->getType() == UIControl::Type::ScrollView)
+                            {
+                                pParent->onMouseScrollInternal(m_mouseEvents[0]);
+                                break;
+                            }
+                        }
+                    }
                 }
             }
         }
@@ -1,6 +1,12 @@
 // Onut
 #include <onut/ContentManager.h>
 #include <onut/Crypto.h>
+#include <onut/Files.h>
+#include <onut/Log.h>
+#include <onut/Renderer.h>
+#include <onut/Settings.h>
+#include <onut/SpriteBatch.h>
+#include <onut/Texture.h>
 #include <onut/UIButton.h>
 #include <onut/UICheckBox.h>
 #include <onut/UIComponents.h>
@@ -14,6 +20,7 @@
 #include <onut/UITreeView.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 OUIControlRef oUI;
@@ -108,6 +115,36 @@ namespace onut
         }
     }
 
+    UIControl::Property::Property(int value)
+    {
+        m_szString = nullptr;
+        m_type = Type::Int;
+        m_int = value;
+    }
+
+    UIControl::Property::Property(float value)
+    {
+        m_szString = nullptr;
+        m_type = Type::Float;
+        m_float = value;
+    }
+
+    UIControl::Property::Property(bool value)
+    {
+        m_szString = nullptr;
+        m_int = 0;
+        m_type = Type::Bool;
+        m_bool = value;
+    }
+
+    UIControl::Property::Property(const char* szValue)
+    {
+        m_type = Type::String;
+        auto len = strlen(szValue);
+        m_szString = new char[len + 1];
+        memcpy(m_szString, szValue, len + 1);
+    }
+
     UIControl::Property::Property(const Property& other)
     {
         m_szString = nullptr;
@@ -220,14 +257,62 @@ namespace onut
         return std::shared_ptr<UIControl>(new UIControl());
     }
 
+    static OUIControlRef createControl(UIControl::Type type)
+    {
+        switch (type)
+        {
+            case UIControl::Type::Control: return UIControl::create();
+            case UIControl::Type::Button: return UIButton::create();
+            case UIControl::Type::Panel: return UIPanel::create();
+            case UIControl::Type::Label: return UILabel::create();
+            case UIControl::Type::Image: return UIImage::create();
+            case UIControl::Type::CheckBox: return UICheckBox::create();
+            case UIControl::Type::TreeView: return UITreeView::create();
+            case UIControl::Type::TextBox: return UITextBox::create();
+            case UIControl::Type::ScrollView: return UIScrollView::create();
+        }
+        return nullptr;
+    }
+
     OUIControlRef UIControl::createFromFile(const std::string& in_filename, OContentManagerRef pContentManager)
     {
         auto pControl = std::shared_ptr<UIControl>(new UIControl());
 
         if (!pContentManager) pContentManager = oContentManager;
-        auto filename = oContentManager->findResourceFile(in_filename);
+        auto filename = pContentManager->findResourceFile(in_filename);
         if (filename.empty()) filename = in_filename;
 
+        // The binary layout saved next to it, unless the JSON was edited since.
+        // Files packed in an archive have no time, so a packed .uib wins over a
+        // packed .json but never over one on disk. The editor works on the JSON
+        if (getExtension(filename) == "JSON" && !(oSettings && oSettings->getIsEditorMode()))
+        {
+            auto binaryFilename = pContentManager->findResourceFile(getFilenameWithoutExtension(filename) + "." + UIBinaryReader::EXTENSION);
+            if (!binaryFilename.empty())
+            {
+                if (getFileTime(binaryFilename) >= getFileTime(filename))
+                {
+                    filename = binaryFilename;
+                }
+                else
+                {
+                    OLogW("Ignoring " + binaryFilename + ", it is older than " + filename);
+                }
+            }
+        }
+        if (getExtension(filename) == "UIB")
+        {
+            auto data = readResourceFile(filename, pContentManager);
+            UIBinaryReader reader(data.getData(), data.getSize());
+            reader.readByte(); // The root is always a UIControl
+            pControl->load(reader);
+            if (!reader.isValid())
+            {
+                OLogE("Invalid UI layout: " + filename);
+            }
+            return pControl;
+        }
+
         // Open json file
         FILE* pFile = nullptr;
 #if defined(WIN32)
@@ -249,10 +334,17 @@ namespace onut
         return pControl;
     }
 
+    uint32_t UIControl::s_hierarchyGeneration = 0;
+
     UIControl::UIControl()
     {
     }
 
+    UIControl::~UIControl()
+    {
+        ++s_hierarchyGeneration;
+    }
+
     bool UIControl::visit(const std::function<bool(const OUIControlRef&, const Rect&)>& callback, const Rect& parentRect)
     {
         auto worldRect = getWorldRect(parentRect);
@@ -377,6 +469,7 @@ namespace onut
         heightType = getJsonEnum(dimTypeMap, jsonNode["heightType"], UIControl::DimType::Absolute);
         xAnchorType = getJsonEnum(anchorTypeMap, jsonNode["anchorType"], UIControl::AnchorType::Percentage);
         yAnchorType = getJsonEnum(anchorTypeMap, jsonNode["anchorType"], UIControl::AnchorType::Percentage);
+        invalidateLayout();
 
         name = getJsonString(jsonNode["name"]);
         m_styleName = getJsonString(jsonNode["style"]);
@@ -448,6 +541,24 @@ namespace onut
 
     void UIControl::save(const std::string& filename) const
     {
+        if (getExtension(filename) == "UIB")
+        {
+            UIBinaryWriter writer;
+            save(writer);
+            auto data = writer.finish();
+            FILE* pFile = nullptr;
+#if defined(WIN32)
+            auto fopenRet = fopen_s(&pFile, filename.c_str(), "wb");
+            assert(!fopenRet);
+#else
+            pFile = fopen(filename.c_str(), "wb");
+            assert(pFile);
+#endif
+            fwrite(data.data(), 1, data.size(), pFile);
+            fclose(pFile);
+            return;
+        }
+
         rapidjson::Document doc;
         doc.SetObject();
         auto& allocator = doc.GetAllocator();
@@ -532,12 +643,108 @@ namespace onut
         }
     }
 
+    void UIControl::load(UIBinaryReader& reader)
+    {
+        rect = reader.readVector4();
+        anchor.x = reader.readFloat();
+        anchor.y = reader.readFloat();
+
+        align = reader.readEnum<onut::Align>();
+        xType = reader.readEnum<PosType>();
+        yType = reader.readEnum<PosType>();
+        widthType = reader.readEnum<DimType>();
+        heightType = reader.readEnum<DimType>();
+        xAnchorType = reader.readEnum<AnchorType>();
+        yAnchorType = reader.readEnum<AnchorType>();
+        invalidateLayout();
+
+        name = reader.readString();
+        m_styleName = reader.readString();
+        m_style = reader.readInt(); // Already hashed
+
+        isEnabled = reader.readBool();
+        isVisible = reader.readBool();
+        isClickThrough = reader.readBool();
+        clipChildren = reader.readBool();
+
+        // Properties
+        auto propertyCount = reader.readUInt();
+        for (decltype(propertyCount) i = 0; i < propertyCount && reader.isValid(); ++i)
+        {
+            auto szName = reader.readString();
+            switch (reader.readEnum<Property::Type>())
+            {
+                case Property::Type::Int: m_properties[szName] = Property(reader.readInt()); break;
+                case Property::Type::Float: m_properties[szName] = Property(reader.readFloat()); break;
+                case Property::Type::String: m_properties[szName] = Property(reader.readString()); break;
+                case Property::Type::Bool: m_properties[szName] = Property(reader.readBool()); break;
+            }
+        }
+
+        // Load children
+        auto childCount = reader.readUInt();
+        for (decltype(childCount) i = 0; i < childCount && reader.isValid(); ++i)
+        {
+            auto pChild = createControl(reader.readEnum<Type>());
+            if (!pChild) return;
+            add(pChild);
+            pChild->load(reader);
+        }
+    }
+
+    void UIControl::save(UIBinaryWriter& writer) const
+    {
+        writer.writeEnum(getType());
+
+        writer.writeVector4(rect);
+        writer.writeFloat(anchor.x);
+        writer.writeFloat(anchor.y);
+
+        writer.writeEnum(align);
+        writer.writeEnum(xType);
+        writer.writeEnum(yType);
+        writer.writeEnum(widthType);
+        writer.writeEnum(heightType);
+        writer.writeEnum(xAnchorType);
+        writer.writeEnum(yAnchorType);
+
+        writer.writeString(name);
+        writer.writeString(m_styleName);
+        writer.writeInt(m_style);
+
+        writer.writeBool(isEnabled);
+        writer.writeBool(isVisible);
+        writer.writeBool(isClickThrough);
+        writer.writeBool(clipChildren);
+
+        writer.writeUInt(static_cast<uint32_t>(m_properties.size()));
+        for (auto& kv : m_properties)
+        {
+            writer.writeString(kv.first);
+            writer.writeEnum(kv.second.getType());
+            switch (kv.second.getType())
+            {
+                case Property::Type::Int: writer.writeInt(kv.second.getInt()); break;
+                case Property::Type::Float: writer.writeFloat(kv.second.getFloat()); break;
+                case Property::Type::String: writer.writeString(kv.second.getString()); break;
+                case Property::Type::Bool: writer.writeBool(kv.second.getBool()); break;
+            }
+        }
+
+        writer.writeUInt(static_cast<uint32_t>(m_children.size()));
+        for (auto& pChild : m_children)
+        {
+            pChild->save(writer);
+        }
+    }
+
     void UIControl::operator=(const UIControl& other)
     {
         isEnabled = other.isEnabled;
         isClickThrough = other.isClickThrough;
         isVisible = other.isVisible;
         clipChildren = other.clipChildren;
+        cacheRender = other.cacheRender;
         rect = other.rect;
         align = other.align;
         xType = other.xType;
@@ -547,6 +754,7 @@ namespace onut
         xAnchorType = other.xAnchorType;
         yAnchorType = other.yAnchorType;
         anchor = other.anchor;
+        invalidateLayout();
         name = other.name;
         pUserData = other.pUserData;
         pSharedUserData = other.pSharedUserData;
@@ -554,6 +762,7 @@ namespace onut
         m_style = other.m_style;
         m_styleName = other.m_styleName;
         m_children.clear();
+        ++s_hierarchyGeneration;
 
         for (auto pChild : other.m_children)
         {
@@ -563,40 +772,8 @@ namespace onut
 
     OUIControlRef UIControl::copy() const
     {
-        OUIControlRef pRet;
-        switch (getType())
-        {
-            case Type::Control:
-                pRet = UIControl::create();
-                break;
-            case Type::Button:
-                pRet = UIButton::create();
-                break;
-            case Type::Panel:
-                pRet = UIPanel::create();
-                break;
-            case Type::Label:
-                pRet = UILabel::create();
-                break;
-            case Type::Image:
-                pRet = UIImage::create();
-                break;
-            case Type::CheckBox:
-                pRet = UICheckBox::create();
-                break;
-            case Type::TreeView:
-                pRet = UITreeView::create();
-                break;
-            case Type::TextBox:
-                pRet = UITextBox::create();
-                break;
-            case Type::ScrollView:
-                pRet = UIScrollView::create();
-                break;
-            default:
-                assert(false);
-                break;
-        }
+        auto pRet = createControl(getType());
+        assert(pRet);
         *pRet.get() = *this;
         return pRet;
     }
@@ -611,7 +788,9 @@ namespace onut
         }
 
         pChild->m_pParent = OThis;
+        pChild->invalidateLayout();
         m_children.push_back(pChild);
+        ++s_hierarchyGeneration;
     }
 
     void UIControl::insert(OUIControlRef pChild, const OUIControlRef& pBefore)
@@ -630,7 +809,9 @@ namespace onut
         }
 
         pChild->m_pParent = OThis;
+        pChild->invalidateLayout();
         m_children.insert(m_children.begin() + i, pChild);
+        ++s_hierarchyGeneration;
     }
 
     void UIControl::insertAfter(OUIControlRef pChild, const OUIControlRef& pAfter)
@@ -648,7 +829,9 @@ namespace onut
         }
 
         pChild->m_pParent = OThis;
+        pChild->invalidateLayout();
         m_children.insert(m_children.begin() + i, pChild);
+        ++s_hierarchyGeneration;
     }
 
     bool UIControl::insertAt(OUIControlRef pChild, size_t index)
@@ -661,7 +844,9 @@ namespace onut
         }
 
         pChild->m_pParent = OThis;
+        pChild->invalidateLayout();
         m_children.insert(m_children.begin() + index, pChild);
+        ++s_hierarchyGeneration;
         return true;
     }
 
@@ -689,6 +874,8 @@ namespace onut
         }
 
         in_pChild->m_pParent.reset();
+        in_pChild->dirtyLayout();
+        ++s_hierarchyGeneration;
     }
 
     void UIControl::removeAll()
@@ -698,8 +885,10 @@ namespace onut
         {
             auto pChild = m_children[i];
             pChild->m_pParent.reset();
+            pChild->dirtyLayout();
         }
         m_children.clear();
+        ++s_hierarchyGeneration;
     }
 
     OUIControlRef UIControl::getChild(const std::string& in_name, bool bSearchSubChildren)
@@ -833,6 +1022,7 @@ namespace onut
     {
         // Prepare our data
         Rect parentRect = {{0, 0}, context->getScreenSize()};
+        updateLayout(parentRect);
         context->m_mouseEvents[0].mousePos = mousePos;
         context->m_mouseEvents[0].isMouseDown = bMouse1Down;
         context->m_mouseEvents[0].pContext = context;
@@ -881,7 +1071,7 @@ namespace onut
                 }, parentRect);
             }
         }
-        else
+        else if (!context->useHitTestIndex || !context->hitTest(this))
         {
             updateInternal(context, parentRect);
         }
@@ -1002,23 +1192,127 @@ namespace onut
     void UIControl::render(const OUIContextRef& context)
     {
         Rect parentRect = {{0, 0}, context->getScreenSize()};
+        updateLayout(parentRect);
+        context->beginHitEntries(this);
         renderInternal(context, parentRect);
+        context->endHitEntries();
     }
 
     Rect UIControl::getWorldRect(const OUIContextRef& context) const
     {
         if (auto pParent = m_pParent.lock())
         {
-            return std::move(getWorldRect(pParent->getWorldRect(context)));
+            if (isLayoutClean()) return m_worldRect;
+            return getWorldRect(pParent->getWorldRect(context));
         }
         else
         {
             Rect parentRect = {{0, 0}, context->getScreenSize()};
-            return std::move(getWorldRect(parentRect));
+            return getWorldRect(parentRect);
+        }
+    }
+
+    void UIControl::invalidateLayout()
+    {
+        dirtyLayout();
+        dirtyParentLayouts();
+        if (auto pParent = m_pParent.lock())
+        {
+            // Its own cache only needs redrawing if resized, which it checks
+            pParent->invalidateRender();
+        }
+    }
+
+    void UIControl::dirtyLayout() const
+    {
+        if (m_isLayoutDirty) return; // Children already are
+        m_isLayoutDirty = true;
+        if (m_children.empty()) return;
+        m_isChildLayoutDirty = true;
+        for (auto& pChild : m_children)
+        {
+            pChild->dirtyLayout();
+        }
+    }
+
+    void UIControl::dirtyParentLayouts() const
+    {
+        for (auto pParent = m_pParent.lock(); pParent && !pParent->m_isChildLayoutDirty; pParent = pParent->m_pParent.lock())
+        {
+            pParent->m_isChildLayoutDirty = true;
+        }
+    }
+
+    uint32_t UIControl::getLayoutTypes() const
+    {
+        return
+            static_cast<uint32_t>(align) |
+            static_cast<uint32_t>(xType) << 4 |
+            static_cast<uint32_t>(yType) << 8 |
+            static_cast<uint32_t>(widthType) << 12 |
+            static_cast<uint32_t>(heightType) << 16 |
+            static_cast<uint32_t>(xAnchorType) << 20 |
+            static_cast<uint32_t>(yAnchorType) << 24;
+    }
+
+    // Public fields written without invalidateLayout()
+    bool UIControl::isLayoutChanged() const
+    {
+        return rect != m_layoutRect || anchor != m_layoutAnchor || getLayoutTypes() != m_layoutTypes;
+    }
+
+    // Parents of a dirty control know it, but a changed field is only
+    // noticed by looking at it, so go all the way up
+    bool UIControl::isLayoutClean() const
+    {
+        for (auto pControl = this; pControl; pControl = pControl->m_pParent.lock().get())
+        {
+            if (pControl->m_isLayoutDirty || pControl->isLayoutChanged()) return false;
+        }
+        return true;
+    }
+
+    void UIControl::updateLayout(const Rect& parentRect) const
+    {
+        auto worldRect = getWorldRect(parentRect);
+        if (!m_isChildLayoutDirty) return;
+        m_isChildLayoutDirty = false;
+        for (auto& pChild : m_children)
+        {
+            pChild->updateLayout(worldRect);
         }
     }
 
     Rect UIControl::getWorldRect(const Rect& parentRect) const
+    {
+        // The parent rect only differs without an invalidation at the root,
+        // when the screen is resized, or when visiting from another rect
+        if (m_isLayoutDirty || m_parentRect != parentRect || isLayoutChanged())
+        {
+            auto worldRect = computeWorldRect(parentRect);
+            if (worldRect != m_worldRect)
+            {
+                for (auto& pChild : m_children)
+                {
+                    pChild->dirtyLayout();
+                }
+                if (!m_children.empty() && !m_isChildLayoutDirty)
+                {
+                    m_isChildLayoutDirty = true;
+                    dirtyParentLayouts();
+                }
+            }
+            m_parentRect = parentRect;
+            m_worldRect = worldRect;
+            m_layoutRect = rect;
+            m_layoutAnchor = anchor;
+            m_layoutTypes = getLayoutTypes();
+            m_isLayoutDirty = false;
+        }
+        return m_worldRect;
+    }
+
+    Rect UIControl::computeWorldRect(const Rect& parentRect) const
     {
         Rect worldRect;
 
@@ -1140,8 +1434,13 @@ namespace onut
     {
         if (!isEnabled || !isVisible) return;
         Rect worldRect = getWorldRect(parentRect);
+        Rect hitRect = context->getHitRect(worldRect);
 
         // Do children first, inverted
+        if (clipChildren)
+        {
+            context->pushHitClip(worldRect);
+        }
         if (context->useNavigation)
         {
             for (auto pChild : m_children)
@@ -1158,14 +1457,15 @@ namespace onut
                 pChild->updateInternal(context, worldRect);
             }
         }
+        if (clipChildren)
+        {
+            context->popHitClip();
+        }
 
         if (!context->m_pHoverControl && !isClickThrough)
         {
             auto &mouseEvt = context->m_mouseEvents[0];
-            if (mouseEvt.mousePos.x >= worldRect.x &&
-                mouseEvt.mousePos.y >= worldRect.y &&
-                mouseEvt.mousePos.x <= worldRect.x + worldRect.z &&
-                mouseEvt.mousePos.y <= worldRect.y + worldRect.w)
+            if (hitRect.Contains(mouseEvt.mousePos))
             {
                 context->m_mouseEvents[0].localMousePos.x = mouseEvt.mousePos.x - worldRect.x;
                 context->m_mouseEvents[0].localMousePos.y = mouseEvt.mousePos.y - worldRect.y;
@@ -1181,9 +1481,19 @@ namespace onut
         if (!isVisible) return;
 
         Rect worldRect = getWorldRect(parentRect);
+        if (cacheRender && renderCached(context, worldRect)) return;
+        renderControlAndChildren(context, worldRect);
+    }
+
+    void UIControl::renderControlAndChildren(const OUIContextRef& context, const Rect& worldRect)
+    {
+        auto wasHitEnabled = context->m_isHitEnabled;
+        context->m_isHitEnabled = wasHitEnabled && isEnabled;
+        context->addHitEntry(this, worldRect);
         if (clipChildren)
         {
             context->pushClip(worldRect);
+            context->pushHitClip(worldRect);
         }
         renderControl(context, worldRect);
         for (auto pChild : m_children)
@@ -1193,7 +1503,127 @@ namespace onut
         if (clipChildren)
         {
             context->popClip();
+            context->popHitClip();
+        }
+        context->m_isHitEnabled = wasHitEnabled;
+    }
+
+    void UIControl::invalidateRender()
+    {
+        m_isRenderCacheDirty = true;
+        if (auto pParent = m_pParent.lock())
+        {
+            pParent->invalidateRender();
+        }
+    }
+
+    bool UIControl::isInRenderCache(const UIControl* pControl) const
+    {
+        while (pControl)
+        {
+            if (pControl == this) return true;
+            pControl = pControl->m_pParent.lock().get();
+        }
+        return false;
+    }
+
+    bool UIControl::isRenderCacheValid(const OUIContextRef& context) const
+    {
+        // Checked first, the controls kept from last time are alive if it didn't change
+        if (m_renderCacheGeneration != s_hierarchyGeneration) return false;
+
+        const UIControl* controls[5] = {
+            context->m_pHoverControl.get(),
+            context->m_pDownControls[0].get(),
+            context->m_pDownControls[1].get(),
+            context->m_pDownControls[2].get(),
+            context->m_pFocus.get()
+        };
+        for (int i = 0; i < 5; ++i)
+        {
+            if (controls[i] == m_renderCacheControls[i]) continue;
+            if (isInRenderCache(controls[i]) || isInRenderCache(m_renderCacheControls[i])) return false;
+        }
+
+        // Text boxes animate their caret while focused
+        const auto& pFocus = context->m_pFocus;
+        if (pFocus && pFocus->getType() == Type::TextBox && isInRenderCache(pFocus.get())) return false;
+
+        return true;
+    }
+
+    bool UIControl::renderCached(const OUIContextRef& context, const Rect& worldRect)
+    {
+        if (!oSpriteBatch->isInBatch() || worldRect.z < 1.f || worldRect.w < 1.f) return false;
+
+        Point size(static_cast<int>(worldRect.z), static_cast<int>(worldRect.w));
+        if (!m_pRenderCache || m_pRenderCache->getSize() != size)
+        {
+            m_pRenderCache = OTexture::createRenderTarget(size);
+            m_isRenderCacheDirty = true;
+        }
+
+        if (m_isRenderCacheDirty || !isRenderCacheValid(context))
+        {
+            // Invalidations while drawing are for the next frame
+            m_isRenderCacheDirty = false;
+            m_renderCacheGeneration = s_hierarchyGeneration;
+            m_renderCacheControls[0] = context->m_pHoverControl.get();
+            m_renderCacheControls[1] = context->m_pDownControls[0].get();
+            m_renderCacheControls[2] = context->m_pDownControls[1].get();
+            m_renderCacheControls[3] = context->m_pDownControls[2].get();
+            m_renderCacheControls[4] = context->m_pFocus.get();
+
+            // Draw in the texture as if at 0, 0. The outside scissor doesn't apply there
+            auto transform = oSpriteBatch->getTransform();
+            auto blendMode = oSpriteBatch->getBlendMode();
+            auto clipOffset = context->m_clipOffset;
+            oSpriteBatch->end();
+            oRenderer->renderStates.renderTarget.push(m_pRenderCache);
+            oRenderer->renderStates.viewport.push({0, 0, size.x, size.y});
+            oRenderer->renderStates.scissorEnabled.push(false);
+            oRenderer->clear(Color::Transparent);
+            context->m_clipOffset = Vector2(worldRect.x, worldRect.y);
+            oSpriteBatch->begin(Matrix::CreateTranslation(-worldRect.x, -worldRect.y, 0));
+
+            renderControlAndChildren(context, worldRect);
+
+            oSpriteBatch->end();
+            context->m_clipOffset = clipOffset;
+            oRenderer->renderStates.scissorEnabled.pop();
+            oRenderer->renderStates.viewport.pop();
+            oRenderer->renderStates.renderTarget.pop();
+            oSpriteBatch->begin(transform, blendMode);
+        }
+        else
+        {
+            // Not drawn, but they can still be hovered
+            addHitEntries(context, worldRect);
+        }
+
+        oSpriteBatch->drawRect(m_pRenderCache, worldRect);
+        return true;
+    }
+
+    void UIControl::addHitEntries(const OUIContextRef& context, const Rect& worldRect)
+    {
+        auto wasHitEnabled = context->m_isHitEnabled;
+        context->m_isHitEnabled = wasHitEnabled && isEnabled;
+        context->addHitEntry(this, worldRect);
+        if (clipChildren)
+        {
+            context->pushHitClip(worldRect);
+        }
+        for (const auto& pChild : m_children)
+        {
+            if (!pChild->isVisible) continue;
+            pChild->addHitEntries(context, pChild->getWorldRect(worldRect));
+        }
+        if (clipChildren)
+        {
+            context->popHitClip();
         }
+        context->m_isHitEnabled = wasHitEnabled;
     }
 
     void UIControl::setWorldRect(const Rect& in_rect, const OUIContextRef& context)
@@ -1316,6 +1746,7 @@ namespace onut
         {
             rect = in_rect;
         }
+        invalidateLayout();
     }
 
     Vector2 UIControl::getAnchorInPixel() const
@@ -1364,6 +1795,7 @@ namespace onut
         {
             anchor.y = in_anchor.y;
         }
+        invalidateLayout();
     }
 
     UIControl::State UIControl::getState(const OUIContextRef& context) const
@@ -3,6 +3,7 @@
 #include <onut/UIImage.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 namespace onut
@@ -34,6 +35,18 @@ namespace onut
         setJsonScale9Component(jsonNode, scale9Component, allocator);
     }
 
+    void UIImage::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        scale9Component = readScale9Component(reader);
+    }
+
+    void UIImage::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writeScale9Component(writer, scale9Component);
+    }
+
     void UIImage::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UIImage>(getStyle());
@@ -3,6 +3,7 @@
 #include <onut/UILabel.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 namespace onut
@@ -39,6 +40,18 @@ namespace onut
         setJsonTextComponent(jsonNode, textComponent, allocator);
     }
 
+    void UILabel::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        textComponent = readTextComponent(reader);
+    }
+
+    void UILabel::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writeTextComponent(writer, textComponent);
+    }
+
     void UILabel::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UILabel>(getStyle());
@@ -3,6 +3,7 @@
 #include <onut/UIPanel.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 namespace onut
@@ -34,6 +35,18 @@ namespace onut
         setJsonColor(jsonNode, "color", color, allocator);
     }
 
+    void UIPanel::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        color = reader.readColor();
+    }
+
+    void UIPanel::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writer.writeColor(color);
+    }
+
     void UIPanel::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UIPanel>(getStyle());
@@ -3,8 +3,12 @@
 #include <onut/UIScrollView.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
+// STL
+#include <algorithm>
+
 namespace onut
 {
     OUIScrollViewRef UIScrollView::create()
@@ -22,8 +26,182 @@ namespace onut
             padding = pOther->padding;
             m_scrollH = pOther->m_scrollH;
             m_scrollV = pOther->m_scrollV;
+            createItem = pOther->createItem;
+            bindItem = pOther->bindItem;
+            getItemHeight = pOther->getItemHeight;
+            itemHeight = pOther->itemHeight;
+            m_itemCount = pOther->m_itemCount;
+            m_areItemOffsetsDirty = true;
         }
+        m_realizedItems.clear();
         UIControl::operator=(other);
+
+        // Its realized rows were copied with the children. This one realizes its own
+        if (pOther)
+        {
+            const auto& otherChildren = pOther->getChildren();
+            for (auto i = otherChildren.size(); i-- > 0;)
+            {
+                for (const auto& realizedItem : pOther->m_realizedItems)
+                {
+                    if (realizedItem.pControl == otherChildren[i])
+                    {
+                        remove(getChildren()[i]);
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    void UIScrollView::setItemCount(size_t count)
+    {
+        m_itemCount = count;
+        invalidateItems();
+    }
+
+    void UIScrollView::invalidateItems()
+    {
+        invalidateRender();
+        m_areItemOffsetsDirty = true;
+        for (auto& realizedItem : m_realizedItems)
+        {
+            realizedItem.index = NO_ITEM;
+        }
+    }
+
+    void UIScrollView::scrollToItem(size_t index)
+    {
+        invalidateRender();
+        m_scrollV = getItemOffset(std::min(index, m_itemCount));
+    }
+
+    const std::vector<float>& UIScrollView::getItemOffsets() const
+    {
+        if (m_areItemOffsetsDirty)
+        {
+            m_itemOffsets.resize(m_itemCount + 1);
+            float offset = 0.f;
+            for (size_t i = 0; i < m_itemCount; ++i)
+            {
+                m_itemOffsets[i] = offset;
+                offset += getItemHeight(i);
+            }
+            m_itemOffsets[m_itemCount] = offset;
+            m_areItemOffsetsDirty = false;
+        }
+        return m_itemOffsets;
+    }
+
+    float UIScrollView::getItemOffset(size_t index) const
+    {
+        if (!getItemHeight) return static_cast<float>(index) * itemHeight;
+        return getItemOffsets()[index];
+    }
+
+    float UIScrollView::getContentHeight() const
+    {
+        return getItemOffset(m_itemCount);
+    }
+
+    size_t UIScrollView::getItemAtOffset(float offset) const
+    {
+        if (!getItemHeight)
+        {
+            if (itemHeight <= 0.f) return 0;
+            auto index = std::min(std::max(0.f, offset / itemHeight), static_cast<float>(m_itemCount - 1));
+            return static_cast<size_t>(index);
+        }
+
+        // Last item starting at or before offset
+        const auto& offsets = getItemOffsets();
+        auto it = std::upper_bound(offsets.begin(), offsets.begin() + m_itemCount, offset);
+        if (it == offsets.begin()) return 0;
+        return static_cast<size_t>(it - offsets.begin()) - 1;
+    }
+
+    void UIScrollView::realizeItems(const Rect& rect)
+    {
+        auto viewHeight = std::max(0.f, rect.w - padding.y - padding.w);
+        m_scrollV = std::max(0.f, std::min(m_scrollV, getContentHeight() - viewHeight));
+
+        size_t from = 0;
+        size_t to = 0;
+        if (m_itemCount && createItem && viewHeight > 0.f)
+        {
+            from = getItemAtOffset(m_scrollV);
+            to = getItemAtOffset(m_scrollV + viewHeight) + 1;
+        }
+        auto count = to - from;
+
+        // Controls still in view keep their item, the others are free
+        m_isIndexRealized.assign(count, false);
+        for (auto& realizedItem : m_realizedItems)
+        {
+            if (realizedItem.index >= from && realizedItem.index < to)
+            {
+                m_isIndexRealized[realizedItem.index - from] = true;
+            }
+            else
+            {
+                realizedItem.index = NO_ITEM;
+            }
+        }
+
+        // The pool only grows to what fits in view
+        while (m_realizedItems.size() < count)
+        {
+            auto pControl = createItem();
+            add(pControl);
+            m_realizedItems.push_back({pControl, NO_ITEM});
+        }
+
+        // Recycle free controls for the items coming in view
+        size_t freeItem = 0;
+        for (auto i = from; i < to; ++i)
+        {
+            if (m_isIndexRealized[i - from]) continue;
+            while (m_realizedItems[freeItem].index != NO_ITEM) ++freeItem;
+            auto& realizedItem = m_realizedItems[freeItem];
+            realizedItem.index = i;
+            if (bindItem)
+            {
+                bindItem(realizedItem.pControl, i);
+            }
+        }
+
+        for (auto& realizedItem : m_realizedItems)
+        {
+            const auto& pControl = realizedItem.pControl;
+            if (realizedItem.index == NO_ITEM)
+            {
+                pControl->isVisible = false;
+                continue;
+            }
+            auto offset = getItemOffset(realizedItem.index);
+            auto y = padding.y + offset - m_scrollV;
+            auto height = getItemOffset(realizedItem.index + 1) - offset;
+            pControl->isVisible = true;
+            if (pControl->rect.y != y || pControl->rect.w != height)
+            {
+                pControl->rect.y = y;
+                pControl->rect.w = height;
+                pControl->invalidateLayout();
+            }
+        }
+    }
+
+    void UIScrollView::renderControl(const OUIContextRef& context, const Rect& rect)
+    {
+        // Children are rendered after this, already showing the right items
+        realizeItems(rect);
+    }
+
+    void UIScrollView::onMouseScrollInternal(const UIMouseEvent& evt)
+    {
+        if (!isScrollV) return;
+        m_scrollV = std::max(0.f, m_scrollV - evt.scroll);
+        invalidateRender();
     }
 
     void UIScrollView::load(const rapidjson::Value& jsonNode)
@@ -41,4 +219,20 @@ namespace onut
         setJsonBool(jsonNode, "scrollV", isScrollV, allocator, true);
         setJsonPadding(jsonNode, padding, allocator);
     }
+
+    void UIScrollView::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        isScrollH = reader.readBool();
+        isScrollV = reader.readBool();
+        padding = reader.readVector4();
+    }
+
+    void UIScrollView::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writer.writeBool(isScrollH);
+        writer.writeBool(isScrollV);
+        writer.writeVector4(padding);
+    }
 };
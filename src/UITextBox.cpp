@@ -3,6 +3,7 @@
 #include <onut/UITextBox.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
 // STL
@@ -42,6 +43,7 @@ namespace onut
 
     void UITextBox::numerifyText()
     {
+        invalidateRender();
         if (m_isNumerical)
         {
             std::stringstream ss(textComponent.text);
@@ -132,6 +134,25 @@ namespace onut
         setJsonInt(jsonNode, "precision", m_decimalPrecision, allocator);
     }
 
+    void UITextBox::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        textComponent = readTextComponent(reader);
+        scale9Component = readScale9Component(reader);
+        m_isNumerical = reader.readBool();
+        m_decimalPrecision = reader.readInt();
+        numerifyText();
+    }
+
+    void UITextBox::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writeTextComponent(writer, textComponent);
+        writeScale9Component(writer, scale9Component);
+        writer.writeBool(m_isNumerical);
+        writer.writeInt(m_decimalPrecision);
+    }
+
     void UITextBox::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UITextBox>(getStyle());
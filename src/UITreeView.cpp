@@ -3,8 +3,13 @@
 #include <onut/UITreeView.h>
 
 // Private
+#include "UIBinary.h"
 #include "UIJson.h"
 
+// STL
+#include <algorithm>
+#include <cmath>
+
 namespace onut
 {
     OUITreeViewRef UITreeView::create()
@@ -21,6 +26,7 @@ namespace onut
             {
                 m_items.push_back(std::shared_ptr<UITreeViewItem>(new UITreeViewItem(*pOtherItem)));
             }
+            dirtyRows();
         }
         UIControl::operator=(other);
     }
@@ -104,90 +110,93 @@ namespace onut
     void UITreeView::clear()
     {
         m_items.clear();
+        dirtyRows();
     }
 
-    OUITreeViewItemRef UITreeView::getItemAtPosition(const Vector2& pos, const Rect& rect, bool* pPickedExpandButton, Rect* pItemRect) const
+    void UITreeView::dirtyRows()
     {
-        // Render it's items
-        Rect itemRect = {rect.x, rect.y, rect.z, itemHeight};
-        itemRect.y -= m_scroll;
-        for (auto pItem : m_items)
-        {
-            auto pRet = getItemAtPosition(pItem, pos, itemRect, pPickedExpandButton, pItemRect);
-            if (pRet)
-            {
-                return pRet;
-            }
-        }
-        return nullptr;
+        m_areRowsDirty = true;
+        invalidateRender();
     }
 
-    float UITreeView::getTotalHeight(const OUITreeViewItemRef& pItem) const
+    const UITreeView::Rows& UITreeView::getRows() const
     {
-        float ret = itemHeight;
-        if (pItem)
+        // Expand states are public, compare them with what the rows were built from
+        if (!m_areRowsDirty)
         {
-            if (pItem->isExpanded)
+            for (const auto& expansion : m_expansions)
             {
-                for (auto pChild : pItem->getItems())
+                if (expansion.first->isExpanded != expansion.second)
                 {
-                    ret += getTotalHeight(pChild);
+                    m_areRowsDirty = true;
+                    break;
                 }
             }
         }
-        else
+        if (m_areRowsDirty)
         {
-            for (auto pChild : m_items)
-            {
-                ret += getTotalHeight(pChild);
-            }
+            m_rows.clear();
+            m_expansions.clear();
+            addRows(m_items, 0);
+            m_areRowsDirty = false;
         }
-        return ret;
+        return m_rows;
     }
 
-    OUITreeViewItemRef UITreeView::getItemAtPosition(const OUITreeViewItemRef& pItem, const Vector2& pos, Rect& rect, bool* pPickedExpandButton, Rect* pItemRect) const
+    void UITreeView::addRows(const TreeViewItems& items, int depth) const
     {
-        if (pos.y >= rect.y &&
-            pos.y <= rect.y + rect.w)
-        {
-            if (pos.x >= rect.x + expandClickWidth ||
-                pos.x <= rect.x)
-            {
-                if (pItemRect) *pItemRect = rect;
-                return pItem;
-            }
-            else if (pPickedExpandButton)
-            {
-                if (pItemRect) *pItemRect = rect;
-                *pPickedExpandButton = true;
-                return pItem;
-            }
-        }
-        rect.y += itemHeight;
-        if (pItem->isExpanded)
+        for (const auto& pItem : items)
         {
+            m_rows.push_back({pItem.get(), depth});
             if (!pItem->m_items.empty())
             {
-                auto xOffset = expandedXOffset;
-                rect.x += xOffset;
-                rect.z -= xOffset;
-                for (auto pHisItem : pItem->m_items)
+                m_expansions.push_back({pItem.get(), pItem->isExpanded});
+                if (pItem->isExpanded)
                 {
-                    auto pRet = getItemAtPosition(pHisItem, pos, rect, pPickedExpandButton, pItemRect);
-                    if (pRet)
-                    {
-                        return pRet;
-                    }
+                    addRows(pItem->m_items, depth + 1);
                 }
-                rect.z += xOffset;
-                rect.x -= xOffset;
             }
         }
+    }
+
+    OUITreeViewItemRef UITreeView::getItemAtPosition(const Vector2& pos, const Rect& rect, bool* pPickedExpandButton, Rect* pItemRect) const
+    {
+        const auto& rows = getRows();
+        if (rows.empty() || itemHeight <= 0.f) return nullptr;
+
+        // Row edges are inclusive, the upper row wins when on the line between two
+        auto offset = pos.y - (rect.y - m_scroll);
+        if (offset < 0.f) return nullptr;
+        auto index = static_cast<size_t>(offset / itemHeight);
+        if (index > 0 && static_cast<float>(index) * itemHeight == offset) --index;
+        if (index >= rows.size()) return nullptr;
+
+        const auto& row = rows[index];
+        auto xOffset = expandedXOffset * static_cast<float>(row.depth);
+        Rect itemRect = {rect.x + xOffset, rect.y - m_scroll + static_cast<float>(index) * itemHeight, rect.z - xOffset, itemHeight};
+        if (pos.x >= itemRect.x + expandClickWidth ||
+            pos.x <= itemRect.x)
+        {
+            if (pItemRect) *pItemRect = itemRect;
+            return row.pItem->shared_from_this();
+        }
+        else if (pPickedExpandButton)
+        {
+            if (pItemRect) *pItemRect = itemRect;
+            *pPickedExpandButton = true;
+            return row.pItem->shared_from_this();
+        }
         return nullptr;
     }
 
+    float UITreeView::getTotalHeight() const
+    {
+        return static_cast<float>(getRows().size()) * itemHeight;
+    }
+
     void UITreeView::unselectAll()
     {
+        invalidateRender();
         m_selectedItems.clear();
         for (auto pItem : m_items)
         {
@@ -197,6 +206,7 @@ namespace onut
 
     void UITreeView::unselectItem(const OUITreeViewItemRef& pItem)
     {
+        invalidateRender();
         pItem->m_isSelected = false;
         for (auto pHisItem : pItem->m_items)
         {
@@ -206,6 +216,7 @@ namespace onut
 
     void UITreeView::addSelectedItem(const OUITreeViewItemRef& pItem)
     {
+        invalidateRender();
         m_selectedItems.push_back(pItem);
         pItem->m_isSelected = true;
         expandTo(pItem);
@@ -242,6 +253,22 @@ namespace onut
         setJsonFloat(jsonNode, "itemHeight", itemHeight, allocator, 18.f);
     }
 
+    void UITreeView::load(UIBinaryReader& reader)
+    {
+        UIControl::load(reader);
+        expandedXOffset = reader.readFloat();
+        expandClickWidth = reader.readFloat();
+        itemHeight = reader.readFloat();
+    }
+
+    void UITreeView::save(UIBinaryWriter& writer) const
+    {
+        UIControl::save(writer);
+        writer.writeFloat(expandedXOffset);
+        writer.writeFloat(expandClickWidth);
+        writer.writeFloat(itemHeight);
+    }
+
     void UITreeView::renderControl(const OUIContextRef& context, const Rect& rect)
     {
         const auto& callback = context->getStyle<UITreeView>(getStyle());
@@ -250,15 +277,28 @@ namespace onut
             callback->render(OThis, rect);
         }
 
-        // Render it's items
+        // Render the items in view. Without clipping, that's the screen
         Rect itemRect = {rect.x, rect.y, rect.z, itemHeight};
-        itemRect.y -= m_scroll;
         const auto& itemCallback = context->getStyle<UITreeViewItem>(getStyle());
         if (itemCallback)
         {
-            for (auto pItem : m_items)
+            const auto& rows = getRows();
+            auto top = rect.y - m_scroll;
+            size_t from = 0;
+            size_t to = rows.size();
+            if (itemHeight > 0.f)
             {
-                pItem->render(itemCallback, ODynamicCast<OUITreeView>(OThis), rect, itemRect);
+                auto viewTop = clipChildren ? rect.y : 0.f;
+                auto viewBottom = clipChildren ? rect.y + rect.w : context->getScreenSize().y;
+                from = static_cast<size_t>(std::max(0.f, std::floor((viewTop - top) / itemHeight)));
+                to = std::min(to, static_cast<size_t>(std::max(0.f, std::floor((viewBottom - top) / itemHeight) + 1.f)));
+            }
+            for (auto i = from; i < to; ++i)
+            {
+                const auto& row = rows[i];
+                auto xOffset = expandedXOffset * static_cast<float>(row.depth);
+                itemRect = {rect.x + xOffset, top + static_cast<float>(i) * itemHeight, rect.z - xOffset, itemHeight};
+                itemCallback->render(row.pItem->shared_from_this(), itemRect);
             }
         }
 
@@ -279,6 +319,7 @@ namespace onut
 
     void UITreeView::onMouseDownInternal(const UIMouseEvent& evt)
     {
+        invalidateRender();
         auto worldRect = getWorldRect(evt.pContext);
         bool pickedExpandButton = false;
         auto pPicked = getItemAtPosition(evt.mousePos, worldRect, &pickedExpandButton);
@@ -330,6 +371,7 @@ namespace onut
 
     void UITreeView::onMouseMoveInternal(const UIMouseEvent& evt)
     {
+        invalidateRender();
         if (hasFocus(evt.pContext) && evt.isMouseDown)
         {
             if (allowReorder)
@@ -382,6 +424,7 @@ namespace onut
     void UITreeView::onMouseUpInternal(const UIMouseEvent& evt)
     {
         if (!m_isDragging) return;
+        invalidateRender();
 
         auto dragHover = m_dragHoverItem;
         auto dragBefore = m_dragBeforeItem;
@@ -460,6 +503,7 @@ namespace onut
 
     void UITreeView::onMouseScrollInternal(const UIMouseEvent& evt)
     {
+        invalidateRender();
         m_scroll -= evt.scroll;
         auto contentSize = getTotalHeight();
         auto worldRect = getWorldRect(evt.pContext);
@@ -474,6 +518,7 @@ namespace onut
         {
             return a->text < b->text;
         });
+        dirtyRows();
     }
 };
 
@@ -509,6 +554,14 @@ namespace onut
 
     void UITreeViewItem::setTreeView(const OUITreeViewRef& pTreeView)
     {
+        if (auto pPreviousTreeView = m_pTreeView.lock())
+        {
+            pPreviousTreeView->dirtyRows();
+        }
+        if (pTreeView)
+        {
+            pTreeView->dirtyRows();
+        }
         m_pTreeView = pTreeView;
         for (auto pItem : m_items)
         {
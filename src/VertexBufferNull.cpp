@@ -0,0 +1,56 @@
+// Onut
+#include <onut/Renderer.h>
+#include <onut/RendererNull.h>
+
+// Private
+#include "VertexBufferNull.h"
+
+// STL
+#include <cassert>
+
+namespace onut
+{
+    OVertexBufferRef VertexBuffer::createStatic(const void* pVertexData, uint32_t size)
+    {
+        auto pRet = OMake<VertexBufferNull>();
+        pRet->setData(pVertexData, size);
+        return pRet;
+    }
+
+    OVertexBufferRef VertexBuffer::createDynamic(uint32_t size)
+    {
+        auto pRet = OMake<VertexBufferNull>();
+        pRet->m_size = size;
+        pRet->m_data.resize(size);
+        pRet->m_isDynamic = true;
+
+        oRenderer->renderStates.vertexBuffer.forceDirty();
+
+        return pRet;
+    }
+
+    void VertexBufferNull::setData(const void* pVertexData, uint32_t size)
+    {
+        if (!m_isDynamic) m_size = size;
+        RendererNull::countUpload(size);
+        oRenderer->renderStates.vertexBuffer.forceDirty();
+    }
+
+    void* VertexBufferNull::map()
+    {
+        assert(m_isDynamic);
+        return m_data.data();
+    }
+
+    void VertexBufferNull::unmap(uint32_t size)
+    {
+        assert(m_isDynamic);
+        RendererNull::countUpload(size);
+        oRenderer->renderStates.vertexBuffer.forceDirty();
+    }
+
+    uint32_t VertexBufferNull::size()
+    {
+        return m_size;
+    }
+}
@@ -0,0 +1,33 @@
+#ifndef VERTEXBUFFERNULL_H_INCLUDED
+#define VERTEXBUFFERNULL_H_INCLUDED
+
+// Onut
+#include <onut/VertexBuffer.h>
+
+// STL
+#include <vector>
+
+// Forward
+#include <onut/ForwardDeclaration.h>
+OForwardDeclare(VertexBufferNull)
+
+namespace onut
+{
+    class VertexBufferNull final : public VertexBuffer
+    {
+    public:
+        void setData(const void* pVertexData, uint32_t size) override;
+        void* map() override;
+        void unmap(uint32_t size) override;
+        uint32_t size() override;
+
+    private:
+        friend class VertexBuffer;
+
+        uint32_t m_size = 0;
+        bool m_isDynamic = false;
+        std::vector<uint8_t> m_data; // What map gives when dynamic
+    };
+}
+
+#endif
@@ -10,6 +10,7 @@
 #include <onut/GamePad.h>
 #include <onut/Input.h>
 #include <onut/Http.h>
+#include <onut/HttpCache.h>
 #include <onut/Log.h>
 #include <onut/Multiplayer.h>
 #include <onut/onut.h>
@@ -177,6 +178,7 @@ namespace onut
         oUI = nullptr;
         oUIContext = nullptr;
         oMultiplayer = nullptr;
+        oHttpCache = nullptr;
         oHttp = nullptr;
         oParticleSystemManager = nullptr;
         oAudioEngine = nullptr;
@@ -225,6 +227,9 @@ namespace onut
             // Sync to main callbacks
             oDispatcher->processQueue();
 
+            // Finish async resource loads
+            oContentManager->update();
+
             // Update
             oAudioEngine->update();
             auto framesToUpdate = oTiming->update(oSettings->getIsFixedStep());
@@ -298,6 +303,7 @@ namespace onut
             {
                 renderCallback();
             }
+            oRenderer->executeCommandLists();
             oSceneManager->render();
             oParticleSystemManager->render();
             oSpriteBatch->begin();
@@ -343,6 +349,29 @@ namespace onut
             if (pFont)
             {
                 pFont->draw("FPS: " + std::to_string(oTiming->getFPS()), {0, 0});
+
+                // Content memory
+                static const char* CATEGORY_NAMES[] = {"Textures", "Sounds"};
+                auto y = pFont->measure("FPS").y;
+                for (int i = 0; i < 2; ++i)
+                {
+                    auto stats = oContentManager->getMemoryStats(static_cast<Resource::MemoryCategory>(i));
+                    auto text = std::string(CATEGORY_NAMES[i]) + ": " + std::to_string(stats.count) + ", " + std::to_string(stats.size / (1024 * 1024)) + " MB";
+                    if (stats.budget) text += " / " + std::to_string(stats.budget / (1024 * 1024)) + " MB";
+                    pFont->draw(text, {0, y * static_cast<float>(i + 1)});
+                }
+
+                // Graphics API calls of the last frame
+                const auto& callStats = oRenderer->getCallStats();
+                if (callStats.drawCalls)
+                {
+                    auto text = "Draws: " + std::to_string(callStats.drawCalls) +
+                        ", States: " + std::to_string(callStats.stateCalls) +
+                        ", Textures: " + std::to_string(callStats.textureBinds) +
+                        ", Samplers: " + std::to_string(callStats.samplerBinds) +
+                        ", Skipped: " + std::to_string(callStats.skippedCalls);
+                    pFont->draw(text, {0, y * 3.f});
+                }
             }
 #endif
 
@@ -201,6 +201,7 @@ void DocumentView::updateSelectedGizmoRect()
     if (pSelected)
     {
         m_pGizmo->rect = (pSelected->getWorldRect(pUIContext));
+        m_pGizmo->invalidateLayout();
     }
 }
 
@@ -387,6 +388,7 @@ void DocumentView::updateGizmoRect()
     rct.x = std::roundf(rct.x);
     rct.y = std::roundf(rct.y);
     m_pGizmo->rect = (rct);
+    m_pGizmo->invalidateLayout();
 }
 
 void DocumentView::xAutoGuideAgainst(const Rect& otherRect, bool& found, const Rect& rect, float& x, bool& side, float& closest)
@@ -566,6 +568,7 @@ float DocumentView::snapX(const OUIControlRef& pControl, float x)
     {
         auto& rect = m_guides[1]->rect;
         m_guides[1]->rect = {ret, rect.y, rect.z, rect.w};
+        m_guides[1]->invalidateLayout();
         m_guides[1]->isVisible = (true);
     }
     else
@@ -638,6 +641,7 @@ float DocumentView::snapY(const OUIControlRef& pControl, float y)
     {
         auto& rect = m_guides[0]->rect;
         m_guides[0]->rect = {rect.x, ret, rect.z, rect.w};
+        m_guides[0]->invalidateLayout();
         m_guides[0]->isVisible = (true);
     }
     else
@@ -759,6 +763,7 @@ void DocumentView::updateMovingGizmo()
             newRect.x = m_controlWorldRectOnDown.x + finalOffset;
             auto& rect = m_guides[1]->rect;
             m_guides[1]->rect = {x, rect.y, rect.z, rect.w};
+            m_guides[1]->invalidateLayout();
             m_guides[1]->isVisible = (true);
         }
         else
@@ -779,6 +784,7 @@ void DocumentView::updateMovingGizmo()
             newRect.y = m_controlWorldRectOnDown.y + finalOffset;
             auto& rect = m_guides[0]->rect;
             m_guides[0]->rect = {rect.x, y, rect.z, rect.w};
+            m_guides[0]->invalidateLayout();
             m_guides[0]->isVisible = (true);
         }
         else
@@ -1110,10 +1116,12 @@ void DocumentView::render(const Rect& rect)
     pUIScreen->setWorldRect(rect, pUIContext);
     pUIScreen->widthType = OUIControl::DimType::Absolute;
     pUIScreen->heightType = OUIControl::DimType::Absolute;
+    pUIScreen->invalidateLayout();
     pUIScreen->render(pUIContext);
     pUIScreen->rect = {0, 0, 0, 0};
     pUIScreen->widthType = OUIControl::DimType::Relative;
     pUIScreen->heightType = OUIControl::DimType::Relative;
+    pUIScreen->invalidateLayout();
 }
 
 void DocumentView::resize(const Vector2& newSize)
@@ -1382,6 +1390,7 @@ void DocumentView::save()
     if (!m_filename.empty())
     {
         pUIScreen->save(m_filename);
+        pUIScreen->save(m_filename.substr(0, m_filename.find_last_of('.')) + ".uib"); // What games load
         setDirty(false);
     }
 }
@@ -311,11 +311,13 @@ void doRectChange(const std::string& actionName, const OUIControlRef& pControl,
     oActionManager->doAction(OMake<onut::Action>(actionName, 
         [=]{
         pControl->rect = rect;
+        pControl->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pControl->rect = previousRect;
+        pControl->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -358,11 +360,13 @@ void onUIControlAnchorXChanged(const OUITextBoxRef& pTextBox, const onut::UIText
     oActionManager->doAction(OMake<onut::Action>("Edit X anchor",
         [=]{
         pSelected->anchor = newAnchor;
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->anchor = prevAnchor;
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -382,11 +386,13 @@ void onUIControlAnchorYChanged(const OUITextBoxRef& pTextBox, const onut::UIText
     oActionManager->doAction(OMake<onut::Action>("Edit Y anchor",
         [=]{
         pSelected->anchor = newAnchor;
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->anchor = prevAnchor;
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -519,11 +525,13 @@ void onUIControlXAnchorPercentChanged(const OUICheckBoxRef& pCheckBox, const onu
         [=]{
         pSelected->anchor = newAnchor;
         pSelected->xAnchorType = newAnchorType;
+        pSelected->invalidateLayout();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->anchor = prevAnchor;
         pSelected->xAnchorType = prevAnchorType;
+        pSelected->invalidateLayout();
         g_pDocument->updateInspector();
     }));
 }
@@ -550,11 +558,13 @@ void onUIControlYAnchorPercentChanged(const OUICheckBoxRef& pCheckBox, const onu
         [=]{
         pSelected->anchor = newAnchor;
         pSelected->yAnchorType = newAnchorType;
+        pSelected->invalidateLayout();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->anchor = prevAnchor;
         pSelected->yAnchorType = prevAnchorType;
+        pSelected->invalidateLayout();
         g_pDocument->updateInspector();
     }));
 }
@@ -584,12 +594,14 @@ void onUIControlWidthPercentChanged(const OUICheckBoxRef& pCheckBox, const onut:
         [=]{
         pSelected->widthType = (newDimType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->widthType = (prevDimType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -620,12 +632,14 @@ void onUIControlHeightPercentChanged(const OUICheckBoxRef& pCheckBox, const onut
         [=]{
         pSelected->heightType = (newDimType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->heightType = (prevDimType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -656,12 +670,14 @@ void onUIControlWidthRelativeChanged(const OUICheckBoxRef& pCheckBox, const onut
         [=]{
         pSelected->widthType = (newDimType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->widthType = (prevDimType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -692,12 +708,14 @@ void onUIControlHeightRelativeChanged(const OUICheckBoxRef& pCheckBox, const onu
         [=]{
         pSelected->heightType = (newDimType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->heightType = (prevDimType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -727,12 +745,14 @@ void onUIControlXPercentChanged(const OUICheckBoxRef& pCheckBox, const onut::UIC
         [=]{
         pSelected->xType = (newType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->xType = (prevType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -762,12 +782,14 @@ void onUIControlYPercentChanged(const OUICheckBoxRef& pCheckBox, const onut::UIC
         [=]{
         pSelected->yType = (newType);
         pSelected->rect = (newRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->yType = (prevType);
         pSelected->rect = (prevRect);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -819,11 +841,13 @@ void onAnchorClicked(const OUIControlRef& pControl, const onut::UIMouseEvent& ev
     oActionManager->doAction(OMake<onut::Action>("Change Anchor",
         [=]{
         pSelected->anchor = (newAnchor);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
         [=]{
         pSelected->anchor = (prevAnchor);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));
@@ -845,46 +869,55 @@ void onAlignChkChanged(const OUICheckBoxRef& pCheckBox, const onut::UICheckEvent
     {
         pSelected->setAnchorPercent({0, 0});
         pSelected->align = (OTopLeft);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkTOP)
     {
         pSelected->setAnchorPercent({.5f, 0});
         pSelected->align = (OTop);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkTOP_RIGHT)
     {
         pSelected->setAnchorPercent({1, 0});
         pSelected->align = (OTopRight);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkLEFT)
     {
         pSelected->setAnchorPercent({0, .5f});
         pSelected->align = (OLeft);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkCENTER)
     {
         pSelected->setAnchorPercent({.5f, .5f});
         pSelected->align = (OCenter);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkRIGHT)
     {
         pSelected->setAnchorPercent({1, .5f});
         pSelected->align = (ORight);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkBOTTOM_LEFT)
     {
         pSelected->setAnchorPercent({0, 1});
         pSelected->align = (OBottomLeft);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkBOTTOM)
     {
         pSelected->setAnchorPercent({.5f, 1});
         pSelected->align = (OBottom);
+        pSelected->invalidateLayout();
     }
     else if (pCheckBox == g_pInspector_UIControl_chkBOTTOM_RIGHT)
     {
         pSelected->setAnchorPercent({1, 1});
         pSelected->align = (OBottomRight);
+        pSelected->invalidateLayout();
     }
     auto newAnchor = pSelected->anchor;
     auto newAlign = pSelected->align;
@@ -894,6 +927,7 @@ void onAlignChkChanged(const OUICheckBoxRef& pCheckBox, const onut::UICheckEvent
         pSelected->rect = (newRect);
         pSelected->anchor = (newAnchor);
         pSelected->align = (newAlign);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     },
@@ -901,6 +935,7 @@ void onAlignChkChanged(const OUICheckBoxRef& pCheckBox, const onut::UICheckEvent
         pSelected->rect = (previousRect);
         pSelected->anchor = (previousAnchor);
         pSelected->align = (previousAlign);
+        pSelected->invalidateLayout();
         g_pDocument->updateSelectedGizmoRect();
         g_pDocument->updateInspector();
     }));